@@ -0,0 +1,174 @@
+// 控制接口往返延迟：服务端在独立线程的事件循环中运行，客户端在主线程阻塞调用
+// 用法：control_benchmark [次数]
+// 输出第二次启动转交参数（连接 + Open + 回复 + 断开）、单条命令和批量命令的延迟
+#include "core/controlclient.h"
+#include "core/controlserver.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QVector>
+#include <QTextStream>
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+struct Summary
+{
+    double median;
+    double p99;
+};
+
+Summary summarize(QVector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    if (samples.isEmpty()) {
+        return Summary{0, 0};
+    }
+    return Summary{samples.at(samples.size() / 2), samples.at(qMin(samples.size() - 1, samples.size() * 99 / 100))};
+}
+
+void report(QTextStream &out, const char *label, const QVector<double> &samples, int commands = 1)
+{
+    const Summary summary = summarize(samples);
+    out << label << "  中位数 " << summary.median << " 微秒，p99 " << summary.p99 << " 微秒";
+    if (commands > 1) {
+        out << "，每条命令 " << summary.median / commands << " 微秒";
+    }
+    out << "\n";
+}
+
+ControlMessage message(quint8 code, const QByteArray &payload = QByteArray())
+{
+    ControlMessage request;
+    request.code = code;
+    request.payload = payload;
+    return request;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int rounds = args.size() > 1 ? args.at(1).toInt() : 2000;
+    const QString name = QString("YinYue-benchmark-%1").arg(QCoreApplication::applicationPid());
+
+    QTextStream out(stdout);
+    out.setRealNumberNotation(QTextStream::FixedNotation);
+    out.setRealNumberPrecision(1);
+
+    // 服务端：状态固定，加入的路径只计数
+    std::atomic<int> enqueued{0};
+    QThread thread;
+    ControlServer *server = new ControlServer;
+    server->setStateProvider([]() {
+        ControlProtocol::PlayerState state;
+        state.state = 1;
+        state.position = 123456;
+        state.duration = 240000;
+        state.volume = 50;
+        state.currentIndex = 3;
+        state.count = 100;
+        state.filePath = "/home/user/Music/Artist/Album/03 - Track.flac";
+        return state;
+    });
+    QObject::connect(server, &ControlServer::enqueueRequested, [&enqueued](const QStringList &paths) {
+        enqueued += paths.size();
+    });
+    QObject::connect(server, &ControlServer::openRequested, [&enqueued](const QStringList &paths) {
+        enqueued += paths.size();
+    });
+    server->moveToThread(&thread);
+    thread.start();
+    auto shutdown = [&](int code) {
+        QMetaObject::invokeMethod(server, [server]() {
+            delete server;
+        }, Qt::BlockingQueuedConnection);
+        thread.quit();
+        thread.wait();
+        return code;
+    };
+    bool listening = false;
+    QMetaObject::invokeMethod(server, [&]() {
+        listening = server->listen(name);
+    }, Qt::BlockingQueuedConnection);
+    if (!listening) {
+        out << "无法监听 " << name << "\n";
+        return shutdown(1);
+    }
+
+    QElapsedTimer timer;
+    QVector<double> samples;
+    samples.reserve(rounds);
+
+    // 第二次启动：每次新建连接，转交一个文件后断开
+    const QByteArray openPayload = ControlProtocol::encodePaths(QStringList() << "/home/user/Music/song.mp3");
+    for (int i = 0; i < rounds; ++i) {
+        timer.start();
+        ControlClient client(name);
+        ControlMessage reply;
+        if (!client.connectToServer() || !client.call(message(ControlProtocol::Open, openPayload), &reply)) {
+            out << "转交失败\n";
+            return shutdown(1);
+        }
+        client.disconnectFromServer();
+        samples.append(timer.nsecsElapsed() / 1000.0);
+    }
+    report(out, "转交参数（连接到断开）", samples);
+
+    ControlClient client(name);
+    if (!client.connectToServer()) {
+        out << "无法连接\n";
+        return shutdown(1);
+    }
+
+    const struct {
+        const char *label;
+        ControlMessage request;
+    } singles[] = {
+        {"Ping                  ", message(ControlProtocol::Ping)},
+        {"QueryState            ", message(ControlProtocol::QueryState)},
+        {"Seek                  ", message(ControlProtocol::Seek, ControlProtocol::encodePosition(60000))},
+    };
+    for (const auto &single : singles) {
+        samples.clear();
+        for (int i = 0; i < rounds; ++i) {
+            timer.start();
+            ControlMessage reply;
+            if (!client.call(single.request, &reply) || reply.code != ControlProtocol::Ok) {
+                out << "命令失败\n";
+                return shutdown(1);
+            }
+            samples.append(timer.nsecsElapsed() / 1000.0);
+        }
+        report(out, single.label, samples);
+    }
+
+    // 批量：一次写入 100 条 Enqueue（每条 10 个路径）和 1 条 QueryState
+    QList<ControlMessage> batch;
+    for (int i = 0; i < 100; ++i) {
+        QStringList paths;
+        for (int j = 0; j < 10; ++j) {
+            paths << QString("/home/user/Music/Artist %1/Album/%2 - Track.flac").arg(i).arg(j);
+        }
+        batch.append(message(ControlProtocol::Enqueue, ControlProtocol::encodePaths(paths)));
+    }
+    batch.append(message(ControlProtocol::QueryState));
+    samples.clear();
+    for (int i = 0; i < qMax(1, rounds / 10); ++i) {
+        timer.start();
+        QList<ControlMessage> replies;
+        if (!client.call(batch, &replies) || replies.size() != batch.size()) {
+            out << "批量命令失败\n";
+            return shutdown(1);
+        }
+        samples.append(timer.nsecsElapsed() / 1000.0);
+    }
+    report(out, "批量 101 条（1000 个路径）", samples, batch.size());
+    out << "服务端收到路径 " << enqueued.load() << " 个\n";
+
+    client.disconnectFromServer();
+    return shutdown(0);
+}
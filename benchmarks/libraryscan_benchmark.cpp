@@ -0,0 +1,109 @@
+// 音乐库扫描：io_uring 与线程池两种后端在不同并发数下的耗时
+// 用法：libraryscan_benchmark [文件数] [目录]
+// 不指定目录时在临时目录中生成合成音乐库（每个文件 8~64KB）；
+// 指定目录时扫描其中已有的文件，可以放在网络存储上对比。
+// Linux 上每轮之前用 POSIX_FADV_DONTNEED 把文件移出页缓存，测量的是冷读取（网络文件系统上不一定生效）
+#include "core/libraryscanner.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
+namespace {
+
+QStringList createLibrary(const QString &folder, int count)
+{
+    QStringList filePaths;
+    QByteArray data;
+    for (int i = 0; i < count; ++i) {
+        const QString filePath = QDir(folder).filePath(QString("%1 - Track %2.mp3").arg(i / 12).arg(i));
+        data.fill(char('A' + i % 26), 8192 + (i * 7919) % 57344);
+        QFile file(filePath);
+        if (file.open(QIODevice::WriteOnly)) {
+            file.write(data);
+            filePaths.append(filePath);
+        }
+    }
+    return filePaths;
+}
+
+void evict(const QStringList &filePaths)
+{
+#ifdef Q_OS_LINUX
+    for (const QString &filePath : filePaths) {
+        QFile file(filePath);
+        if (file.open(QIODevice::ReadOnly)) {
+            ::posix_fadvise(file.handle(), 0, 0, POSIX_FADV_DONTNEED);
+        }
+    }
+#else
+    Q_UNUSED(filePaths);
+#endif
+}
+
+double run(const QStringList &filePaths, int depth, LibraryScanner::Backend backend, bool cold, int *errors)
+{
+    if (cold) {
+        evict(filePaths);
+    }
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<ScannedFile> files = LibraryScanner::scanFiles(filePaths, depth, backend);
+    const double ms = timer.nsecsElapsed() / 1e6;
+    *errors = 0;
+    for (const ScannedFile &file : files) {
+        *errors += !file.isValid() || file.header.isEmpty();
+    }
+    return ms;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int count = args.size() > 1 ? args.at(1).toInt() : 5000;
+
+    QTextStream out(stdout);
+    out.setRealNumberNotation(QTextStream::FixedNotation);
+    out.setRealNumberPrecision(1);
+
+    QTemporaryDir temp;
+    QStringList filePaths;
+    if (args.size() > 2) {
+        const QDir dir(args.at(2));
+        const QStringList names = dir.entryList({"*.mp3", "*.wav", "*.flac"}, QDir::Files | QDir::NoDotAndDotDot);
+        for (int i = 0; i < names.size() && i < count; ++i) {
+            filePaths.append(dir.filePath(names.at(i)));
+        }
+    } else {
+        filePaths = createLibrary(temp.path(), count);
+    }
+    out << "文件数 " << filePaths.size() << "，io_uring " << (LibraryScanner::isIoUringAvailable() ? "可用" : "不可用") << "\n";
+
+    const int depths[] = {1, 4, 16, 64, 256};
+    for (bool cold : {false, true}) {
+        out << (cold ? "冷读取" : "页缓存中") << "\n";
+        out << "并发数    io_uring(ms)  线程池(ms)\n";
+        for (int depth : depths) {
+            int uringErrors = 0;
+            int poolErrors = 0;
+            const double uring = LibraryScanner::isIoUringAvailable()
+                ? run(filePaths, depth, LibraryScanner::IoUring, cold, &uringErrors) : -1;
+            const double pool = run(filePaths, depth, LibraryScanner::ThreadPool, cold, &poolErrors);
+            out << QString("%1").arg(depth, 6) << "    " << QString::number(uring, 'f', 1).rightJustified(12)
+                << "  " << QString::number(pool, 'f', 1).rightJustified(10);
+            if (uringErrors + poolErrors > 0) {
+                out << "  失败 " << uringErrors << "/" << poolErrors;
+            }
+            out << "\n";
+        }
+    }
+    return 0;
+}
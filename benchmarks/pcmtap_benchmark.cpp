@@ -0,0 +1,120 @@
+// 频谱 PCM 副本对音频线程的开销
+// 用法：pcmtap_benchmark [秒数]
+// 模拟输出设备的 readData()：从环形缓冲区取 48kHz 立体声 → 10 段均衡 → 转换为 16 位，
+// 每块之后按 AudioEngine 的方式写一份副本；另一个线程以 60Hz 取走副本并做 2048 点 FFT，
+// 与界面线程的负载相同。分别统计写副本的耗时占实时时长和占音频线程工作量的比例。
+#include "core/dspchain.h"
+#include "core/fft.h"
+#include "core/pcmring.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+const int SampleRate = 48000;
+const int Channels = 2;
+const int BlockFrames = 1024;   // 设备每次拉取的帧数
+const int TapSamples = 1 << 15; // 与 AudioEngine 相同
+const int FftSize = 2048;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int seconds = args.size() > 1 ? qMax(1, args.at(1).toInt()) : 30;
+
+    QTextStream out(stdout);
+    out.setRealNumberNotation(QTextStream::FixedNotation);
+    out.setRealNumberPrecision(3);
+
+    PcmRing ring(1 << 19);
+    PcmRing tap(TapSamples);
+    DspChain dsp;
+    dsp.prepare(SampleRate, Channels);
+    const float gains[10] = { 4, 3, 1, 0, -1, -2, 0, 2, 3, 4 };
+    dsp.setParameters(DspChain::graphicEqualizer(gains));
+
+    // 消费者：按 60Hz 取走副本并做 FFT
+    std::atomic<bool> running(true);
+    std::atomic<qint64> consumed(0);
+    qint64 fftCount = 0;
+    qint64 fftNs = 0;
+    std::thread consumer([&]() {
+        Fft fft(FftSize);
+        std::vector<float> buffer(8192);
+        std::vector<float> frame(FftSize, 0.0f);
+        std::vector<float> power(FftSize / 2 + 1);
+        QElapsedTimer timer;
+        while (running.load(std::memory_order_relaxed)) {
+            for (;;) {
+                int count = qMin(tap.readAvailable(), int(buffer.size()));
+                count -= count % Channels;
+                if (count == 0) {
+                    break;
+                }
+                tap.read(buffer.data(), count);
+                consumed.fetch_add(count, std::memory_order_relaxed);
+                for (int i = 0; i < qMin(count / Channels, FftSize); ++i) {
+                    frame[size_t(i)] = 0.5f * (buffer[size_t(i) * Channels] + buffer[size_t(i) * Channels + 1]);
+                }
+            }
+            timer.start();
+            fft.powerSpectrum(frame.data(), power.data());
+            fftNs += timer.nsecsElapsed();
+            ++fftCount;
+            std::this_thread::sleep_for(std::chrono::microseconds(16667));
+        }
+    });
+
+    std::vector<float> source(size_t(BlockFrames) * Channels);
+    for (size_t i = 0; i < source.size(); ++i) {
+        source[i] = float((i * 2654435761u % 65536) / 65536.0 - 0.5) * 0.5f;
+    }
+    std::vector<float> samples(source.size());
+    std::vector<qint16> device(source.size());
+
+    // 按实时节奏运行，消费者的取用时机与真实情况一致
+    const qint64 blocks = qint64(seconds) * SampleRate / BlockFrames;
+    const auto blockDuration = std::chrono::microseconds(qint64(BlockFrames) * 1000000 / SampleRate);
+    auto next = std::chrono::steady_clock::now();
+    qint64 workNs = 0;
+    qint64 tapNs = 0;
+    qint64 dropped = 0;
+    QElapsedTimer timer;
+    for (qint64 b = 0; b < blocks; ++b) {
+        ring.write(source.data(), int(source.size()));
+
+        timer.start();
+        const int got = ring.read(samples.data(), int(samples.size())) / Channels;
+        dsp.process(samples.data(), got);
+        const qint64 beforeTap = timer.nsecsElapsed();
+        int count = qMin(got * Channels, tap.writeAvailable());
+        count -= count % Channels;
+        tap.write(samples.data(), count);
+        const qint64 afterTap = timer.nsecsElapsed();
+        convertSamples(samples.data(), device.data(), got * Channels);
+        workNs += timer.nsecsElapsed();
+        tapNs += afterTap - beforeTap;
+        dropped += got * Channels - count;
+
+        next += blockDuration;
+        std::this_thread::sleep_until(next);
+    }
+    running.store(false);
+    consumer.join();
+
+    const double audioNs = double(blocks) * BlockFrames * 1e9 / SampleRate;
+    out << "处理 " << blocks * BlockFrames / double(SampleRate) << " 秒音频，每块 " << BlockFrames << " 帧\n";
+    out << "音频线程工作量（含副本） " << workNs / audioNs * 100.0 << "% 实时\n";
+    out << "写副本 " << tapNs / audioNs * 100.0 << "% 实时，占音频线程工作量 "
+        << double(tapNs) / workNs * 100.0 << "%\n";
+    out << "副本样本 写入 " << consumed.load() << "，丢弃 " << dropped << "\n";
+    out << "界面线程 FFT " << double(fftNs) / qMax<qint64>(1, fftCount) / 1000.0 << " 微秒/帧，60Hz 时 "
+        << double(fftNs) / qMax<qint64>(1, fftCount) * 60.0 / 1e9 * 100.0 << "% 单核\n";
+    return 0;
+}
@@ -0,0 +1,139 @@
+// 播放队列容器对比：QList<MusicFile>（原实现）与 TrackSequence（隐式 treap）
+// 用法：playlistqueue_benchmark [队列长度] [操作次数]
+#include "models/tracksequence.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTextStream>
+
+namespace {
+
+QList<MusicFile> makeFiles(int count, int offset)
+{
+    QList<MusicFile> files;
+    files.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        MusicFile file;
+        file.setFilePath(QString("/music/track%1.mp3").arg(offset + i));
+        file.setTitle(QString("Track %1").arg(offset + i));
+        files.append(file);
+    }
+    return files;
+}
+
+struct Result
+{
+    double buildMs = 0;
+    double insertMs = 0;
+    double removeMs = 0;
+    double moveMs = 0;
+    double readMs = 0;
+    qint64 checksum = 0;
+};
+
+Result runList(const QList<MusicFile> &initial, int operations)
+{
+    Result result;
+    QRandomGenerator rng(42);
+    QElapsedTimer timer;
+
+    timer.start();
+    QList<MusicFile> list = initial;
+    list.detach();
+    result.buildMs = timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    for (int i = 0; i < operations; ++i) {
+        list.insert(rng.bounded(list.size() + 1), initial.at(i % initial.size()));
+    }
+    result.insertMs = timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    for (int i = 0; i < operations; ++i) {
+        const int from = rng.bounded(list.size());
+        const MusicFile file = list.takeAt(from);
+        list.insert(rng.bounded(list.size() + 1), file);
+    }
+    result.moveMs = timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    for (int i = 0; i < operations; ++i) {
+        result.checksum += list.at(rng.bounded(list.size())).title().size();
+    }
+    result.readMs = timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    for (int i = 0; i < operations; ++i) {
+        list.removeAt(rng.bounded(list.size()));
+    }
+    result.removeMs = timer.nsecsElapsed() / 1e6;
+    return result;
+}
+
+Result runSequence(const QList<MusicFile> &initial, int operations)
+{
+    Result result;
+    QRandomGenerator rng(42);
+    QElapsedTimer timer;
+
+    timer.start();
+    TrackSequence sequence;
+    sequence.assign(initial);
+    result.buildMs = timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    for (int i = 0; i < operations; ++i) {
+        sequence.insert(rng.bounded(sequence.size() + 1), QList<MusicFile>() << initial.at(i % initial.size()));
+    }
+    result.insertMs = timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    for (int i = 0; i < operations; ++i) {
+        const int from = rng.bounded(sequence.size());
+        sequence.move(from, 1, rng.bounded(sequence.size()));
+    }
+    result.moveMs = timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    for (int i = 0; i < operations; ++i) {
+        result.checksum += sequence.at(rng.bounded(sequence.size())).title().size();
+    }
+    result.readMs = timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    for (int i = 0; i < operations; ++i) {
+        sequence.remove(rng.bounded(sequence.size()), 1);
+    }
+    result.removeMs = timer.nsecsElapsed() / 1e6;
+    return result;
+}
+
+void print(QTextStream &out, const char *name, const Result &result)
+{
+    out << qSetFieldWidth(16) << name
+        << qSetFieldWidth(10) << result.buildMs << result.insertMs << result.moveMs
+        << result.readMs << result.removeMs << qSetFieldWidth(0) << "\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int size = args.size() > 1 ? args.at(1).toInt() : 200000;
+    const int operations = args.size() > 2 ? args.at(2).toInt() : 20000;
+
+    const QList<MusicFile> initial = makeFiles(size, 0);
+
+    QTextStream out(stdout);
+    out.setRealNumberNotation(QTextStream::FixedNotation);
+    out.setRealNumberPrecision(2);
+    out << "队列长度 " << size << "，每项操作 " << operations << " 次（毫秒）\n";
+    out << qSetFieldWidth(16) << "容器"
+        << qSetFieldWidth(10) << "建立" << "插入" << "移动" << "随机读" << "删除"
+        << qSetFieldWidth(0) << "\n";
+    print(out, "QList", runList(initial, operations));
+    print(out, "TrackSequence", runSequence(initial, operations));
+    return 0;
+}
@@ -0,0 +1,194 @@
+// 重采样的质量与速度：Resampler（多相、SSE）对比参考实现（双精度直接卷积，每个输出帧现算 sinc 与窗函数）
+// 以及最简单的线性插值
+// 用法：resampler_benchmark [秒数]
+// 质量以纯音的信噪比衡量：输出与按目标采样率直接生成的正弦波之差；降采样另测高于新奈奎斯特频率的纯音残留
+#include "core/resampler.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QtMath>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+namespace {
+
+const int Channels = 2;
+const double Amplitude = 0.5;
+
+// 参考实现：256 点 Blackman-Harris 窗 sinc，双精度，逐帧计算核函数
+std::vector<float> referenceResample(const std::vector<float> &in, int inRate, int outRate)
+{
+    const int half = 128;
+    const double ratio = double(inRate) / outRate;
+    const double fc = 0.475 * qMin(1.0, double(outRate) / inRate);
+    const int frames = int(in.size() / Channels);
+    const int outFrames = int((qint64(frames) * outRate + inRate - 1) / inRate);
+    std::vector<float> out(size_t(outFrames) * Channels, 0.0f);
+    const double width = half / qMin(1.0, double(outRate) / inRate);
+    for (int n = 0; n < outFrames; ++n) {
+        const double t = n * ratio;
+        const int first = qMax(0, int(std::ceil(t - width)));
+        const int last = qMin(frames - 1, int(std::floor(t + width)));
+        double acc[Channels] = {};
+        double norm = 0.0;
+        for (int j = first; j <= last; ++j) {
+            const double d = j - t;
+            const double x = 2.0 * fc * d;
+            const double sinc = qFuzzyIsNull(x) ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+            const double r = (d / width + 1.0) / 2.0;  // 0 ~ 1
+            const double window = 0.35875 - 0.48829 * std::cos(2 * M_PI * r) + 0.14128 * std::cos(4 * M_PI * r)
+                                - 0.01168 * std::cos(6 * M_PI * r);
+            const double h = 2.0 * fc * sinc * window;
+            norm += h;
+            for (int c = 0; c < Channels; ++c) {
+                acc[c] += h * in[size_t(j) * Channels + size_t(c)];
+            }
+        }
+        for (int c = 0; c < Channels; ++c) {
+            out[size_t(n) * Channels + size_t(c)] = float(acc[c] / norm);
+        }
+    }
+    return out;
+}
+
+std::vector<float> linearResample(const std::vector<float> &in, int inRate, int outRate)
+{
+    const double ratio = double(inRate) / outRate;
+    const int frames = int(in.size() / Channels);
+    const int outFrames = int((qint64(frames) * outRate + inRate - 1) / inRate);
+    std::vector<float> out(size_t(outFrames) * Channels);
+    for (int n = 0; n < outFrames; ++n) {
+        const double t = n * ratio;
+        const int j = qMin(int(t), frames - 1);
+        const int k = qMin(j + 1, frames - 1);
+        const float a = float(t - j);
+        for (int c = 0; c < Channels; ++c) {
+            const float x0 = in[size_t(j) * Channels + size_t(c)];
+            const float x1 = in[size_t(k) * Channels + size_t(c)];
+            out[size_t(n) * Channels + size_t(c)] = x0 + a * (x1 - x0);
+        }
+    }
+    return out;
+}
+
+std::vector<float> polyphaseResample(const std::vector<float> &in, int inRate, int outRate)
+{
+    Resampler resampler;
+    resampler.configure(inRate, Channels, outRate, Channels);
+    const int frames = int(in.size() / Channels);
+    std::vector<float> out(size_t(resampler.maxOutputFrames(frames) + resampler.maxOutputFrames(0)) * Channels);
+    // 按解码器缓冲区的大小分块送入
+    int produced = 0;
+    for (int done = 0; done < frames; done += 4096) {
+        const int n = qMin(4096, frames - done);
+        produced += resampler.process(in.data() + size_t(done) * Channels, n, out.data() + size_t(produced) * Channels);
+    }
+    produced += resampler.drain(out.data() + size_t(produced) * Channels);
+    out.resize(size_t(produced) * Channels);
+    return out;
+}
+
+std::vector<float> sine(double frequency, int rate, int frames)
+{
+    std::vector<float> samples(size_t(frames) * Channels);
+    for (int i = 0; i < frames; ++i) {
+        const float v = float(Amplitude * std::sin(2 * M_PI * frequency * i / rate));
+        for (int c = 0; c < Channels; ++c) {
+            samples[size_t(i) * Channels + size_t(c)] = v;
+        }
+    }
+    return samples;
+}
+
+// 去掉首尾各 0.1 秒（参考实现和线性插值的边界效应）后与理想正弦比较
+double snr(const std::vector<float> &out, double frequency, int rate)
+{
+    const int frames = int(out.size() / Channels);
+    double signal = 0.0;
+    double noise = 0.0;
+    for (int i = rate / 10; i < frames - rate / 10; ++i) {
+        const double ideal = Amplitude * std::sin(2 * M_PI * frequency * i / rate);
+        const double e = out[size_t(i) * Channels] - ideal;
+        signal += ideal * ideal;
+        noise += e * e;
+    }
+    return noise > 0 ? 10.0 * std::log10(signal / noise) : 200.0;
+}
+
+// 相对于满幅正弦（Amplitude）的残留电平
+double residual(const std::vector<float> &out, int rate)
+{
+    const int frames = int(out.size() / Channels);
+    double energy = 0.0;
+    int count = 0;
+    for (int i = rate / 10; i < frames - rate / 10; ++i, ++count) {
+        energy += double(out[size_t(i) * Channels]) * out[size_t(i) * Channels];
+    }
+    return 10.0 * std::log10(qMax(1e-30, energy / qMax(1, count)) / (Amplitude * Amplitude / 2));
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int seconds = args.size() > 1 ? qMax(1, args.at(1).toInt()) : 10;
+
+    QTextStream out(stdout);
+    out.setRealNumberNotation(QTextStream::FixedNotation);
+    out.setRealNumberPrecision(2);
+
+    using Method = std::function<std::vector<float>(const std::vector<float> &, int, int)>;
+    const struct { const char *name; Method run; bool timedFully; } methods[] = {
+        { "Resampler（多相 SSE）", polyphaseResample, true },
+        { "参考（双精度直接卷积）", referenceResample, false },
+        { "线性插值", linearResample, true },
+    };
+    const int rates[][2] = { { 44100, 48000 }, { 48000, 44100 }, { 88200, 48000 },
+                             { 96000, 48000 }, { 192000, 48000 }, { 22050, 48000 } };
+    const double tones[] = { 1000.0, 10000.0, 18000.0 };
+
+    for (const auto &pair : rates) {
+        const int inRate = pair[0];
+        const int outRate = pair[1];
+        Resampler probe;
+        probe.configure(inRate, Channels, outRate, Channels);
+        out << inRate << " -> " << outRate << " Hz（" << probe.phases() << " 相，每相 " << probe.tapsPerPhase()
+            << " 抽头）\n";
+
+        for (const auto &method : methods) {
+            // 速度：立体声噪声；参考实现太慢，只处理 1 秒
+            const int timedSeconds = method.timedFully ? seconds : 1;
+            std::vector<float> noise(size_t(inRate) * timedSeconds * Channels);
+            for (size_t i = 0; i < noise.size(); ++i) {
+                noise[i] = float((i * 2654435761u % 65536) / 65536.0 - 0.5);
+            }
+            QElapsedTimer timer;
+            timer.start();
+            const std::vector<float> result = method.run(noise, inRate, outRate);
+            const double msPerSecond = timer.nsecsElapsed() / 1e6 / timedSeconds;
+
+            out << "  " << method.name << "：" << msPerSecond << " 毫秒/秒音频，信噪比";
+            out.setRealNumberPrecision(1);
+            for (double tone : tones) {
+                if (tone >= qMin(inRate, outRate) * 0.45) {
+                    continue;
+                }
+                const std::vector<float> toneOut = method.run(sine(tone, inRate, inRate), inRate, outRate);
+                out << " " << int(tone) << "Hz " << snr(toneOut, tone, outRate) << "dB";
+            }
+            if (outRate * 0.6 < inRate * 0.45) {
+                // 高于输出奈奎斯特频率的纯音应被滤除（输入采样率要足够高才能表示这个频率）
+                const double alias = outRate * 0.6;
+                const std::vector<float> aliasOut = method.run(sine(alias, inRate, inRate), inRate, outRate);
+                out << "，" << int(alias) << "Hz 残留 " << residual(aliasOut, outRate) << "dB";
+            }
+            out.setRealNumberPrecision(2);
+            out << "\n";
+            Q_UNUSED(result);
+        }
+    }
+    return 0;
+}
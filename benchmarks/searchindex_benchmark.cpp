@@ -0,0 +1,105 @@
+// 音乐库搜索延迟：模拟在搜索框中逐字输入，统计每次按键的查询时间
+// 用法：searchindex_benchmark [歌曲数] [重复次数]
+// 目标：100 万首歌曲时每次按键（含首次输入和无结果的查询）都在 10 毫秒以内
+#include "models/musiclibrary.h"
+#include "models/searchindex.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QTextStream>
+#include <algorithm>
+
+namespace {
+
+const double TargetMs = 10.0;
+const int ResultLimit = 5000;  // 与主窗口的搜索结果上限一致
+
+// 模拟常见的音乐库：每张专辑 12 首放在同一目录，每位艺术家 4 张专辑，20 种流派
+MusicFile makeTrack(int i)
+{
+    const int album = i / 12;
+    const int artist = album / 4;
+    const QString artistName = QString("Artist %1").arg(artist);
+    const QString albumName = QString("Album %1").arg(album);
+
+    MusicFile file;
+    file.setFilePath(QString("/home/user/Music/%1/%2/%3 - Track %4.flac")
+                         .arg(artistName, albumName).arg(i % 12 + 1, 2, 10, QChar('0')).arg(i));
+    file.setTitle(QString("Track title %1").arg(i));
+    file.setArtist(artistName);
+    file.setAlbum(albumName);
+    file.setGenre(QString("Genre %1").arg(artist % 20));
+    file.setDuration(180000 + i % 120000);
+    file.setLastModified(QDateTime::fromMSecsSinceEpoch(1600000000000LL + i));
+    return file;
+}
+
+double median(QVector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    return samples.isEmpty() ? 0.0 : samples.at(samples.size() / 2);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int count = args.size() > 1 ? args.at(1).toInt() : 1000000;
+    const int repeats = args.size() > 2 ? qMax(1, args.at(2).toInt()) : 5;
+
+    QTextStream out(stdout);
+    out.setRealNumberNotation(QTextStream::FixedNotation);
+    out.setRealNumberPrecision(2);
+    out << "歌曲数 " << count << "，每组输入重复 " << repeats << " 次\n";
+
+    QElapsedTimer timer;
+    timer.start();
+    MusicLibrary library;
+    for (int i = 0; i < count; ++i) {
+        library.insert(makeTrack(i));
+    }
+    out << "建立音乐库 " << timer.elapsed() << " 毫秒\n";
+
+    timer.start();
+    SearchIndex index(&library);
+    out << "建立索引 " << timer.elapsed() << " 毫秒，文档 " << index.documentCount()
+        << "，词 " << index.tokenCount() << "\n";
+
+    // 每组是一次完整的输入过程；组与组之间清空搜索框，下一组的首字不能复用上次结果
+    const QStringList typed = {
+        QString("artist %1").arg(count / 48 / 2),
+        QString("track title %1").arg(count / 2),
+        QString("genre 7 album %1").arg(count / 12 / 3),
+        "itle 12345",   // 子串匹配
+        "flac 01",      // 路径中的词，命中数很多
+        "zzzz qqqq",    // 没有结果
+    };
+
+    double worst = 0.0;
+    for (const QString &text : typed) {
+        QVector<QVector<double>> samples(text.size());
+        QVector<int> hits(text.size());
+        for (int r = 0; r < repeats; ++r) {
+            index.search(QString());
+            for (int n = 1; n <= text.size(); ++n) {
+                const QStringList results = index.search(text.left(n), ResultLimit);
+                samples[n - 1].append(index.lastQueryMs());
+                hits[n - 1] = results.size();
+            }
+        }
+
+        out << "输入 \"" << text << "\"\n";
+        for (int n = 1; n <= text.size(); ++n) {
+            const double ms = median(samples.at(n - 1));
+            worst = qMax(worst, ms);
+            out << "  " << text.left(n).leftJustified(text.size() + 2) << ms << " 毫秒，"
+                << hits.at(n - 1) << " 首" << (ms > TargetMs ? "  超出目标" : "") << "\n";
+        }
+    }
+
+    out << "最慢的一次按键 " << worst << " 毫秒，目标 " << TargetMs << " 毫秒："
+        << (worst <= TargetMs ? "达到" : "未达到") << "\n";
+    return worst <= TargetMs ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+// 音乐库内存占用对比：QMap<QString, MusicFile>（原实现的布局）与 TrackStore（列式存储），
+// 以及整个程序中随歌曲数增长的部分（音乐库、排序视图、搜索索引）每首歌的占用
+// 用法：trackstore_benchmark [歌曲数]
+// 以 glibc 的 mallinfo2 统计堆内存增量；整体占用含后台线程分配的内存，改用 Linux 的常驻内存增量；
+// 其他平台只输出 TrackStore 自身的估算值
+#include "models/trackstore.h"
+#include "models/musiclibrary.h"
+#include "models/libraryview.h"
+#include "models/searchindex.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMap>
+#include <QThread>
+#include <QUrl>
+#include <QTextStream>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+namespace {
+
+// 原 MusicFile 的字段布局：路径另存一份 QUrl，艺术家、专辑、流派每首歌各一份
+struct LegacyTrack
+{
+    QString title;
+    QString artist;
+    QString album;
+    QString genre;
+    int duration = 0;
+    QUrl fileUrl;
+    QString filePath;
+    QDateTime lastModified;
+    quint64 contentHash = 0;
+    quint64 artHash = 0;
+    float trackLoudness = 0;
+    float trackPeak = 0;
+    float albumLoudness = 0;
+    float albumPeak = 0;
+    QDateTime dateAdded;
+    int playCount = 0;
+    int skipCount = 0;
+    QDateTime lastPlayed;
+};
+
+qint64 heapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return qint64(mallinfo2().uordblks);
+#elif defined(__GLIBC__)
+    return qint64(mallinfo().uordblks);
+#else
+    return -1;
+#endif
+}
+
+// 常驻内存（字节），先把空闲的堆内存还给系统，避免已释放的临时数据计入
+qint64 residentBytes()
+{
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+#if defined(Q_OS_LINUX)
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 1) {
+            return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+        }
+    }
+#endif
+    return -1;
+}
+
+// 模拟常见的音乐库：每张专辑 12 首放在同一目录，每位艺术家 4 张专辑，20 种流派
+MusicFile makeTrack(int i)
+{
+    const int album = i / 12;
+    const int artist = album / 4;
+    const QString artistName = QString("Artist %1").arg(artist);
+    const QString albumName = QString("Album %1").arg(album);
+
+    MusicFile file;
+    file.setFilePath(QString("/home/user/Music/%1/%2/%3 - Track %4.flac")
+                         .arg(artistName, albumName).arg(i % 12 + 1, 2, 10, QChar('0')).arg(i));
+    file.setTitle(QString("Track title %1").arg(i));
+    file.setArtist(artistName);
+    file.setAlbum(albumName);
+    file.setGenre(QString("Genre %1").arg(artist % 20));
+    file.setDuration(180000 + i % 120000);
+    file.setLastModified(QDateTime::fromMSecsSinceEpoch(1600000000000LL + i));
+    file.setDateAdded(QDateTime::fromMSecsSinceEpoch(1600000000000LL + i));
+    file.setContentHash(quint64(i) * 0x9e3779b97f4a7c15ULL | 1);
+    return file;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int count = args.size() > 1 ? args.at(1).toInt() : 1000000;
+
+    QTextStream out(stdout);
+    out.setRealNumberNotation(QTextStream::FixedNotation);
+    out.setRealNumberPrecision(1);
+    out << "歌曲数 " << count << "\n";
+
+    // 标题文字本身（每首都不同，两种布局都必须保存）
+    qint64 titleBytes = 0;
+    for (int i = 0; i < count; ++i) {
+        titleBytes += makeTrack(i).title().size() * qint64(sizeof(QChar));
+    }
+    const double titlePerTrack = double(titleBytes) / count;
+    out << "标题文字 " << titlePerTrack << " 字节/首\n";
+
+    QElapsedTimer timer;
+    {
+        const qint64 before = heapInUse();
+        timer.start();
+        QMap<QString, LegacyTrack> legacy;
+        for (int i = 0; i < count; ++i) {
+            const MusicFile file = makeTrack(i);
+            LegacyTrack track;
+            track.title = file.title();
+            track.artist = file.artist();
+            track.album = file.album();
+            track.genre = file.genre();
+            track.duration = file.duration();
+            track.filePath = file.filePath();
+            track.fileUrl = file.fileUrl();
+            track.lastModified = file.lastModified();
+            track.dateAdded = file.dateAdded();
+            track.contentHash = file.contentHash();
+            legacy.insert(track.filePath, track);
+        }
+        const double ms = timer.nsecsElapsed() / 1e6;
+        const qint64 used = heapInUse() - before;
+        if (used >= 0) {
+            out << "QMap<QString, MusicFile>  " << double(used) / count << " 字节/首，不含标题文字 "
+                << double(used) / count - titlePerTrack << "，建立 " << ms << " 毫秒\n";
+        }
+    }
+
+    {
+        const qint64 before = heapInUse();
+        timer.start();
+        TrackStore store;
+        for (int i = 0; i < count; ++i) {
+            store.insert(makeTrack(i));
+        }
+        const double ms = timer.nsecsElapsed() / 1e6;
+        const qint64 used = heapInUse() - before;
+        if (used >= 0) {
+            out << "TrackStore（实测）       " << double(used) / count << " 字节/首，不含标题文字 "
+                << double(used) / count - titlePerTrack << "，建立 " << ms << " 毫秒\n";
+        }
+        out << "TrackStore（估算）       " << double(store.bytesUsed()) / count << " 字节/首，不含标题文字 "
+            << double(store.bytesUsed() - store.titleBytes()) / count << "\n";
+
+        // 按路径查找的速度
+        timer.start();
+        qint64 found = 0;
+        for (int i = 0; i < count; i += 7) {
+            found += store.find(makeTrack(i).filePath()) >= 0;
+        }
+        out << "按路径查找 " << found << " 次，" << timer.nsecsElapsed() / 1e6 << " 毫秒（含生成路径）\n";
+    }
+
+    // 整个程序：音乐库载入后依次建立搜索索引和排序视图（按艺术家 → 专辑 → 标题），逐项统计增量
+    {
+        const qint64 start = residentBytes();
+        MusicLibrary library;
+        for (int i = 0; i < count; ++i) {
+            library.insert(makeTrack(i));
+        }
+        const qint64 afterLibrary = residentBytes();
+
+        timer.start();
+        SearchIndex index(&library);
+        const double indexMs = timer.nsecsElapsed() / 1e6;
+        const qint64 afterIndex = residentBytes();
+
+        timer.start();
+        LibraryView view(&library);
+        view.setSortKeys({LibraryView::Artist, LibraryView::Album, LibraryView::Title});
+        while (view.count() < library.count() || view.isSorting()) {
+            QCoreApplication::processEvents();
+            QThread::msleep(1);
+        }
+        const double viewMs = timer.nsecsElapsed() / 1e6;
+        const qint64 afterView = residentBytes();
+
+        if (start >= 0) {
+            out << "音乐库（常驻内存）       " << double(afterLibrary - start) / count << " 字节/首\n";
+            out << "搜索索引                 " << double(afterIndex - afterLibrary) / count
+                << " 字节/首，建立 " << indexMs << " 毫秒\n";
+            out << "排序视图                 " << double(afterView - afterIndex) / count
+                << " 字节/首，载入并排序 " << viewMs << " 毫秒\n";
+            out << "整个程序合计             " << double(afterView - start) / count
+                << " 字节/首，不含标题文字 " << double(afterView - start) / count - titlePerTrack << "\n";
+        }
+        out << "TrackStore（估算）       " << double(library.memoryUsage()) / count << " 字节/首\n";
+    }
+    return 0;
+}
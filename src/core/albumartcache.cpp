@@ -0,0 +1,426 @@
+#include "albumartcache.h"
+#include "audiotagreader.h"
+#include "contenthash.h"
+#include "ioscheduler.h"
+#include "models/musiclibrary.h"
+#include <QThreadPool>
+#include <QThread>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include <QDir>
+#include <QBuffer>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QMutex>
+#include <QSet>
+#include <QVector>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+const quint32 IndexMagic = 0x59594154;  // "YYAT"
+const quint32 IndexVersion = 1;
+const int SlotBytes = AlbumArtCache::ThumbnailSize * AlbumArtCache::ThumbnailSize * 4;
+const int SlotsPerChunk = 64;           // 每块 4 MiB
+const qint64 ChunkBytes = qint64(SlotBytes) * SlotsPerChunk;
+
+// 缩小解码：JPEG 等格式可以在解码阶段直接按比例缩小，不必先解出整张大图
+QImage decodeThumbnail(const QByteArray &data)
+{
+    QByteArray bytes = data;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer);
+
+    const QSize bounds(AlbumArtCache::ThumbnailSize, AlbumArtCache::ThumbnailSize);
+    QSize size = reader.size();
+    if (size.isValid() && (size.width() > bounds.width() || size.height() > bounds.height())) {
+        reader.setScaledSize(size.scaled(bounds, Qt::KeepAspectRatio));
+    }
+
+    QImage image = reader.read();
+    if (image.isNull()) {
+        return image;
+    }
+    if (image.width() > bounds.width() || image.height() > bounds.height()) {
+        image = image.scaled(bounds, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    return image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+quint64 artworkHash(const QByteArray &data)
+{
+    quint64 hash = ContentHasher::hash(data.constData(), data.size());
+    // 0 表示未检查，1 表示没有封面
+    return hash <= AlbumArtCache::NoArtwork ? hash + 2 : hash;
+}
+
+} // namespace
+
+struct AlbumArtCache::Job
+{
+    QStringList paths;
+    std::atomic<int> next{0};
+    std::atomic<int> activeWorkers{0};
+    std::atomic<bool> canceled{false};
+
+    QMutex mutex;
+    QSet<quint64> claimed;                // 已在图集中或正在解码的封面
+    QHash<QString, quint64> folderHashes; // 目录封面只读取一次
+
+    // 返回 true 表示由调用者负责解码
+    bool claim(quint64 hash)
+    {
+        QMutexLocker locker(&mutex);
+        if (claimed.contains(hash)) {
+            return false;
+        }
+        claimed.insert(hash);
+        return true;
+    }
+};
+
+AlbumArtCache::AlbumArtCache(MusicLibrary *library, QObject *parent)
+    : QObject(parent)
+    , m_library(library)
+    , m_pool(new QThreadPool(this))
+    , m_indexDirty(false)
+{
+    // 封面提取是后台任务，不与响度分析、哈希计算争抢太多线程
+    m_pool->setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QDir().mkpath(cacheDir);
+    m_atlas.setFileName(cacheDir + "/artwork.atlas");
+    m_indexPath = cacheDir + "/artwork.index";
+
+    if (openAtlas()) {
+        loadIndex();
+    }
+}
+
+AlbumArtCache::~AlbumArtCache()
+{
+    cancel();
+    m_pool->waitForDone();
+    if (m_indexDirty) {
+        saveIndex();
+    }
+}
+
+void AlbumArtCache::extractMissing()
+{
+    extract(m_library->filesWithoutArt());
+}
+
+void AlbumArtCache::extract(const QStringList &filePaths)
+{
+    cancel();
+
+    auto job = std::make_shared<Job>();
+    job->paths = filePaths;
+    for (auto it = m_slots.constBegin(); it != m_slots.constEnd(); ++it) {
+        job->claimed.insert(it.key());
+    }
+    m_job = job;
+
+    if (filePaths.isEmpty()) {
+        m_job.reset();
+        emit finished(false);
+        return;
+    }
+
+    int workers = qMin(m_pool->maxThreadCount(), filePaths.size());
+    job->activeWorkers = workers;
+    for (int i = 0; i < workers; ++i) {
+        m_pool->start([this, job]() {
+            forever {
+                if (job->canceled) {
+                    break;
+                }
+                int index = job->next.fetch_add(1);
+                if (index >= job->paths.size()) {
+                    break;
+                }
+
+                const QString filePath = job->paths.at(index);
+                QByteArray data;
+                {
+                    ScheduledFile file(filePath, &job->canceled);
+                    if (file.open(QIODevice::ReadOnly)) {
+                        data = AudioTagReader::embeddedCover(&file);
+                    }
+                }
+
+                quint64 hash = NoArtwork;
+                if (!data.isEmpty()) {
+                    hash = artworkHash(data);
+                } else {
+                    // 同一目录的歌曲共用目录封面
+                    const QString directory = QFileInfo(filePath).absolutePath();
+                    QMutexLocker locker(&job->mutex);
+                    auto it = job->folderHashes.constFind(directory);
+                    if (it != job->folderHashes.constEnd()) {
+                        hash = it.value();
+                    } else {
+                        locker.unlock();
+                        const QString coverPath = folderCoverPath(directory);
+                        ScheduledFile cover(coverPath, &job->canceled);
+                        if (!coverPath.isEmpty() && cover.open(QIODevice::ReadOnly)) {
+                            data = cover.readAll();
+                            hash = artworkHash(data);
+                        }
+                        locker.relock();
+                        job->folderHashes.insert(directory, hash);
+                    }
+                }
+
+                QImage thumbnail;
+                if (hash != NoArtwork && !data.isEmpty() && job->claim(hash)) {
+                    thumbnail = decodeThumbnail(data);
+                    if (thumbnail.isNull()) {
+                        qDebug() << "无法解码封面:" << filePath;
+                    }
+                }
+
+                QMetaObject::invokeMethod(this, [this, job, filePath, hash, thumbnail]() {
+                    onArtworkExtracted(job, filePath, hash, thumbnail);
+                }, Qt::QueuedConnection);
+            }
+            QMetaObject::invokeMethod(this, [this, job]() {
+                onWorkerFinished(job);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+void AlbumArtCache::cancel()
+{
+    if (!m_job) {
+        return;
+    }
+    m_job->canceled = true;
+    m_job.reset();
+    emit finished(true);
+}
+
+bool AlbumArtCache::isRunning() const
+{
+    return m_job != nullptr;
+}
+
+bool AlbumArtCache::contains(quint64 artHash) const
+{
+    return m_slots.contains(artHash);
+}
+
+QImage AlbumArtCache::thumbnail(quint64 artHash) const
+{
+    auto it = m_slots.constFind(artHash);
+    if (it == m_slots.constEnd()) {
+        return QImage();
+    }
+    // 只读构造，图像直接引用映射内存，图集在对象销毁前不会解除映射
+    const uchar *data = slotData(it->index);
+    return QImage(data, it->width, it->height, ThumbnailSize * 4, QImage::Format_ARGB32_Premultiplied);
+}
+
+QImage AlbumArtCache::fullImage(const QString &filePath)
+{
+    return QImage::fromData(coverData(filePath));
+}
+
+QByteArray AlbumArtCache::coverData(const QString &filePath)
+{
+    QFile file(filePath);
+    if (file.open(QIODevice::ReadOnly)) {
+        QByteArray data = AudioTagReader::embeddedCover(&file);
+        if (!data.isEmpty()) {
+            return data;
+        }
+    }
+
+    QFile cover(folderCoverPath(QFileInfo(filePath).absolutePath()));
+    if (!cover.fileName().isEmpty() && cover.open(QIODevice::ReadOnly)) {
+        return cover.readAll();
+    }
+    return QByteArray();
+}
+
+QString AlbumArtCache::folderCoverPath(const QString &directory)
+{
+    // 名称过滤不区分大小写，cover 优先于 folder
+    static const QStringList names = {
+        "cover.jpg", "cover.jpeg", "cover.png",
+        "folder.jpg", "folder.jpeg", "folder.png"
+    };
+    QDir dir(directory);
+    const QStringList entries = dir.entryList(names, QDir::Files | QDir::Readable);
+    for (const QString &name : names) {
+        for (const QString &entry : entries) {
+            if (entry.compare(name, Qt::CaseInsensitive) == 0) {
+                return dir.filePath(entry);
+            }
+        }
+    }
+    return QString();
+}
+
+int AlbumArtCache::thumbnailCount() const
+{
+    return m_slots.size();
+}
+
+qint64 AlbumArtCache::atlasBytes() const
+{
+    return qint64(m_chunks.size()) * ChunkBytes;
+}
+
+void AlbumArtCache::onArtworkExtracted(const std::shared_ptr<Job> &job, const QString &filePath,
+                                       quint64 artHash, const QImage &thumbnail)
+{
+    if (job != m_job) {
+        return;
+    }
+
+    if (!thumbnail.isNull() && !store(artHash, thumbnail)) {
+        return;  // 图集不可用，下次启动再试
+    }
+    m_library->setArtHash(filePath, artHash);
+    emit artworkReady(filePath, artHash);
+}
+
+void AlbumArtCache::onWorkerFinished(const std::shared_ptr<Job> &job)
+{
+    if (--job->activeWorkers > 0 || job != m_job) {
+        return;
+    }
+    m_job.reset();
+    if (m_indexDirty) {
+        saveIndex();
+    }
+    emit finished(false);
+}
+
+bool AlbumArtCache::store(quint64 artHash, const QImage &thumbnail)
+{
+    if (m_slots.contains(artHash)) {
+        return true;
+    }
+
+    const int index = m_slots.size();
+    if (index >= m_chunks.size() * SlotsPerChunk && !mapChunk()) {
+        return false;
+    }
+
+    uchar *slot = slotData(index);
+    const int rowBytes = thumbnail.width() * 4;
+    for (int y = 0; y < thumbnail.height(); ++y) {
+        std::memcpy(slot + y * ThumbnailSize * 4, thumbnail.constScanLine(y), rowBytes);
+    }
+
+    m_slots.insert(artHash, Slot{index, quint16(thumbnail.width()), quint16(thumbnail.height())});
+    m_indexDirty = true;
+    return true;
+}
+
+uchar *AlbumArtCache::slotData(int index) const
+{
+    return m_chunks.at(index / SlotsPerChunk) + qint64(index % SlotsPerChunk) * SlotBytes;
+}
+
+bool AlbumArtCache::openAtlas()
+{
+    if (!m_atlas.open(QIODevice::ReadWrite)) {
+        qDebug() << "无法打开封面图集:" << m_atlas.fileName() << m_atlas.errorString();
+        return false;
+    }
+
+    // 只映射完整的块，末尾不完整的部分在下次扩容时覆盖
+    const int chunks = int(m_atlas.size() / ChunkBytes);
+    for (int i = 0; i < chunks; ++i) {
+        uchar *data = m_atlas.map(qint64(i) * ChunkBytes, ChunkBytes);
+        if (!data) {
+            qDebug() << "无法映射封面图集:" << m_atlas.errorString();
+            return false;
+        }
+        m_chunks.append(data);
+    }
+    return true;
+}
+
+bool AlbumArtCache::mapChunk()
+{
+    if (!m_atlas.isOpen()) {
+        return false;
+    }
+    const qint64 offset = qint64(m_chunks.size()) * ChunkBytes;
+    if (!m_atlas.resize(offset + ChunkBytes)) {
+        qDebug() << "无法扩展封面图集:" << m_atlas.errorString();
+        return false;
+    }
+    uchar *data = m_atlas.map(offset, ChunkBytes);
+    if (!data) {
+        qDebug() << "无法映射封面图集:" << m_atlas.errorString();
+        return false;
+    }
+    m_chunks.append(data);
+    return true;
+}
+
+void AlbumArtCache::loadIndex()
+{
+    QFile file(m_indexPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream in(&file);
+    quint32 magic = 0, version = 0;
+    qint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != IndexMagic || version != IndexVersion || count < 0) {
+        return;
+    }
+
+    const int capacity = m_chunks.size() * SlotsPerChunk;
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        quint64 hash;
+        qint32 index;
+        quint16 width, height;
+        in >> hash >> index >> width >> height;
+        // 索引必须连续且落在已映射的范围内，否则丢弃后面的条目
+        if (in.status() != QDataStream::Ok || index != i || index >= capacity
+            || width > ThumbnailSize || height > ThumbnailSize) {
+            break;
+        }
+        m_slots.insert(hash, Slot{index, width, height});
+    }
+}
+
+bool AlbumArtCache::saveIndex()
+{
+    // 按槽位顺序写出，加载时据此校验
+    QVector<quint64> hashes(m_slots.size());
+    for (auto it = m_slots.constBegin(); it != m_slots.constEnd(); ++it) {
+        hashes[it->index] = it.key();
+    }
+
+    QSaveFile file(m_indexPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out << IndexMagic << IndexVersion << qint32(hashes.size());
+    for (int i = 0; i < hashes.size(); ++i) {
+        const Slot slot = m_slots.value(hashes[i]);
+        out << hashes[i] << qint32(i) << slot.width << slot.height;
+    }
+    if (!file.commit()) {
+        return false;
+    }
+    m_indexDirty = false;
+    return true;
+}
@@ -0,0 +1,84 @@
+#ifndef ALBUMARTCACHE_H
+#define ALBUMARTCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QImage>
+#include <QFile>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+
+class QThreadPool;
+class MusicLibrary;
+
+// 专辑封面缩略图缓存
+// 扫描时在工作线程中提取内嵌封面或目录下的 cover.jpg/folder.jpg，缩小后写入内存映射的图集文件。
+// 图集以图片内容哈希为键，同一张封面只保存一次；界面读取缩略图时直接引用映射内存，不需要解码。
+class AlbumArtCache : public QObject
+{
+    Q_OBJECT
+public:
+    static const int ThumbnailSize = 128;
+    static const quint64 NoArtwork = 1;  // 已检查但没有封面
+
+    explicit AlbumArtCache(MusicLibrary *library, QObject *parent = nullptr);
+    ~AlbumArtCache();
+
+    // 为音乐库中尚未检查过封面的文件提取封面
+    void extractMissing();
+    void extract(const QStringList &filePaths);
+    void cancel();
+    bool isRunning() const;
+
+    // 缩略图，图像数据直接指向映射内存，没有封面时返回空图像
+    bool contains(quint64 artHash) const;
+    QImage thumbnail(quint64 artHash) const;
+
+    // 按需解码原始分辨率的封面，会读取文件，只在需要显示大图时调用
+    static QImage fullImage(const QString &filePath);
+
+    // 读取文件的封面原始数据：内嵌封面优先，其次是同目录下的封面图片
+    static QByteArray coverData(const QString &filePath);
+    static QString folderCoverPath(const QString &directory);
+
+    // 统计
+    int thumbnailCount() const;
+    qint64 atlasBytes() const;
+
+signals:
+    void artworkReady(const QString &filePath, quint64 artHash);
+    void finished(bool canceled);
+
+private:
+    struct Job;
+    struct Slot
+    {
+        int index;
+        quint16 width;
+        quint16 height;
+    };
+
+    void onArtworkExtracted(const std::shared_ptr<Job> &job, const QString &filePath,
+                            quint64 artHash, const QImage &thumbnail);
+    void onWorkerFinished(const std::shared_ptr<Job> &job);
+    bool store(quint64 artHash, const QImage &thumbnail);
+    uchar *slotData(int index) const;
+    bool openAtlas();
+    bool mapChunk();
+    void loadIndex();
+    bool saveIndex();
+
+private:
+    MusicLibrary *m_library;  // 不拥有此指针
+    QThreadPool *m_pool;
+    std::shared_ptr<Job> m_job;
+    QFile m_atlas;
+    QList<uchar *> m_chunks;      // 每块单独映射，扩容时已有指针保持有效
+    QHash<quint64, Slot> m_slots;
+    QString m_indexPath;
+    bool m_indexDirty;
+};
+
+#endif // ALBUMARTCACHE_H
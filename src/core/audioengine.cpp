@@ -0,0 +1,904 @@
+#include "audioengine.h"
+#include "pcmdecoder.h"
+#include "ioscheduler.h"
+#include <QAudioDecoder>
+#include <QAudioBuffer>
+#include <QAudioDeviceInfo>
+#include <QAudioOutput>
+#include <QFile>
+#include <QIODevice>
+#include <QThread>
+#include <QDebug>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+namespace {
+const int RingSamples = 1 << 19;       // 约 5.5 秒的 48kHz 立体声
+const int TapSamples = 1 << 15;        // 频谱副本，约 0.34 秒的 48kHz 立体声，足够界面一帧取用
+const int OutputBufferMs = 200;        // 输出设备缓冲区长度
+const int MaxReadFrames = 4096;        // 每次 readData() 最多处理的帧数
+const int TickInterval = 20;
+const int NotifyInterval = 1000;       // positionChanged 的间隔，与 QMediaPlayer 默认值一致
+const int DeviceSampleRate = 48000;    // 设备没有首选采样率时使用
+
+qint64 clockNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
+// 输出设备以拉模式读取的数据源，readData() 在音频线程中运行：
+// 从环形缓冲区取样本，经 DSP 链处理后转换为设备格式；数据不足时补静音，保持设备一直运行
+// 启用副本时把处理后的样本另写一份到 tap，写不下的直接丢弃，音频线程从不等待
+class PullDevice : public QIODevice
+{
+public:
+    PullDevice(PcmRing *ring, PcmRing *tap, DspChain *dsp, QObject *parent)
+        : QIODevice(parent)
+        , playedFrames(0)
+        , latencyFrames(0)
+        , firstAudioNs(0)
+        , inputEnded(false)
+        , drained(false)
+        , underruns(0)
+        , tapEnabled(false)
+        , m_ring(ring)
+        , m_tap(tap)
+        , m_dsp(dsp)
+        , m_channels(0)
+        , m_floatOutput(true)
+        , m_silentFrames(0)
+    {
+    }
+
+    void configure(int channels, bool floatOutput)
+    {
+        m_channels = channels;
+        m_floatOutput = floatOutput;
+        m_scratch.assign(size_t(MaxReadFrames) * size_t(channels), 0.0f);
+    }
+
+    void resetCounters()
+    {
+        playedFrames.store(0, std::memory_order_relaxed);
+        firstAudioNs.store(0, std::memory_order_relaxed);
+        inputEnded.store(false, std::memory_order_relaxed);
+        drained.store(false, std::memory_order_relaxed);
+        m_silentFrames = 0;
+    }
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override
+    {
+        // 不足的部分补静音，对设备来说总是有数据
+        return qint64(MaxReadFrames) * m_channels * bytesPerSample() + QIODevice::bytesAvailable();
+    }
+
+    std::atomic<qint64> playedFrames;   // 本段（换歌或跳转后）已送入设备的帧数
+    std::atomic<qint64> latencyFrames;  // 设备缓冲区的长度
+    std::atomic<qint64> firstAudioNs;   // 本段第一次送出有效数据的时间（clockNs），用于统计跳转延迟
+    std::atomic<bool> inputEnded;       // 解码已结束，缓冲区中是最后的数据
+    std::atomic<bool> drained;          // 最后的数据已从设备播放完毕
+    std::atomic<int> underruns;
+    std::atomic<bool> tapEnabled;
+
+protected:
+    qint64 readData(char *data, qint64 maxlen) override
+    {
+        const int bytesPerFrame = m_channels * bytesPerSample();
+        if (bytesPerFrame == 0) {
+            return 0;
+        }
+        const int frames = int(qMin<qint64>(maxlen / bytesPerFrame, MaxReadFrames));
+        if (frames == 0) {
+            return 0;
+        }
+
+        float *samples = m_scratch.data();
+        const int got = m_ring->read(samples, frames * m_channels) / m_channels;
+        if (got > 0) {
+            m_dsp->process(samples, got);
+            if (playedFrames.fetch_add(got, std::memory_order_relaxed) == 0) {
+                firstAudioNs.store(clockNs(), std::memory_order_relaxed);
+            }
+            if (tapEnabled.load(std::memory_order_relaxed)) {
+                int count = qMin(got * m_channels, m_tap->writeAvailable());
+                count -= count % m_channels;
+                m_tap->write(samples, count);
+            }
+        }
+        if (got < frames) {
+            std::fill(samples + got * m_channels, samples + frames * m_channels, 0.0f);
+            if (inputEnded.load(std::memory_order_acquire) && m_ring->readAvailable() == 0) {
+                // 最后的数据还在设备缓冲区中，再送入一个缓冲区长度的静音后才算播放完毕
+                m_silentFrames += frames - got;
+                if (m_silentFrames >= latencyFrames.load(std::memory_order_relaxed)) {
+                    drained.store(true, std::memory_order_release);
+                }
+            } else if (got > 0) {
+                underruns.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        if (m_floatOutput) {
+            std::memcpy(data, samples, size_t(frames) * size_t(bytesPerFrame));
+        } else {
+            convertSamples(samples, reinterpret_cast<qint16 *>(data), frames * m_channels);
+        }
+        return qint64(frames) * bytesPerFrame;
+    }
+
+    qint64 writeData(const char *data, qint64 len) override
+    {
+        Q_UNUSED(data);
+        Q_UNUSED(len);
+        return -1;
+    }
+
+private:
+    int bytesPerSample() const
+    {
+        return m_floatOutput ? SampleFormat<float>::Bytes : SampleFormat<qint16>::Bytes;
+    }
+
+    PcmRing *m_ring;
+    PcmRing *m_tap;
+    DspChain *m_dsp;
+    int m_channels;
+    bool m_floatOutput;
+    qint64 m_silentFrames;  // 数据播完后补的静音帧数
+    std::vector<float> m_scratch;
+};
+
+// 跳转时交给解码器的数据源：文件头（FLAC 的 STREAMINFO，MP3 为空）后面接着从跳转点开始的文件内容，
+// 解码器看到的是一个从帧边界开始的完整文件，不需要从头解码
+class SeekSource : public QIODevice
+{
+public:
+    SeekSource(const QString &filePath, const QByteArray &header, qint64 offset, QObject *parent)
+        : QIODevice(parent)
+        , m_file(filePath)
+        , m_header(header)
+        , m_offset(offset)
+    {
+    }
+
+    bool open(OpenMode mode) override
+    {
+        if (!m_file.open(QIODevice::ReadOnly) || m_offset > m_file.size()) {
+            return false;
+        }
+        // 不使用 QIODevice 的缓冲，readData() 中的 pos() 就是要读取的位置
+        return QIODevice::open(mode | QIODevice::Unbuffered);
+    }
+
+    void close() override
+    {
+        m_file.close();
+        QIODevice::close();
+    }
+
+    bool isSequential() const override { return false; }
+    qint64 size() const override { return m_header.size() + m_file.size() - m_offset; }
+
+protected:
+    qint64 readData(char *data, qint64 maxlen) override
+    {
+        qint64 position = pos();
+        qint64 done = 0;
+        if (position < m_header.size()) {
+            done = qMin<qint64>(maxlen, m_header.size() - position);
+            std::memcpy(data, m_header.constData() + position, size_t(done));
+            position += done;
+        }
+        if (done < maxlen) {
+            if (!m_file.seek(m_offset + position - m_header.size())) {
+                return done > 0 ? done : -1;
+            }
+            const qint64 n = m_file.read(data + done, maxlen - done);
+            if (n < 0) {
+                return done > 0 ? done : -1;
+            }
+            done += n;
+        }
+        return done;
+    }
+
+    qint64 writeData(const char *data, qint64 len) override
+    {
+        Q_UNUSED(data);
+        Q_UNUSED(len);
+        return -1;
+    }
+
+private:
+    QFile m_file;
+    QByteArray m_header;
+    qint64 m_offset;
+};
+
+// 住在输出线程中的对象，拥有 QAudioOutput；所有方法都通过阻塞的队列调用在输出线程中执行，
+// 执行时 readData() 不会同时运行，因此可以安全地清空环形缓冲区和 DSP 状态
+class AudioOutputWorker : public QObject
+{
+public:
+    AudioOutputWorker(PcmRing *ring, PcmRing *tap, DspChain *dsp)
+        : device(new PullDevice(ring, tap, dsp, this))
+        , m_ring(ring)
+        , m_dsp(dsp)
+        , m_output(nullptr)
+    {
+    }
+
+    PullDevice *device;  // 随本对象移到输出线程
+
+    // 按设备首选的采样率（没有时用 48kHz）打开立体声输出，优先 float，其次 16 位整数；
+    // 失败时返回无效格式
+    QAudioFormat open()
+    {
+        if (m_output) {
+            return m_format;
+        }
+        const QAudioDeviceInfo info = QAudioDeviceInfo::defaultOutputDevice();
+        const QAudioFormat preferred = info.preferredFormat();
+        const int channels = qBound(1, preferred.channelCount(), 2);
+        QList<int> rates;
+        if (preferred.sampleRate() > 0) {
+            rates << preferred.sampleRate();
+        }
+        rates << DeviceSampleRate << 44100;
+
+        QAudioFormat format;
+        format.setChannelCount(channels);
+        format.setCodec("audio/pcm");
+        format.setByteOrder(QAudioFormat::LittleEndian);
+        bool supported = false;
+        for (int rate : qAsConst(rates)) {
+            format.setSampleRate(rate);
+            format.setSampleType(QAudioFormat::Float);
+            format.setSampleSize(32);
+            if (info.isFormatSupported(format)) {
+                supported = true;
+                break;
+            }
+            format.setSampleType(QAudioFormat::SignedInt);
+            format.setSampleSize(16);
+            if (info.isFormatSupported(format)) {
+                supported = true;
+                break;
+            }
+        }
+        if (!supported) {
+            qDebug() << "输出设备不支持任何可用格式:" << info.deviceName();
+            return QAudioFormat();
+        }
+
+        qDebug() << "打开音频输出:" << info.deviceName() << format;
+        m_format = format;
+        m_output = new QAudioOutput(info, format, this);
+        m_output->setBufferSize(format.bytesForDuration(OutputBufferMs * 1000));
+        device->configure(format.channelCount(), format.sampleType() == QAudioFormat::Float);
+        device->open(QIODevice::ReadOnly);
+        device->latencyFrames.store(format.framesForDuration(OutputBufferMs * 1000), std::memory_order_relaxed);
+        m_dsp->prepare(format.sampleRate(), format.channelCount());
+        return format;
+    }
+
+    void start()
+    {
+        if (!m_output) {
+            return;
+        }
+        if (m_output->state() == QAudio::SuspendedState) {
+            m_output->resume();
+        } else if (m_output->state() == QAudio::StoppedState) {
+            m_output->start(device);
+        }
+    }
+
+    void suspend()
+    {
+        if (m_output && m_output->state() == QAudio::ActiveState) {
+            m_output->suspend();
+        }
+    }
+
+    void flush()
+    {
+        // 丢弃设备中尚未播放的数据，下次 start() 重新开始拉取
+        if (m_output && m_output->state() != QAudio::StoppedState) {
+            m_output->stop();
+        }
+        m_ring->clear();
+        m_dsp->reset();
+        device->resetCounters();
+    }
+
+    void close()
+    {
+        if (m_output) {
+            m_output->stop();
+            delete m_output;
+            m_output = nullptr;
+        }
+        device->close();
+    }
+
+private:
+    PcmRing *m_ring;
+    DspChain *m_dsp;
+    QAudioOutput *m_output;
+    QAudioFormat m_format;
+};
+
+AudioEngine::AudioEngine(QObject *parent)
+    : QObject(parent)
+    , m_decoder(new QAudioDecoder(this))
+    , m_fallback(nullptr)
+    , m_source(nullptr)
+    , m_outputThread(new QThread(this))
+    , m_worker(nullptr)
+    , m_ring(RingSamples)
+    , m_tap(TapSamples)
+    , m_state(QMediaPlayer::StoppedState)
+    , m_status(QMediaPlayer::NoMedia)
+    , m_duration(0)
+    , m_pendingOffset(0)
+    , m_seekTarget(0)
+    , m_originSample(0)
+    , m_skipFrames(-1)
+    , m_decodeFinished(false)
+    , m_notifiedPosition(-1)
+    , m_seekStartedNs(0)
+    , m_previewMs(0)
+{
+    m_worker = new AudioOutputWorker(&m_ring, &m_tap, &m_dsp);
+    m_worker->moveToThread(m_outputThread);
+    m_outputThread->setObjectName("AudioOutput");
+    m_outputThread->start(QThread::TimeCriticalPriority);
+
+    connect(m_decoder, &QAudioDecoder::bufferReady, this, &AudioEngine::pump);
+    connect(m_decoder, &QAudioDecoder::finished, this, &AudioEngine::onDecoderFinished);
+    connect(m_decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error),
+            this, &AudioEngine::onDecoderError);
+    connect(m_decoder, &QAudioDecoder::durationChanged, this, [this](qint64 duration) {
+        // 从中间开始解码时解码器估计的时长不可靠（MP3 按剩余字节数估计），以跳转表为准
+        if (m_source && !m_seekTable.isEmpty()) {
+            return;
+        }
+        if (duration > 0 && duration != m_duration) {
+            m_duration = duration;
+            emit durationChanged(duration);
+        }
+    });
+
+    m_tick.setInterval(TickInterval);
+    connect(&m_tick, &QTimer::timeout, this, &AudioEngine::onTick);
+
+    if (!PcmDecoder::isAvailable()) {
+        useFallback();
+    }
+}
+
+void AudioEngine::useFallback()
+{
+    qWarning() << "QAudioDecoder 不可用，改用 QMediaPlayer 播放，均衡器和频谱不起作用";
+    m_fallback = new QMediaPlayer(this);
+    m_fallback->setVolume(qBound(0, qRound(m_dsp.gain() * 100), 100));
+    // 状态和状态变化直接沿用，MusicPlayer 看到的与原来使用 QMediaPlayer 时相同
+    connect(m_fallback, &QMediaPlayer::stateChanged, this, &AudioEngine::setState);
+    connect(m_fallback, &QMediaPlayer::mediaStatusChanged, this, &AudioEngine::setStatus);
+    connect(m_fallback, &QMediaPlayer::positionChanged, this, &AudioEngine::positionChanged);
+    connect(m_fallback, &QMediaPlayer::durationChanged, this, [this](qint64 duration) {
+        m_duration = duration;
+        emit durationChanged(duration);
+    });
+    connect(m_fallback, QOverload<QMediaPlayer::Error>::of(&QMediaPlayer::error), this, [this]() {
+        m_errorString = m_fallback->errorString();
+        emit error(m_errorString);
+    });
+}
+
+AudioEngine::~AudioEngine()
+{
+    m_decoder->stop();
+    QMetaObject::invokeMethod(m_worker, [this]() { m_worker->close(); }, Qt::BlockingQueuedConnection);
+    m_outputThread->quit();
+    m_outputThread->wait();
+    delete m_worker;
+}
+
+void AudioEngine::setMedia(const QUrl &media, const TrackHead &head)
+{
+    if (m_fallback) {
+        m_media = media;
+        m_errorString.clear();
+        m_fallback->setMedia(QMediaContent(media));
+        return;
+    }
+    stopDecoder();
+    flushOutput();
+    m_media = media;
+    m_seekTable = SeekTable();
+    m_format = QAudioFormat();
+    m_seekStartedNs = 0;
+    m_previewMs = 0;
+    m_errorString.clear();
+    m_notifiedPosition = -1;
+    if (m_duration != 0) {
+        m_duration = 0;
+        emit durationChanged(0);
+    }
+    setState(QMediaPlayer::StoppedState);
+
+    if (media.isEmpty()) {
+        m_tick.stop();
+        setStatus(QMediaPlayer::NoMedia);
+        return;
+    }
+    setStatus(QMediaPlayer::LoadingMedia);
+    startDecoder(0);
+    if (!head.isEmpty()) {
+        queueHead(head);
+    }
+}
+
+void AudioEngine::play()
+{
+    if (m_fallback) {
+        m_fallback->play();
+        return;
+    }
+    if (m_media.isEmpty() || m_status == QMediaPlayer::InvalidMedia) {
+        return;
+    }
+    if (m_status == QMediaPlayer::EndOfMedia) {
+        // 播放结束后再次播放从头开始（单曲循环）
+        flushOutput();
+        startDecoder(0);
+        setStatus(QMediaPlayer::BufferingMedia);
+    }
+    m_previewMs = 0;
+    setState(QMediaPlayer::PlayingState);
+    // 格式确定之前还没有打开设备，第一个缓冲区到达后开始输出
+    if (m_format.isValid()) {
+        startOutput();
+    }
+}
+
+void AudioEngine::pause()
+{
+    if (m_fallback) {
+        m_fallback->pause();
+        return;
+    }
+    if (m_state != QMediaPlayer::PlayingState) {
+        return;
+    }
+    suspendOutput();
+    m_seekStartedNs = 0;
+    setState(QMediaPlayer::PausedState);
+}
+
+void AudioEngine::stop()
+{
+    if (m_fallback) {
+        m_fallback->stop();
+        return;
+    }
+    if (m_state == QMediaPlayer::StoppedState) {
+        return;
+    }
+    // 停止后回到开头并预先缓冲，再次播放时立即出声
+    stopDecoder();
+    flushOutput();
+    m_seekStartedNs = 0;
+    m_previewMs = 0;
+    setState(QMediaPlayer::StoppedState);
+    if (!m_media.isEmpty() && m_status != QMediaPlayer::InvalidMedia) {
+        startDecoder(0);
+        setStatus(QMediaPlayer::LoadedMedia);
+    }
+    emit positionChanged(0);
+}
+
+void AudioEngine::setPosition(qint64 position)
+{
+    if (m_fallback) {
+        // QMediaPlayer 没有出声的通知，跳转耗时未知
+        m_fallback->setPosition(position);
+        emit seekCompleted(-1);
+        return;
+    }
+    if (m_media.isEmpty() || m_status == QMediaPlayer::InvalidMedia) {
+        return;
+    }
+    position = qMax<qint64>(0, position);
+    if (m_duration > 0) {
+        position = qMin(position, m_duration);
+    }
+    stopDecoder();
+    flushOutput();
+    startDecoder(position);
+    if (m_status == QMediaPlayer::EndOfMedia) {
+        setStatus(QMediaPlayer::BufferingMedia);
+    }
+    // flushOutput() 已停止设备，暂停状态下的试听片段随之结束
+    m_previewMs = 0;
+    m_seekStartedNs = m_state == QMediaPlayer::PlayingState ? clockNs() : 0;
+    if (m_state == QMediaPlayer::PlayingState && m_format.isValid()) {
+        startOutput();
+    }
+    m_notifiedPosition = position;
+    emit positionChanged(position);
+}
+
+void AudioEngine::preview(qint64 position, int durationMs)
+{
+    setPosition(position);
+    if (m_fallback || m_state == QMediaPlayer::PlayingState || !m_format.isValid()) {
+        return;
+    }
+    m_seekStartedNs = clockNs();
+    m_previewMs = durationMs;
+    startOutput();
+}
+
+void AudioEngine::setSeekTable(const SeekTable &table)
+{
+    if (m_fallback) {
+        return;
+    }
+    m_seekTable = table;
+    const qint64 duration = table.durationMs();
+    if (duration > 0 && duration != m_duration) {
+        m_duration = duration;
+        emit durationChanged(duration);
+    }
+}
+
+qint64 AudioEngine::position() const
+{
+    if (m_fallback) {
+        return m_fallback->position();
+    }
+    if (m_status == QMediaPlayer::EndOfMedia) {
+        return m_duration;
+    }
+    if (!m_format.isValid() || m_deviceFormat.sampleRate() <= 0) {
+        return m_seekTarget;
+    }
+    // 已送入设备的帧数减去设备缓冲区中尚未播放的部分
+    const qint64 played = m_worker->device->playedFrames.load(std::memory_order_relaxed)
+                        - m_worker->device->latencyFrames.load(std::memory_order_relaxed);
+    return m_seekTarget + qMax<qint64>(0, played) * 1000 / m_deviceFormat.sampleRate();
+}
+
+void AudioEngine::setGain(float gain)
+{
+    m_dsp.setGain(gain);
+    if (m_fallback) {
+        m_fallback->setVolume(qBound(0, qRound(gain * 100), 100));
+    }
+}
+
+void AudioEngine::setTapEnabled(bool enabled)
+{
+    m_worker->device->tapEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+int AudioEngine::underruns() const
+{
+    return m_worker->device->underruns.load(std::memory_order_relaxed);
+}
+
+void AudioEngine::pump()
+{
+    if (!pushPending()) {
+        return;  // 环形缓冲区已满，由定时器稍后重试
+    }
+    while (m_decoder->bufferAvailable()) {
+        const QAudioBuffer buffer = m_decoder->read();
+        if (!buffer.isValid()) {
+            continue;
+        }
+        if (!PcmDecoder::toFloat(buffer, m_decoded)) {
+            fail(tr("不支持的采样格式"));
+            return;
+        }
+
+        const QAudioFormat format = buffer.format();
+        int offset = 0;  // 转换结果接在 m_pending 中已有数据之后
+        if (!m_format.isValid()) {
+            if (!configureTrack(format)) {
+                return;
+            }
+        } else if (format.channelCount() != m_format.channelCount()
+                   || format.sampleRate() != m_format.sampleRate()) {
+            // 同一首歌中途改变格式（串接的 Ogg、部分 MP3/AAC 流）：先输出旧格式滤波器中剩余的尾部，
+            // 再按新格式重建，设备格式不变
+            drainResampler();
+            offset = m_pending.size();
+            m_resampler.configure(format.sampleRate(), format.channelCount(),
+                                  m_deviceFormat.sampleRate(), m_deviceFormat.channelCount());
+            if (m_skipFrames > 0) {
+                m_skipFrames = m_skipFrames * format.sampleRate() / m_format.sampleRate();
+            }
+            m_format = format;
+        }
+
+        // 跳转：按样本数丢弃目标位置之前的帧。
+        // 从跳转点开始解码时缓冲区的时间戳从 0 开始，不能用 startTime() 判断位置
+        if (m_skipFrames < 0) {
+            const qint64 origin = m_seekTable.sampleRate > 0
+                                ? m_originSample * format.sampleRate() / m_seekTable.sampleRate : 0;
+            m_skipFrames = qMax<qint64>(0, m_seekTarget * format.sampleRate() / 1000 - origin);
+        }
+        const int bufferFrames = m_decoded.size() / format.channelCount();
+        const int skipFrames = int(qMin<qint64>(m_skipFrames, bufferFrames));
+        m_skipFrames -= skipFrames;
+
+        // 转换为设备的采样率和声道数
+        const int frames = bufferFrames - skipFrames;
+        m_pending.resize(offset + m_resampler.maxOutputFrames(frames) * m_resampler.outputChannels());
+        const int converted = m_resampler.process(m_decoded.constData() + skipFrames * format.channelCount(),
+                                                  frames, m_pending.data() + offset);
+        m_pending.resize(offset + converted * m_resampler.outputChannels());
+        m_pendingOffset = 0;
+
+        if (!pushPending()) {
+            return;
+        }
+    }
+}
+
+void AudioEngine::onDecoderFinished()
+{
+    m_decodeFinished = true;
+    if (!m_format.isValid()) {
+        fail(tr("没有解码出任何音频数据"));
+        return;
+    }
+    drainResampler();
+    if (pushPending()) {
+        m_worker->device->inputEnded.store(true, std::memory_order_release);
+    }
+}
+
+void AudioEngine::onDecoderError()
+{
+    if (m_decoder->error() == QAudioDecoder::ServiceMissingError) {
+        // 构造时没有发现、开始解码才知道没有后端：改用 QMediaPlayer 重新打开这首歌
+        const QUrl media = m_media;
+        const bool playing = m_state == QMediaPlayer::PlayingState;
+        stopDecoder();
+        flushOutput();
+        m_tick.stop();
+        useFallback();
+        setMedia(media);
+        if (playing) {
+            play();
+        }
+        return;
+    }
+    fail(m_decoder->errorString());
+}
+
+void AudioEngine::onTick()
+{
+    // 缓冲区满时暂停了读取，有空间后继续
+    if (m_decoder->bufferAvailable() || m_pendingOffset < m_pending.size()) {
+        pump();
+    }
+    if (m_decodeFinished && m_pendingOffset >= m_pending.size()) {
+        m_worker->device->inputEnded.store(true, std::memory_order_release);
+    }
+    // 缓冲区占用交给 I/O 调度，偏低时后台任务让出磁盘；解码结束后缓冲区自然变空，不算
+    IoScheduler::instance()->reportPlaybackBuffer(double(m_ring.readAvailable()) / RingSamples,
+                                                  m_state == QMediaPlayer::PlayingState && !m_decodeFinished);
+
+    // 跳转后第一次出声：统计延迟，试听片段从这时开始计时
+    const qint64 firstAudio = m_worker->device->firstAudioNs.load(std::memory_order_relaxed);
+    if (m_seekStartedNs > 0 && firstAudio > 0) {
+        emit seekCompleted(qMax<qint64>(0, firstAudio - m_seekStartedNs) / 1000000);
+        m_seekStartedNs = 0;
+    }
+    if (m_previewMs > 0 && firstAudio > 0 && clockNs() - firstAudio >= qint64(m_previewMs) * 1000000) {
+        m_previewMs = 0;
+        if (m_state != QMediaPlayer::PlayingState) {
+            suspendOutput();
+        }
+    }
+
+    if (m_state != QMediaPlayer::PlayingState) {
+        return;
+    }
+    if (m_worker->device->drained.load(std::memory_order_acquire)) {
+        // 先切换到停止状态再通知播放结束，和 QMediaPlayer 的顺序一致
+        suspendOutput();
+        setState(QMediaPlayer::StoppedState);
+        setStatus(QMediaPlayer::EndOfMedia);
+        return;
+    }
+    const qint64 current = position();
+    if (m_notifiedPosition < 0 || qAbs(current - m_notifiedPosition) >= NotifyInterval) {
+        m_notifiedPosition = current;
+        emit positionChanged(current);
+    }
+}
+
+void AudioEngine::startDecoder(qint64 position)
+{
+    m_seekTarget = position;
+    m_decodeFinished = false;
+    m_pending.clear();
+    m_pendingOffset = 0;
+    m_resampler.reset();
+    m_decoder->stop();
+
+    // 有跳转表时从目标之前最近的帧开始解码，省去从头解码到目标位置的时间
+    SeekSource *previous = m_source;
+    m_source = nullptr;
+    m_originSample = 0;
+    m_skipFrames = -1;
+    const SeekPoint point = m_media.isLocalFile() ? m_seekTable.locate(position) : SeekPoint{0, -1};
+    if (point.offset > 0) {
+        m_source = new SeekSource(m_media.toLocalFile(), m_seekTable.header, point.offset, this);
+        if (m_source->open(QIODevice::ReadOnly)) {
+            m_originSample = point.sample;
+        } else {
+            delete m_source;
+            m_source = nullptr;
+        }
+    }
+    if (m_source) {
+        m_decoder->setSourceDevice(m_source);
+    } else {
+        m_decoder->setSourceFilename(m_media.isLocalFile() ? m_media.toLocalFile() : m_media.toString());
+    }
+    if (previous) {
+        previous->deleteLater();
+    }
+    m_decoder->start();
+    m_tick.start();
+}
+
+void AudioEngine::stopDecoder()
+{
+    m_decoder->stop();
+    m_pending.clear();
+    m_pendingOffset = 0;
+    m_decodeFinished = false;
+}
+
+bool AudioEngine::openOutput()
+{
+    if (m_deviceFormat.isValid()) {
+        return true;
+    }
+    QAudioFormat format;
+    QMetaObject::invokeMethod(m_worker, [this, &format]() { format = m_worker->open(); },
+                              Qt::BlockingQueuedConnection);
+    if (!format.isValid()) {
+        fail(tr("无法打开音频输出设备"));
+        return false;
+    }
+    m_deviceFormat = format;
+    return true;
+}
+
+bool AudioEngine::configureTrack(const QAudioFormat &format)
+{
+    if (!openOutput()) {
+        return false;
+    }
+    // 同样格式的歌曲连续播放时不重建滤波器
+    if (m_resampler.inputRate() != format.sampleRate() || m_resampler.inputChannels() != format.channelCount()
+        || m_resampler.outputRate() != m_deviceFormat.sampleRate()
+        || m_resampler.outputChannels() != m_deviceFormat.channelCount()) {
+        m_resampler.configure(format.sampleRate(), format.channelCount(),
+                              m_deviceFormat.sampleRate(), m_deviceFormat.channelCount());
+    } else {
+        m_resampler.reset();
+    }
+    m_format = format;
+    setStatus(QMediaPlayer::BufferedMedia);
+    if (m_state == QMediaPlayer::PlayingState) {
+        startOutput();
+    }
+    return true;
+}
+
+void AudioEngine::queueHead(const TrackHead &head)
+{
+    QAudioFormat format;
+    format.setSampleRate(head.sampleRate);
+    format.setChannelCount(head.channels);
+    format.setSampleSize(32);
+    format.setSampleType(QAudioFormat::Float);
+    format.setCodec("audio/pcm");
+    if (!configureTrack(format)) {
+        return;
+    }
+    // 解码器输出的前 frames 帧与缓存的开头相同，丢弃后正好接上
+    m_skipFrames = head.frames();
+    m_pending.resize(m_resampler.maxOutputFrames(int(head.frames())) * m_resampler.outputChannels());
+    const int converted = m_resampler.process(head.samples.constData(), int(head.frames()), m_pending.data());
+    m_pending.resize(converted * m_resampler.outputChannels());
+    m_pendingOffset = 0;
+    pushPending();
+}
+
+void AudioEngine::drainResampler()
+{
+    // 把滤波器中剩余的尾部样本接到待写入数据之后
+    m_pending.remove(0, m_pendingOffset);
+    m_pendingOffset = 0;
+    const int offset = m_pending.size();
+    m_pending.resize(offset + m_resampler.maxOutputFrames(0) * m_resampler.outputChannels());
+    const int frames = m_resampler.drain(m_pending.data() + offset);
+    m_pending.resize(offset + frames * m_resampler.outputChannels());
+}
+
+bool AudioEngine::pushPending()
+{
+    const int channels = qMax(1, m_deviceFormat.channelCount());
+    const int remaining = m_pending.size() - m_pendingOffset;
+    if (remaining <= 0) {
+        return true;
+    }
+    // 只写入整帧，读端按帧取用
+    int count = qMin(remaining, m_ring.writeAvailable());
+    count -= count % channels;
+    m_pendingOffset += m_ring.write(m_pending.constData() + m_pendingOffset, count);
+    return m_pendingOffset >= m_pending.size();
+}
+
+void AudioEngine::flushOutput()
+{
+    QMetaObject::invokeMethod(m_worker, [this]() { m_worker->flush(); }, Qt::BlockingQueuedConnection);
+}
+
+void AudioEngine::startOutput()
+{
+    QMetaObject::invokeMethod(m_worker, [this]() { m_worker->start(); }, Qt::BlockingQueuedConnection);
+}
+
+void AudioEngine::suspendOutput()
+{
+    QMetaObject::invokeMethod(m_worker, [this]() { m_worker->suspend(); }, Qt::BlockingQueuedConnection);
+}
+
+void AudioEngine::setState(QMediaPlayer::State state)
+{
+    if (m_state != state) {
+        m_state = state;
+        if (state != QMediaPlayer::PlayingState) {
+            IoScheduler::instance()->reportPlaybackBuffer(1.0, false);
+        }
+        emit stateChanged(state);
+    }
+}
+
+void AudioEngine::setStatus(QMediaPlayer::MediaStatus status)
+{
+    if (m_status != status) {
+        m_status = status;
+        emit mediaStatusChanged(status);
+    }
+}
+
+void AudioEngine::fail(const QString &errorString)
+{
+    qDebug() << "播放失败:" << m_media << errorString;
+    m_errorString = errorString;
+    stopDecoder();
+    flushOutput();
+    m_tick.stop();
+    setState(QMediaPlayer::StoppedState);
+    emit error(errorString);
+    setStatus(QMediaPlayer::InvalidMedia);
+}
@@ -0,0 +1,133 @@
+#ifndef AUDIOENGINE_H
+#define AUDIOENGINE_H
+
+#include <QObject>
+#include <QMediaPlayer>
+#include <QAudioFormat>
+#include <QTimer>
+#include <QUrl>
+#include <QVector>
+#include "dspchain.h"
+#include "pcmring.h"
+#include "resampler.h"
+#include "seektablecache.h"
+#include "trackheadcache.h"
+
+class QAudioDecoder;
+class QThread;
+class AudioOutputWorker;
+class SeekSource;
+
+// PCM 播放引擎：QAudioDecoder 解码 → 重采样到设备格式 → 无锁环形缓冲区 → 音频线程中经 DSP 链处理后送入 QAudioOutput
+// 状态沿用 QMediaPlayer 的枚举，MusicPlayer 可以直接替换原来的 QMediaPlayer。
+// 解码在界面线程中异步进行，环形缓冲区满时暂停读取；输出设备在单独的线程中以拉模式运行，
+// 界面卡顿不会造成断音。设备在第一次播放时按固定的采样率和声道数打开，之后换歌不再重新打开，
+// 歌曲的采样率、声道数与设备不同时由 Resampler 转换。
+// QAudioDecoder 不支持跳转：有跳转表时从目标之前最近的帧开始解码（把文件头和该帧之后的内容作为数据源交给解码器），
+// 没有时从头解码；两种情况都按样本数丢弃目标位置之前的数据。
+// 没有 QAudioDecoder 后端的平台（Qt 5.15 的 macOS）上退回到内部的 QMediaPlayer 直接播放：
+// 均衡器、频谱、跳转表和预解码的开头都不起作用，增益只能按音量在 100% 处截断。
+class AudioEngine : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AudioEngine(QObject *parent = nullptr);
+    ~AudioEngine();
+
+    // head 是缓存中已解码的歌曲开头：先播放它，解码器从头解码并丢弃同样多的帧后接在后面
+    void setMedia(const QUrl &media, const TrackHead &head = TrackHead());
+    QUrl media() const { return m_media; }
+    void play();
+    void pause();
+    void stop();
+    void setPosition(qint64 position);
+    // 拖动进度条时的试听：跳转后暂停状态下也出声 durationMs 毫秒，播放状态与普通跳转相同
+    void preview(qint64 position, int durationMs);
+    // 当前歌曲的跳转表，可以在播放过程中随时设置；setMedia() 时清除
+    void setSeekTable(const SeekTable &table);
+
+    QMediaPlayer::State state() const { return m_state; }
+    QMediaPlayer::MediaStatus mediaStatus() const { return m_status; }
+    qint64 position() const;
+    qint64 duration() const { return m_duration; }
+    QString errorString() const { return m_errorString; }
+
+    // setParameters() 可以在界面线程直接调用；退回 QMediaPlayer 时不起作用
+    DspChain *dsp() { return &m_dsp; }
+    // 音量与均衡增益（线性倍数），退回 QMediaPlayer 时换算为音量
+    void setGain(float gain);
+    bool isFallback() const { return m_fallback != nullptr; }
+
+    // 频谱显示用的 PCM 副本：经过 DSP 处理、设备格式的交错样本，启用后才写入；
+    // 读端只能是一个线程（界面线程），跟不上时新数据被丢弃
+    PcmRing *tap() { return &m_tap; }
+    void setTapEnabled(bool enabled);
+    QAudioFormat outputFormat() const { return m_deviceFormat; }
+
+    // 统计：输出欠载（缓冲区没有数据可播）的次数
+    int underruns() const;
+
+signals:
+    void stateChanged(QMediaPlayer::State state);
+    void mediaStatusChanged(QMediaPlayer::MediaStatus status);
+    void positionChanged(qint64 position);
+    void durationChanged(qint64 duration);
+    void error(const QString &errorString);
+    // 跳转（或试听）后第一次有数据送入设备，latencyMs 为从跳转到出声的时间
+    void seekCompleted(qint64 latencyMs);
+
+private slots:
+    void pump();
+    void onDecoderFinished();
+    void onDecoderError();
+    void onTick();
+
+private:
+    void startDecoder(qint64 position);
+    void stopDecoder();
+    bool openOutput();
+    bool configureTrack(const QAudioFormat &format);
+    void queueHead(const TrackHead &head);
+    void drainResampler();
+    bool pushPending();
+    void flushOutput();
+    void startOutput();
+    void suspendOutput();
+    void setState(QMediaPlayer::State state);
+    void setStatus(QMediaPlayer::MediaStatus status);
+    void fail(const QString &errorString);
+    void useFallback();
+
+private:
+    QAudioDecoder *m_decoder;
+    QMediaPlayer *m_fallback;  // 没有解码后端时用它播放，为空表示使用 PCM 引擎
+    SeekSource *m_source;      // 从跳转点开始解码时的数据源，从头解码时为空
+    QThread *m_outputThread;
+    AudioOutputWorker *m_worker;
+    DspChain m_dsp;
+    PcmRing m_ring;
+    PcmRing m_tap;
+    QTimer m_tick;  // 缓冲区满时重试读取、检测播放结束、通知进度
+
+    QUrl m_media;
+    QMediaPlayer::State m_state;
+    QMediaPlayer::MediaStatus m_status;
+    QString m_errorString;
+    qint64 m_duration;
+    QAudioFormat m_deviceFormat;  // 输出设备的格式，打开后整个会话不变
+    QAudioFormat m_format;     // 当前歌曲解码后的格式，第一个缓冲区到达后确定
+    Resampler m_resampler;
+    QVector<float> m_decoded;  // 转换为 float 的解码数据（歌曲格式）
+    QVector<float> m_pending;  // 已转换为设备格式、环形缓冲区放不下尚未写入的样本
+    int m_pendingOffset;
+    qint64 m_seekTarget;       // 本次解码开始的位置（毫秒），之前的数据丢弃
+    SeekTable m_seekTable;
+    qint64 m_originSample;     // 解码起点在歌曲中的样本位置（跳转表的采样率）
+    qint64 m_skipFrames;       // 还要丢弃的帧数，-1 表示等第一个缓冲区确定格式后再计算
+    bool m_decodeFinished;
+    qint64 m_notifiedPosition;
+    qint64 m_seekStartedNs;    // 等待出声的跳转开始的时间，0 表示没有
+    int m_previewMs;           // 暂停状态下试听片段的长度，0 表示没有在试听
+};
+
+#endif // AUDIOENGINE_H
@@ -0,0 +1,360 @@
+#include "audiotagreader.h"
+#include <QIODevice>
+#include <QByteArray>
+#include <QtEndian>
+
+namespace {
+
+QByteArray readAt(QIODevice *device, qint64 offset, qint64 length)
+{
+    if (offset < 0 || !device->seek(offset)) {
+        return QByteArray();
+    }
+    return device->read(length);
+}
+
+quint32 synchsafe(const uchar *p)
+{
+    return (quint32(p[0] & 0x7f) << 21) | (quint32(p[1] & 0x7f) << 14)
+         | (quint32(p[2] & 0x7f) << 7) | quint32(p[3] & 0x7f);
+}
+
+// 去除 ID3v2 的反同步字节（0xFF 之后插入的 0x00）
+QByteArray removeUnsynchronisation(const QByteArray &data)
+{
+    QByteArray result;
+    result.reserve(data.size());
+    for (int i = 0; i < data.size(); ++i) {
+        result.append(data[i]);
+        if (uchar(data[i]) == 0xff && i + 1 < data.size() && data[i + 1] == 0) {
+            ++i;
+        }
+    }
+    return result;
+}
+
+// 跳过以 0 结尾的字符串，UTF-16 编码以两个 0 字节结尾
+int skipTerminatedString(const QByteArray &data, int pos, int encoding)
+{
+    if (encoding == 1 || encoding == 2) {
+        while (pos + 1 < data.size()) {
+            if (data[pos] == 0 && data[pos + 1] == 0) {
+                return pos + 2;
+            }
+            pos += 2;
+        }
+        return -1;
+    }
+    int end = data.indexOf('\0', pos);
+    return end < 0 ? -1 : end + 1;
+}
+
+const int FrontCover = 3;
+const qint64 MaxTagSize = 32 * 1024 * 1024;
+
+} // namespace
+
+bool AudioTagReader::audioPayloadRange(QIODevice *device, qint64 *begin, qint64 *end)
+{
+    if (!device || !device->isOpen() || device->isSequential()) {
+        return false;
+    }
+
+    qint64 size = device->size();
+    qint64 start = skipId3v2(device, 0);
+    qint64 stop = size;
+
+    QByteArray magic = readAt(device, start, 12);
+    if (magic.startsWith("fLaC")) {
+        start = skipFlacMetadata(device, start);
+        if (start < 0) {
+            return false;
+        }
+    } else if (magic.size() == 12 && magic.startsWith("RIFF") && magic.mid(8, 4) == "WAVE") {
+        // WAV 只取 data 块，LIST/id3 等信息块都不计入
+        if (!findRiffData(device, &start, &stop)) {
+            return false;
+        }
+        *begin = start;
+        *end = stop;
+        return true;
+    }
+
+    stop = trimTrailingTags(device, start, stop);
+    if (stop <= start) {
+        return false;
+    }
+
+    *begin = start;
+    *end = stop;
+    return true;
+}
+
+QByteArray AudioTagReader::embeddedCover(QIODevice *device)
+{
+    if (!device || !device->isOpen() || device->isSequential()) {
+        return QByteArray();
+    }
+
+    QByteArray cover = id3v2Cover(device);
+    if (!cover.isEmpty()) {
+        return cover;
+    }
+
+    qint64 start = skipId3v2(device, 0);
+    if (readAt(device, start, 4) == "fLaC") {
+        return flacCover(device, start);
+    }
+    return QByteArray();
+}
+
+QByteArray AudioTagReader::id3v2Cover(QIODevice *device)
+{
+    QByteArray header = readAt(device, 0, 10);
+    if (header.size() < 10 || !header.startsWith("ID3")) {
+        return QByteArray();
+    }
+
+    const uchar *h = reinterpret_cast<const uchar *>(header.constData());
+    const int version = h[3];
+    const uchar flags = h[5];
+    qint64 tagSize = synchsafe(h + 6);
+    if (version < 2 || version > 4 || tagSize > MaxTagSize) {
+        return QByteArray();
+    }
+
+    QByteArray tag = device->read(tagSize);
+    if (version < 4 && (flags & 0x80)) {
+        tag = removeUnsynchronisation(tag);
+    }
+
+    int pos = 0;
+    if (version >= 3 && (flags & 0x40) && tag.size() >= 4) {
+        // 扩展头：v2.3 的长度不含自身，v2.4 为同步安全整数且包含自身
+        const uchar *p = reinterpret_cast<const uchar *>(tag.constData());
+        pos = version == 3 ? 4 + int(qFromBigEndian<quint32>(p)) : int(synchsafe(p));
+    }
+
+    const int headerSize = version == 2 ? 6 : 10;
+    QByteArray fallback;
+    while (pos + headerSize <= tag.size()) {
+        const uchar *p = reinterpret_cast<const uchar *>(tag.constData()) + pos;
+        if (p[0] == 0) {
+            break;  // 填充区
+        }
+
+        QByteArray id;
+        int frameSize;
+        quint16 frameFlags = 0;
+        if (version == 2) {
+            id = tag.mid(pos, 3);
+            frameSize = (p[3] << 16) | (p[4] << 8) | p[5];
+        } else {
+            id = tag.mid(pos, 4);
+            frameSize = version == 4 ? int(synchsafe(p + 4)) : int(qFromBigEndian<quint32>(p + 4));
+            frameFlags = qFromBigEndian<quint16>(p + 8);
+        }
+        pos += headerSize;
+        if (frameSize <= 0 || pos + frameSize > tag.size()) {
+            break;
+        }
+
+        if (id == "APIC" || id == "PIC") {
+            QByteArray frame = tag.mid(pos, frameSize);
+            if (version == 4) {
+                if (frameFlags & 0x000c) {
+                    pos += frameSize;
+                    continue;  // 压缩或加密的帧不处理
+                }
+                if (frameFlags & 0x0001) {
+                    frame = frame.mid(4);  // 数据长度指示
+                }
+                if (frameFlags & 0x0002) {
+                    frame = removeUnsynchronisation(frame);
+                }
+            }
+
+            int encoding = frame.isEmpty() ? 0 : uchar(frame[0]);
+            int cursor = version == 2 ? 4 : skipTerminatedString(frame, 1, 0);  // 图片格式 / MIME
+            if (cursor > 0 && cursor < frame.size()) {
+                int pictureType = uchar(frame[cursor]);
+                cursor = skipTerminatedString(frame, cursor + 1, encoding);  // 描述
+                if (cursor > 0 && cursor < frame.size()) {
+                    QByteArray data = frame.mid(cursor);
+                    if (pictureType == FrontCover) {
+                        return data;
+                    }
+                    if (fallback.isEmpty()) {
+                        fallback = data;
+                    }
+                }
+            }
+        }
+        pos += frameSize;
+    }
+    return fallback;
+}
+
+QByteArray AudioTagReader::flacCover(QIODevice *device, qint64 offset)
+{
+    qint64 pos = offset + 4;
+    QByteArray fallback;
+
+    forever {
+        QByteArray header = readAt(device, pos, 4);
+        if (header.size() < 4) {
+            break;
+        }
+        const uchar *h = reinterpret_cast<const uchar *>(header.constData());
+        bool last = h[0] & 0x80;
+        int type = h[0] & 0x7f;
+        qint64 length = (qint64(h[1]) << 16) | (qint64(h[2]) << 8) | qint64(h[3]);
+
+        if (type == 6 && length >= 32 && length <= MaxTagSize) {
+            // PICTURE 块：类型、MIME、描述、尺寸信息之后是图片数据，全部为大端
+            QByteArray block = readAt(device, pos + 4, length);
+            if (block.size() != length) {
+                break;  // 文件被截断
+            }
+            const uchar *p = reinterpret_cast<const uchar *>(block.constData());
+            qint64 cursor = 0;
+            quint32 pictureType = qFromBigEndian<quint32>(p);
+            cursor += 4;
+            if (cursor + 4 <= block.size()) {
+                cursor += 4 + qFromBigEndian<quint32>(p + cursor);  // MIME
+            }
+            if (cursor + 4 <= block.size()) {
+                cursor += 4 + qFromBigEndian<quint32>(p + cursor);  // 描述
+            }
+            cursor += 16;  // 宽、高、色深、索引色数
+            if (cursor + 4 <= block.size()) {
+                quint32 dataLength = qFromBigEndian<quint32>(p + cursor);
+                cursor += 4;
+                if (cursor + dataLength <= quint64(block.size())) {
+                    QByteArray data = block.mid(int(cursor), int(dataLength));
+                    if (pictureType == FrontCover) {
+                        return data;
+                    }
+                    if (fallback.isEmpty()) {
+                        fallback = data;
+                    }
+                }
+            }
+        }
+
+        pos += 4 + length;
+        if (last) {
+            break;
+        }
+    }
+    return fallback;
+}
+
+qint64 AudioTagReader::skipId3v2(QIODevice *device, qint64 offset)
+{
+    // 文件开头可能连续存在多个 ID3v2 标签
+    forever {
+        QByteArray header = readAt(device, offset, 10);
+        if (header.size() < 10 || !header.startsWith("ID3")) {
+            return offset;
+        }
+        const uchar *p = reinterpret_cast<const uchar *>(header.constData());
+        qint64 tagSize = 10 + synchsafe(p + 6);
+        if (p[5] & 0x10) {
+            tagSize += 10;  // 带页脚
+        }
+        offset += tagSize;
+    }
+}
+
+qint64 AudioTagReader::skipFlacMetadata(QIODevice *device, qint64 offset)
+{
+    qint64 size = device->size();
+    qint64 pos = offset + 4;  // 跳过 "fLaC"
+
+    // Vorbis 注释、图片等元数据块全部位于音频帧之前
+    forever {
+        QByteArray header = readAt(device, pos, 4);
+        if (header.size() < 4) {
+            return -1;
+        }
+        const uchar *p = reinterpret_cast<const uchar *>(header.constData());
+        bool last = p[0] & 0x80;
+        qint64 length = (qint64(p[1]) << 16) | (qint64(p[2]) << 8) | qint64(p[3]);
+        pos += 4 + length;
+        if (pos > size) {
+            return -1;
+        }
+        if (last) {
+            return pos;
+        }
+    }
+}
+
+bool AudioTagReader::findRiffData(QIODevice *device, qint64 *begin, qint64 *end)
+{
+    qint64 size = device->size();
+    qint64 pos = 12;
+
+    while (pos + 8 <= size) {
+        QByteArray chunk = readAt(device, pos, 8);
+        if (chunk.size() < 8) {
+            break;
+        }
+        quint32 length = qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(chunk.constData()) + 4);
+        if (chunk.startsWith("data")) {
+            *begin = pos + 8;
+            *end = qMin(pos + 8 + qint64(length), size);
+            return *end > *begin;
+        }
+        // RIFF 块按偶数字节对齐
+        pos += 8 + qint64(length) + (length & 1);
+    }
+    return false;
+}
+
+qint64 AudioTagReader::trimTrailingTags(QIODevice *device, qint64 begin, qint64 end)
+{
+    bool trimmed = true;
+    while (trimmed && end - begin > 0) {
+        trimmed = false;
+
+        // ID3v1（以及扩展的 TAG+）
+        if (end - begin >= 128 && readAt(device, end - 128, 3) == "TAG") {
+            end -= 128;
+            if (end - begin >= 227 && readAt(device, end - 227, 4) == "TAG+") {
+                end -= 227;
+            }
+            trimmed = true;
+            continue;
+        }
+
+        // APEv2 页脚
+        if (end - begin >= 32) {
+            QByteArray footer = readAt(device, end - 32, 32);
+            if (footer.size() == 32 && footer.startsWith("APETAGEX")) {
+                const uchar *p = reinterpret_cast<const uchar *>(footer.constData());
+                qint64 tagSize = qFromLittleEndian<quint32>(p + 12);
+                quint32 flags = qFromLittleEndian<quint32>(p + 20);
+                if (flags & 0x80000000u) {
+                    tagSize += 32;  // 带头部
+                }
+                if (tagSize > 0 && tagSize <= end - begin) {
+                    end -= tagSize;
+                    trimmed = true;
+                    continue;
+                }
+            }
+        }
+
+        // Lyrics3v2
+        if (end - begin >= 15 && readAt(device, end - 9, 9) == "LYRICS200") {
+            qint64 lyricsSize = readAt(device, end - 15, 6).toLongLong();
+            if (lyricsSize > 0 && lyricsSize + 15 <= end - begin) {
+                end -= lyricsSize + 15;
+                trimmed = true;
+            }
+        }
+    }
+    return end;
+}
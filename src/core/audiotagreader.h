@@ -0,0 +1,35 @@
+#ifndef AUDIOTAGREADER_H
+#define AUDIOTAGREADER_H
+
+#include <QtGlobal>
+#include <QByteArray>
+
+class QIODevice;
+
+// 音频文件标签结构解析
+// 只解析容器和标签的边界，不解码音频
+class AudioTagReader
+{
+public:
+    // 计算音频数据（去除 ID3v2/ID3v1/APE 标签、FLAC 元数据块、RIFF 附加块）所在的字节范围 [begin, end)
+    // 重新编辑标签不会改变该范围内的内容
+    static bool audioPayloadRange(QIODevice *device, qint64 *begin, qint64 *end);
+
+    // 读取内嵌封面（ID3v2 APIC/PIC 帧或 FLAC PICTURE 块）的原始图片数据，优先返回封面正面
+    static QByteArray embeddedCover(QIODevice *device);
+
+private:
+    static QByteArray id3v2Cover(QIODevice *device);
+    static QByteArray flacCover(QIODevice *device, qint64 offset);
+
+    // 跳过文件开头的 ID3v2 标签，返回其后的偏移
+    static qint64 skipId3v2(QIODevice *device, qint64 offset);
+    // 跳过 FLAC 元数据块，返回第一个音频帧的偏移，失败返回 -1
+    static qint64 skipFlacMetadata(QIODevice *device, qint64 offset);
+    // 查找 WAV 的 data 块
+    static bool findRiffData(QIODevice *device, qint64 *begin, qint64 *end);
+    // 去除文件末尾的 ID3v1/APEv2 标签，返回新的结束偏移
+    static qint64 trimTrailingTags(QIODevice *device, qint64 begin, qint64 end);
+};
+
+#endif // AUDIOTAGREADER_H
@@ -0,0 +1,152 @@
+#include "contenthash.h"
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+const quint64 Prime1 = 11400714785074694791ULL;
+const quint64 Prime2 = 14029467366897019727ULL;
+const quint64 Prime3 = 1609587929392839161ULL;
+const quint64 Prime4 = 9650029242287828579ULL;
+const quint64 Prime5 = 2870177450012600261ULL;
+
+inline quint64 rotl(quint64 x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline quint64 read64(const uchar *p)
+{
+    quint64 v;
+    std::memcpy(&v, p, sizeof(v));
+    return qFromLittleEndian(v);
+}
+
+inline quint32 read32(const uchar *p)
+{
+    quint32 v;
+    std::memcpy(&v, p, sizeof(v));
+    return qFromLittleEndian(v);
+}
+
+inline quint64 round(quint64 acc, quint64 input)
+{
+    acc += input * Prime2;
+    acc = rotl(acc, 31);
+    return acc * Prime1;
+}
+
+inline quint64 mergeRound(quint64 acc, quint64 val)
+{
+    acc ^= round(0, val);
+    return acc * Prime1 + Prime4;
+}
+
+} // namespace
+
+ContentHasher::ContentHasher(quint64 seed)
+{
+    reset(seed);
+}
+
+void ContentHasher::reset(quint64 seed)
+{
+    m_seed = seed;
+    m_v[0] = seed + Prime1 + Prime2;
+    m_v[1] = seed + Prime2;
+    m_v[2] = seed;
+    m_v[3] = seed - Prime1;
+    m_totalLength = 0;
+    m_bufferSize = 0;
+}
+
+void ContentHasher::addData(const char *data, qint64 length)
+{
+    if (!data || length <= 0) {
+        return;
+    }
+
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    const uchar *end = p + length;
+    m_totalLength += quint64(length);
+
+    // 先补满上次剩余的缓冲区
+    if (m_bufferSize + length < 32) {
+        std::memcpy(m_buffer + m_bufferSize, p, size_t(length));
+        m_bufferSize += int(length);
+        return;
+    }
+    if (m_bufferSize > 0) {
+        int fill = 32 - m_bufferSize;
+        std::memcpy(m_buffer + m_bufferSize, p, size_t(fill));
+        m_v[0] = round(m_v[0], read64(m_buffer));
+        m_v[1] = round(m_v[1], read64(m_buffer + 8));
+        m_v[2] = round(m_v[2], read64(m_buffer + 16));
+        m_v[3] = round(m_v[3], read64(m_buffer + 24));
+        p += fill;
+        m_bufferSize = 0;
+    }
+
+    // 主循环：每次处理 32 字节，四路累加器互不依赖
+    quint64 v1 = m_v[0], v2 = m_v[1], v3 = m_v[2], v4 = m_v[3];
+    while (end - p >= 32) {
+        v1 = round(v1, read64(p));
+        v2 = round(v2, read64(p + 8));
+        v3 = round(v3, read64(p + 16));
+        v4 = round(v4, read64(p + 24));
+        p += 32;
+    }
+    m_v[0] = v1; m_v[1] = v2; m_v[2] = v3; m_v[3] = v4;
+
+    if (p < end) {
+        m_bufferSize = int(end - p);
+        std::memcpy(m_buffer, p, size_t(m_bufferSize));
+    }
+}
+
+quint64 ContentHasher::result() const
+{
+    quint64 h;
+    if (m_totalLength >= 32) {
+        h = rotl(m_v[0], 1) + rotl(m_v[1], 7) + rotl(m_v[2], 12) + rotl(m_v[3], 18);
+        h = mergeRound(h, m_v[0]);
+        h = mergeRound(h, m_v[1]);
+        h = mergeRound(h, m_v[2]);
+        h = mergeRound(h, m_v[3]);
+    } else {
+        h = m_seed + Prime5;
+    }
+    h += m_totalLength;
+
+    const uchar *p = m_buffer;
+    const uchar *end = m_buffer + m_bufferSize;
+    while (end - p >= 8) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * Prime1 + Prime4;
+        p += 8;
+    }
+    if (end - p >= 4) {
+        h ^= quint64(read32(p)) * Prime1;
+        h = rotl(h, 23) * Prime2 + Prime3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= quint64(*p) * Prime5;
+        h = rotl(h, 11) * Prime1;
+        ++p;
+    }
+
+    h ^= h >> 33;
+    h *= Prime2;
+    h ^= h >> 29;
+    h *= Prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+quint64 ContentHasher::hash(const char *data, qint64 length, quint64 seed)
+{
+    ContentHasher hasher(seed);
+    hasher.addData(data, length);
+    return hasher.result();
+}
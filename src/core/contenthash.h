@@ -0,0 +1,30 @@
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <QtGlobal>
+#include <QByteArray>
+
+// 流式 64 位非加密哈希（XXH64 算法）
+// 速度远高于磁盘带宽，适合对音频数据做内容指纹
+class ContentHasher
+{
+public:
+    explicit ContentHasher(quint64 seed = 0);
+
+    void reset(quint64 seed = 0);
+    void addData(const char *data, qint64 length);
+    void addData(const QByteArray &data) { addData(data.constData(), data.size()); }
+    quint64 result() const;
+
+    // 一次性计算整块数据的哈希
+    static quint64 hash(const char *data, qint64 length, quint64 seed = 0);
+
+private:
+    quint64 m_seed;
+    quint64 m_v[4];
+    quint64 m_totalLength;
+    uchar m_buffer[32];
+    int m_bufferSize;
+};
+
+#endif // CONTENTHASH_H
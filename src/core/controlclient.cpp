@@ -0,0 +1,114 @@
+#include "controlclient.h"
+#include <QElapsedTimer>
+#include <QDebug>
+#include <QFileInfo>
+
+namespace {
+const int HandoffConnectTimeout = 100;   // 没有实例时连接立即失败，这里只是防止对方卡住
+const int HandoffReplyTimeout = 2000;
+}
+
+ControlClient::ControlClient(const QString &serverName)
+    : m_serverName(serverName)
+{
+}
+
+bool ControlClient::connectToServer(int timeoutMs)
+{
+    m_buffer.clear();
+    m_socket.connectToServer(m_serverName);
+    return m_socket.waitForConnected(timeoutMs);
+}
+
+bool ControlClient::isConnected() const
+{
+    return m_socket.state() == QLocalSocket::ConnectedState;
+}
+
+void ControlClient::disconnectFromServer()
+{
+    m_socket.disconnectFromServer();
+    if (m_socket.state() != QLocalSocket::UnconnectedState) {
+        m_socket.waitForDisconnected(100);
+    }
+}
+
+bool ControlClient::call(const QList<ControlMessage> &requests, QList<ControlMessage> *replies, int timeoutMs)
+{
+    replies->clear();
+    if (!isConnected()) {
+        return false;
+    }
+
+    QByteArray out;
+    for (const ControlMessage &request : requests) {
+        ControlProtocol::appendFrame(out, request);
+    }
+    // 不阻塞地尽量写出，其余部分在等待回复时写出
+    m_socket.write(out);
+    m_socket.flush();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    int offset = 0;
+    while (replies->size() < requests.size()) {
+        ControlMessage reply;
+        bool malformed = false;
+        if (ControlProtocol::readFrame(m_buffer, offset, &reply, &malformed)) {
+            replies->append(reply);
+            continue;
+        }
+        const qint64 remaining = timeoutMs - timer.elapsed();
+        if (malformed || remaining <= 0 || !m_socket.waitForReadyRead(int(remaining))) {
+            m_buffer.remove(0, offset);
+            return false;
+        }
+        m_buffer += m_socket.readAll();
+    }
+    m_buffer.remove(0, offset);
+    return true;
+}
+
+bool ControlClient::call(const ControlMessage &request, ControlMessage *reply, int timeoutMs)
+{
+    QList<ControlMessage> replies;
+    if (!call(QList<ControlMessage>() << request, &replies, timeoutMs)) {
+        return false;
+    }
+    *reply = replies.first();
+    return true;
+}
+
+bool ControlClient::handoff(const QStringList &arguments)
+{
+    ControlClient client;
+    if (!client.connectToServer(HandoffConnectTimeout)) {
+        return false;
+    }
+
+    // 相对路径按本进程的工作目录解析，对方的工作目录不同
+    QStringList paths;
+    for (const QString &argument : arguments) {
+        paths.append(QFileInfo(argument).absoluteFilePath());
+    }
+    ControlMessage request;
+    request.code = ControlProtocol::Open;
+    request.payload = ControlProtocol::encodePaths(paths);
+    ControlMessage reply;
+    const bool replied = client.call(request, &reply, HandoffReplyTimeout);
+
+    // 连接上之后就算转交完成：对方仍在监听，本进程无法再监听同一个名字，继续启动只会多出一个窗口。
+    // 只有对方在回复前断开（进程刚好退出）时才由本进程接管
+    if (!replied && !client.isConnected()) {
+        qWarning() << "正在运行的实例未回复就断开了，改为启动新实例";
+        return false;
+    }
+    if (!replied) {
+        // 请求已经写出，对方界面线程忙完后仍会处理
+        qWarning() << "正在运行的实例没有及时回复，参数可能稍后才会打开";
+    } else if (reply.code != ControlProtocol::Ok) {
+        qWarning() << "正在运行的实例拒绝了参数，状态" << reply.code;
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+#ifndef CONTROLCLIENT_H
+#define CONTROLCLIENT_H
+
+#include "controlprotocol.h"
+#include <QList>
+#include <QLocalSocket>
+
+// 本地套接字控制接口（客户端），阻塞调用，不需要事件循环
+class ControlClient
+{
+public:
+    explicit ControlClient(const QString &serverName = ControlProtocol::serverName());
+
+    bool connectToServer(int timeoutMs = 100);
+    bool isConnected() const;
+    void disconnectFromServer();
+
+    // 一次写入所有请求，按顺序等待全部回复；超时或断开时返回 false
+    bool call(const QList<ControlMessage> &requests, QList<ControlMessage> *replies, int timeoutMs = 1000);
+    bool call(const ControlMessage &request, ControlMessage *reply, int timeoutMs = 1000);
+
+    // 把命令行参数（已转为绝对路径）交给正在运行的实例；没有实例在运行时返回 false。
+    // 连接上之后即使回复超时也返回 true，避免同时运行两个实例
+    static bool handoff(const QStringList &arguments);
+
+private:
+    QString m_serverName;
+    QLocalSocket m_socket;
+    QByteArray m_buffer;
+};
+
+#endif // CONTROLCLIENT_H
@@ -0,0 +1,109 @@
+#include "controlprotocol.h"
+#include <QDataStream>
+#include <QtEndian>
+#include <cstring>
+
+QString ControlProtocol::serverName()
+{
+    QString user = qEnvironmentVariable("USER");
+    if (user.isEmpty()) {
+        user = qEnvironmentVariable("USERNAME");
+    }
+    return QString("YinYue-%1").arg(user);
+}
+
+void ControlProtocol::appendFrame(QByteArray &out, const ControlMessage &message)
+{
+    const int offset = out.size();
+    out.resize(offset + HeaderSize + 1 + message.payload.size());
+    char *data = out.data() + offset;
+    qToLittleEndian<quint32>(quint32(1 + message.payload.size()), data);
+    data[HeaderSize] = char(message.code);
+    if (!message.payload.isEmpty()) {
+        std::memcpy(data + HeaderSize + 1, message.payload.constData(), size_t(message.payload.size()));
+    }
+}
+
+QByteArray ControlProtocol::frame(quint8 code, const QByteArray &payload)
+{
+    ControlMessage message;
+    message.code = code;
+    message.payload = payload;
+    QByteArray out;
+    appendFrame(out, message);
+    return out;
+}
+
+bool ControlProtocol::readFrame(const QByteArray &buffer, int &offset, ControlMessage *message, bool *malformed)
+{
+    *malformed = false;
+    if (buffer.size() - offset < HeaderSize) {
+        return false;
+    }
+    const quint32 length = qFromLittleEndian<quint32>(buffer.constData() + offset);
+    if (length < 1 || length > quint32(MaxFrameSize)) {
+        *malformed = true;
+        return false;
+    }
+    if (buffer.size() - offset - HeaderSize < int(length)) {
+        return false;
+    }
+    const char *data = buffer.constData() + offset + HeaderSize;
+    message->code = quint8(data[0]);
+    message->payload = QByteArray(data + 1, int(length) - 1);
+    offset += HeaderSize + int(length);
+    return true;
+}
+
+QByteArray ControlProtocol::encodePaths(const QStringList &paths)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << paths;
+    return payload;
+}
+
+bool ControlProtocol::decodePaths(const QByteArray &payload, QStringList *paths)
+{
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_5_12);
+    in >> *paths;
+    return in.status() == QDataStream::Ok;
+}
+
+QByteArray ControlProtocol::encodePosition(qint64 position)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << position;
+    return payload;
+}
+
+bool ControlProtocol::decodePosition(const QByteArray &payload, qint64 *position)
+{
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_5_12);
+    in >> *position;
+    return in.status() == QDataStream::Ok;
+}
+
+QByteArray ControlProtocol::encodeState(const PlayerState &state)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << state.state << state.position << state.duration << state.volume
+        << state.currentIndex << state.count << state.filePath;
+    return payload;
+}
+
+bool ControlProtocol::decodeState(const QByteArray &payload, PlayerState *state)
+{
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_5_12);
+    in >> state->state >> state->position >> state->duration >> state->volume
+       >> state->currentIndex >> state->count >> state->filePath;
+    return in.status() == QDataStream::Ok;
+}
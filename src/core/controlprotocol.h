@@ -0,0 +1,72 @@
+#ifndef CONTROLPROTOCOL_H
+#define CONTROLPROTOCOL_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+// 控制接口的一条消息：请求中 code 为命令，回复中为状态
+struct ControlMessage
+{
+    quint8 code = 0;
+    QByteArray payload;
+};
+
+// 本地套接字控制接口的帧格式
+// 每帧：4 字节小端长度（不含长度本身）+ 1 字节命令或状态 + 参数（QDataStream 编码）。
+// 客户端可以一次写入多帧，服务端按顺序处理，把所有回复合并为一次写入，每个请求对应一个回复。
+class ControlProtocol
+{
+public:
+    enum Command : quint8 {
+        Ping = 1,
+        Open,         // 参数：路径列表；第二次启动时转交的命令行参数，加入后播放并激活窗口。
+                      // Open 和 Enqueue 传入的目录都会作为音乐文件夹永久加入音乐库（保存到设置中），
+                      // 只想播放其中的歌曲时请传文件路径
+        Enqueue,      // 参数：路径列表；只加入播放列表
+        Play,
+        Pause,
+        Stop,
+        Next,
+        Previous,
+        Seek,         // 参数：位置（毫秒）
+        QueryState    // 回复：PlayerState
+    };
+
+    enum Status : quint8 {
+        Ok = 0,
+        UnknownCommand,
+        BadArguments
+    };
+
+    struct PlayerState
+    {
+        qint32 state = 0;          // QMediaPlayer::State
+        qint64 position = 0;
+        qint64 duration = 0;
+        qint32 volume = 0;
+        qint32 currentIndex = -1;
+        qint32 count = 0;
+        QString filePath;
+    };
+
+    static const int HeaderSize = 4;
+    static const int MaxFrameSize = 16 << 20;
+
+    // 每个用户一个服务名
+    static QString serverName();
+
+    static void appendFrame(QByteArray &out, const ControlMessage &message);
+    static QByteArray frame(quint8 code, const QByteArray &payload = QByteArray());
+    // 从 buffer 的 offset 处读取一帧并前移 offset；数据不完整时返回 false，长度非法时 malformed 置位
+    static bool readFrame(const QByteArray &buffer, int &offset, ControlMessage *message, bool *malformed);
+
+    static QByteArray encodePaths(const QStringList &paths);
+    static bool decodePaths(const QByteArray &payload, QStringList *paths);
+    static QByteArray encodePosition(qint64 position);
+    static bool decodePosition(const QByteArray &payload, qint64 *position);
+    static QByteArray encodeState(const PlayerState &state);
+    static bool decodeState(const QByteArray &payload, PlayerState *state);
+};
+
+#endif // CONTROLPROTOCOL_H
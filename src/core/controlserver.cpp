@@ -0,0 +1,164 @@
+#include "controlserver.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
+#include <QDebug>
+
+namespace {
+const int ProbeTimeout = 200;   // 判断已有的套接字是否还有实例在监听
+}
+
+ControlServer::ControlServer(QObject *parent)
+    : QObject(parent)
+    , m_server(new QLocalServer(this))
+{
+    // 只允许当前用户连接
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection, this, &ControlServer::onNewConnection);
+}
+
+ControlServer::~ControlServer()
+{
+    m_server->close();
+}
+
+bool ControlServer::listen(const QString &name)
+{
+    if (m_server->listen(name)) {
+        return true;
+    }
+    if (m_server->serverError() != QAbstractSocket::AddressInUseError) {
+        qWarning() << "控制接口监听失败:" << m_server->errorString();
+        return false;
+    }
+
+    // 套接字已存在：能连上说明另一个实例在运行，否则是异常退出留下的
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(ProbeTimeout)) {
+        qDebug() << "已有实例在监听控制接口";
+        return false;
+    }
+    QLocalServer::removeServer(name);
+    if (!m_server->listen(name)) {
+        qWarning() << "控制接口监听失败:" << m_server->errorString();
+        return false;
+    }
+    return true;
+}
+
+bool ControlServer::isListening() const
+{
+    return m_server->isListening();
+}
+
+void ControlServer::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        m_buffers.insert(socket, QByteArray());
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            onReadyRead(socket);
+        });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+            m_buffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void ControlServer::onReadyRead(QLocalSocket *socket)
+{
+    auto it = m_buffers.find(socket);
+    if (it == m_buffers.end()) {
+        return;
+    }
+    it.value() += socket->readAll();
+    if (m_busy.contains(socket)) {
+        return;  // 正在执行的命令进入了嵌套事件循环（如对话框），返回后按顺序继续处理
+    }
+
+    // 处理所有完整的帧，回复合并为一次写入；执行命令期间连接可能断开
+    QPointer<QLocalSocket> guard(socket);
+    m_busy.insert(socket);
+    QByteArray replies;
+    int offset = 0;
+    bool malformed = false;
+    for (;;) {
+        it = m_buffers.find(socket);
+        if (!guard || it == m_buffers.end()) {
+            m_busy.remove(socket);
+            return;
+        }
+        ControlMessage request;
+        if (!ControlProtocol::readFrame(it.value(), offset, &request, &malformed)) {
+            it.value().remove(0, offset);
+            break;
+        }
+        ControlProtocol::appendFrame(replies, execute(request));
+    }
+    m_busy.remove(socket);
+
+    if (!replies.isEmpty()) {
+        socket->write(replies);
+    }
+    if (malformed) {
+        qWarning() << "控制接口收到格式错误的数据，断开连接";
+        it.value().clear();
+        socket->disconnectFromServer();
+    }
+}
+
+ControlMessage ControlServer::execute(const ControlMessage &request)
+{
+    ControlMessage reply;
+    reply.code = ControlProtocol::Ok;
+
+    switch (request.code) {
+    case ControlProtocol::Ping:
+        break;
+    case ControlProtocol::Open:
+    case ControlProtocol::Enqueue: {
+        QStringList paths;
+        if (!ControlProtocol::decodePaths(request.payload, &paths)) {
+            reply.code = ControlProtocol::BadArguments;
+        } else if (request.code == ControlProtocol::Open) {
+            emit openRequested(paths);
+        } else {
+            emit enqueueRequested(paths);
+        }
+        break;
+    }
+    case ControlProtocol::Play:
+        emit playRequested();
+        break;
+    case ControlProtocol::Pause:
+        emit pauseRequested();
+        break;
+    case ControlProtocol::Stop:
+        emit stopRequested();
+        break;
+    case ControlProtocol::Next:
+        emit nextRequested();
+        break;
+    case ControlProtocol::Previous:
+        emit previousRequested();
+        break;
+    case ControlProtocol::Seek: {
+        qint64 position = 0;
+        if (!ControlProtocol::decodePosition(request.payload, &position) || position < 0) {
+            reply.code = ControlProtocol::BadArguments;
+        } else {
+            emit seekRequested(position);
+        }
+        break;
+    }
+    case ControlProtocol::QueryState:
+        reply.payload = ControlProtocol::encodeState(
+            m_stateProvider ? m_stateProvider() : ControlProtocol::PlayerState());
+        break;
+    default:
+        reply.code = ControlProtocol::UnknownCommand;
+        break;
+    }
+    return reply;
+}
@@ -0,0 +1,53 @@
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+
+#include "controlprotocol.h"
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <functional>
+
+class QLocalServer;
+class QLocalSocket;
+
+// 本地套接字控制接口（服务端）
+// 第二次启动的程序和外部脚本通过它控制正在运行的实例。命令在界面线程中按顺序执行：
+// 播放控制和加入文件通过信号交给主窗口，查询状态通过 StateProvider 读取，
+// 同一次写入中的多条命令的回复合并为一次写回。
+class ControlServer : public QObject
+{
+    Q_OBJECT
+public:
+    using StateProvider = std::function<ControlProtocol::PlayerState()>;
+
+    explicit ControlServer(QObject *parent = nullptr);
+    ~ControlServer();
+
+    // 开始监听；已有实例在监听时返回 false。上次异常退出留下的套接字文件会被清理
+    bool listen(const QString &name = ControlProtocol::serverName());
+    bool isListening() const;
+    void setStateProvider(const StateProvider &provider) { m_stateProvider = provider; }
+
+signals:
+    void openRequested(const QStringList &paths);
+    void enqueueRequested(const QStringList &paths);
+    void playRequested();
+    void pauseRequested();
+    void stopRequested();
+    void nextRequested();
+    void previousRequested();
+    void seekRequested(qint64 position);
+
+private:
+    void onNewConnection();
+    void onReadyRead(QLocalSocket *socket);
+    ControlMessage execute(const ControlMessage &request);
+
+private:
+    QLocalServer *m_server;
+    QHash<QLocalSocket *, QByteArray> m_buffers;   // 每个连接尚未处理完的数据
+    QSet<QLocalSocket *> m_busy;                    // 正在执行命令的连接
+    StateProvider m_stateProvider;
+};
+
+#endif // CONTROLSERVER_H
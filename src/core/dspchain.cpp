@@ -0,0 +1,408 @@
+#include "dspchain.h"
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+const int Fresh = 4;                  // 三缓冲中间格“有新数据”标记
+const int ChunkFrames = 256;          // 每次处理的最大帧数（scratch 大小）
+const int RampChunkFrames = 32;       // 渐变期间每块更新一次系数
+const double RampSeconds = 0.02;      // 参数渐变时长
+const double ReleaseSeconds = 0.08;   // 限幅器恢复时间常数
+const float GraphicFrequencies[10] = {31.25f, 62.5f, 125.0f, 250.0f, 500.0f,
+                                      1000.0f, 2000.0f, 4000.0f, 8000.0f, 16000.0f};
+const float GraphicQ = 1.41f;         // 约一个倍频程带宽
+
+inline double dbToLinear(double db)
+{
+    return std::pow(10.0, db / 20.0);
+}
+
+// 一级双二阶（直接 II 型转置），处理两个相邻声道；state 依次为两声道的 s1、两声道的 s2
+inline void filterPair(double cb0, double cb1, double cb2, double ca1, double ca2,
+                       double *state, double *x, int frames, int stride)
+{
+#if defined(__SSE2__)
+    const __m128d b0 = _mm_set1_pd(cb0);
+    const __m128d b1 = _mm_set1_pd(cb1);
+    const __m128d b2 = _mm_set1_pd(cb2);
+    const __m128d a1 = _mm_set1_pd(ca1);
+    const __m128d a2 = _mm_set1_pd(ca2);
+    __m128d s1 = _mm_loadu_pd(state);
+    __m128d s2 = _mm_loadu_pd(state + 2);
+    for (int f = 0; f < frames; ++f) {
+        double *p = x + f * stride;
+        const __m128d in = _mm_loadu_pd(p);
+        const __m128d y = _mm_add_pd(_mm_mul_pd(b0, in), s1);
+        s1 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(b1, in), _mm_mul_pd(a1, y)), s2);
+        s2 = _mm_sub_pd(_mm_mul_pd(b2, in), _mm_mul_pd(a2, y));
+        _mm_storeu_pd(p, y);
+    }
+    _mm_storeu_pd(state, s1);
+    _mm_storeu_pd(state + 2, s2);
+#else
+    double s1l = state[0], s1r = state[1], s2l = state[2], s2r = state[3];
+    for (int f = 0; f < frames; ++f) {
+        double *p = x + f * stride;
+        const double yl = cb0 * p[0] + s1l;
+        const double yr = cb0 * p[1] + s1r;
+        s1l = cb1 * p[0] - ca1 * yl + s2l;
+        s1r = cb1 * p[1] - ca1 * yr + s2r;
+        s2l = cb2 * p[0] - ca2 * yl;
+        s2r = cb2 * p[1] - ca2 * yr;
+        p[0] = yl;
+        p[1] = yr;
+    }
+    state[0] = s1l;
+    state[1] = s1r;
+    state[2] = s2l;
+    state[3] = s2r;
+#endif
+}
+
+} // namespace
+
+DspChain::Parameters DspChain::graphicEqualizer(const float gains[10])
+{
+    Parameters parameters;
+    parameters.equalizer = true;
+    parameters.bandCount = 10;
+    for (int i = 0; i < 10; ++i) {
+        parameters.bands[i] = Band{Peaking, GraphicFrequencies[i], gains[i], GraphicQ};
+    }
+    return parameters;
+}
+
+DspChain::DspChain()
+    : m_middle(1)
+    , m_writeSlot(0)
+    , m_readSlot(2)
+    , m_gain(1.0f)
+    , m_reduction(0.0f)
+    , m_minLimiterGain(1.0f)
+    , m_sampleRate(0)
+    , m_channels(0)
+    , m_bandCount(0)
+    , m_targetBandCount(0)
+    , m_rampPosition(0)
+    , m_rampLength(0)
+    , m_preampStart(1.0)
+    , m_preampTarget(1.0)
+    , m_preamp(1.0)
+    , m_stride(0)
+    , m_appliedGain(1.0f)
+    , m_limiterEnabled(true)
+    , m_ceiling(1.0f)
+    , m_limiterGain(1.0f)
+    , m_limiterRelease(0.0f)
+{
+    m_ceiling = float(dbToLinear(m_active.ceiling));
+}
+
+void DspChain::setParameters(const Parameters &parameters)
+{
+    m_userParameters = parameters;
+    m_slots[m_writeSlot] = parameters;
+    m_writeSlot = m_middle.exchange(m_writeSlot | Fresh, std::memory_order_acq_rel) & 3;
+}
+
+void DspChain::prepare(int sampleRate, int channels)
+{
+    m_sampleRate = qMax(1, sampleRate);
+    m_channels = qMax(1, channels);
+    m_stride = m_channels == 1 ? 1 : (m_channels + 1) & ~1;
+    m_state.assign(size_t(MaxBands) * size_t(m_stride) * 2, 0.0);
+    m_scratch.assign(size_t(ChunkFrames) * size_t(m_stride), 0.0);
+    m_rampLength = qMax(1, int(m_sampleRate * RampSeconds));
+    m_limiterRelease = float(1.0 - std::exp(-1.0 / (ReleaseSeconds * m_sampleRate)));
+    m_limiterGain = 1.0f;
+
+    // 按新的采样率直接套用参数，不渐变
+    applyParameters(m_active);
+    m_rampPosition = m_rampLength;
+    updateRamp();
+}
+
+void DspChain::reset()
+{
+    std::fill(m_state.begin(), m_state.end(), 0.0);
+    m_limiterGain = 1.0f;
+}
+
+void DspChain::process(float *samples, int frames)
+{
+    // 取用界面线程最近一次设置的参数
+    if (m_middle.load(std::memory_order_acquire) & Fresh) {
+        m_readSlot = m_middle.exchange(m_readSlot, std::memory_order_acq_rel) & 3;
+        applyParameters(m_slots[m_readSlot]);
+    }
+    if (m_channels == 0 || frames <= 0) {
+        return;
+    }
+
+#if defined(__SSE2__)
+    // 滤波器衰减到极小值时避免非规格化数拖慢运算
+    const unsigned int csr = _mm_getcsr();
+    _mm_setcsr(csr | 0x8040);
+#endif
+    m_minLimiterGain = 1.0f;
+    while (frames > 0) {
+        const bool ramping = m_rampPosition < m_rampLength;
+        int chunk = qMin(frames, ramping ? RampChunkFrames : ChunkFrames);
+        if (ramping) {
+            updateRamp();
+        }
+        processChunk(samples, chunk);
+        if (ramping) {
+            m_rampPosition += chunk;
+            if (m_rampPosition >= m_rampLength) {
+                updateRamp();
+            }
+        }
+        samples += chunk * m_channels;
+        frames -= chunk;
+    }
+    m_reduction.store(float(-20.0 * std::log10(m_minLimiterGain)), std::memory_order_relaxed);
+#if defined(__SSE2__)
+    _mm_setcsr(csr);
+#endif
+}
+
+DspChain::Coefficients DspChain::identity()
+{
+    return Coefficients{1.0, 0.0, 0.0, 0.0, 0.0};
+}
+
+DspChain::Coefficients DspChain::design(const Band &band, int sampleRate)
+{
+    // RBJ Audio EQ Cookbook
+    const double frequency = qBound(10.0, double(band.frequency), sampleRate * 0.49);
+    const double q = qMax(0.1, double(band.q));
+    const double a = std::pow(10.0, band.gain / 40.0);
+    const double w0 = 2.0 * M_PI * frequency / sampleRate;
+    const double cosw = std::cos(w0);
+    const double alpha = std::sin(w0) / (2.0 * q);
+
+    double b0, b1, b2, a0, a1, a2;
+    switch (band.type) {
+    case LowShelf: {
+        const double s = 2.0 * std::sqrt(a) * alpha;
+        b0 = a * ((a + 1) - (a - 1) * cosw + s);
+        b1 = 2 * a * ((a - 1) - (a + 1) * cosw);
+        b2 = a * ((a + 1) - (a - 1) * cosw - s);
+        a0 = (a + 1) + (a - 1) * cosw + s;
+        a1 = -2 * ((a - 1) + (a + 1) * cosw);
+        a2 = (a + 1) + (a - 1) * cosw - s;
+        break;
+    }
+    case HighShelf: {
+        const double s = 2.0 * std::sqrt(a) * alpha;
+        b0 = a * ((a + 1) + (a - 1) * cosw + s);
+        b1 = -2 * a * ((a - 1) + (a + 1) * cosw);
+        b2 = a * ((a + 1) + (a - 1) * cosw - s);
+        a0 = (a + 1) - (a - 1) * cosw + s;
+        a1 = 2 * ((a - 1) - (a + 1) * cosw);
+        a2 = (a + 1) - (a - 1) * cosw - s;
+        break;
+    }
+    case Peaking:
+    default:
+        b0 = 1 + alpha * a;
+        b1 = -2 * cosw;
+        b2 = 1 - alpha * a;
+        a0 = 1 + alpha / a;
+        a1 = -2 * cosw;
+        a2 = 1 - alpha / a;
+        break;
+    }
+    return Coefficients{b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0};
+}
+
+void DspChain::applyParameters(const Parameters &parameters)
+{
+    m_active = parameters;
+    m_active.bandCount = qBound(0, parameters.bandCount, int(MaxBands));
+    m_limiterEnabled = m_active.limiter;
+    m_ceiling = float(dbToLinear(qMin(0.0f, m_active.ceiling)));
+    if (m_sampleRate == 0) {
+        return;
+    }
+
+    // 从当前系数渐变到新系数；新增的级从直通开始，状态清零
+    const int targetCount = m_active.equalizer ? m_active.bandCount : 0;
+    const int runCount = qMax(m_bandCount, targetCount);
+    for (int i = 0; i < runCount; ++i) {
+        if (i >= m_bandCount) {
+            m_current[i] = identity();
+            std::fill_n(m_state.begin() + i * m_stride * 2, m_stride * 2, 0.0);
+        }
+        m_start[i] = m_current[i];
+        m_target[i] = i < targetCount ? design(m_active.bands[i], m_sampleRate) : identity();
+    }
+    m_bandCount = runCount;
+    m_targetBandCount = targetCount;
+    m_preampStart = m_preamp;
+    m_preampTarget = m_active.equalizer ? dbToLinear(m_active.preamp) : 1.0;
+    m_rampPosition = 0;
+}
+
+void DspChain::updateRamp()
+{
+    if (m_rampPosition >= m_rampLength) {
+        // 渐变结束：直接使用目标系数，去掉已变为直通的级
+        for (int i = 0; i < m_bandCount; ++i) {
+            m_current[i] = m_target[i];
+        }
+        m_bandCount = m_targetBandCount;
+        m_preamp = m_preampTarget;
+        return;
+    }
+
+    // 取本块中点的插值位置；双二阶稳定域是凸集，两组稳定系数的线性插值仍然稳定
+    const double t = qMin(1.0, (m_rampPosition + RampChunkFrames * 0.5) / m_rampLength);
+    for (int i = 0; i < m_bandCount; ++i) {
+        const Coefficients &s = m_start[i];
+        const Coefficients &e = m_target[i];
+        m_current[i] = Coefficients{s.b0 + (e.b0 - s.b0) * t, s.b1 + (e.b1 - s.b1) * t,
+                                    s.b2 + (e.b2 - s.b2) * t, s.a1 + (e.a1 - s.a1) * t,
+                                    s.a2 + (e.a2 - s.a2) * t};
+    }
+    m_preamp = m_preampStart + (m_preampTarget - m_preampStart) * t;
+}
+
+template <int Lanes>
+void DspChain::runCascade(int frames)
+{
+    // 按级处理整块：同一级的系数和状态留在寄存器中，声道两两一组用 SSE2 并行
+    double *x = m_scratch.data();
+    for (int band = 0; band < m_bandCount; ++band) {
+        const Coefficients &c = m_current[band];
+        double *state = m_state.data() + band * Lanes * 2;
+        for (int pair = 0; pair < Lanes / 2; ++pair) {
+            filterPair(c.b0, c.b1, c.b2, c.a1, c.a2, state + pair * 4, x + pair * 2, frames, Lanes);
+        }
+    }
+}
+
+template <>
+void DspChain::runCascade<1>(int frames)
+{
+    double *x = m_scratch.data();
+    for (int band = 0; band < m_bandCount; ++band) {
+        const Coefficients &c = m_current[band];
+        double *state = m_state.data() + band * 2;
+        double s1 = state[0];
+        double s2 = state[1];
+        for (int f = 0; f < frames; ++f) {
+            const double in = x[f];
+            const double y = c.b0 * in + s1;
+            s1 = c.b1 * in - c.a1 * y + s2;
+            s2 = c.b2 * in - c.a2 * y;
+            x[f] = y;
+        }
+        state[0] = s1;
+        state[1] = s2;
+    }
+}
+
+void DspChain::runCascadeGeneric(int frames)
+{
+    double *x = m_scratch.data();
+    for (int band = 0; band < m_bandCount; ++band) {
+        const Coefficients &c = m_current[band];
+        double *state = m_state.data() + band * m_stride * 2;
+        for (int pair = 0; pair < m_stride / 2; ++pair) {
+            filterPair(c.b0, c.b1, c.b2, c.a1, c.a2, state + pair * 4, x + pair * 2, frames, m_stride);
+        }
+    }
+}
+
+void DspChain::processChunk(float *samples, int frames)
+{
+    if (m_bandCount == 0 && m_preamp == 1.0) {
+        applyGainAndLimit(samples, frames);
+        return;
+    }
+
+    // 转换为 double 并乘以前级增益，声道数补齐到偶数，补齐的声道为 0
+    double *x = m_scratch.data();
+    for (int f = 0; f < frames; ++f) {
+        const float *in = samples + f * m_channels;
+        double *out = x + f * m_stride;
+        for (int c = 0; c < m_channels; ++c) {
+            out[c] = in[c] * m_preamp;
+        }
+        for (int c = m_channels; c < m_stride; ++c) {
+            out[c] = 0.0;
+        }
+    }
+
+    switch (m_stride) {
+    case 1:
+        runCascade<1>(frames);
+        break;
+    case 2:
+        runCascade<2>(frames);
+        break;
+    case 6:
+        runCascade<6>(frames);
+        break;
+    case 8:
+        runCascade<8>(frames);
+        break;
+    default:
+        runCascadeGeneric(frames);
+        break;
+    }
+
+    for (int f = 0; f < frames; ++f) {
+        const double *in = x + f * m_stride;
+        float *out = samples + f * m_channels;
+        for (int c = 0; c < m_channels; ++c) {
+            out[c] = float(in[c]);
+        }
+    }
+    applyGainAndLimit(samples, frames);
+}
+
+void DspChain::applyGainAndLimit(float *samples, int frames)
+{
+    // 输出增益在块内线性渐变到目标值
+    const float target = m_gain.load(std::memory_order_relaxed);
+    const float step = (target - m_appliedGain) / frames;
+    float gain = m_appliedGain;
+
+    for (int f = 0; f < frames; ++f) {
+        gain += step;
+        float *frame = samples + f * m_channels;
+        float peak = 0.0f;
+        for (int c = 0; c < m_channels; ++c) {
+            frame[c] *= gain;
+            peak = qMax(peak, std::fabs(frame[c]));
+        }
+        if (!m_limiterEnabled) {
+            continue;
+        }
+
+        // 峰值超过上限时立即压低增益，之后按时间常数恢复
+        if (peak * m_limiterGain > m_ceiling) {
+            m_limiterGain = m_ceiling / peak;
+        }
+        if (m_limiterGain < 1.0f) {
+            for (int c = 0; c < m_channels; ++c) {
+                frame[c] *= m_limiterGain;
+            }
+            m_minLimiterGain = qMin(m_minLimiterGain, m_limiterGain);
+            m_limiterGain += (1.0f - m_limiterGain) * m_limiterRelease;
+            if (m_limiterGain > 0.99999f) {
+                m_limiterGain = 1.0f;
+            }
+        }
+    }
+    m_appliedGain = target;
+}
@@ -0,0 +1,186 @@
+#ifndef DSPCHAIN_H
+#define DSPCHAIN_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// 播放用的 DSP 链：前级增益 → 参数均衡（双二阶级联）→ 输出增益（音量与响度均衡）→ 限幅器
+// process() 在音频线程中处理交错的 float 样本，不分配内存、不加锁；
+// 界面线程通过三缓冲传入新参数，音频线程在下一块开始时取用，滤波系数在约 20ms 内渐变，不会产生爆音。
+class DspChain
+{
+public:
+    enum { MaxBands = 16 };
+
+    enum FilterType {
+        Peaking,    // 峰值
+        LowShelf,   // 低架
+        HighShelf   // 高架
+    };
+
+    struct Band
+    {
+        FilterType type;
+        float frequency;  // Hz
+        float gain;       // dB
+        float q;
+    };
+
+    struct Parameters
+    {
+        bool equalizer = false;  // 关闭时均衡和前级增益都不生效
+        float preamp = 0.0f;     // dB
+        int bandCount = 0;
+        Band bands[MaxBands] = {};
+        bool limiter = true;
+        float ceiling = -0.3f;   // 限幅器上限（dBFS）
+    };
+
+    // 常用的 10 段图示均衡（31Hz ~ 16kHz，倍频程间隔）
+    static Parameters graphicEqualizer(const float gains[10]);
+
+    DspChain();
+
+    // 界面线程：只能由同一个线程调用
+    void setParameters(const Parameters &parameters);
+    Parameters parameters() const { return m_userParameters; }
+    // 线性增益，任意线程
+    void setGain(float gain) { m_gain.store(gain, std::memory_order_relaxed); }
+    float gain() const { return m_gain.load(std::memory_order_relaxed); }
+
+    // 音频线程
+    void prepare(int sampleRate, int channels);  // 采样率或声道数变化时调用，清空滤波器状态
+    void reset();                                // 跳转或换歌时清空滤波器状态
+    void process(float *samples, int frames);
+    int sampleRate() const { return m_sampleRate; }
+    int channels() const { return m_channels; }
+
+    // 统计：限幅器最近一块的最大衰减（dB，正数），任意线程读取
+    float gainReduction() const { return m_reduction.load(std::memory_order_relaxed); }
+
+private:
+    // 归一化的双二阶系数（a0 = 1）
+    struct Coefficients
+    {
+        double b0, b1, b2, a1, a2;
+    };
+
+    static Coefficients identity();
+    static Coefficients design(const Band &band, int sampleRate);
+    void applyParameters(const Parameters &parameters);
+    void updateRamp();
+    void processChunk(float *samples, int frames);
+    template <int Channels>
+    void runCascade(int frames);
+    void runCascadeGeneric(int frames);
+    void applyGainAndLimit(float *samples, int frames);
+
+private:
+    // 三缓冲：写端与读端各持有一格，中间一格带“有新数据”标记交换
+    Parameters m_userParameters;
+    Parameters m_slots[3];
+    std::atomic<int> m_middle;
+    int m_writeSlot;
+    int m_readSlot;
+
+    std::atomic<float> m_gain;
+    std::atomic<float> m_reduction;
+    float m_minLimiterGain;  // 本次 process() 中限幅器的最小增益
+
+    int m_sampleRate;
+    int m_channels;
+    Parameters m_active;
+
+    // 滤波器：渐变期间按块在起点和目标系数之间线性插值
+    int m_bandCount;  // 正在运行的级数（渐变期间取新旧较大者）
+    int m_targetBandCount;
+    Coefficients m_start[MaxBands];
+    Coefficients m_target[MaxBands];
+    Coefficients m_current[MaxBands];
+    int m_rampPosition;  // 已渐变的帧数
+    int m_rampLength;
+    double m_preampStart;
+    double m_preampTarget;
+    double m_preamp;
+
+    std::vector<double> m_state;    // 每级每声道 2 个状态量，声道数补齐到偶数
+    std::vector<double> m_scratch;  // 当前块转换为 double 的样本，声道数补齐到偶数
+    int m_stride;                   // 补齐后的声道数
+
+    float m_appliedGain;
+    bool m_limiterEnabled;
+    float m_ceiling;
+    float m_limiterGain;
+    float m_limiterRelease;  // 每帧恢复的比例
+};
+
+// 样本格式转换：float（-1 ~ 1）与整数 PCM 之间，按格式在编译期选择缩放系数
+template <typename T>
+struct SampleFormat;
+
+template <>
+struct SampleFormat<float>
+{
+    static constexpr int Bytes = 4;
+    static float fromFloat(float v) { return v; }
+    static float toFloat(float v) { return v; }
+};
+
+template <>
+struct SampleFormat<qint16>
+{
+    static constexpr int Bytes = 2;
+    static constexpr float Scale = 32767.0f;
+    // 按当前舍入模式（默认为四舍六入五成双）取整，与下面 SSE2 的 cvtps 结果逐位相同
+    static qint16 fromFloat(float v) { return qint16(std::lrintf(qBound(-1.0f, v, 1.0f) * Scale)); }
+    static float toFloat(qint16 v) { return v * (1.0f / 32768.0f); }
+};
+
+template <>
+struct SampleFormat<qint32>
+{
+    static constexpr int Bytes = 4;
+    static constexpr double Scale = 2147483647.0;
+    static qint32 fromFloat(float v) { return qint32(qRound64(qBound(-1.0, double(v), 1.0) * Scale)); }
+    static float toFloat(qint32 v) { return float(v * (1.0 / 2147483648.0)); }
+};
+
+// 把 float 样本批量转换为目标格式
+template <typename T>
+void convertSamples(const float *in, T *out, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        out[i] = SampleFormat<T>::fromFloat(in[i]);
+    }
+}
+
+#if defined(__SSE2__)
+// 16 位输出每次转换 8 个样本，packs 饱和前先限制在 -1 ~ 1。
+// cvtps 与 lrintf 使用同一舍入模式，结果与逐个转换一致
+template <>
+inline void convertSamples<qint16>(const float *in, qint16 *out, int count)
+{
+    const __m128 scale = _mm_set1_ps(SampleFormat<qint16>::Scale);
+    const __m128 lower = _mm_set1_ps(-1.0f);
+    const __m128 upper = _mm_set1_ps(1.0f);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), lower), upper);
+        const __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), lower), upper);
+        const __m128i lo = _mm_cvtps_epi32(_mm_mul_ps(a, scale));
+        const __m128i hi = _mm_cvtps_epi32(_mm_mul_ps(b, scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(lo, hi));
+    }
+    for (; i < count; ++i) {
+        out[i] = SampleFormat<qint16>::fromFloat(in[i]);
+    }
+}
+#endif
+
+#endif // DSPCHAIN_H
@@ -0,0 +1,215 @@
+#include "duplicateanalyzer.h"
+#include "contenthash.h"
+#include "audiotagreader.h"
+#include "ioscheduler.h"
+#include "models/musiclibrary.h"
+#include <QThreadPool>
+#include <QThread>
+#include <QFile>
+#include <QDebug>
+
+namespace {
+// 大块顺序读取，让吞吐量受限于磁盘而不是系统调用次数
+const qint64 ReadChunkSize = 1024 * 1024;
+}
+
+struct DuplicateAnalyzer::Job
+{
+    QStringList paths;
+    std::atomic<int> next{0};
+    std::atomic<int> activeWorkers{0};
+    std::atomic<bool> canceled{false};
+    std::atomic<qint64> bytes{0};
+};
+
+DuplicateAnalyzer::DuplicateAnalyzer(MusicLibrary *library, QObject *parent)
+    : QObject(parent)
+    , m_library(library)
+    , m_pool(new QThreadPool(this))
+    , m_processed(0)
+    , m_elapsed(0)
+    , m_bytes(0)
+{
+    m_pool->setMaxThreadCount(QThread::idealThreadCount());
+}
+
+DuplicateAnalyzer::~DuplicateAnalyzer()
+{
+    cancel();
+    m_pool->waitForDone();
+}
+
+void DuplicateAnalyzer::start()
+{
+    start(m_library->filesWithoutHash());
+}
+
+void DuplicateAnalyzer::start(const QStringList &filePaths)
+{
+    cancel();
+
+    auto job = std::make_shared<Job>();
+    job->paths = filePaths;
+    m_job = job;
+    m_processed = 0;
+    m_elapsed = 0;
+    m_bytes = 0;
+    m_timer.start();
+
+    emit progressChanged(0, filePaths.size());
+    if (filePaths.isEmpty()) {
+        m_job.reset();
+        emit finished(false);
+        return;
+    }
+
+    // 每个工作线程从共享队列中取文件，直到取完或被取消
+    int workers = qMin(m_pool->maxThreadCount(), filePaths.size());
+    job->activeWorkers = workers;
+    for (int i = 0; i < workers; ++i) {
+        m_pool->start([this, job]() {
+            forever {
+                if (job->canceled) {
+                    break;
+                }
+                int index = job->next.fetch_add(1);
+                if (index >= job->paths.size()) {
+                    break;
+                }
+
+                const QString filePath = job->paths.at(index);
+                quint64 hash = 0;
+                qint64 bytesRead = 0;
+                if (!hashAudioPayload(filePath, &hash, &bytesRead, &job->canceled)) {
+                    hash = 0;
+                }
+                job->bytes += bytesRead;
+
+                QMetaObject::invokeMethod(this, [this, job, filePath, hash]() {
+                    onFileHashed(job, filePath, hash);
+                }, Qt::QueuedConnection);
+            }
+            QMetaObject::invokeMethod(this, [this, job]() {
+                onWorkerFinished(job);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+void DuplicateAnalyzer::cancel()
+{
+    if (!m_job) {
+        return;
+    }
+    m_job->canceled = true;
+    m_elapsed = m_timer.elapsed();
+    m_bytes = m_job->bytes;
+    m_job.reset();
+    emit finished(true);
+}
+
+bool DuplicateAnalyzer::isRunning() const
+{
+    return m_job != nullptr;
+}
+
+void DuplicateAnalyzer::setMaxThreads(int count)
+{
+    m_pool->setMaxThreadCount(qMax(1, count));
+}
+
+int DuplicateAnalyzer::maxThreads() const
+{
+    return m_pool->maxThreadCount();
+}
+
+int DuplicateAnalyzer::processedCount() const
+{
+    return m_processed;
+}
+
+int DuplicateAnalyzer::totalCount() const
+{
+    return m_job ? m_job->paths.size() : m_processed;
+}
+
+qint64 DuplicateAnalyzer::bytesHashed() const
+{
+    return m_job ? m_job->bytes.load() : m_bytes;
+}
+
+qint64 DuplicateAnalyzer::elapsedMs() const
+{
+    return m_job ? m_timer.elapsed() : m_elapsed;
+}
+
+bool DuplicateAnalyzer::hashAudioPayload(const QString &filePath, quint64 *hash,
+                                         qint64 *bytesRead, const std::atomic<bool> *canceled)
+{
+    ScheduledFile file(filePath, canceled);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "无法打开文件计算哈希:" << filePath << file.errorString();
+        return false;
+    }
+
+    qint64 begin = 0;
+    qint64 end = 0;
+    if (!AudioTagReader::audioPayloadRange(&file, &begin, &end) || !file.seek(begin)) {
+        qDebug() << "无法定位音频数据:" << filePath;
+        return false;
+    }
+
+    ContentHasher hasher;
+    QByteArray buffer(int(qMin(ReadChunkSize, end - begin)), Qt::Uninitialized);
+    qint64 remaining = end - begin;
+    while (remaining > 0) {
+        if (canceled && canceled->load(std::memory_order_relaxed)) {
+            return false;
+        }
+        qint64 n = file.read(buffer.data(), qMin<qint64>(buffer.size(), remaining));
+        if (n <= 0) {
+            return false;
+        }
+        hasher.addData(buffer.constData(), n);
+        remaining -= n;
+        if (bytesRead) {
+            *bytesRead += n;
+        }
+    }
+
+    *hash = hasher.result();
+    // 0 保留为“未计算”
+    if (*hash == 0) {
+        *hash = 1;
+    }
+    return true;
+}
+
+void DuplicateAnalyzer::onFileHashed(const std::shared_ptr<Job> &job, const QString &filePath, quint64 hash)
+{
+    if (job != m_job) {
+        return;  // 已取消或已被新任务替换
+    }
+
+    ++m_processed;
+    if (hash != 0) {
+        m_library->setContentHash(filePath, hash);
+    }
+    emit progressChanged(m_processed, job->paths.size());
+}
+
+void DuplicateAnalyzer::onWorkerFinished(const std::shared_ptr<Job> &job)
+{
+    if (job != m_job || --job->activeWorkers > 0) {
+        return;
+    }
+
+    m_elapsed = m_timer.elapsed();
+    m_bytes = job->bytes;
+    double seconds = qMax<qint64>(1, m_elapsed) / 1000.0;
+    qDebug() << "重复检测完成，共" << m_processed << "个文件，"
+             << (m_bytes / (1024.0 * 1024.0)) / seconds << "MB/s";
+
+    m_job.reset();
+    emit finished(false);
+}
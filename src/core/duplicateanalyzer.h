@@ -0,0 +1,62 @@
+#ifndef DUPLICATEANALYZER_H
+#define DUPLICATEANALYZER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <atomic>
+#include <memory>
+
+class QThreadPool;
+class MusicLibrary;
+
+// 后台重复歌曲分析器
+// 多线程计算每个文件音频数据（不含标签）的哈希，结果写回音乐库
+class DuplicateAnalyzer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DuplicateAnalyzer(MusicLibrary *library, QObject *parent = nullptr);
+    ~DuplicateAnalyzer();
+
+    // 分析音乐库中尚未计算哈希的文件
+    void start();
+    void start(const QStringList &filePaths);
+    void cancel();
+    bool isRunning() const;
+
+    // 并发读取的线程数，机械硬盘上可以调小以避免来回寻道
+    void setMaxThreads(int count);
+    int maxThreads() const;
+
+    // 进度与吞吐量
+    int processedCount() const;
+    int totalCount() const;
+    qint64 bytesHashed() const;
+    qint64 elapsedMs() const;
+
+    // 计算单个文件音频数据的哈希，可在任意线程调用
+    static bool hashAudioPayload(const QString &filePath, quint64 *hash,
+                                 qint64 *bytesRead = nullptr,
+                                 const std::atomic<bool> *canceled = nullptr);
+
+signals:
+    void progressChanged(int processed, int total);
+    void finished(bool canceled);
+
+private:
+    struct Job;
+    void onFileHashed(const std::shared_ptr<Job> &job, const QString &filePath, quint64 hash);
+    void onWorkerFinished(const std::shared_ptr<Job> &job);
+
+private:
+    MusicLibrary *m_library;  // 不拥有此指针
+    QThreadPool *m_pool;
+    std::shared_ptr<Job> m_job;
+    int m_processed;
+    QElapsedTimer m_timer;
+    qint64 m_elapsed;
+    qint64 m_bytes;
+};
+
+#endif // DUPLICATEANALYZER_H
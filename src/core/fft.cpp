@@ -0,0 +1,102 @@
+#include "fft.h"
+#include <QtGlobal>
+#include <QtMath>
+
+namespace {
+
+typedef std::complex<float> Complex;
+
+// 直接按公式相乘，避免 std::complex 为处理无穷大和 NaN 调用的慢速路径
+inline Complex multiply(const Complex &a, const Complex &b)
+{
+    return Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+} // namespace
+
+Fft::Fft(int size)
+    : m_size(qMax(2, size))
+    , m_half(m_size / 2)
+{
+    Q_ASSERT((m_size & (m_size - 1)) == 0);
+
+    int bits = 0;
+    while ((1 << bits) < m_half) {
+        ++bits;
+    }
+    m_bitReverse.resize(size_t(m_half));
+    for (int i = 0; i < m_half; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        m_bitReverse[size_t(i)] = r;
+    }
+
+    m_twiddles.resize(size_t(qMax(1, m_half / 2)));
+    for (int k = 0; k < int(m_twiddles.size()); ++k) {
+        const double angle = -2.0 * M_PI * k / m_half;
+        m_twiddles[size_t(k)] = Complex(float(std::cos(angle)), float(std::sin(angle)));
+    }
+    m_split.resize(size_t(m_half + 1));
+    for (int k = 0; k <= m_half; ++k) {
+        const double angle = -2.0 * M_PI * k / m_size;
+        m_split[size_t(k)] = Complex(float(std::cos(angle)), float(std::sin(angle)));
+    }
+    m_buffer.resize(size_t(m_half));
+    m_spectrum.resize(size_t(m_half + 1));
+}
+
+void Fft::complexTransform(Complex *data) const
+{
+    for (int i = 0; i < m_half; ++i) {
+        const int r = m_bitReverse[size_t(i)];
+        if (r > i) {
+            std::swap(data[i], data[r]);
+        }
+    }
+    // 迭代基 2 蝶形运算（按时间抽取）
+    for (int length = 2; length <= m_half; length <<= 1) {
+        const int half = length / 2;
+        const int step = m_half / length;
+        for (int start = 0; start < m_half; start += length) {
+            Complex *a = data + start;
+            Complex *b = a + half;
+            for (int j = 0; j < half; ++j) {
+                const Complex v = multiply(b[j], m_twiddles[size_t(j * step)]);
+                b[j] = a[j] - v;
+                a[j] += v;
+            }
+        }
+    }
+}
+
+void Fft::transform(const float *in, Complex *out)
+{
+    // 偶数下标作实部、奇数下标作虚部
+    for (int n = 0; n < m_half; ++n) {
+        m_buffer[size_t(n)] = Complex(in[2 * n], in[2 * n + 1]);
+    }
+    complexTransform(m_buffer.data());
+
+    const Complex z0 = m_buffer[0];
+    out[0] = Complex(z0.real() + z0.imag(), 0.0f);
+    out[m_half] = Complex(z0.real() - z0.imag(), 0.0f);
+    for (int k = 1; k < m_half; ++k) {
+        const Complex a = m_buffer[size_t(k)];
+        const Complex b = std::conj(m_buffer[size_t(m_half - k)]);
+        const Complex even = (a + b) * 0.5f;
+        const Complex diff = (a - b) * 0.5f;
+        const Complex odd(diff.imag(), -diff.real());  // diff / i
+        out[k] = even + multiply(m_split[size_t(k)], odd);
+    }
+}
+
+void Fft::powerSpectrum(const float *in, float *power)
+{
+    transform(in, m_spectrum.data());
+    for (int k = 0; k <= m_half; ++k) {
+        const Complex &c = m_spectrum[size_t(k)];
+        power[k] = c.real() * c.real() + c.imag() * c.imag();
+    }
+}
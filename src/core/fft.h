@@ -0,0 +1,35 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <vector>
+
+// 实数输入的快速傅里叶变换，长度为 2 的幂
+// 把 N 个实数样本打包成 N/2 个复数做一次迭代基 2 变换，再拆分出实数序列的频谱；
+// 旋转因子和位反转表在构造时算好，transform() 不分配内存。
+class Fft
+{
+public:
+    explicit Fft(int size);
+
+    int size() const { return m_size; }
+
+    // in 为 size() 个实数，out 为 size()/2 + 1 个复数（0 ~ 奈奎斯特频率）
+    void transform(const float *in, std::complex<float> *out);
+    // 各频点的功率 |X|^2，power 为 size()/2 + 1 个
+    void powerSpectrum(const float *in, float *power);
+
+private:
+    void complexTransform(std::complex<float> *data) const;
+
+private:
+    int m_size;
+    int m_half;
+    std::vector<int> m_bitReverse;               // N/2 点复数变换的位反转表
+    std::vector<std::complex<float>> m_twiddles;  // N/2 点变换的旋转因子 e^(-2πik/(N/2))
+    std::vector<std::complex<float>> m_split;     // 拆分实数频谱用的 e^(-2πik/N)
+    std::vector<std::complex<float>> m_buffer;
+    std::vector<std::complex<float>> m_spectrum;
+};
+
+#endif // FFT_H
@@ -0,0 +1,238 @@
+#include "ioscheduler.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QDebug>
+#include <chrono>
+#include <thread>
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const qint64 DefaultBandwidth = 32 << 20;  // 后台默认 32MB/s，机械硬盘上给播放留出足够余量
+const qint64 BurstNs = 100000000;          // 令牌桶最多积攒 100ms 的额度
+const double LowWater = 0.25;              // 缓冲区低于这个比例时暂停后台读取（约 1.4 秒）
+const double HighWater = 0.5;              // 恢复到这个比例以上再继续
+const int ReportTimeout = 500;             // 超过这个时间没有报告视为没有在播放
+const int MaxBackoffWait = 5000;           // 单次读取最长等待，避免后台任务饿死（解码器有超时）
+const int WaitSlice = 50;                  // 等待时检查取消的间隔
+#ifdef Q_OS_LINUX
+const int IoprioWhoProcess = 1;            // 配合线程号使用时只作用于该线程
+const int IoprioClassIdle = 3;
+const int IoprioClassShift = 13;
+#endif
+
+qint64 currentThreadId()
+{
+#ifdef Q_OS_LINUX
+    return ::syscall(SYS_gettid);
+#else
+    return 0;
+#endif
+}
+}
+
+IoScheduler *IoScheduler::instance()
+{
+    static IoScheduler scheduler;
+    return &scheduler;
+}
+
+IoScheduler::IoScheduler()
+    : m_limit(DefaultBandwidth)
+    , m_nextSlotNs(0)
+    , m_lastReportMs(0)
+    , m_backedOff(false)
+    , m_metrics{1.0, false, 0, 0, 0, 0}
+{
+    m_clock.start();
+}
+
+bool IoScheduler::acquire(qint64 bytes, const std::atomic<bool> *canceled)
+{
+    // 界面线程的少量读取（歌词、配置等）不受限制，也不能阻塞
+    if (!isBackgroundThread()) {
+        return true;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    QElapsedTimer waited;
+    waited.start();
+
+    // 播放缓冲区偏低：等到恢复
+    while (isBackedOffLocked() && waited.elapsed() < MaxBackoffWait) {
+        if (canceled && canceled->load(std::memory_order_relaxed)) {
+            m_metrics.throttledMs += waited.elapsed();
+            return false;
+        }
+        m_resumed.wait(&m_mutex, WaitSlice);
+    }
+
+    // 带宽上限：计算这次读取的开始时间，预约之后在锁外等待
+    qint64 delayNs = 0;
+    if (m_limit > 0) {
+        const qint64 now = m_clock.nsecsElapsed();
+        m_nextSlotNs = qMax(m_nextSlotNs, now - BurstNs);
+        delayNs = m_nextSlotNs - now;
+        m_nextSlotNs += bytes * 1000000000 / m_limit;
+        if (delayNs > 0) {
+            ++m_metrics.rateLimitedReads;
+        }
+    }
+    m_metrics.backgroundBytes += bytes;
+    locker.unlock();
+
+    while (delayNs > 0) {
+        if (canceled && canceled->load(std::memory_order_relaxed)) {
+            break;
+        }
+        const qint64 slice = qMin<qint64>(delayNs, qint64(WaitSlice) * 1000000);
+        std::this_thread::sleep_for(std::chrono::nanoseconds(slice));
+        delayNs -= slice;
+    }
+
+    const qint64 elapsed = waited.elapsed();
+    if (elapsed > 0) {
+        locker.relock();
+        m_metrics.throttledMs += elapsed;
+    }
+    return !(canceled && canceled->load(std::memory_order_relaxed));
+}
+
+void IoScheduler::refund(qint64 bytes)
+{
+    if (bytes <= 0 || !isBackgroundThread()) {
+        return;
+    }
+    // 预约的时间提前，下一次读取少等这一段；已经等过的时间无法退回
+    QMutexLocker locker(&m_mutex);
+    if (m_limit > 0) {
+        m_nextSlotNs -= bytes * 1000000000 / m_limit;
+    }
+    m_metrics.backgroundBytes -= bytes;
+}
+
+bool IoScheduler::isBackgroundThread()
+{
+    QCoreApplication *app = QCoreApplication::instance();
+    return app && QThread::currentThread() != app->thread();
+}
+
+void IoScheduler::setBandwidthLimit(qint64 bytesPerSecond)
+{
+    QMutexLocker locker(&m_mutex);
+    m_limit = qMax<qint64>(0, bytesPerSecond);
+}
+
+qint64 IoScheduler::bandwidthLimit() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_limit;
+}
+
+void IoScheduler::reportPlaybackBuffer(double occupancy, bool active)
+{
+    QMutexLocker locker(&m_mutex);
+    m_lastReportMs = m_clock.elapsed();
+    m_metrics.bufferOccupancy = occupancy;
+
+    const bool wasBackedOff = m_backedOff;
+    if (!active || occupancy >= HighWater) {
+        m_backedOff = false;
+    } else if (occupancy < LowWater) {
+        m_backedOff = true;
+    }
+    m_metrics.backedOff = m_backedOff;
+    if (m_backedOff && !wasBackedOff) {
+        ++m_metrics.backoffEvents;
+        qDebug() << "播放缓冲区偏低，暂停后台读取:" << occupancy;
+    } else if (!m_backedOff && wasBackedOff) {
+        m_resumed.wakeAll();
+    }
+}
+
+bool IoScheduler::isBackedOff() const
+{
+    QMutexLocker locker(&m_mutex);
+    return isBackedOffLocked();
+}
+
+bool IoScheduler::isBackedOffLocked() const
+{
+    // 播放引擎停止报告（退出、卡住）时不能让后台任务一直等下去
+    return m_backedOff && m_clock.elapsed() - m_lastReportMs < ReportTimeout;
+}
+
+IoScheduler::Metrics IoScheduler::metrics() const
+{
+    QMutexLocker locker(&m_mutex);
+    Metrics metrics = m_metrics;
+    metrics.backedOff = isBackedOffLocked();
+    return metrics;
+}
+
+qint64 IoScheduler::enterIdlePriority()
+{
+#ifdef Q_OS_LINUX
+    // ioprio_set(IOPRIO_WHO_PROCESS, tid, ...) 只作用于指定的线程
+    const qint64 thread = currentThreadId();
+    QMutexLocker locker(&m_priorityMutex);
+    auto it = m_idleThreads.find(thread);
+    if (it != m_idleThreads.end()) {
+        ++it->depth;
+        return thread;
+    }
+    const int previous = int(::syscall(SYS_ioprio_get, IoprioWhoProcess, thread));
+    if (previous < 0
+        || ::syscall(SYS_ioprio_set, IoprioWhoProcess, thread, IoprioClassIdle << IoprioClassShift) != 0) {
+        qDebug() << "无法设置空闲 I/O 优先级";
+        return thread;  // 不再重试；没有记录，退出时不做任何事
+    }
+    m_idleThreads.insert(thread, IdleThread{1, previous});
+    return thread;
+#else
+    return 0;
+#endif
+}
+
+void IoScheduler::leaveIdlePriority(qint64 thread)
+{
+#ifdef Q_OS_LINUX
+    if (thread == 0) {
+        return;
+    }
+    // 线程池的线程之后还会执行其他任务（包括前台的元数据读取），不能一直留在空闲优先级
+    QMutexLocker locker(&m_priorityMutex);
+    auto it = m_idleThreads.find(thread);
+    if (it == m_idleThreads.end() || --it->depth > 0) {
+        return;
+    }
+    ::syscall(SYS_ioprio_set, IoprioWhoProcess, thread, it->previous);
+    m_idleThreads.erase(it);
+#else
+    Q_UNUSED(thread);
+#endif
+}
+
+ScheduledFile::~ScheduledFile()
+{
+    close();
+    IoScheduler::instance()->leaveIdlePriority(m_idleThread);
+}
+
+qint64 ScheduledFile::readData(char *data, qint64 maxlen)
+{
+    IoScheduler *scheduler = IoScheduler::instance();
+    if (IoScheduler::isBackgroundThread() && currentThreadId() != m_idleThread) {
+        // 第一次读取时设为空闲 I/O 优先级；解码器可能换到自己的线程读取，设置跟着线程走
+        scheduler->leaveIdlePriority(m_idleThread);
+        m_idleThread = scheduler->enterIdlePriority();
+    }
+    if (!scheduler->acquire(maxlen, m_canceled)) {
+        return -1;
+    }
+    const qint64 read = QFile::readData(data, maxlen);
+    scheduler->refund(maxlen - qMax<qint64>(0, read));
+    return read;
+}
@@ -0,0 +1,98 @@
+#ifndef IOSCHEDULER_H
+#define IOSCHEDULER_H
+
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QHash>
+#include <atomic>
+
+// 后台任务（重复检测、响度分析、波形、跳转表、封面等）的磁盘读取调度
+// 所有后台读取在读之前经过 acquire()，读完后用 refund() 退回没有读到的部分：
+// - 读取期间线程设为空闲 I/O 优先级（Linux），只在磁盘空闲时得到服务，文件关闭后恢复原来的优先级；
+// - 按带宽上限（令牌桶）排队；
+// - 播放引擎报告的缓冲区占用低于下限时暂停，回到上限以上再继续，让正在播放的歌曲先读。
+// 在界面线程中调用时不做任何限制，界面线程从不等待。
+class IoScheduler
+{
+public:
+    struct Metrics
+    {
+        double bufferOccupancy;   // 最近报告的播放缓冲区占用（0 ~ 1）
+        bool backedOff;           // 当前是否因缓冲区偏低暂停后台读取
+        qint64 backoffEvents;     // 进入暂停的次数
+        qint64 rateLimitedReads;  // 因带宽上限等待过的读取次数
+        qint64 throttledMs;       // 后台线程累计等待的时间
+        qint64 backgroundBytes;   // 后台读取的总字节数
+    };
+
+    static IoScheduler *instance();
+
+    // 读取 bytes 字节之前调用；canceled 置位时放弃等待并返回 false
+    bool acquire(qint64 bytes, const std::atomic<bool> *canceled = nullptr);
+    // 实际读到的比预约的少（文件末尾、短读）时退回差额
+    void refund(qint64 bytes);
+
+    // 当前线程的读取是否受调度；界面线程不受限制
+    static bool isBackgroundThread();
+
+    // 把当前线程设为空闲 I/O 优先级，可以嵌套；返回线程号，0 表示不支持
+    qint64 enterIdlePriority();
+    // 最外层退出时恢复进入前的优先级，可以在其他线程调用
+    void leaveIdlePriority(qint64 thread);
+
+    // 后台带宽上限（字节/秒），0 表示不限
+    void setBandwidthLimit(qint64 bytesPerSecond);
+    qint64 bandwidthLimit() const;
+
+    // 播放引擎定期报告缓冲区占用；active 为 false（暂停、停止、解码已结束）时不限制后台读取
+    void reportPlaybackBuffer(double occupancy, bool active);
+    bool isBackedOff() const;
+
+    Metrics metrics() const;
+
+private:
+    IoScheduler();
+    bool isBackedOffLocked() const;
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_resumed;
+    QElapsedTimer m_clock;
+    qint64 m_limit;
+    qint64 m_nextSlotNs;          // 令牌桶：下一次读取最早可以开始的时间
+    qint64 m_lastReportMs;
+    bool m_backedOff;
+    Metrics m_metrics;
+
+    struct IdleThread
+    {
+        int depth;
+        int previous;  // 进入前的 I/O 优先级
+    };
+    QMutex m_priorityMutex;
+    QHash<qint64, IdleThread> m_idleThreads;
+};
+
+// 经过 IoScheduler 读取的文件，可以交给只接受 QIODevice 的接口（QAudioDecoder、AudioTagReader）
+class ScheduledFile : public QFile
+{
+public:
+    explicit ScheduledFile(const QString &name, const std::atomic<bool> *canceled = nullptr)
+        : QFile(name)
+        , m_canceled(canceled)
+        , m_idleThread(0)
+    {
+    }
+    ~ScheduledFile() override;
+
+protected:
+    qint64 readData(char *data, qint64 maxlen) override;
+
+private:
+    const std::atomic<bool> *m_canceled;
+    qint64 m_idleThread;  // 为读取这个文件设为空闲 I/O 优先级的线程，0 表示没有
+};
+
+#endif // IOSCHEDULER_H
@@ -0,0 +1,748 @@
+#include "libraryscanner.h"
+#include "ioscheduler.h"
+#include <QThreadPool>
+#include <QThread>
+#include <QMutex>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#else
+#include <QStorageInfo>
+#endif
+#ifdef Q_OS_LINUX
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/statfs.h>
+#include <sys/sysmacros.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const int MaxQueueDepth = 256;   // 再深对网络存储也没有收益，只会占用更多文件描述符
+const int SolidDepth = 32;
+const int RotationalDepth = 1;   // 机械硬盘上并发读取只会增加寻道
+const int NetworkDepth = 64;     // 网络存储的耗时主要是往返延迟，并发越多越能重叠
+const int MaxDevices = 16;       // 同时扫描的设备数
+const int BackoffPoll = 50;      // 播放缓冲区偏低时检查恢复和取消的间隔
+
+// 每批文件开始读取前经过 I/O 调度（界面线程中调用时不受限制）：
+// 播放缓冲区偏低时一直等到恢复，扫描没有超时，不必像解码那样限时；再按带宽上限预约这一批文件开头的读取量。
+// 只有取消时返回 false
+bool throttleBatch(int count, const std::atomic<bool> *canceled)
+{
+    IoScheduler *scheduler = IoScheduler::instance();
+    while (IoScheduler::isBackgroundThread() && scheduler->isBackedOff()) {
+        if (canceled && canceled->load(std::memory_order_relaxed)) {
+            return false;
+        }
+        QThread::msleep(BackoffPoll);
+    }
+    return scheduler->acquire(qint64(count) * LibraryScanner::HeaderBytes, canceled);
+}
+
+// 文件比预约的开头短或读取失败时退回差额
+void refundHeader(const ScannedFile &file)
+{
+    IoScheduler::instance()->refund(LibraryScanner::HeaderBytes - file.header.size());
+}
+
+#ifdef Q_OS_LINUX
+const quint16 IdleIoprio = 3 << 13;  // IOPRIO_CLASS_IDLE：后台扫描的读取只在磁盘空闲时得到服务
+
+// 直接使用系统调用的最小 io_uring 封装（不依赖 liburing）
+class Uring
+{
+public:
+    ~Uring()
+    {
+        if (m_sqes) {
+            ::munmap(m_sqes, m_sqesSize);
+        }
+        if (m_cqRing && m_cqRing != m_sqRing) {
+            ::munmap(m_cqRing, m_cqRingSize);
+        }
+        if (m_sqRing) {
+            ::munmap(m_sqRing, m_sqRingSize);
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+    }
+
+    bool init(unsigned entries)
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        m_fd = int(::syscall(__NR_io_uring_setup, entries, &params));
+        if (m_fd < 0) {
+            return false;
+        }
+
+        m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMap) {
+            m_sqRingSize = m_cqRingSize = qMax(m_sqRingSize, m_cqRingSize);
+        }
+        m_sqRing = map(m_sqRingSize, IORING_OFF_SQ_RING);
+        if (!m_sqRing) {
+            return false;
+        }
+        m_cqRing = singleMap ? m_sqRing : map(m_cqRingSize, IORING_OFF_CQ_RING);
+        m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = static_cast<io_uring_sqe *>(map(m_sqesSize, IORING_OFF_SQES));
+        if (!m_cqRing || !m_sqes) {
+            return false;
+        }
+
+        char *sq = static_cast<char *>(m_sqRing);
+        char *cq = static_cast<char *>(m_cqRing);
+        m_sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        m_sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        m_sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        m_sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        m_sqEntries = params.sq_entries;
+        m_cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        m_cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        m_cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        m_localTail = *m_sqTail;
+        m_submitted = m_localTail;
+        return true;
+    }
+
+    // 扫描用到的操作在 5.6 之后才齐全，旧内核上回退到线程池
+    bool supports(const QVector<int> &opcodes)
+    {
+        const int count = 256;
+        QByteArray buffer(int(sizeof(io_uring_probe) + count * sizeof(io_uring_probe_op)), 0);
+        io_uring_probe *probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+        if (::syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_PROBE, probe, count) < 0) {
+            return false;
+        }
+        for (int opcode : opcodes) {
+            if (opcode > probe->last_op || !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 确保提交队列中至少有 count 个空位，不够时先提交已有的请求；提交失败时返回 false
+    bool reserve(unsigned count)
+    {
+        if (freeEntries() >= count) {
+            return true;
+        }
+        return submit(0) && freeEntries() >= count;
+    }
+
+    // 先用 reserve() 确保有空位
+    io_uring_sqe *nextSqe()
+    {
+        if (freeEntries() == 0) {
+            return nullptr;
+        }
+        const unsigned index = m_localTail & m_sqMask;
+        io_uring_sqe *sqe = &m_sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        m_sqArray[index] = index;
+        ++m_localTail;
+        return sqe;
+    }
+
+    // 提交所有新的请求，并等待至少 waitCount 个完成
+    bool submit(unsigned waitCount)
+    {
+        __atomic_store_n(m_sqTail, m_localTail, __ATOMIC_RELEASE);
+        const unsigned toSubmit = m_localTail - m_submitted;
+        for (;;) {
+            const long ret = ::syscall(__NR_io_uring_enter, m_fd, toSubmit, waitCount,
+                                       waitCount > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (ret >= 0) {
+                m_submitted += unsigned(ret);
+                return true;
+            }
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    // 只等待已提交的请求完成，不再提交新的
+    bool wait()
+    {
+        for (;;) {
+            if (::syscall(__NR_io_uring_enter, m_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) >= 0) {
+                return true;
+            }
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    // 已进入内核但还没有取走完成结果的请求数
+    unsigned inKernel() const { return m_submitted - m_completed; }
+
+    template<typename Handler>
+    int drain(Handler handler)
+    {
+        unsigned head = *m_cqHead;
+        const unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        int count = 0;
+        while (head != tail) {
+            const io_uring_cqe &cqe = m_cqes[head & m_cqMask];
+            handler(cqe.user_data, cqe.res);
+            ++head;
+            ++count;
+        }
+        m_completed += unsigned(count);
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+        return count;
+    }
+
+private:
+    unsigned freeEntries() const
+    {
+        return m_sqEntries - (m_localTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE));
+    }
+
+    void *map(size_t size, off_t offset)
+    {
+        void *ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, offset);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    int m_fd = -1;
+    void *m_sqRing = nullptr;
+    void *m_cqRing = nullptr;
+    io_uring_sqe *m_sqes = nullptr;
+    size_t m_sqRingSize = 0;
+    size_t m_cqRingSize = 0;
+    size_t m_sqesSize = 0;
+    unsigned *m_sqHead = nullptr;
+    unsigned *m_sqTail = nullptr;
+    unsigned *m_sqArray = nullptr;
+    unsigned m_sqMask = 0;
+    unsigned m_sqEntries = 0;
+    unsigned *m_cqHead = nullptr;
+    unsigned *m_cqTail = nullptr;
+    unsigned m_cqMask = 0;
+    io_uring_cqe *m_cqes = nullptr;
+    unsigned m_localTail = 0;
+    unsigned m_submitted = 0;
+    unsigned m_completed = 0;
+};
+
+const QVector<int> &requiredOps()
+{
+    static const QVector<int> ops = {IORING_OP_STATX, IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE};
+    return ops;
+}
+
+// 每个在处理中的文件占一个槽位；statx 与 openat 同时提交，
+// 打开完成后读取开头，读完关闭，两条链都结束时槽位空出
+struct Slot
+{
+    int file = -1;
+    int pending = 0;
+    int fd = -1;
+    struct statx stx;
+    QByteArray path;
+    QByteArray buffer;
+};
+
+enum Op : quint64 {
+    OpStatx,
+    OpOpen,
+    OpRead,
+    OpClose
+};
+
+quint64 userData(int slot, Op op)
+{
+    return (quint64(slot) << 2) | op;
+}
+
+bool scanWithUring(const QStringList &filePaths, int queueDepth, QVector<ScannedFile> &results,
+                   const std::atomic<bool> *canceled, const LibraryScanner::ProgressCallback &progress)
+{
+    // 内核写入 table 中的 statx 结果和读取缓冲区，table 必须比 ring 活得久
+    QVector<Slot> table(queueDepth);
+    Uring ring;
+    // 每个文件最多同时有两个请求（statx + openat）
+    if (!ring.init(unsigned(queueDepth * 2)) || !ring.supports(requiredOps())) {
+        return false;
+    }
+
+    QVector<int> freeSlots;
+    for (int i = queueDepth - 1; i >= 0; --i) {
+        table[i].buffer.resize(LibraryScanner::HeaderBytes);
+        freeSlots.append(i);
+    }
+
+    int next = 0;
+    int inFlight = 0;
+    int done = 0;
+    bool failed = false;   // 提交失败后不再发出新请求，只等待已进入内核的请求完成
+    // 读取请求自带优先级，内核的 io-wq 线程不继承本线程的 I/O 优先级
+    const quint16 readIoprio = IoScheduler::isBackgroundThread() ? IdleIoprio : 0;
+
+    auto finishSlot = [&](int index) {
+        Slot &slot = table[index];
+        refundHeader(results.at(slot.file));
+        slot.file = -1;
+        freeSlots.append(index);
+        --inFlight;
+        if (++done % LibraryScanner::ProgressBatch == 0 && progress && !failed) {
+            progress(done);
+        }
+    };
+
+    auto handle = [&](quint64 data, int res) {
+        const int index = int(data >> 2);
+        const Op op = Op(data & 3);
+        Slot &slot = table[index];
+        ScannedFile &result = results[slot.file];
+        switch (op) {
+        case OpStatx:
+            if (res < 0) {
+                result.error = -res;
+            } else {
+                result.size = qint64(slot.stx.stx_size);
+                result.modifiedMs = qint64(slot.stx.stx_mtime.tv_sec) * 1000 + slot.stx.stx_mtime.tv_nsec / 1000000;
+            }
+            break;
+        case OpOpen:
+            if (res < 0) {
+                result.error = -res;
+            } else if (failed || !ring.reserve(1)) {
+                failed = true;
+                ::close(res);
+            } else {
+                slot.fd = res;
+                io_uring_sqe *sqe = ring.nextSqe();
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = slot.fd;
+                sqe->addr = quint64(reinterpret_cast<quintptr>(slot.buffer.data()));
+                sqe->len = unsigned(slot.buffer.size());
+                sqe->off = 0;
+                sqe->ioprio = readIoprio;
+                sqe->user_data = userData(index, OpRead);
+                ++slot.pending;
+            }
+            break;
+        case OpRead:
+            if (res < 0) {
+                result.error = -res;
+            } else {
+                result.header = QByteArray(slot.buffer.constData(), res);
+            }
+            if (failed || !ring.reserve(1)) {
+                failed = true;
+                ::close(slot.fd);
+            } else {
+                io_uring_sqe *sqe = ring.nextSqe();
+                sqe->opcode = IORING_OP_CLOSE;
+                sqe->fd = slot.fd;
+                sqe->user_data = userData(index, OpClose);
+                ++slot.pending;
+            }
+            slot.fd = -1;
+            break;
+        case OpClose:
+            break;
+        }
+        if (--slot.pending == 0) {
+            finishSlot(index);
+        }
+    };
+
+    while (!failed && (next < filePaths.size() || inFlight > 0)) {
+        // 补满空闲槽位；每批文件的第一个之前经过 I/O 调度，等待期间已提交的请求继续在内核中完成
+        while (!freeSlots.isEmpty() && next < filePaths.size()
+               && !(canceled && canceled->load(std::memory_order_relaxed))) {
+            if (next % LibraryScanner::ProgressBatch == 0
+                && !throttleBatch(qMin(LibraryScanner::ProgressBatch, filePaths.size() - next), canceled)) {
+                break;
+            }
+            if (!ring.reserve(2)) {
+                failed = true;
+                break;
+            }
+            const int index = freeSlots.takeLast();
+            Slot &slot = table[index];
+            slot.file = next;
+            slot.pending = 2;
+            slot.path = QFile::encodeName(filePaths.at(next));
+            results[next].filePath = filePaths.at(next);
+            ++next;
+            ++inFlight;
+
+            io_uring_sqe *sqe = ring.nextSqe();
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = quint64(reinterpret_cast<quintptr>(slot.path.constData()));
+            sqe->len = STATX_SIZE | STATX_MTIME;
+            sqe->off = quint64(reinterpret_cast<quintptr>(&slot.stx));
+            sqe->user_data = userData(index, OpStatx);
+
+            sqe = ring.nextSqe();
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = quint64(reinterpret_cast<quintptr>(slot.path.constData()));
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe->user_data = userData(index, OpOpen);
+        }
+        if (failed || inFlight == 0) {
+            break;  // 提交失败或已取消
+        }
+        if (!ring.submit(1)) {
+            failed = true;
+            break;
+        }
+        ring.drain(handle);
+    }
+
+    if (failed) {
+        // 极少见（资源不足等）；由调用方改用线程池重新扫描。
+        // 已进入内核的请求仍会写入 table，等它们全部完成后才能释放，打开的文件在 handle 中同步关闭
+        qWarning() << "io_uring 提交失败，改用线程池";
+        while (ring.inKernel() > 0) {
+            if (!ring.wait()) {
+                // 无法确认内核已不再写入，宁可泄漏这块内存
+                new QVector<Slot>(std::move(table));
+                break;
+            }
+            ring.drain(handle);
+        }
+        return false;
+    }
+    return true;
+}
+#endif
+
+ScannedFile scanOne(const QString &filePath)
+{
+    ScannedFile result;
+    result.filePath = filePath;
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        result.error = file.exists() ? EACCES : ENOENT;
+        return result;
+    }
+    const QFileInfo info(file);
+    result.size = info.size();
+    result.modifiedMs = info.lastModified().toMSecsSinceEpoch();
+    result.header = file.read(LibraryScanner::HeaderBytes);
+    return result;
+}
+
+void scanWithThreads(const QStringList &filePaths, int queueDepth, QVector<ScannedFile> &results,
+                     const std::atomic<bool> *canceled, const LibraryScanner::ProgressCallback &progress)
+{
+    // 每个线程同时只处理一个文件，线程数即并发数
+    QThreadPool pool;
+    pool.setMaxThreadCount(queueDepth);
+    const bool background = IoScheduler::isBackgroundThread();
+    QMutex claimMutex;
+    int next = 0;
+    std::atomic<int> done{0};
+
+    // 取下一个文件；每批的第一个文件在锁内经过 I/O 调度，其他线程随之等待。取消或处理完时返回 -1
+    auto claim = [&]() -> int {
+        QMutexLocker locker(&claimMutex);
+        if (next >= filePaths.size() || (canceled && canceled->load(std::memory_order_relaxed))) {
+            return -1;
+        }
+        if (next % LibraryScanner::ProgressBatch == 0
+            && !throttleBatch(qMin(LibraryScanner::ProgressBatch, filePaths.size() - next), canceled)) {
+            return -1;
+        }
+        return next++;
+    };
+
+    const int workers = qMin(queueDepth, filePaths.size());
+    for (int i = 0; i < workers; ++i) {
+        pool.start([&]() {
+            // I/O 优先级按线程设置，每个工作线程各自进入空闲优先级，结束时恢复
+            IoScheduler *scheduler = IoScheduler::instance();
+            const qint64 idleThread = background ? scheduler->enterIdlePriority() : 0;
+            for (;;) {
+                const int index = claim();
+                if (index < 0) {
+                    break;
+                }
+                results[index] = scanOne(filePaths.at(index));
+                if (background) {
+                    refundHeader(results.at(index));
+                }
+                const int scanned = done.fetch_add(1) + 1;
+                if (scanned % LibraryScanner::ProgressBatch == 0 && progress) {
+                    progress(scanned);
+                }
+            }
+            scheduler->leaveIdlePriority(idleThread);
+        });
+    }
+    pool.waitForDone();
+}
+}
+
+struct LibraryScanner::Job
+{
+    QString root;
+    QStringList nameFilters;
+    int queueDepth = 1;
+    Backend backend = Auto;
+    std::atomic<bool> canceled{false};
+};
+
+LibraryScanner::LibraryScanner(QObject *parent)
+    : QObject(parent)
+    , m_pool(new QThreadPool(this))
+    , m_concurrency{SolidDepth, RotationalDepth, NetworkDepth}
+    , m_backend(Auto)
+{
+    qRegisterMetaType<ScannedFile>("ScannedFile");
+    qRegisterMetaType<QVector<ScannedFile>>("QVector<ScannedFile>");
+    // 每个设备一个线程，线程大部分时间在等待 I/O
+    m_pool->setMaxThreadCount(MaxDevices);
+}
+
+LibraryScanner::~LibraryScanner()
+{
+    cancel();
+    m_pool->waitForDone();
+}
+
+void LibraryScanner::setDeviceConcurrency(DeviceKind kind, int depth)
+{
+    m_concurrency[kind] = qBound(1, depth, MaxQueueDepth);
+}
+
+void LibraryScanner::scan(const QStringList &roots, const QStringList &nameFilters)
+{
+    m_nameFilters = nameFilters;
+    QList<quint64> touched;
+    for (const QString &root : roots) {
+        const quint64 device = deviceOf(root);
+        auto it = m_devices.find(device);
+        if (it == m_devices.end()) {
+            it = m_devices.insert(device, Device());
+            it->kind = deviceKind(root);
+        }
+        if (it->job && it->job->root == root) {
+            // 扫描期间目录又有变化，结果可能不完整，重新开始
+            it->job->canceled.store(true);
+            it->job.reset();
+        }
+        if (!it->pending.contains(root)) {
+            it->pending.append(root);
+        }
+        if (!touched.contains(device)) {
+            touched.append(device);
+        }
+    }
+    for (quint64 device : touched) {
+        startNext(device);
+    }
+}
+
+void LibraryScanner::startNext(quint64 device)
+{
+    auto it = m_devices.find(device);
+    if (it == m_devices.end() || it->job) {
+        return;
+    }
+    if (it->pending.isEmpty()) {
+        m_devices.erase(it);
+        if (m_devices.isEmpty()) {
+            emit finished();
+        }
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->root = it->pending.takeFirst();
+    job->nameFilters = m_nameFilters;
+    job->queueDepth = m_concurrency[it->kind];
+    job->backend = m_backend;
+    it->job = job;
+
+    m_pool->start([this, device, job]() {
+        QElapsedTimer timer;
+        timer.start();
+        // 列目录和 io_uring 的提交都在这个线程中进行；读取文件开头的请求另外带有空闲优先级
+        IoScheduler *scheduler = IoScheduler::instance();
+        const qint64 idleThread = scheduler->enterIdlePriority();
+
+        // 只列出文件名：目录项类型来自 readdir，不需要对每个文件调用 stat
+        // 目录不可读（磁盘未挂载、网络断开）时结果为空但不完整，调用方不能据此认为文件已被删除
+        const QDir dir(job->root);
+        const bool readable = dir.isReadable();
+        const QStringList names = dir.entryList(job->nameFilters, QDir::Files | QDir::NoDotAndDotDot);
+        QStringList filePaths;
+        filePaths.reserve(names.size());
+        for (const QString &name : names) {
+            filePaths.append(dir.absoluteFilePath(name));
+        }
+
+        // 整个目录一次交给 scanFiles，io_uring 或线程池只建立一次；进度在处理过程中报告
+        const int total = filePaths.size();
+        Backend used = job->backend;
+        const QVector<ScannedFile> files = scanFiles(filePaths, job->queueDepth, job->backend, &used, &job->canceled,
+                                                     [this, job, total](int scanned) {
+            QMetaObject::invokeMethod(this, [this, job, scanned, total]() {
+                if (!job->canceled.load()) {
+                    emit rootProgress(job->root, scanned, total);
+                }
+            }, Qt::QueuedConnection);
+        });
+        scheduler->leaveIdlePriority(idleThread);
+        const qint64 elapsed = timer.elapsed();
+        const bool complete = readable && !job->canceled.load();
+        qDebug() << "扫描音乐库:" << job->root << files.size() << "个文件，"
+                 << elapsed << "ms，" << (used == IoUring ? "io_uring" : "线程池")
+                 << "并发" << job->queueDepth;
+
+        QMetaObject::invokeMethod(this, [this, device, job, files, elapsed, complete]() {
+            onRootScanned(device, job, files, elapsed, complete);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void LibraryScanner::onRootScanned(quint64 device, const std::shared_ptr<Job> &job,
+                                   const QVector<ScannedFile> &files, qint64 elapsedMs, bool complete)
+{
+    auto it = m_devices.find(device);
+    if (it == m_devices.end() || it->job != job) {
+        return;  // 已取消或已被新的扫描替换
+    }
+    it->job.reset();
+    emit rootFinished(job->root, files, elapsedMs, complete);
+    startNext(device);
+}
+
+void LibraryScanner::cancel()
+{
+    for (Device &device : m_devices) {
+        if (device.job) {
+            device.job->canceled.store(true);
+        }
+    }
+    m_devices.clear();
+}
+
+QVector<ScannedFile> LibraryScanner::scanFiles(const QStringList &filePaths, int queueDepth, Backend backend,
+                                               Backend *used, const std::atomic<bool> *canceled,
+                                               const ProgressCallback &progress)
+{
+    queueDepth = qBound(1, queueDepth, MaxQueueDepth);
+    QVector<ScannedFile> results(filePaths.size());
+    if (filePaths.isEmpty()) {
+        if (used) {
+            *used = backend == Auto ? ThreadPool : backend;
+        }
+        return results;
+    }
+
+    Backend actual = ThreadPool;
+#ifdef Q_OS_LINUX
+    if (backend != ThreadPool) {
+        if (scanWithUring(filePaths, queueDepth, results, canceled, progress)) {
+            actual = IoUring;
+        } else {
+            qDebug() << "io_uring 不可用，使用线程池扫描";
+            results = QVector<ScannedFile>(filePaths.size());
+        }
+    }
+#endif
+    if (actual == ThreadPool) {
+        scanWithThreads(filePaths, queueDepth, results, canceled, progress);
+    }
+    if (used) {
+        *used = actual;
+    }
+
+    // 取消时没有处理到的文件不返回
+    if (canceled && canceled->load(std::memory_order_relaxed)) {
+        QVector<ScannedFile> done;
+        for (const ScannedFile &file : results) {
+            if (!file.filePath.isEmpty()) {
+                done.append(file);
+            }
+        }
+        return done;
+    }
+    return results;
+}
+
+bool LibraryScanner::isIoUringAvailable()
+{
+#ifdef Q_OS_LINUX
+    static const bool available = []() {
+        Uring ring;
+        return ring.init(4) && ring.supports(requiredOps());
+    }();
+    return available;
+#else
+    return false;
+#endif
+}
+
+quint64 LibraryScanner::deviceOf(const QString &path)
+{
+#ifdef Q_OS_UNIX
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) == 0) {
+        return quint64(st.st_dev);
+    }
+    return 0;
+#else
+    // 没有 st_dev 的系统按卷区分
+    return qHash(QStorageInfo(path).device());
+#endif
+}
+
+LibraryScanner::DeviceKind LibraryScanner::deviceKind(const QString &path)
+{
+#ifdef Q_OS_LINUX
+    struct statfs fs;
+    if (::statfs(QFile::encodeName(path).constData(), &fs) == 0) {
+        switch (quint32(fs.f_type)) {
+        case 0x6969:        // NFS
+        case 0x517b:        // SMB
+        case 0xff534d42:    // CIFS
+        case 0xfe534d42:    // SMB2
+        case 0x65735546:    // FUSE（sshfs 等）
+            return Network;
+        default:
+            break;
+        }
+    }
+
+    // 块设备是否为机械硬盘；分区的 queue 目录在所属磁盘下
+    const quint64 device = deviceOf(path);
+    const QString sysfs = QString("/sys/dev/block/%1:%2/").arg(major(device)).arg(minor(device));
+    for (const QString &name : {QString("queue/rotational"), QString("../queue/rotational")}) {
+        QFile file(sysfs + name);
+        if (file.open(QIODevice::ReadOnly)) {
+            return file.readAll().trimmed() == "1" ? Rotational : SolidState;
+        }
+    }
+#else
+    Q_UNUSED(path);
+#endif
+    return SolidState;
+}
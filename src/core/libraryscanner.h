@@ -0,0 +1,112 @@
+#ifndef LIBRARYSCANNER_H
+#define LIBRARYSCANNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QMetaType>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+class QThreadPool;
+
+// 扫描得到的单个文件：大小、修改时间和文件开头
+struct ScannedFile
+{
+    QString filePath;
+    qint64 size = -1;
+    qint64 modifiedMs = 0;   // 修改时间（自 1970 年起的毫秒数）
+    QByteArray header;       // 文件开头，读入后随后的元数据探测直接命中页缓存
+    int error = 0;           // 失败时的 errno，0 表示成功
+
+    bool isValid() const { return error == 0; }
+};
+
+// 音乐库目录扫描
+// 目录只列出文件名，每个文件的 statx、openat、读取开头和 close 批量提交：
+// Linux 上通过 io_uring 同时保持 queueDepth 个文件在处理中，网络存储上延迟可以重叠；
+// 不支持 io_uring（旧内核、容器禁止、其他系统）时用同样并发数的线程池逐个处理。
+// 多个根目录按所在设备（st_dev）分组：不同设备上的根目录同时扫描，同一设备上的依次扫描，
+// 并发数按设备类型设置，固态硬盘和网络存储并发读取，机械硬盘顺序读取避免磁头来回寻道。
+// 后台扫描与其他后台任务一样经过 IoScheduler：空闲 I/O 优先级，每批文件按开头的字节数预约带宽，
+// 播放缓冲区偏低时在两批之间暂停。
+class LibraryScanner : public QObject
+{
+    Q_OBJECT
+public:
+    enum Backend {
+        Auto,
+        IoUring,
+        ThreadPool
+    };
+
+    enum DeviceKind {
+        SolidState,
+        Rotational,
+        Network
+    };
+
+    static const int HeaderBytes = 4096;
+
+    explicit LibraryScanner(QObject *parent = nullptr);
+    ~LibraryScanner();
+
+    // 每种设备上同时处理的文件数
+    void setDeviceConcurrency(DeviceKind kind, int depth);
+    int deviceConcurrency(DeviceKind kind) const { return m_concurrency[kind]; }
+    void setBackend(Backend backend) { m_backend = backend; }
+
+    // 在后台扫描各根目录中匹配 nameFilters 的文件（不递归），每个根目录完成后发出 rootFinished；
+    // 正在扫描的根目录重新开始，已在排队的不重复排队
+    void scan(const QStringList &roots, const QStringList &nameFilters);
+    void cancel();
+    bool isRunning() const { return !m_devices.isEmpty(); }
+
+    // 每处理完 ProgressBatch 个文件调用一次，参数为已完成的文件数；可能在工作线程中调用
+    using ProgressCallback = std::function<void(int scanned)>;
+    static const int ProgressBatch = 512;
+
+    // 同步处理一组文件，结果与输入顺序相同；used 返回实际使用的后端。
+    // 整组文件共用一个 io_uring（或线程池），不随进度报告重新创建
+    static QVector<ScannedFile> scanFiles(const QStringList &filePaths, int queueDepth, Backend backend,
+                                          Backend *used = nullptr, const std::atomic<bool> *canceled = nullptr,
+                                          const ProgressCallback &progress = ProgressCallback());
+    static bool isIoUringAvailable();
+
+    // 路径所在的设备号和设备类型（无法判断时按固态硬盘处理）
+    static quint64 deviceOf(const QString &path);
+    static DeviceKind deviceKind(const QString &path);
+
+signals:
+    void rootProgress(const QString &root, int scanned, int total);
+    // complete 为 false 表示目录无法读取，files 不代表目录的全部内容
+    void rootFinished(const QString &root, const QVector<ScannedFile> &files, qint64 elapsedMs, bool complete);
+    void finished();   // 所有排队的根目录都已完成
+
+private:
+    struct Job;
+    struct Device
+    {
+        DeviceKind kind = SolidState;
+        QStringList pending;
+        std::shared_ptr<Job> job;
+    };
+
+    void startNext(quint64 device);
+    void onRootScanned(quint64 device, const std::shared_ptr<Job> &job, const QVector<ScannedFile> &files,
+                       qint64 elapsedMs, bool complete);
+
+    QThreadPool *m_pool;
+    QHash<quint64, Device> m_devices;
+    QStringList m_nameFilters;
+    int m_concurrency[3];
+    Backend m_backend;
+};
+
+Q_DECLARE_METATYPE(ScannedFile)
+
+#endif // LIBRARYSCANNER_H
@@ -0,0 +1,229 @@
+#include "loudnessanalyzer.h"
+#include "loudnessmeter.h"
+#include "pcmdecoder.h"
+#include "models/musiclibrary.h"
+#include <QThreadPool>
+#include <QThread>
+#include <QFileInfo>
+#include <QSet>
+#include <QDebug>
+#include <cmath>
+
+struct LoudnessAnalyzer::Job
+{
+    QStringList paths;
+    std::atomic<int> next{0};
+    std::atomic<int> activeWorkers{0};
+    std::atomic<bool> canceled{false};
+};
+
+LoudnessAnalyzer::LoudnessAnalyzer(MusicLibrary *library, QObject *parent)
+    : QObject(parent)
+    , m_library(library)
+    , m_pool(new QThreadPool(this))
+    , m_processed(0)
+    , m_audioMs(0)
+    , m_elapsed(0)
+{
+    m_pool->setMaxThreadCount(QThread::idealThreadCount());
+}
+
+LoudnessAnalyzer::~LoudnessAnalyzer()
+{
+    cancel();
+    m_pool->waitForDone();
+}
+
+void LoudnessAnalyzer::start()
+{
+    // 专辑响度需要整张专辑的数据，未分析歌曲所在目录的其他歌曲也一起参与
+    QSet<QString> albums;
+    const QStringList pending = m_library->filesWithoutLoudness();
+    for (const QString &path : pending) {
+        albums.insert(QFileInfo(path).absolutePath());
+    }
+
+    QStringList paths;
+    const QStringList all = m_library->filePaths();
+    for (const QString &path : all) {
+        if (albums.contains(QFileInfo(path).absolutePath())) {
+            paths.append(path);
+        }
+    }
+    start(paths);
+}
+
+void LoudnessAnalyzer::start(const QStringList &filePaths)
+{
+    cancel();
+
+    auto job = std::make_shared<Job>();
+    job->paths = filePaths;
+    m_job = job;
+    m_processed = 0;
+    m_audioMs = 0;
+    m_elapsed = 0;
+    m_albumPending.clear();
+    m_albumHistograms.clear();
+    m_albumPeaks.clear();
+    m_albumTracks.clear();
+    for (const QString &path : filePaths) {
+        ++m_albumPending[QFileInfo(path).absolutePath()];
+    }
+    m_timer.start();
+
+    emit progressChanged(0, filePaths.size());
+    if (filePaths.isEmpty()) {
+        m_job.reset();
+        emit finished(false);
+        return;
+    }
+
+    int workers = qMin(m_pool->maxThreadCount(), filePaths.size());
+    job->activeWorkers = workers;
+    for (int i = 0; i < workers; ++i) {
+        m_pool->start([this, job]() {
+            forever {
+                if (job->canceled) {
+                    break;
+                }
+                int index = job->next.fetch_add(1);
+                if (index >= job->paths.size()) {
+                    break;
+                }
+
+                const QString filePath = job->paths.at(index);
+                TrackResult result = analyzeTrack(filePath, &job->canceled);
+                QMetaObject::invokeMethod(this, [this, job, filePath, result]() {
+                    onTrackAnalyzed(job, filePath, result);
+                }, Qt::QueuedConnection);
+            }
+            QMetaObject::invokeMethod(this, [this, job]() {
+                onWorkerFinished(job);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+void LoudnessAnalyzer::cancel()
+{
+    if (!m_job) {
+        return;
+    }
+    m_job->canceled = true;
+    m_elapsed = m_timer.elapsed();
+    m_job.reset();
+    emit finished(true);
+}
+
+bool LoudnessAnalyzer::isRunning() const
+{
+    return m_job != nullptr;
+}
+
+void LoudnessAnalyzer::setMaxThreads(int count)
+{
+    m_pool->setMaxThreadCount(qMax(1, count));
+}
+
+int LoudnessAnalyzer::totalCount() const
+{
+    return m_job ? m_job->paths.size() : m_processed;
+}
+
+double LoudnessAnalyzer::tracksPerSecond() const
+{
+    qint64 elapsed = m_job ? m_timer.elapsed() : m_elapsed;
+    return elapsed > 0 ? m_processed * 1000.0 / elapsed : 0.0;
+}
+
+double LoudnessAnalyzer::realtimeFactor() const
+{
+    qint64 elapsed = m_job ? m_timer.elapsed() : m_elapsed;
+    return elapsed > 0 ? double(m_audioMs) / elapsed : 0.0;
+}
+
+LoudnessAnalyzer::TrackResult LoudnessAnalyzer::analyzeTrack(const QString &filePath, const std::atomic<bool> *canceled)
+{
+    TrackResult result{false, 0.0, 0.0, 0, QVector<quint32>()};
+    std::unique_ptr<LoudnessMeter> meter;
+    int meterChannels = 0;
+    int meterRate = 0;
+
+    PcmDecoder decoder;
+    bool ok = decoder.decode(filePath, [&](const float *samples, int frames, int channels, int sampleRate) {
+        if (!meter || channels != meterChannels || sampleRate != meterRate) {
+            // 中途格式变化（串接的流、声道数不同的章节）：之前的部分并入直方图，用新格式重新建立测量器
+            if (meter) {
+                LoudnessMeter::mergeHistogram(result.histogram, meter->histogram());
+                result.peak = qMax(result.peak, meter->truePeak());
+            }
+            meter.reset(new LoudnessMeter(sampleRate, channels));
+            meterChannels = channels;
+            meterRate = sampleRate;
+        }
+        meter->process(samples, frames);
+        return true;
+    }, canceled);
+
+    if (!ok || !meter) {
+        if (!canceled || !canceled->load()) {
+            qDebug() << "响度分析失败:" << filePath << decoder.errorString();
+        }
+        return result;
+    }
+
+    // 直方图可以直接合并，门限计算覆盖整首歌曲的所有部分
+    LoudnessMeter::mergeHistogram(result.histogram, meter->histogram());
+    result.peak = qMax(result.peak, meter->truePeak());
+    result.loudness = LoudnessMeter::integratedLoudness(result.histogram);
+    result.audioMs = decoder.sampleRate() > 0 ? decoder.decodedFrames() * 1000 / decoder.sampleRate() : 0;
+    result.ok = std::isfinite(result.loudness);
+    return result;
+}
+
+void LoudnessAnalyzer::onTrackAnalyzed(const std::shared_ptr<Job> &job, const QString &filePath, const TrackResult &result)
+{
+    if (job != m_job) {
+        return;
+    }
+
+    ++m_processed;
+    m_audioMs += result.audioMs;
+    const QString album = QFileInfo(filePath).absolutePath();
+    if (result.ok) {
+        m_library->setTrackLoudness(filePath, float(result.loudness), float(result.peak));
+        LoudnessMeter::mergeHistogram(m_albumHistograms[album], result.histogram);
+        m_albumPeaks[album] = qMax(m_albumPeaks.value(album), result.peak);
+        m_albumTracks[album].append(filePath);
+    }
+
+    // 整张专辑分析完成后合并直方图计算专辑响度
+    if (--m_albumPending[album] == 0) {
+        double albumLoudness = LoudnessMeter::integratedLoudness(m_albumHistograms.value(album));
+        if (std::isfinite(albumLoudness)) {
+            const QStringList tracks = m_albumTracks.value(album);
+            for (const QString &track : tracks) {
+                m_library->setAlbumLoudness(track, float(albumLoudness), float(m_albumPeaks.value(album)));
+            }
+        }
+        m_albumHistograms.remove(album);
+        m_albumTracks.remove(album);
+    }
+
+    emit progressChanged(m_processed, job->paths.size());
+}
+
+void LoudnessAnalyzer::onWorkerFinished(const std::shared_ptr<Job> &job)
+{
+    if (job != m_job || --job->activeWorkers > 0) {
+        return;
+    }
+
+    m_elapsed = m_timer.elapsed();
+    qDebug() << "响度分析完成，共" << m_processed << "首，"
+             << tracksPerSecond() << "首/秒，" << realtimeFactor() << "倍实时速度";
+
+    m_job.reset();
+    emit finished(false);
+}
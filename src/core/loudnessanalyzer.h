@@ -0,0 +1,72 @@
+#ifndef LOUDNESSANALYZER_H
+#define LOUDNESSANALYZER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
+#include <atomic>
+#include <memory>
+
+class QThreadPool;
+class MusicLibrary;
+
+// 批量响度分析（EBU R128）
+// 在线程池中逐首解码并测量综合响度与真峰值，同一目录下的歌曲视为一张专辑并合并计算专辑响度
+class LoudnessAnalyzer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LoudnessAnalyzer(MusicLibrary *library, QObject *parent = nullptr);
+    ~LoudnessAnalyzer();
+
+    // 分析音乐库中尚未分析的歌曲（同专辑已分析的歌曲也会一并重新计算专辑响度）
+    void start();
+    void start(const QStringList &filePaths);
+    void cancel();
+    bool isRunning() const;
+
+    void setMaxThreads(int count);
+
+    // 进度与吞吐量
+    int processedCount() const { return m_processed; }
+    int totalCount() const;
+    double tracksPerSecond() const;
+    double realtimeFactor() const;  // 已分析音频时长 / 实际耗时
+
+signals:
+    void progressChanged(int processed, int total);
+    void finished(bool canceled);
+
+private:
+    struct Job;
+    struct TrackResult
+    {
+        bool ok;
+        double loudness;
+        double peak;
+        qint64 audioMs;
+        QVector<quint32> histogram;
+    };
+    void onTrackAnalyzed(const std::shared_ptr<Job> &job, const QString &filePath, const TrackResult &result);
+    void onWorkerFinished(const std::shared_ptr<Job> &job);
+    static TrackResult analyzeTrack(const QString &filePath, const std::atomic<bool> *canceled);
+
+private:
+    MusicLibrary *m_library;  // 不拥有此指针
+    QThreadPool *m_pool;
+    std::shared_ptr<Job> m_job;
+    int m_processed;
+    qint64 m_audioMs;
+    qint64 m_elapsed;
+    QElapsedTimer m_timer;
+
+    // 专辑（目录）聚合状态
+    QHash<QString, int> m_albumPending;
+    QHash<QString, QVector<quint32>> m_albumHistograms;
+    QHash<QString, double> m_albumPeaks;
+    QHash<QString, QStringList> m_albumTracks;
+};
+
+#endif // LOUDNESSANALYZER_H
@@ -0,0 +1,321 @@
+#include "loudnessmeter.h"
+#include <QtMath>
+#include <cmath>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const double AbsoluteGate = -70.0;
+const double RelativeGate = -10.0;
+const double HistogramStep = 0.1;
+
+inline double energyToLoudness(double energy)
+{
+    return -0.691 + 10.0 * std::log10(energy);
+}
+
+inline double loudnessToEnergy(double loudness)
+{
+    return std::pow(10.0, (loudness + 0.691) / 10.0);
+}
+
+inline double binLoudness(int bin)
+{
+    return AbsoluteGate + (bin + 0.5) * HistogramStep;
+}
+
+} // namespace
+
+LoudnessMeter::LoudnessMeter(int sampleRate, int channels)
+    : m_sampleRate(qMax(1, sampleRate))
+    , m_channels(qMax(1, channels))
+    , m_state(m_channels * 4, 0.0)
+    , m_weights(m_channels, 1.0)
+    , m_subBlockFrames(qMax(1, m_sampleRate / 10))
+    , m_subBlockPosition(0)
+    , m_subBlockEnergy(0.0)
+    , m_subBlockCount(0)
+    , m_histogram(HistogramBins, 0)
+    , m_peakHistory(m_channels * 2 * PeakTaps, 0.0f)
+    , m_peakPosition(0)
+    , m_truePeak(0.0)
+{
+    std::memset(m_recentEnergy, 0, sizeof(m_recentEnergy));
+
+    // 高架滤波（BS.1770 第一级），按实际采样率重新推导系数
+    const double fs = m_sampleRate;
+    double f0 = 1681.974450955533;
+    double gain = 3.999843853973347;
+    double q = 0.7071752369554196;
+    double k = std::tan(M_PI * f0 / fs);
+    double vh = std::pow(10.0, gain / 20.0);
+    double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    m_shelfB[0] = (vh + vb * k / q + k * k) / a0;
+    m_shelfB[1] = 2.0 * (k * k - vh) / a0;
+    m_shelfB[2] = (vh - vb * k / q + k * k) / a0;
+    m_shelfA[0] = 2.0 * (k * k - 1.0) / a0;
+    m_shelfA[1] = (1.0 - k / q + k * k) / a0;
+
+    // RLB 高通（第二级）
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = std::tan(M_PI * f0 / fs);
+    a0 = 1.0 + k / q + k * k;
+    m_highpassB[0] = 1.0;
+    m_highpassB[1] = -2.0;
+    m_highpassB[2] = 1.0;
+    m_highpassA[0] = 2.0 * (k * k - 1.0) / a0;
+    m_highpassA[1] = (1.0 - k / q + k * k) / a0;
+
+    // 5.0 / 5.1 的环绕声道加权，LFE 不计入
+    if (m_channels == 5) {
+        m_weights[3] = m_weights[4] = 1.41;
+    } else if (m_channels == 6) {
+        m_weights[3] = 0.0;
+        m_weights[4] = m_weights[5] = 1.41;
+    }
+
+    // 真峰值插值系数：Hann 窗 sinc，每相 12 个抽头，各相归一化
+    for (int phase = 1; phase <= 3; ++phase) {
+        double sum = 0.0;
+        for (int tap = 0; tap < PeakTaps; ++tap) {
+            double t = tap - PeakTaps / 2 + phase / 4.0;
+            double sinc = std::sin(M_PI * t) / (M_PI * t);
+            double window = 0.5 * (1.0 + std::cos(M_PI * t / (PeakTaps / 2)));
+            m_peakPhases[phase - 1][tap] = sinc * window;
+            sum += sinc * window;
+        }
+        for (int tap = 0; tap < PeakTaps; ++tap) {
+            m_peakPhases[phase - 1][tap] /= sum;
+        }
+    }
+}
+
+void LoudnessMeter::process(const float *samples, int frames)
+{
+    updateTruePeak(samples, frames);
+
+    // 按子块边界切分，块内使用与声道数匹配的滤波实现
+    while (frames > 0) {
+        int chunk = qMin(frames, m_subBlockFrames - m_subBlockPosition);
+        switch (m_channels) {
+        case 1:
+            m_subBlockEnergy += filterBlock<1>(samples, chunk);
+            break;
+        case 2:
+            m_subBlockEnergy += filterBlock<2>(samples, chunk);
+            break;
+        default:
+            m_subBlockEnergy += filterBlockGeneric(samples, chunk);
+            break;
+        }
+        samples += chunk * m_channels;
+        frames -= chunk;
+        m_subBlockPosition += chunk;
+        if (m_subBlockPosition == m_subBlockFrames) {
+            finishSubBlock();
+        }
+    }
+}
+
+template <int Channels>
+double LoudnessMeter::filterBlock(const float *samples, int frames)
+{
+    const double b0 = m_shelfB[0], b1 = m_shelfB[1], b2 = m_shelfB[2];
+    const double a1 = m_shelfA[0], a2 = m_shelfA[1];
+    const double c1 = m_highpassA[0], c2 = m_highpassA[1];
+    double *state = m_state.data();
+
+#if defined(__SSE2__)
+    if (Channels == 2) {
+        // 立体声：左右声道放在同一个 128 位寄存器中并行滤波
+        __m128d s1 = _mm_set_pd(state[4], state[0]);
+        __m128d s2 = _mm_set_pd(state[5], state[1]);
+        __m128d s3 = _mm_set_pd(state[6], state[2]);
+        __m128d s4 = _mm_set_pd(state[7], state[3]);
+        const __m128d vb0 = _mm_set1_pd(b0), vb1 = _mm_set1_pd(b1), vb2 = _mm_set1_pd(b2);
+        const __m128d va1 = _mm_set1_pd(a1), va2 = _mm_set1_pd(a2);
+        const __m128d vc1 = _mm_set1_pd(c1), vc2 = _mm_set1_pd(c2);
+        const __m128d vminus2 = _mm_set1_pd(-2.0);
+        __m128d energy = _mm_setzero_pd();
+        for (int i = 0; i < frames; ++i) {
+            __m128d x = _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(samples + i * 2))));
+            __m128d y1 = _mm_add_pd(_mm_mul_pd(vb0, x), s1);
+            s1 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(vb1, x), _mm_mul_pd(va1, y1)), s2);
+            s2 = _mm_sub_pd(_mm_mul_pd(vb2, x), _mm_mul_pd(va2, y1));
+            __m128d y2 = _mm_add_pd(y1, s3);
+            s3 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(vminus2, y1), _mm_mul_pd(vc1, y2)), s4);
+            s4 = _mm_sub_pd(y1, _mm_mul_pd(vc2, y2));
+            energy = _mm_add_pd(energy, _mm_mul_pd(y2, y2));
+        }
+        double lanes[2];
+        _mm_storel_pd(&state[0], s1); _mm_storeh_pd(&state[4], s1);
+        _mm_storel_pd(&state[1], s2); _mm_storeh_pd(&state[5], s2);
+        _mm_storel_pd(&state[2], s3); _mm_storeh_pd(&state[6], s3);
+        _mm_storel_pd(&state[3], s4); _mm_storeh_pd(&state[7], s4);
+        _mm_storeu_pd(lanes, energy);
+        return lanes[0] * m_weights[0] + lanes[1] * m_weights[1];
+    }
+#endif
+
+    // 声道数固定时内层循环可被编译器展开并向量化
+    double s1[Channels], s2[Channels], s3[Channels], s4[Channels], energy[Channels];
+    for (int c = 0; c < Channels; ++c) {
+        s1[c] = state[c * 4];
+        s2[c] = state[c * 4 + 1];
+        s3[c] = state[c * 4 + 2];
+        s4[c] = state[c * 4 + 3];
+        energy[c] = 0.0;
+    }
+    for (int i = 0; i < frames; ++i) {
+        for (int c = 0; c < Channels; ++c) {
+            double x = samples[i * Channels + c];
+            double y1 = b0 * x + s1[c];
+            s1[c] = b1 * x - a1 * y1 + s2[c];
+            s2[c] = b2 * x - a2 * y1;
+            double y2 = y1 + s3[c];
+            s3[c] = -2.0 * y1 - c1 * y2 + s4[c];
+            s4[c] = y1 - c2 * y2;
+            energy[c] += y2 * y2;
+        }
+    }
+    double total = 0.0;
+    for (int c = 0; c < Channels; ++c) {
+        state[c * 4] = s1[c];
+        state[c * 4 + 1] = s2[c];
+        state[c * 4 + 2] = s3[c];
+        state[c * 4 + 3] = s4[c];
+        total += energy[c] * m_weights[c];
+    }
+    return total;
+}
+
+double LoudnessMeter::filterBlockGeneric(const float *samples, int frames)
+{
+    double total = 0.0;
+    for (int c = 0; c < m_channels; ++c) {
+        if (m_weights[c] == 0.0) {
+            continue;
+        }
+        double *state = m_state.data() + c * 4;
+        double energy = 0.0;
+        for (int i = 0; i < frames; ++i) {
+            double x = samples[i * m_channels + c];
+            double y1 = m_shelfB[0] * x + state[0];
+            state[0] = m_shelfB[1] * x - m_shelfA[0] * y1 + state[1];
+            state[1] = m_shelfB[2] * x - m_shelfA[1] * y1;
+            double y2 = y1 + state[2];
+            state[2] = -2.0 * y1 - m_highpassA[0] * y2 + state[3];
+            state[3] = y1 - m_highpassA[1] * y2;
+            energy += y2 * y2;
+        }
+        total += energy * m_weights[c];
+    }
+    return total;
+}
+
+void LoudnessMeter::updateTruePeak(const float *samples, int frames)
+{
+    double peak = m_truePeak;
+    for (int i = 0; i < frames; ++i) {
+        for (int c = 0; c < m_channels; ++c) {
+            // 同时写入两份，读取时总能取到连续的 PeakTaps 个样本
+            float *history = m_peakHistory.data() + c * 2 * PeakTaps;
+            float x = samples[i * m_channels + c];
+            history[m_peakPosition] = x;
+            history[m_peakPosition + PeakTaps] = x;
+            peak = qMax(peak, double(std::fabs(x)));
+
+            const float *window = history + m_peakPosition + 1;
+            for (int phase = 0; phase < 3; ++phase) {
+                double y = 0.0;
+                for (int tap = 0; tap < PeakTaps; ++tap) {
+                    y += window[tap] * m_peakPhases[phase][PeakTaps - 1 - tap];
+                }
+                peak = qMax(peak, std::fabs(y));
+            }
+        }
+        m_peakPosition = (m_peakPosition + 1) % PeakTaps;
+    }
+    m_truePeak = peak;
+}
+
+void LoudnessMeter::finishSubBlock()
+{
+    m_recentEnergy[m_subBlockCount % 4] = m_subBlockEnergy;
+    ++m_subBlockCount;
+    m_subBlockEnergy = 0.0;
+    m_subBlockPosition = 0;
+
+    if (m_subBlockCount < 4) {
+        return;
+    }
+
+    double energy = (m_recentEnergy[0] + m_recentEnergy[1] + m_recentEnergy[2] + m_recentEnergy[3])
+                    / (4.0 * m_subBlockFrames);
+    if (energy <= 0.0) {
+        return;
+    }
+    double loudness = energyToLoudness(energy);
+    if (loudness < AbsoluteGate) {
+        return;
+    }
+    int bin = qBound(0, int((loudness - AbsoluteGate) / HistogramStep), HistogramBins - 1);
+    ++m_histogram[bin];
+}
+
+double LoudnessMeter::integratedLoudness() const
+{
+    return integratedLoudness(m_histogram);
+}
+
+double LoudnessMeter::truePeak() const
+{
+    return m_truePeak;
+}
+
+double LoudnessMeter::integratedLoudness(const QVector<quint32> &histogram)
+{
+    // 第一步：绝对门限（-70 LUFS）以上所有块的平均能量
+    double energySum = 0.0;
+    quint64 blocks = 0;
+    for (int bin = 0; bin < histogram.size(); ++bin) {
+        if (histogram[bin]) {
+            energySum += histogram[bin] * loudnessToEnergy(binLoudness(bin));
+            blocks += histogram[bin];
+        }
+    }
+    if (blocks == 0) {
+        return -HUGE_VAL;
+    }
+
+    // 第二步：相对门限（平均响度 -10 LU）
+    double gate = energyToLoudness(energySum / blocks) + RelativeGate;
+    energySum = 0.0;
+    blocks = 0;
+    for (int bin = 0; bin < histogram.size(); ++bin) {
+        double loudness = binLoudness(bin);
+        if (histogram[bin] && loudness >= gate) {
+            energySum += histogram[bin] * loudnessToEnergy(loudness);
+            blocks += histogram[bin];
+        }
+    }
+    if (blocks == 0) {
+        return -HUGE_VAL;
+    }
+    return energyToLoudness(energySum / blocks);
+}
+
+void LoudnessMeter::mergeHistogram(QVector<quint32> &target, const QVector<quint32> &source)
+{
+    if (target.size() < source.size()) {
+        target.resize(source.size());
+    }
+    for (int bin = 0; bin < source.size(); ++bin) {
+        target[bin] += source[bin];
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef LOUDNESSMETER_H
+#define LOUDNESSMETER_H
+
+#include <QVector>
+
+// EBU R128 / ITU-R BS.1770 响度测量
+// K 计权滤波 + 400ms 门限块（75% 重叠），块响度记入直方图以便按专辑合并
+class LoudnessMeter
+{
+public:
+    enum { HistogramBins = 750 };  // -70 ~ +5 LUFS，0.1 LU 精度
+
+    LoudnessMeter(int sampleRate, int channels);
+
+    // 输入交错的 float 样本
+    void process(const float *samples, int frames);
+
+    double integratedLoudness() const;  // LUFS，没有有效块时返回 -HUGE_VAL
+    double truePeak() const;            // 4 倍过采样后的峰值（线性幅度）
+    const QVector<quint32> &histogram() const { return m_histogram; }
+
+    // 由（可能合并了多首歌曲的）直方图计算综合响度，用于专辑响度
+    static double integratedLoudness(const QVector<quint32> &histogram);
+    static void mergeHistogram(QVector<quint32> &target, const QVector<quint32> &source);
+
+private:
+    template <int Channels>
+    double filterBlock(const float *samples, int frames);
+    double filterBlockGeneric(const float *samples, int frames);
+    void updateTruePeak(const float *samples, int frames);
+    void finishSubBlock();
+
+private:
+    int m_sampleRate;
+    int m_channels;
+
+    // K 计权：高架滤波 + RLB 高通，两级双二阶
+    double m_shelfB[3], m_shelfA[2];
+    double m_highpassB[3], m_highpassA[2];
+    QVector<double> m_state;    // 每个声道 4 个状态量
+    QVector<double> m_weights;  // 声道权重（环绕声道 1.41，LFE 0）
+
+    // 100ms 子块累加，每 4 个子块组成一个 400ms 门限块
+    int m_subBlockFrames;
+    int m_subBlockPosition;
+    double m_subBlockEnergy;
+    double m_recentEnergy[4];
+    int m_subBlockCount;
+    QVector<quint32> m_histogram;
+
+    // 真峰值：4 相多相插值
+    enum { PeakTaps = 12 };
+    double m_peakPhases[3][PeakTaps];
+    QVector<float> m_peakHistory;  // 每声道 2 * PeakTaps，避免取模
+    int m_peakPosition;
+    double m_truePeak;
+};
+
+#endif // LOUDNESSMETER_H
@@ -0,0 +1,193 @@
+#include "metadataprober.h"
+#include "ioscheduler.h"
+#include <QMediaPlayer>
+#include <QMediaContent>
+#include <QFileInfo>
+#include <QDebug>
+
+namespace {
+const int IoRetryInterval = 100;  // 毫秒
+}
+
+MetadataProber::MetadataProber(QObject *parent)
+    : QObject(parent)
+    , m_player(new QMediaPlayer(this))
+    , m_timeout(MusicFile::DefaultMetadataTimeout)
+    , m_timedOut(0)
+    , m_maxLatency(0)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(0);
+    connect(&m_timer, &QTimer::timeout, this, &MetadataProber::probeNext);
+
+    m_deadline.setSingleShot(true);
+    connect(&m_deadline, &QTimer::timeout, this, &MetadataProber::onDeadline);
+
+    m_ioRetry.setSingleShot(true);
+    m_ioRetry.setInterval(IoRetryInterval);
+    connect(&m_ioRetry, &QTimer::timeout, this, &MetadataProber::probeNext);
+
+    // 只用来读取元数据，不输出声音
+    m_player->setMuted(true);
+    connect(m_player, QOverload<>::of(&QMediaPlayer::metaDataChanged), this, &MetadataProber::checkCurrent);
+    connect(m_player, &QMediaPlayer::durationChanged, this, &MetadataProber::checkCurrent);
+    connect(m_player, &QMediaPlayer::mediaStatusChanged, this, &MetadataProber::checkCurrent);
+}
+
+void MetadataProber::enqueue(const QStringList &filePaths)
+{
+    for (const QString &path : filePaths) {
+        if (!m_pending.contains(path) && path != m_current) {
+            m_pending.insert(path);
+            m_queue.enqueue(path);
+        }
+    }
+    if (!m_pending.isEmpty() && m_current.isEmpty()) {
+        m_timer.start();
+    }
+}
+
+void MetadataProber::setPrioritized(const QStringList &filePaths)
+{
+    // 只保留仍在等待探测的条目；移出优先队列的条目仍在后台队列中
+    m_prioritized.clear();
+    for (const QString &path : filePaths) {
+        if (m_pending.contains(path)) {
+            m_prioritized.append(path);
+        }
+    }
+    if (!m_prioritized.isEmpty() && m_current.isEmpty()) {
+        m_timer.start();
+    }
+}
+
+void MetadataProber::cancel(const QStringList &filePaths)
+{
+    for (const QString &path : filePaths) {
+        m_pending.remove(path);
+        m_prioritized.removeAll(path);
+        if (path == m_current) {
+            abortCurrent();
+        }
+    }
+    // 后台队列中的路径在取出时跳过，不必逐个查找
+    if (m_pending.isEmpty()) {
+        m_queue.clear();
+    }
+}
+
+void MetadataProber::clear()
+{
+    m_prioritized.clear();
+    m_queue.clear();
+    m_pending.clear();
+    m_timer.stop();
+    m_ioRetry.stop();
+    if (!m_current.isEmpty()) {
+        abortCurrent();
+    }
+}
+
+int MetadataProber::pendingCount() const
+{
+    return m_pending.size() + (m_current.isEmpty() ? 0 : 1);
+}
+
+QString MetadataProber::takeNext()
+{
+    while (!m_prioritized.isEmpty()) {
+        const QString path = m_prioritized.takeFirst();
+        if (m_pending.remove(path)) {
+            return path;
+        }
+    }
+    while (!m_queue.isEmpty()) {
+        const QString path = m_queue.dequeue();
+        if (m_pending.remove(path)) {
+            return path;
+        }
+    }
+    return QString();
+}
+
+void MetadataProber::probeNext()
+{
+    if (!m_current.isEmpty()) {
+        return;
+    }
+    // 探测由 QMediaPlayer 在其他线程读取文件，无法经过 IoScheduler 限速；
+    // 播放缓冲区偏低时推迟，不在这时打开新文件
+    if (IoScheduler::instance()->isBackedOff()) {
+        m_ioRetry.start();
+        return;
+    }
+
+    while (true) {
+        const QString path = takeNext();
+        if (path.isEmpty()) {
+            emit finished();
+            return;
+        }
+
+        // 不存在的文件保留占位条目
+        if (!QFileInfo(path).isFile()) {
+            qDebug() << "播放列表中的文件不存在:" << path;
+            continue;
+        }
+
+        m_current = path;
+        m_elapsed.start();
+        m_deadline.start(m_timeout);
+        m_player->setMedia(QMediaContent(QUrl::fromLocalFile(path)));
+        // 有的后端在 setMedia() 中同步载入完成
+        checkCurrent();
+        return;
+    }
+}
+
+void MetadataProber::checkCurrent()
+{
+    if (m_current.isEmpty()) {
+        return;
+    }
+    if (MusicFile::isMetadataReady(*m_player)) {
+        finishCurrent();
+    } else if (m_player->mediaStatus() == QMediaPlayer::InvalidMedia) {
+        qDebug() << "无法读取元数据:" << m_current << m_player->errorString();
+        finishCurrent();
+    }
+}
+
+void MetadataProber::onDeadline()
+{
+    if (m_current.isEmpty()) {
+        return;
+    }
+    ++m_timedOut;
+    qDebug() << "读取元数据超时:" << m_current;
+    finishCurrent();
+}
+
+void MetadataProber::finishCurrent()
+{
+    m_deadline.stop();
+    m_maxLatency = qMax(m_maxLatency, m_elapsed.elapsed());
+
+    // 失败或超时也记录修改时间，按已读到的信息结束，避免反复探测同一个坏文件
+    MusicFile file = MusicFile::placeholder(m_current);
+    file.setLastModified(QFileInfo(m_current).lastModified());
+    file.readMetadata(*m_player);
+
+    m_current.clear();
+    m_player->setMedia(QMediaContent());
+    emit probed(file);
+    m_timer.start();
+}
+
+void MetadataProber::abortCurrent()
+{
+    m_deadline.stop();
+    m_current.clear();
+    m_player->setMedia(QMediaContent());
+    m_timer.start();
+}
@@ -0,0 +1,69 @@
+#ifndef METADATAPROBER_H
+#define METADATAPROBER_H
+
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "models/musicfile.h"
+
+class QMediaPlayer;
+
+// 未探测条目的元数据探测队列
+// 探测依赖 QMediaPlayer，只能在主线程进行。这里复用一个播放器异步等待元数据，不进入嵌套事件循环；
+// 每个文件有截止时间，损坏的文件超时后按已读到的信息（至少有文件名）结束，不会卡住队列。
+// 优先探测界面上可见或即将播放的条目，其余按加入顺序在后台探测。
+class MetadataProber : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetadataProber(QObject *parent = nullptr);
+
+    void enqueue(const QStringList &filePaths);
+    // 设置优先探测的条目（按先后顺序），上一次设置中不再出现的条目回到后台队列
+    void setPrioritized(const QStringList &filePaths);
+    // 取消探测（条目已被删除），正在探测的文件会立即中止
+    void cancel(const QStringList &filePaths);
+    void clear();
+    int pendingCount() const;
+
+    // 单个文件的最长探测时间（毫秒）
+    void setTimeout(int ms) { m_timeout = ms; }
+    int timeout() const { return m_timeout; }
+
+    // 统计：超时的文件数和单个文件的最长耗时
+    int timedOutCount() const { return m_timedOut; }
+    qint64 maxLatency() const { return m_maxLatency; }
+
+signals:
+    void probed(const MusicFile &file);
+    void finished();
+
+private slots:
+    void probeNext();
+    void checkCurrent();
+    void onDeadline();
+
+private:
+    QString takeNext();
+    void finishCurrent();
+    void abortCurrent();
+
+private:
+    QMediaPlayer *m_player;
+    QStringList m_prioritized;       // 优先队列，按界面顺序
+    QQueue<QString> m_queue;         // 后台队列，可能含有已取消或已探测的路径，取出时跳过
+    QSet<QString> m_pending;         // 尚未探测的路径
+    QString m_current;               // 正在探测的文件
+    QTimer m_timer;
+    QTimer m_deadline;
+    QTimer m_ioRetry;                // 播放缓冲区偏低时推迟下一次探测
+    QElapsedTimer m_elapsed;
+    int m_timeout;
+    int m_timedOut;
+    qint64 m_maxLatency;
+};
+
+#endif // METADATAPROBER_H
@@ -1,42 +1,101 @@
 #include "musicplayer.h"
+#include "audioengine.h"
+#include "models/musiclibrary.h"
+#include "playstatslog.h"
+#include "trackvalidator.h"
+#include "seektablecache.h"
+#include "trackheadcache.h"
+#include <QtMath>
+#include <QDebug>
+
+namespace {
+const double ReferenceLoudness = -18.0;  // 目标响度（LUFS）
+const double PeakCeiling = 0.0;          // 增益后真峰值不超过 0 dBTP
+const int MaxSkippedTracks = 64;         // 切歌时最多连续跳过的无法播放歌曲数
+const int ScrubSnippetMs = 120;          // 暂停时拖动试听的片段长度
+const int MinScrubInterval = 60;         // 拖动中两次跳转的最小间隔（毫秒）
+const int MaxScrubInterval = 300;
+}
 
 MusicPlayer::MusicPlayer(QObject *parent)
     : QObject(parent)
-    , m_player(new QMediaPlayer(this))
+    , m_player(new AudioEngine(this))
+    , m_playlist(nullptr)
+    , m_library(nullptr)
+    , m_statsLog(nullptr)
+    , m_validator(nullptr)
+    , m_seekTables(nullptr)
+    , m_headCache(nullptr)
+    , m_volume(50)
+    , m_trackGain(0.0)
+    , m_gainMode(GainTrack)
+    , m_statsStarted(false)
+    , m_statsFinished(false)
+    , m_wantPlaying(false)
+    , m_sourceFailed(false)
+    , m_scrubbing(false)
+    , m_scrubPreview(true)
+    , m_awaitingScrubEnd(false)
+    , m_scrubTarget(-1)
+    , m_scrubSeeks(0)
+    , m_lastScrubSeeks(0)
+    , m_lastSeekLatency(-1)
 {
     // 连接信号
-    connect(m_player, &QMediaPlayer::stateChanged, this, &MusicPlayer::stateChanged);
-    connect(m_player, &QMediaPlayer::positionChanged, this, &MusicPlayer::positionChanged);
-    connect(m_player, &QMediaPlayer::durationChanged, this, &MusicPlayer::durationChanged);
-    connect(m_player, &QMediaPlayer::mediaStatusChanged, this, &MusicPlayer::mediaStatusChanged);
-    connect(m_player, &QMediaPlayer::mediaStatusChanged, this, &MusicPlayer::onMediaStatusChanged);
-    
-    // 使用 Qt5 风格的错误信号连接
-    connect(m_player, static_cast<void(QMediaPlayer::*)(QMediaPlayer::Error)>(&QMediaPlayer::error),
-            this, [this](QMediaPlayer::Error error) {
-                emit errorOccurred(m_player->errorString());
-            });
+    connect(m_player, &AudioEngine::stateChanged, this, &MusicPlayer::stateChanged);
+    connect(m_player, &AudioEngine::stateChanged, this, &MusicPlayer::onStateChanged);
+    connect(m_player, &AudioEngine::positionChanged, this, &MusicPlayer::positionChanged);
+    connect(m_player, &AudioEngine::durationChanged, this, &MusicPlayer::durationChanged);
+    connect(m_player, &AudioEngine::mediaStatusChanged, this, &MusicPlayer::mediaStatusChanged);
+    connect(m_player, &AudioEngine::mediaStatusChanged, this, &MusicPlayer::onMediaStatusChanged);
+    connect(m_player, &AudioEngine::error, this, &MusicPlayer::skipFailedTrack);
+    connect(m_player, &AudioEngine::seekCompleted, this, &MusicPlayer::onSeekCompleted);
+
+    m_scrubTimer.setSingleShot(true);
+    connect(&m_scrubTimer, &QTimer::timeout, this, &MusicPlayer::issueScrubSeek);
 
     // 设置默认音量
-    m_player->setVolume(50);
+    applyVolume();
 }
 
 MusicPlayer::~MusicPlayer()
 {
 }
 
+void MusicPlayer::setSeekTables(SeekTableCache *cache)
+{
+    if (m_seekTables) {
+        disconnect(m_seekTables, nullptr, this, nullptr);
+    }
+    m_seekTables = cache;
+    if (m_seekTables) {
+        connect(m_seekTables, &SeekTableCache::tableReady, this, &MusicPlayer::onSeekTableReady);
+    }
+}
+
+void MusicPlayer::onSeekTableReady(const QString &filePath)
+{
+    // 跳转表在后台建立，可能在歌曲开始播放之后才到达
+    if (m_source.isLocalFile() && m_source.toLocalFile() == filePath) {
+        m_player->setSeekTable(m_seekTables->table(filePath));
+    }
+}
+
 void MusicPlayer::play()
 {
+    m_wantPlaying = true;
     m_player->play();
 }
 
 void MusicPlayer::pause()
 {
+    m_wantPlaying = false;
     m_player->pause();
 }
 
 void MusicPlayer::stop()
 {
+    m_wantPlaying = false;
     m_player->stop();
 }
 
@@ -52,18 +111,172 @@ void MusicPlayer::previous()
 
 void MusicPlayer::setVolume(int volume)
 {
-    m_player->setVolume(volume);
-    emit volumeChanged(volume);
+    m_volume = qBound(0, volume, 100);
+    applyVolume();
+    emit volumeChanged(m_volume);
 }
 
 void MusicPlayer::setPosition(qint64 position)
 {
+    if (m_statsLog && m_statsStarted) {
+        m_statsLog->record(PlayStatsLog::Seek, m_statsPath, position);
+    }
     m_player->setPosition(position);
 }
 
+void MusicPlayer::beginScrub()
+{
+    m_scrubbing = true;
+    m_awaitingScrubEnd = false;
+    m_scrubTarget = -1;
+    m_scrubSeeks = 0;
+    m_scrubClock.invalidate();
+}
+
+void MusicPlayer::scrubTo(qint64 position)
+{
+    if (!m_scrubbing) {
+        setPosition(position);
+        return;
+    }
+    m_scrubTarget = position;
+    if (!m_scrubPreview || m_scrubTimer.isActive()) {
+        return;
+    }
+    // 上一次跳转还没来得及出声就再跳没有意义，间隔跟随引擎实际的跳转耗时
+    const qint64 interval = qBound<qint64>(MinScrubInterval, m_lastSeekLatency, MaxScrubInterval);
+    const qint64 wait = m_scrubClock.isValid() ? interval - m_scrubClock.elapsed() : 0;
+    if (wait <= 0) {
+        issueScrubSeek();
+    } else {
+        m_scrubTimer.start(int(wait));
+    }
+}
+
+void MusicPlayer::issueScrubSeek()
+{
+    if (!m_scrubbing || m_scrubTarget < 0) {
+        return;
+    }
+    m_player->preview(m_scrubTarget, ScrubSnippetMs);
+    m_scrubTarget = -1;
+    ++m_scrubSeeks;
+    m_scrubClock.start();
+}
+
+void MusicPlayer::endScrub(qint64 position)
+{
+    m_scrubTimer.stop();
+    m_scrubTarget = -1;
+    if (!m_scrubbing) {
+        setPosition(position);
+        return;
+    }
+    m_scrubbing = false;
+    setPosition(position);
+    m_lastScrubSeeks = ++m_scrubSeeks;
+    m_awaitingScrubEnd = m_player->state() == QMediaPlayer::PlayingState;
+    if (!m_awaitingScrubEnd) {
+        // 暂停时松开后不出声，没有延迟可统计
+        emit scrubFinished(m_lastScrubSeeks, -1);
+    }
+}
+
+void MusicPlayer::onSeekCompleted(qint64 latencyMs)
+{
+    m_lastSeekLatency = latencyMs;
+    if (m_awaitingScrubEnd) {
+        m_awaitingScrubEnd = false;
+        qDebug() << "拖动进度条: 跳转" << m_lastScrubSeeks << "次，松开后" << latencyMs << "ms 出声";
+        emit scrubFinished(m_lastScrubSeeks, latencyMs);
+    }
+}
+
 void MusicPlayer::setSource(const QUrl &source)
 {
-    m_player->setMedia(QMediaContent(source));
+    // 上一首开始播放但没有播完就切换，记为跳过
+    if (m_statsLog && m_statsStarted && !m_statsFinished) {
+        m_statsLog->record(PlayStatsLog::Skip, m_statsPath, m_player->position());
+    }
+    m_statsPath = source.isLocalFile() ? source.toLocalFile() : source.toString();
+    m_statsStarted = false;
+    m_statsFinished = false;
+    m_sourceFailed = false;
+
+    m_source = source;
+    m_scrubTimer.stop();
+    m_scrubbing = false;
+    m_awaitingScrubEnd = false;
+    updateTrackGain();
+    // 预先解码好开头的歌曲立即出声，其余部分随后从文件接上
+    const TrackHead head = m_headCache && source.isLocalFile() ? m_headCache->lookup(source.toLocalFile()) : TrackHead();
+    m_player->setMedia(source, head);
+    if (m_seekTables && source.isLocalFile()) {
+        m_seekTables->request(source.toLocalFile());
+    }
+}
+
+void MusicPlayer::setReplayGainMode(ReplayGainMode mode)
+{
+    m_gainMode = mode;
+    updateTrackGain();
+}
+
+void MusicPlayer::updateTrackGain()
+{
+    m_trackGain = 0.0;
+    if (m_gainMode != GainOff && m_library && m_source.isLocalFile()) {
+        const MusicFile file = m_library->file(m_source.toLocalFile());
+        float loudness = file.trackLoudness();
+        float peak = file.trackPeak();
+        if (m_gainMode == GainAlbum && !qIsNaN(file.albumLoudness())) {
+            loudness = file.albumLoudness();
+            peak = file.albumPeak();
+        }
+        if (!qIsNaN(loudness)) {
+            m_trackGain = ReferenceLoudness - loudness;
+            // 提升增益时避免削波
+            if (peak > 0.0f) {
+                double peakDb = 20.0 * std::log10(double(peak));
+                m_trackGain = qMin(m_trackGain, PeakCeiling - peakDb);
+            }
+        }
+    }
+    applyVolume();
+}
+
+DspChain::Parameters MusicPlayer::equalizer() const
+{
+    return m_player->dsp()->parameters();
+}
+
+void MusicPlayer::setEqualizer(const DspChain::Parameters &parameters)
+{
+    m_player->dsp()->setParameters(parameters);
+}
+
+PcmRing *MusicPlayer::pcmTap() const
+{
+    return m_player->tap();
+}
+
+void MusicPlayer::setPcmTapEnabled(bool enabled)
+{
+    m_player->setTapEnabled(enabled);
+}
+
+QAudioFormat MusicPlayer::outputFormat() const
+{
+    return m_player->outputFormat();
+}
+
+void MusicPlayer::applyVolume()
+{
+    // 音量是线性幅度，均衡增益换算为倍数后叠加到用户音量上；
+    // 增益在 DSP 链中施加，提升后超过满幅的部分由限幅器处理，不再截断在 100%
+    // （引擎退回 QMediaPlayer 时仍截断）
+    double factor = std::pow(10.0, m_trackGain / 20.0);
+    m_player->setGain(float(m_volume / 100.0 * factor));
 }
 
 Playlist::PlayMode MusicPlayer::playMode() const
@@ -124,7 +337,7 @@ qint64 MusicPlayer::duration() const
 
 int MusicPlayer::volume() const
 {
-    return m_player->volume();
+    return m_volume;
 }
 
 void MusicPlayer::onPlaylistChanged()
@@ -133,58 +346,102 @@ void MusicPlayer::onPlaylistChanged()
     // 只有在播放列表为空时才停止播放
     if (m_player->state() != QMediaPlayer::StoppedState && m_playlist && m_playlist->count() == 0) {
         stop();
-        m_player->setMedia(QMediaContent());  // 清除当前媒体
+        m_player->setMedia(QUrl());  // 清除当前媒体
+    }
+}
+
+void MusicPlayer::onStateChanged(QMediaPlayer::State state)
+{
+    // 每次设置歌曲后第一次进入播放状态记为开始播放；单曲循环重新播放时也算一次
+    if (state == QMediaPlayer::PlayingState && !m_statsStarted && !m_statsPath.isEmpty()) {
+        m_statsStarted = true;
+        m_statsFinished = false;
+        if (m_statsLog) {
+            m_statsLog->record(PlayStatsLog::Start, m_statsPath);
+        }
     }
 }
 
 void MusicPlayer::onMediaStatusChanged(QMediaPlayer::MediaStatus status)
 {
+    if (status == QMediaPlayer::EndOfMedia && m_statsStarted) {
+        m_statsStarted = false;
+        m_statsFinished = true;
+        if (m_statsLog) {
+            m_statsLog->record(PlayStatsLog::Finish, m_statsPath, m_player->duration());
+        }
+    }
+
+    if (status == QMediaPlayer::InvalidMedia) {
+        skipFailedTrack(m_player->errorString());
+        return;
+    }
+
     if (status == QMediaPlayer::EndOfMedia && m_playlist) {
         switch (m_playlist->playMode()) {
-            case Playlist::Sequential: {
-                // 顺序播放模式：如果不是最后一首，播放下一首
-                int nextIndex = m_playlist->currentIndex() + 1;
-                if (nextIndex < m_playlist->count()) {
-                    m_playlist->setCurrentIndex(nextIndex);
-                    MusicFile nextFile = m_playlist->at(nextIndex);
-                    setSource(nextFile.fileUrl());
-                    emit currentSongChanged(nextIndex);  // 发送歌曲改变信号
-                    play();
+            case Playlist::Sequential:
+            case Playlist::Random:
+            case Playlist::RepeatAll: {
+                // 顺序播放到最后一首后停止；随机和列表循环总有下一首，除非后面的歌曲都无法播放
+                int nextIndex = nextPlayableIndex();
+                if (nextIndex != -1) {
+                    playIndex(nextIndex);
                 } else {
-                    // 最后一首播放完就停止
                     stop();
                 }
                 break;
             }
-            case Playlist::Random: {
-                // 随机播放模式：随机选择一首
-                int nextIndex = m_playlist->nextIndex();
-                if (nextIndex != -1) {
-                    m_playlist->setCurrentIndex(nextIndex);
-                    MusicFile nextFile = m_playlist->at(nextIndex);
-                    setSource(nextFile.fileUrl());
-                    emit currentSongChanged(nextIndex);  // 发送歌曲改变信号
-                    play();
-                }
-                break;
-            }
             case Playlist::RepeatOne: {
                 // 单曲循环模式：重新播放当前歌曲
                 play();
                 break;
             }
-            case Playlist::RepeatAll: {
-                // 列表循环模式：播放下一首（如果是最后一首则回到第一首）
-                int nextIndex = m_playlist->nextIndex();
-                if (nextIndex != -1) {
-                    m_playlist->setCurrentIndex(nextIndex);
-                    MusicFile nextFile = m_playlist->at(nextIndex);
-                    setSource(nextFile.fileUrl());
-                    emit currentSongChanged(nextIndex);  // 发送歌曲改变信号
-                    play();
-                }
-                break;
-            }
         }
     }
-} 
\ No newline at end of file
+}
+
+int MusicPlayer::nextPlayableIndex() const
+{
+    const QList<int> upcoming = m_playlist->upcomingIndices(MaxSkippedTracks);
+    for (int index : upcoming) {
+        if (!m_validator || m_validator->isPlayable(m_playlist->at(index).filePath())) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+void MusicPlayer::playIndex(int index)
+{
+    m_playlist->setCurrentIndex(index);
+    MusicFile nextFile = m_playlist->at(index);
+    setSource(nextFile.fileUrl());
+    emit currentSongChanged(index);  // 发送歌曲改变信号
+    play();
+}
+
+void MusicPlayer::skipFailedTrack(const QString &error)
+{
+    // 错误信号和 InvalidMedia 状态可能先后到达，同一首只处理一次
+    if (m_sourceFailed || m_source.isEmpty()) {
+        return;
+    }
+    m_sourceFailed = true;
+    emit errorOccurred(error);
+
+    if (m_validator && m_source.isLocalFile()) {
+        m_validator->markFailed(m_source.toLocalFile(), error);
+    }
+
+    // 正在播放列表时直接切到下一首可以播放的歌曲，不停下来等用户处理
+    if (!m_wantPlaying || !m_playlist || m_playlist->currentIndex() < 0
+        || m_playlist->playMode() == Playlist::RepeatOne) {
+        return;
+    }
+    int nextIndex = nextPlayableIndex();
+    if (nextIndex != -1 && nextIndex != m_playlist->currentIndex()) {
+        playIndex(nextIndex);
+    } else {
+        stop();
+    }
+}
@@ -5,12 +5,31 @@
 #include <QMediaPlayer>
 #include <QUrl>
 #include <QMediaContent>
+#include <QAudioFormat>
+#include <QTimer>
+#include <QElapsedTimer>
 #include "models/playlist.h"
+#include "dspchain.h"
+
+class AudioEngine;
+class PcmRing;
+class MusicLibrary;
+class PlayStatsLog;
+class SeekTableCache;
+class TrackHeadCache;
+class TrackValidator;
 
 class MusicPlayer : public QObject
 {
     Q_OBJECT
 public:
+    // 音量均衡模式
+    enum ReplayGainMode {
+        GainOff,    // 关闭
+        GainTrack,  // 按单曲响度
+        GainAlbum   // 按专辑响度
+    };
+
     explicit MusicPlayer(QObject *parent = nullptr);
     ~MusicPlayer();
 
@@ -23,7 +42,38 @@ public:
     void setVolume(int volume);
     void setPosition(qint64 position);
     void setSource(const QUrl &source);
+
+    // 拖动进度条：拖动过程中只保留最新的目标位置，按引擎跳转的实际耗时限制频率；
+    // 关闭试听时拖动中不跳转，松开后只跳转一次
+    void beginScrub();
+    void scrubTo(qint64 position);
+    void endScrub(qint64 position);
+    bool isScrubbing() const { return m_scrubbing; }
+    bool scrubPreview() const { return m_scrubPreview; }
+    void setScrubPreview(bool enabled) { m_scrubPreview = enabled; }
+    // 统计：上一次拖动实际执行的跳转次数，最近一次跳转从发出到出声的时间（毫秒，-1 表示未知）
+    int lastScrubSeeks() const { return m_lastScrubSeeks; }
+    qint64 lastSeekLatency() const { return m_lastSeekLatency; }
     void setPlaylist(Playlist *playlist) { m_playlist = playlist; }
+    void setLibrary(MusicLibrary *library) { m_library = library; }
+    void setStatsLog(PlayStatsLog *log) { m_statsLog = log; }
+    void setValidator(TrackValidator *validator) { m_validator = validator; }
+    void setSeekTables(SeekTableCache *cache);
+    void setHeadCache(TrackHeadCache *cache) { m_headCache = cache; }
+    
+    // 音量均衡：开始播放时按音乐库中保存的响度调整增益
+    ReplayGainMode replayGainMode() const { return m_gainMode; }
+    void setReplayGainMode(ReplayGainMode mode);
+    double currentGain() const { return m_trackGain; }  // 当前歌曲的增益（dB）
+
+    // 均衡器、前级增益和限幅器，修改后在音频线程中平滑过渡
+    DspChain::Parameters equalizer() const;
+    void setEqualizer(const DspChain::Parameters &parameters);
+
+    // 频谱显示：输出前 PCM 数据的副本（只在启用时写入）及其格式
+    PcmRing *pcmTap() const;
+    void setPcmTapEnabled(bool enabled);
+    QAudioFormat outputFormat() const;
     
     // 播放模式控制
     Playlist::PlayMode playMode() const;
@@ -41,6 +91,7 @@ public:
 
 private slots:
     void onMediaStatusChanged(QMediaPlayer::MediaStatus status);  // 添加处理播放结束的槽函数
+    void onStateChanged(QMediaPlayer::State state);
 
 signals:
     void stateChanged(QMediaPlayer::State state);
@@ -51,10 +102,45 @@ signals:
     void errorOccurred(const QString &error);
     void playModeChanged(Playlist::PlayMode mode);  // 新增播放模式改变信号
     void currentSongChanged(int index);  // 新增：当前歌曲改变信号
+    void scrubFinished(int seeks, qint64 latencyMs);  // 拖动结束且松开后的跳转已出声
+
+private:
+    void updateTrackGain();
+    void applyVolume();
+    int nextPlayableIndex() const;  // 跳过预读检查判定为无法播放的歌曲，没有可播放的返回 -1
+    void playIndex(int index);
+    void skipFailedTrack(const QString &error);
+    void onSeekTableReady(const QString &filePath);
+    void issueScrubSeek();
+    void onSeekCompleted(qint64 latencyMs);
 
 private:
-    QMediaPlayer *m_player;
+    AudioEngine *m_player;
     Playlist *m_playlist;  // 不拥有此指针
+    MusicLibrary *m_library;  // 不拥有此指针
+    PlayStatsLog *m_statsLog;  // 不拥有此指针
+    TrackValidator *m_validator;  // 不拥有此指针
+    SeekTableCache *m_seekTables;  // 不拥有此指针
+    TrackHeadCache *m_headCache;  // 不拥有此指针
+    QUrl m_source;
+    int m_volume;          // 用户设置的音量
+    double m_trackGain;    // 当前歌曲的均衡增益（dB）
+    ReplayGainMode m_gainMode;
+    QString m_statsPath;   // 当前歌曲的路径，用于记录播放统计
+    bool m_statsStarted;   // 当前歌曲已记录开始播放
+    bool m_statsFinished;  // 当前歌曲已播放完毕
+    bool m_wantPlaying;    // 用户要求播放（未暂停或停止）
+    bool m_sourceFailed;   // 当前歌曲已按出错处理
+
+    QTimer m_scrubTimer;          // 距上次跳转不足间隔时，到时间再跳到最新目标
+    QElapsedTimer m_scrubClock;   // 上次拖动中跳转的时间
+    bool m_scrubbing;
+    bool m_scrubPreview;
+    bool m_awaitingScrubEnd;      // 松开后的跳转还没有出声
+    qint64 m_scrubTarget;         // 尚未执行的最新目标，-1 表示没有
+    int m_scrubSeeks;
+    int m_lastScrubSeeks;
+    qint64 m_lastSeekLatency;
 };
 
 #endif // MUSICPLAYER_H 
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "pcmdecoder.h"
+#include "ioscheduler.h"
+#include <QAudioDecoder>
+#include <QAudioBuffer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QtEndian>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+const int DefaultTimeout = 10000;  // 毫秒
+
+// 本机字节序的 16/32 位整数批量转换为 float，返回已处理的样本数（4 或 8 的倍数），余下的由调用者逐个转换
+int convertInt16(const uchar *data, float *dst, int count)
+{
+#if defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i * 2));
+        // 放到 32 位的高半部分再算术右移，完成符号扩展
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    return i;
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(dst);
+    Q_UNUSED(count);
+    return 0;
+#endif
+}
+
+int convertInt32(const uchar *data, float *dst, int count)
+{
+#if defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i * 4));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+    return i;
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(dst);
+    Q_UNUSED(count);
+    return 0;
+#endif
+}
+
+}
+
+PcmDecoder::PcmDecoder()
+    : m_timeout(DefaultTimeout)
+    , m_decodedFrames(0)
+    , m_sampleRate(0)
+    , m_channelCount(0)
+{
+}
+
+bool PcmDecoder::isAvailable()
+{
+    static const bool available = QAudioDecoder().isAvailable();
+    return available;
+}
+
+bool PcmDecoder::decode(const QString &filePath, const Sink &sink, const std::atomic<bool> *canceled)
+{
+    m_errorString.clear();
+    m_decodedFrames = 0;
+    m_sampleRate = 0;
+    m_channelCount = 0;
+
+    // 后台解码经过 I/O 调度读取文件，不与正在播放的歌曲争抢磁盘
+    ScheduledFile file(filePath, canceled);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_errorString = file.errorString();
+        return false;
+    }
+    QAudioDecoder decoder;
+    decoder.setSourceDevice(&file);
+
+    QEventLoop loop;
+    QTimer watchdog;
+    watchdog.setSingleShot(true);
+    watchdog.setInterval(m_timeout);
+    QTimer cancelPoll;
+    cancelPoll.setInterval(50);
+
+    bool ok = true;
+    bool done = false;
+    QVector<float> samples;
+
+    auto finish = [&](bool success, const QString &error) {
+        if (done) {
+            return;
+        }
+        done = true;
+        ok = success;
+        if (!success) {
+            m_errorString = error;
+        }
+        decoder.stop();
+        loop.quit();
+    };
+
+    QObject::connect(&decoder, &QAudioDecoder::bufferReady, &loop, [&]() {
+        while (!done && decoder.bufferAvailable()) {
+            QAudioBuffer buffer = decoder.read();
+            if (!buffer.isValid()) {
+                continue;
+            }
+            if (!toFloat(buffer, samples)) {
+                finish(false, QStringLiteral("不支持的采样格式"));
+                return;
+            }
+            m_channelCount = buffer.format().channelCount();
+            m_sampleRate = buffer.format().sampleRate();
+            int frames = buffer.frameCount();
+            m_decodedFrames += frames;
+            if (!sink(samples.constData(), frames, m_channelCount, m_sampleRate)) {
+                finish(true, QString());
+                return;
+            }
+        }
+        watchdog.start();
+    });
+    QObject::connect(&decoder, &QAudioDecoder::finished, &loop, [&]() {
+        finish(m_decodedFrames > 0, QStringLiteral("没有解码出任何音频数据"));
+    });
+    QObject::connect(&decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error), &loop, [&]() {
+        finish(false, decoder.errorString());
+    });
+    QObject::connect(&watchdog, &QTimer::timeout, &loop, [&]() {
+        finish(false, QStringLiteral("解码超时"));
+    });
+    QObject::connect(&cancelPoll, &QTimer::timeout, &loop, [&]() {
+        if (canceled->load(std::memory_order_relaxed)) {
+            finish(false, QStringLiteral("已取消"));
+        }
+    });
+
+    decoder.start();
+    watchdog.start();
+    if (canceled) {
+        cancelPoll.start();
+    }
+    // 错误信号可能在 start() 中同步发出
+    if (!done) {
+        loop.exec();
+    }
+    return ok;
+}
+
+bool PcmDecoder::toFloat(const QAudioBuffer &buffer, QVector<float> &out)
+{
+    const QAudioFormat format = buffer.format();
+    const int sampleCount = buffer.sampleCount();
+    const uchar *data = buffer.constData<uchar>();
+    const bool bigEndian = format.byteOrder() == QAudioFormat::BigEndian;
+    const bool nativeOrder = bigEndian == (Q_BYTE_ORDER == Q_BIG_ENDIAN);
+    out.resize(sampleCount);
+    float *dst = out.data();
+
+    switch (format.sampleType()) {
+    case QAudioFormat::Float:
+        if (format.sampleSize() != 32) {
+            return false;
+        }
+        if (nativeOrder) {
+            std::memcpy(dst, data, size_t(sampleCount) * sizeof(float));
+            return true;
+        }
+        for (int i = 0; i < sampleCount; ++i) {
+            quint32 bits = bigEndian ? qFromBigEndian<quint32>(data + i * 4) : qFromLittleEndian<quint32>(data + i * 4);
+            std::memcpy(dst + i, &bits, sizeof(float));
+        }
+        return true;
+    case QAudioFormat::SignedInt:
+        switch (format.sampleSize()) {
+        case 16:
+            for (int i = nativeOrder ? convertInt16(data, dst, sampleCount) : 0; i < sampleCount; ++i) {
+                qint16 v = bigEndian ? qFromBigEndian<qint16>(data + i * 2) : qFromLittleEndian<qint16>(data + i * 2);
+                dst[i] = v * (1.0f / 32768.0f);
+            }
+            return true;
+        case 24:
+            for (int i = 0; i < sampleCount; ++i) {
+                const uchar *p = data + i * 3;
+                quint32 v = bigEndian ? (quint32(p[0]) << 24) | (quint32(p[1]) << 16) | (quint32(p[2]) << 8)
+                                      : (quint32(p[2]) << 24) | (quint32(p[1]) << 16) | (quint32(p[0]) << 8);
+                dst[i] = qint32(v) * (1.0f / 2147483648.0f);
+            }
+            return true;
+        case 32:
+            for (int i = nativeOrder ? convertInt32(data, dst, sampleCount) : 0; i < sampleCount; ++i) {
+                qint32 v = bigEndian ? qFromBigEndian<qint32>(data + i * 4) : qFromLittleEndian<qint32>(data + i * 4);
+                dst[i] = v * (1.0f / 2147483648.0f);
+            }
+            return true;
+        default:
+            return false;
+        }
+    case QAudioFormat::UnSignedInt:
+        if (format.sampleSize() != 8) {
+            return false;
+        }
+        for (int i = 0; i < sampleCount; ++i) {
+            dst[i] = (int(data[i]) - 128) * (1.0f / 128.0f);
+        }
+        return true;
+    default:
+        return false;
+    }
+}
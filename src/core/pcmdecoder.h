@@ -0,0 +1,46 @@
+#ifndef PCMDECODER_H
+#define PCMDECODER_H
+
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <functional>
+
+class QAudioBuffer;
+
+// 同步 PCM 解码器
+// 在调用线程内运行局部事件循环驱动 QAudioDecoder，把每个缓冲区转换为交错的 float 样本
+// 供后台分析任务（响度、波形等）使用，不能在 GUI 线程中调用
+class PcmDecoder
+{
+public:
+    // 返回 false 表示不再需要后续数据
+    using Sink = std::function<bool(const float *samples, int frames, int channels, int sampleRate)>;
+
+    PcmDecoder();
+
+    // 两个缓冲区之间允许的最长等待时间，超时视为解码失败
+    void setTimeout(int ms) { m_timeout = ms; }
+
+    bool decode(const QString &filePath, const Sink &sink, const std::atomic<bool> *canceled = nullptr);
+
+    QString errorString() const { return m_errorString; }
+    qint64 decodedFrames() const { return m_decodedFrames; }
+    int sampleRate() const { return m_sampleRate; }
+    int channelCount() const { return m_channelCount; }
+
+    // 当前平台是否有 QAudioDecoder 后端（Qt 5.15 的 macOS 上没有）
+    static bool isAvailable();
+
+    // 把任意整数/浮点 PCM 缓冲区转换为交错 float
+    static bool toFloat(const QAudioBuffer &buffer, QVector<float> &out);
+
+private:
+    int m_timeout;
+    QString m_errorString;
+    qint64 m_decodedFrames;
+    int m_sampleRate;
+    int m_channelCount;
+};
+
+#endif // PCMDECODER_H
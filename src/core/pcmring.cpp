@@ -0,0 +1,73 @@
+#include "pcmring.h"
+#include <algorithm>
+
+PcmRing::PcmRing(int capacity)
+    : m_mask(0)
+    , m_head(0)
+    , m_tail(0)
+{
+    if (capacity > 0) {
+        allocate(capacity);
+    }
+}
+
+void PcmRing::allocate(int capacity)
+{
+    quint32 size = 1;
+    while (size < quint32(capacity)) {
+        size <<= 1;
+    }
+    m_buffer.reset(new float[size]);
+    m_mask = size - 1;
+    clear();
+}
+
+void PcmRing::clear()
+{
+    m_head.store(0, std::memory_order_relaxed);
+    m_tail.store(0, std::memory_order_relaxed);
+}
+
+int PcmRing::readAvailable() const
+{
+    return int(m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_relaxed));
+}
+
+int PcmRing::writeAvailable() const
+{
+    if (!m_buffer) {
+        return 0;
+    }
+    return capacity() - int(m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_acquire));
+}
+
+int PcmRing::write(const float *samples, int count)
+{
+    const quint32 tail = m_tail.load(std::memory_order_relaxed);
+    count = qMin(count, writeAvailable());
+    if (count <= 0) {
+        return 0;
+    }
+    // 可能绕回开头，分两段复制
+    const quint32 start = tail & m_mask;
+    const int first = qMin(count, int(m_mask + 1 - start));
+    std::copy(samples, samples + first, m_buffer.get() + start);
+    std::copy(samples + first, samples + count, m_buffer.get());
+    m_tail.store(tail + quint32(count), std::memory_order_release);
+    return count;
+}
+
+int PcmRing::read(float *samples, int count)
+{
+    const quint32 head = m_head.load(std::memory_order_relaxed);
+    count = qMin(count, readAvailable());
+    if (count <= 0) {
+        return 0;
+    }
+    const quint32 start = head & m_mask;
+    const int first = qMin(count, int(m_mask + 1 - start));
+    std::copy(m_buffer.get() + start, m_buffer.get() + start + first, samples);
+    std::copy(m_buffer.get(), m_buffer.get() + (count - first), samples + first);
+    m_head.store(head + quint32(count), std::memory_order_release);
+    return count;
+}
@@ -0,0 +1,32 @@
+#ifndef PCMRING_H
+#define PCMRING_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+
+// 交错 float 样本的无锁环形缓冲区（单生产者单消费者）
+// 生产者只调用 write()/writeAvailable()，消费者只调用 read()/readAvailable()；
+// clear() 和 allocate() 要求两端都没有在访问。
+class PcmRing
+{
+public:
+    explicit PcmRing(int capacity = 0);
+
+    void allocate(int capacity);  // 样本数，向上取 2 的幂
+    int capacity() const { return int(m_mask + 1); }
+    void clear();
+
+    int readAvailable() const;
+    int writeAvailable() const;
+    int write(const float *samples, int count);  // 返回实际写入的样本数
+    int read(float *samples, int count);         // 返回实际读出的样本数
+
+private:
+    std::unique_ptr<float[]> m_buffer;
+    quint32 m_mask;
+    std::atomic<quint32> m_head;  // 下一个待读取的位置，只由消费者修改
+    std::atomic<quint32> m_tail;  // 下一个待写入的位置，只由生产者修改
+};
+
+#endif // PCMRING_H
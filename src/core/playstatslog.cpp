@@ -0,0 +1,273 @@
+#include "playstatslog.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDebug>
+
+namespace {
+const quint32 LogMagic = 0x5959504c;       // "YYPL"
+const quint32 SnapshotMagic = 0x59595053;  // "YYPS"
+const quint32 FormatVersion = 2;
+const quint32 LegacyVersion = 1;  // 没有日志代号的旧格式，记录格式相同
+
+const int DrainIntervalMs = 200;
+const qint64 CompactThreshold = 256 * 1024;  // 日志超过此大小时压缩
+}
+
+PlayStatsLog::PlayStatsLog(const QString &directory, QObject *parent)
+    : QObject(parent)
+    , m_ring(new Event[Capacity])
+    , m_head(0)
+    , m_tail(0)
+    , m_dropped(0)
+    , m_stop(false)
+    , m_generation(1)
+{
+    QDir().mkpath(directory);
+    m_logPath = directory + "/playstats.log";
+    m_snapshotPath = directory + "/playstats.dat";
+}
+
+PlayStatsLog::~PlayStatsLog()
+{
+    if (m_writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        m_writer.join();
+    }
+}
+
+void PlayStatsLog::start()
+{
+    if (!m_writer.joinable()) {
+        m_writer = std::thread(&PlayStatsLog::writerLoop, this);
+    }
+}
+
+void PlayStatsLog::record(EventType type, const QString &filePath, qint64 positionMs)
+{
+    const quint32 tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) >= Capacity) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Event &event = m_ring[tail & (Capacity - 1)];
+    event.type = type;
+    event.time = QDateTime::currentMSecsSinceEpoch();
+    event.position = positionMs;
+    event.path = filePath;  // 只增加引用计数
+    m_tail.store(tail + 1, std::memory_order_release);
+}
+
+PlayStatsLog::Stats PlayStatsLog::stats(const QString &filePath) const
+{
+    return m_stats.value(filePath);
+}
+
+qint64 PlayStatsLog::droppedEvents() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+void PlayStatsLog::writerLoop()
+{
+    // 先恢复已有统计：快照 + 上次压缩后追加的日志
+    const quint64 absorbed = loadSnapshot();
+    if (!replayLog(absorbed)) {
+        // 日志已并入快照（压缩后、清空前异常退出）或无法识别，清空后重新开始
+        QFile::resize(m_logPath, 0);
+    }
+    publish(m_writerStats);
+
+    QFile log(m_logPath);
+    QDataStream out(&log);
+    out.setVersion(QDataStream::Qt_5_12);
+    auto openLog = [&]() {
+        out.resetStatus();
+        if (!log.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qDebug() << "无法打开播放统计日志:" << m_logPath << log.errorString();
+            return;
+        }
+        if (log.size() == 0) {
+            out << LogMagic << FormatVersion << m_generation;
+        }
+    };
+    openLog();
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_wake.wait_for(lock, std::chrono::milliseconds(DrainIntervalMs), [this]() { return m_stop.load(); });
+        }
+        const bool stopping = m_stop.load();
+
+        QHash<QString, Stats> changed;
+        if (drain(out, &changed)) {
+            log.flush();
+            publish(changed);
+        }
+
+        if (stopping || log.size() > CompactThreshold) {
+            log.close();
+            if (compact()) {
+                log.resize(0);
+                ++m_generation;
+            }
+            if (stopping) {
+                break;
+            }
+            openLog();
+        }
+    }
+}
+
+bool PlayStatsLog::drain(QDataStream &out, QHash<QString, Stats> *changed)
+{
+    const quint32 tail = m_tail.load(std::memory_order_acquire);
+    quint32 head = m_head.load(std::memory_order_relaxed);
+    if (head == tail) {
+        return false;
+    }
+
+    for (; head != tail; ++head) {
+        Event &event = m_ring[head & (Capacity - 1)];
+        out << event.type << event.time << event.position << event.path;
+
+        Stats &stats = m_writerStats[event.path];
+        apply(stats, event.type, event.time);
+        if (event.type != Seek) {
+            changed->insert(event.path, stats);
+        }
+        event.path = QString();  // 在后台线程释放字符串
+    }
+    m_head.store(head, std::memory_order_release);
+    return true;
+}
+
+quint64 PlayStatsLog::loadSnapshot()
+{
+    QFile file(m_snapshotPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic, version;
+    quint64 absorbed = 0;  // 旧格式的快照不包含任何有代号的日志
+    qint32 count;
+    in >> magic >> version;
+    if (magic != SnapshotMagic || (version != FormatVersion && version != LegacyVersion)) {
+        return 0;
+    }
+    if (version == FormatVersion) {
+        in >> absorbed;
+    }
+    in >> count;
+
+    m_writerStats.reserve(count);
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString path;
+        Stats stats;
+        qint32 playCount, skipCount;
+        in >> path >> playCount >> skipCount >> stats.lastPlayed;
+        stats.playCount = playCount;
+        stats.skipCount = skipCount;
+        if (in.status() == QDataStream::Ok) {
+            m_writerStats.insert(path, stats);
+        }
+    }
+    return absorbed;
+}
+
+bool PlayStatsLog::replayLog(quint64 absorbed)
+{
+    m_generation = absorbed + 1;
+    QFile file(m_logPath);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        return true;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic, version;
+    quint64 generation = 1;  // 旧格式的日志视为第一份
+    in >> magic >> version;
+    if (magic != LogMagic || (version != FormatVersion && version != LegacyVersion)) {
+        return false;
+    }
+    if (version == FormatVersion) {
+        in >> generation;
+    }
+    if (in.status() != QDataStream::Ok || generation <= absorbed) {
+        return false;
+    }
+    m_generation = generation;
+
+    // 异常退出时最后一条记录可能不完整，读到第一条坏记录为止
+    while (!in.atEnd()) {
+        Event event;
+        in >> event.type >> event.time >> event.position >> event.path;
+        if (in.status() != QDataStream::Ok) {
+            break;
+        }
+        apply(m_writerStats[event.path], event.type, event.time);
+    }
+    return true;
+}
+
+bool PlayStatsLog::compact()
+{
+    QSaveFile file(m_snapshotPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_12);
+    // 记录并入的日志代号，之后清空日志前异常退出不会重复计数
+    out << SnapshotMagic << FormatVersion << m_generation << qint32(m_writerStats.size());
+    for (auto it = m_writerStats.constBegin(); it != m_writerStats.constEnd(); ++it) {
+        out << it.key() << qint32(it->playCount) << qint32(it->skipCount) << it->lastPlayed;
+    }
+    return file.commit();
+}
+
+void PlayStatsLog::publish(const QHash<QString, Stats> &changed)
+{
+    if (changed.isEmpty()) {
+        return;
+    }
+    QMetaObject::invokeMethod(this, [this, changed]() {
+        applyChanges(changed);
+    }, Qt::QueuedConnection);
+}
+
+void PlayStatsLog::applyChanges(const QHash<QString, Stats> &changed)
+{
+    for (auto it = changed.constBegin(); it != changed.constEnd(); ++it) {
+        m_stats.insert(it.key(), it.value());
+    }
+    emit statsChanged(changed.keys());
+}
+
+void PlayStatsLog::apply(Stats &stats, quint8 type, qint64 time)
+{
+    switch (type) {
+    case Start:
+        ++stats.playCount;
+        stats.lastPlayed = qMax(stats.lastPlayed, time);
+        break;
+    case Skip:
+        ++stats.skipCount;
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef PLAYSTATSLOG_H
+#define PLAYSTATSLOG_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+class QDataStream;
+
+// 播放统计事件日志
+// 播放路径上 record() 只把事件写入无锁环形缓冲区（单生产者单消费者），不做任何 I/O；
+// 后台线程定期取出事件追加到二进制日志，同时累加到每首歌的统计，
+// 日志超过一定大小或退出时压缩为统计快照并清空日志。每份日志有递增的代号，
+// 快照记录已并入的日志代号，写完快照、清空日志之前异常退出时重放会跳过已并入的日志。
+class PlayStatsLog : public QObject
+{
+    Q_OBJECT
+public:
+    enum EventType : quint8 {
+        Start = 1,   // 开始播放
+        Finish = 2,  // 播放完毕
+        Skip = 3,    // 未播完就切换
+        Seek = 4     // 拖动进度
+    };
+
+    struct Stats
+    {
+        int playCount = 0;
+        int skipCount = 0;
+        qint64 lastPlayed = 0;  // 毫秒时间戳，0 表示从未播放
+    };
+
+    explicit PlayStatsLog(const QString &directory, QObject *parent = nullptr);
+    ~PlayStatsLog();
+
+    // 启动后台线程；载入已有统计后通过 statsChanged 通知
+    void start();
+
+    // 只能在一个线程（界面线程）调用；缓冲区满时丢弃事件，不会阻塞
+    void record(EventType type, const QString &filePath, qint64 positionMs = 0);
+
+    Stats stats(const QString &filePath) const;
+    qint64 droppedEvents() const;
+
+signals:
+    void statsChanged(const QStringList &filePaths);
+
+private:
+    struct Event
+    {
+        quint8 type = 0;
+        qint64 time = 0;
+        qint64 position = 0;
+        QString path;
+    };
+
+    void writerLoop();
+    bool drain(QDataStream &out, QHash<QString, Stats> *changed);
+    quint64 loadSnapshot();
+    bool replayLog(quint64 absorbed);
+    bool compact();
+    void publish(const QHash<QString, Stats> &changed);
+    void applyChanges(const QHash<QString, Stats> &changed);
+    static void apply(Stats &stats, quint8 type, qint64 time);
+
+private:
+    static const quint32 Capacity = 4096;  // 必须是 2 的幂
+
+    std::unique_ptr<Event[]> m_ring;
+    std::atomic<quint32> m_head;  // 下一个待读取的位置，只由后台线程修改
+    std::atomic<quint32> m_tail;  // 下一个待写入的位置，只由界面线程修改
+    std::atomic<qint64> m_dropped;
+    std::atomic<bool> m_stop;
+
+    std::thread m_writer;
+    std::mutex m_wakeMutex;  // 只用于后台线程的定时等待，record() 不加锁
+    std::condition_variable m_wake;
+
+    QString m_logPath;
+    QString m_snapshotPath;
+    QHash<QString, Stats> m_writerStats;  // 只在后台线程访问
+    quint64 m_generation;                 // 当前日志的代号，只在后台线程访问
+    QHash<QString, Stats> m_stats;        // 只在界面线程访问
+};
+
+#endif // PLAYSTATSLOG_H
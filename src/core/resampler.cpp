@@ -0,0 +1,354 @@
+#include "resampler.h"
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#if defined(__SSE2__)
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+const int BaseTaps = 64;          // 升采样时每相的抽头数，降采样时按比例增加
+const int MaxTaps = 512;
+const int ChunkFrames = 1024;     // 每次追加到历史缓冲区的输入帧数
+const double Cutoff = 0.475;      // 截止频率（相对于较低的采样率），-6dB 点略低于奈奎斯特频率
+const double KaiserBeta = 8.96;   // 阻带约 -90dB
+const float CenterGain = 0.7071f; // 中置、环绕声道混入左右声道的系数（-3dB）
+
+// 零阶修正贝塞尔函数
+double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    const double q = x * x / 4.0;
+    for (int k = 1; k < 64; ++k) {
+        term *= q / (double(k) * double(k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+// n 为 8 的倍数
+inline float dot(const float *a, const float *b, int n)
+{
+#if defined(__SSE2__)
+    __m128 s0 = _mm_setzero_ps();
+    __m128 s1 = _mm_setzero_ps();
+    for (int i = 0; i < n; i += 8) {
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    s0 = _mm_add_ps(s0, s1);
+    s0 = _mm_add_ps(s0, _mm_movehl_ps(s0, s0));
+    s0 = _mm_add_ss(s0, _mm_shuffle_ps(s0, s0, 1));
+    return _mm_cvtss_f32(s0);
+#else
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    for (int i = 0; i < n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    return (s0 + s1) + (s2 + s3);
+#endif
+}
+
+} // namespace
+
+Resampler::Resampler()
+    : m_inputRate(0)
+    , m_outputRate(0)
+    , m_inputChannels(0)
+    , m_outputChannels(0)
+    , m_up(1)
+    , m_down(1)
+    , m_interpolate(false)
+    , m_step(1.0)
+    , m_phases(0)
+    , m_taps(0)
+    , m_planeSize(0)
+    , m_fill(0)
+    , m_index(0)
+    , m_phase(0)
+    , m_frac(0.0)
+    , m_inputFrames(0)
+    , m_outputFrames(0)
+{
+}
+
+void Resampler::configure(int inputRate, int inputChannels, int outputRate, int outputChannels)
+{
+    m_inputRate = qMax(1, inputRate);
+    m_outputRate = qMax(1, outputRate);
+    m_inputChannels = qMax(1, inputChannels);
+    m_outputChannels = qMax(1, outputChannels);
+
+    const int g = std::gcd(m_inputRate, m_outputRate);
+    m_up = m_outputRate / g;
+    m_down = m_inputRate / g;
+
+    if (m_inputRate == m_outputRate) {
+        m_taps = 0;
+        m_phases = 0;
+        m_filter.clear();
+    } else {
+        // 降采样时截止频率按比例降低，抽头数相应增加以保持过渡带宽度
+        const double stretch = qMax(1.0, double(m_inputRate) / m_outputRate);
+        m_taps = qMin(MaxTaps, (int(std::ceil(BaseTaps * stretch)) + 7) & ~7);
+        m_interpolate = m_up > MaxPhases;
+        m_phases = m_interpolate ? int(MaxPhases) : m_up;
+        m_step = double(m_inputRate) / m_outputRate;
+        buildFilter();
+    }
+    buildMix();
+    reset();
+}
+
+void Resampler::buildFilter()
+{
+    const int rows = m_phases + (m_interpolate ? 1 : 0);
+    const double fc = Cutoff * qMin(1.0, double(m_outputRate) / m_inputRate);  // 每个输入样本的周期数
+    const double half = m_taps / 2;
+    const double i0Beta = besselI0(KaiserBeta);
+    m_filter.assign(size_t(rows) * size_t(m_taps), 0.0f);
+    std::vector<double> h(static_cast<size_t>(m_taps));
+
+    for (int p = 0; p < rows; ++p) {
+        const double frac = double(p) / m_phases;
+        float *row = m_filter.data() + size_t(p) * size_t(m_taps);
+        double sum = 0.0;
+        for (int k = 0; k < m_taps; ++k) {
+            // 第 k 个抽头到输出位置的距离（输入样本数）
+            const double d = k - (half - 1) - frac;
+            const double x = 2.0 * fc * d;
+            const double sinc = qFuzzyIsNull(x) ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+            const double r = d / half;
+            const double window = r * r < 1.0 ? besselI0(KaiserBeta * std::sqrt(1.0 - r * r)) / i0Beta : 0.0;
+            h[size_t(k)] = 2.0 * fc * sinc * window;
+            sum += h[size_t(k)];
+        }
+        // 每相直流增益归一化为 1，避免相位间的增益起伏
+        for (int k = 0; k < m_taps; ++k) {
+            row[k] = float(h[size_t(k)] / sum);
+        }
+    }
+}
+
+void Resampler::buildMix()
+{
+    const int in = m_inputChannels;
+    const int out = m_outputChannels;
+    m_mix.assign(size_t(in) * size_t(out), 0.0f);
+    auto weight = [this, in](int o, int i) -> float & { return m_mix[size_t(o) * size_t(in) + size_t(i)]; };
+
+    if (in == out) {
+        for (int c = 0; c < in; ++c) {
+            weight(c, c) = 1.0f;
+        }
+    } else if (out == 1) {
+        for (int i = 0; i < in; ++i) {
+            weight(0, i) = 1.0f / in;
+        }
+    } else if (in == 1) {
+        for (int o = 0; o < out; ++o) {
+            weight(o, 0) = 1.0f;
+        }
+    } else if (out == 2) {
+        // Qt 的声道顺序：FL FR [FC] [LFE] 环绕……；3、5 声道及 6 声道以上带中置，6 声道以上第 4 个为 LFE
+        const bool hasCenter = in == 3 || in >= 5;
+        const bool hasLfe = in >= 6;
+        weight(0, 0) = 1.0f;
+        weight(1, 1) = 1.0f;
+        int side = 0;
+        for (int i = 2; i < in; ++i) {
+            if (hasCenter && i == 2) {
+                weight(0, i) = CenterGain;
+                weight(1, i) = CenterGain;
+            } else if (hasLfe && i == 3) {
+                continue;
+            } else {
+                weight(side, i) = CenterGain;
+                side ^= 1;
+            }
+        }
+        // 每个输出声道的系数之和归一化为 1，混合后不会超过满幅
+        for (int o = 0; o < 2; ++o) {
+            float sum = 0.0f;
+            for (int i = 0; i < in; ++i) {
+                sum += weight(o, i);
+            }
+            for (int i = 0; i < in; ++i) {
+                weight(o, i) /= sum;
+            }
+        }
+    } else {
+        for (int c = 0; c < qMin(in, out); ++c) {
+            weight(c, c) = 1.0f;
+        }
+    }
+}
+
+void Resampler::reset()
+{
+    m_planeSize = 2 * m_taps + ChunkFrames;
+    m_history.assign(m_taps > 0 ? size_t(m_planeSize) * size_t(m_outputChannels) : 0, 0.0f);
+    // 预先放入半个滤波器长度的静音，第一个输出帧正好对准第一个输入帧
+    m_fill = m_taps > 0 ? m_taps / 2 - 1 : 0;
+    m_index = 0;
+    m_phase = 0;
+    m_frac = 0.0;
+    m_inputFrames = 0;
+    m_outputFrames = 0;
+}
+
+int Resampler::maxOutputFrames(int inputFrames) const
+{
+    if (m_taps == 0) {
+        return inputFrames;
+    }
+    return int(std::ceil(double(inputFrames + m_taps) * m_outputRate / m_inputRate)) + 2;
+}
+
+int Resampler::process(const float *in, int frames, float *out)
+{
+    if (frames <= 0) {
+        return 0;
+    }
+    m_inputFrames += frames;
+
+    if (m_taps == 0) {
+        // 采样率相同，只做声道映射
+        if (m_inputChannels == m_outputChannels) {
+            std::memcpy(out, in, size_t(frames) * size_t(m_inputChannels) * sizeof(float));
+        } else {
+            for (int f = 0; f < frames; ++f) {
+                const float *src = in + size_t(f) * size_t(m_inputChannels);
+                for (int o = 0; o < m_outputChannels; ++o) {
+                    const float *w = m_mix.data() + size_t(o) * size_t(m_inputChannels);
+                    float acc = 0.0f;
+                    for (int i = 0; i < m_inputChannels; ++i) {
+                        acc += w[i] * src[i];
+                    }
+                    out[size_t(f) * size_t(m_outputChannels) + size_t(o)] = acc;
+                }
+            }
+        }
+        m_outputFrames += frames;
+        return frames;
+    }
+
+    // 输出帧数不超过输入时长对应的帧数（向上取整）
+    const qint64 limit = (m_inputFrames * m_outputRate + m_inputRate - 1) / m_inputRate;
+    int produced = 0;
+    for (int done = 0; done < frames; ) {
+        const int n = qMin(ChunkFrames, frames - done);
+        append(in + size_t(done) * size_t(m_inputChannels), n);
+        produced += render(out + size_t(produced) * size_t(m_outputChannels), limit);
+        compact();
+        done += n;
+    }
+    return produced;
+}
+
+int Resampler::drain(float *out)
+{
+    if (m_taps == 0) {
+        return 0;
+    }
+    // 补半个滤波器长度的静音，使最后的输入样本经过完整的滤波器
+    const int pad = m_taps / 2;
+    for (int o = 0; o < m_outputChannels; ++o) {
+        float *plane = m_history.data() + size_t(o) * size_t(m_planeSize);
+        std::fill(plane + m_fill, plane + m_fill + pad, 0.0f);
+    }
+    m_fill += pad;
+    const qint64 limit = (m_inputFrames * m_outputRate + m_inputRate - 1) / m_inputRate;
+    const int produced = render(out, limit);
+    compact();
+    return produced;
+}
+
+void Resampler::append(const float *in, int frames)
+{
+    // 按声道拆开并同时完成声道混合
+    const int inChannels = m_inputChannels;
+    for (int o = 0; o < m_outputChannels; ++o) {
+        float *plane = m_history.data() + size_t(o) * size_t(m_planeSize) + m_fill;
+        const float *w = m_mix.data() + size_t(o) * size_t(inChannels);
+        if (inChannels == m_outputChannels && w[o] == 1.0f) {
+            for (int f = 0; f < frames; ++f) {
+                plane[f] = in[size_t(f) * size_t(inChannels) + size_t(o)];
+            }
+        } else {
+            for (int f = 0; f < frames; ++f) {
+                const float *src = in + size_t(f) * size_t(inChannels);
+                float acc = 0.0f;
+                for (int i = 0; i < inChannels; ++i) {
+                    acc += w[i] * src[i];
+                }
+                plane[f] = acc;
+            }
+        }
+    }
+    m_fill += frames;
+}
+
+int Resampler::render(float *out, qint64 limit)
+{
+    const int channels = m_outputChannels;
+    const int taps = m_taps;
+    int produced = 0;
+    while (m_outputFrames < limit && m_index + taps <= m_fill) {
+        float *frame = out + size_t(produced) * size_t(channels);
+        if (!m_interpolate) {
+            const float *row = m_filter.data() + size_t(m_phase) * size_t(taps);
+            for (int o = 0; o < channels; ++o) {
+                frame[o] = dot(row, m_history.data() + size_t(o) * size_t(m_planeSize) + m_index, taps);
+            }
+            m_phase += m_down;
+            m_index += m_phase / m_up;
+            m_phase %= m_up;
+        } else {
+            const double position = m_frac * m_phases;
+            const int p = qMin(int(position), m_phases - 1);
+            const float a = float(position - p);
+            const float *row0 = m_filter.data() + size_t(p) * size_t(taps);
+            const float *row1 = row0 + taps;
+            for (int o = 0; o < channels; ++o) {
+                const float *x = m_history.data() + size_t(o) * size_t(m_planeSize) + m_index;
+                const float y0 = dot(row0, x, taps);
+                const float y1 = dot(row1, x, taps);
+                frame[o] = y0 + a * (y1 - y0);
+            }
+            m_frac += m_step;
+            const int advance = int(m_frac);
+            m_index += advance;
+            m_frac -= advance;
+        }
+        ++produced;
+        ++m_outputFrames;
+    }
+    return produced;
+}
+
+void Resampler::compact()
+{
+    // 把还会用到的样本移到开头；降采样时 m_index 可能已经越过 m_fill
+    const int shift = qMin(m_index, m_fill);
+    if (shift == 0) {
+        return;
+    }
+    const int keep = m_fill - shift;
+    for (int o = 0; o < m_outputChannels; ++o) {
+        float *plane = m_history.data() + size_t(o) * size_t(m_planeSize);
+        std::memmove(plane, plane + shift, size_t(keep) * sizeof(float));
+    }
+    m_fill = keep;
+    m_index -= shift;
+}
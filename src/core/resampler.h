@@ -0,0 +1,72 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <QtGlobal>
+#include <vector>
+
+// 采样率与声道转换：把解码出的交错 float 样本转换为输出设备的固定采样率和声道数，
+// 换歌时设备不必按新格式重新打开。
+// 多相加窗 sinc 滤波（Kaiser 窗，阻带约 -90dB），采样率之比化简后相位数不超过 MaxPhases 时
+// 按有理数比例精确计算，否则在相邻两相之间线性插值；内积用 SSE 计算。
+// 声道映射：单声道复制到两个声道，5.1/7.1 等按常用系数混合到立体声（不含 LFE）。
+// 只在一个线程中使用。
+class Resampler
+{
+public:
+    enum { MaxPhases = 1024 };
+
+    Resampler();
+
+    void configure(int inputRate, int inputChannels, int outputRate, int outputChannels);
+    void reset();  // 跳转或换歌：清空历史样本
+
+    int inputRate() const { return m_inputRate; }
+    int outputRate() const { return m_outputRate; }
+    int inputChannels() const { return m_inputChannels; }
+    int outputChannels() const { return m_outputChannels; }
+    bool isPassthrough() const { return m_taps == 0; }
+    int tapsPerPhase() const { return m_taps; }
+    int phases() const { return m_phases; }
+
+    // 处理 frames 帧输入所需的最大输出帧数
+    int maxOutputFrames(int inputFrames) const;
+    // 返回写入 out 的帧数（交错，outputChannels 个声道）
+    int process(const float *in, int frames, float *out);
+    // 输入结束：用静音补齐滤波器尾部，输出剩余的样本（最多 maxOutputFrames(0) 帧）
+    int drain(float *out);
+
+private:
+    void buildFilter();
+    void buildMix();
+    void append(const float *in, int frames);
+    int render(float *out, qint64 limit);
+    void compact();
+
+private:
+    int m_inputRate;
+    int m_outputRate;
+    int m_inputChannels;
+    int m_outputChannels;
+
+    // 输出第 n 帧对应输入位置 n * m_down / m_up（有理模式）
+    int m_up;
+    int m_down;
+    bool m_interpolate;  // 相位数超过 MaxPhases 时在相邻两相之间插值
+    double m_step;       // 插值模式下每个输出帧前进的输入帧数
+    int m_phases;
+    int m_taps;          // 每相的抽头数，8 的倍数；0 表示不需要重采样
+    std::vector<float> m_filter;  // m_phases（插值模式多一行）× m_taps
+    std::vector<float> m_mix;     // 声道混合矩阵，outputChannels × inputChannels
+
+    // 按声道分开存放的历史样本，便于连续的内积
+    std::vector<float> m_history;
+    int m_planeSize;
+    int m_fill;      // 每个声道已有的帧数
+    int m_index;     // 下一个输出帧的第一个抽头所在位置
+    int m_phase;     // 有理模式下的相位（0 ~ m_up-1）
+    double m_frac;   // 插值模式下的小数位置（0 ~ 1）
+    qint64 m_inputFrames;
+    qint64 m_outputFrames;
+};
+
+#endif // RESAMPLER_H
@@ -0,0 +1,751 @@
+#include "seektablecache.h"
+#include "contenthash.h"
+#include "ioscheduler.h"
+#include <QThreadPool>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const quint32 SeekTableMagic = 0x59595354;  // "YYST"
+const quint32 SeekTableVersion = 1;
+const int IntervalMs = 250;         // 跳转点间隔，跳转后最多多解码这么长
+const int WindowBytes = 1 << 16;    // 扫描时每次读取的字节数
+const int Mp3PrerollFrames = 2;     // 比特池最多引用前面 511 字节，提前两帧开始解码足够
+const int MaxResync = 1 << 16;      // 失步后最多向后搜索的字节数，超过视为音频数据结束
+const int PrefetchBatch = 64;        // 预先生成时每个任务最多检查的歌曲数
+const qint64 DefaultDiskLimit = 256 * 1024 * 1024;  // 四分钟的 MP3 约 8KB，可保存约三万首
+
+// 按位置读取文件的滑动窗口，扫描基本是顺序的，每次读一大块
+class FileWindow
+{
+public:
+    explicit FileWindow(QFile *file)
+        : m_file(file)
+        , m_size(file->size())
+        , m_start(0)
+    {
+    }
+
+    qint64 size() const { return m_size; }
+
+    // [pos, pos + n) 的数据，超出文件末尾时返回 nullptr
+    const uchar *at(qint64 pos, int n)
+    {
+        if (pos < 0 || pos + n > m_size) {
+            return nullptr;
+        }
+        if (pos < m_start || pos + n > m_start + m_data.size()) {
+            if (!m_file->seek(pos)) {
+                return nullptr;
+            }
+            m_data = m_file->read(qMax<qint64>(WindowBytes, n));
+            m_start = pos;
+            if (m_data.size() < n) {
+                return nullptr;
+            }
+        }
+        return reinterpret_cast<const uchar *>(m_data.constData()) + (pos - m_start);
+    }
+
+    // 从 pos 开始窗口中连续可用的数据，保证至少 minBytes 个（文件末尾除外）
+    const uchar *span(qint64 pos, int minBytes, int *length)
+    {
+        const int need = int(qMin<qint64>(minBytes, m_size - pos));
+        const uchar *p = need > 0 ? at(pos, need) : nullptr;
+        if (p) {
+            *length = int(m_start + m_data.size() - pos);
+        }
+        return p;
+    }
+
+private:
+    QFile *m_file;
+    qint64 m_size;
+    qint64 m_start;
+    QByteArray m_data;
+};
+
+// 跳过文件开头的 ID3v2 标签（可能有多个）
+qint64 skipId3(FileWindow &window)
+{
+    qint64 pos = 0;
+    while (const uchar *p = window.at(pos, 10)) {
+        if (p[0] != 'I' || p[1] != 'D' || p[2] != '3') {
+            break;
+        }
+        const qint64 size = (qint64(p[6] & 0x7f) << 21) | ((p[7] & 0x7f) << 14) | ((p[8] & 0x7f) << 7) | (p[9] & 0x7f);
+        pos += 10 + size + ((p[5] & 0x10) ? 10 : 0);
+    }
+    return pos;
+}
+
+struct Mp3Frame
+{
+    int version;     // 3 = MPEG1，2 = MPEG2，0 = MPEG2.5
+    int layer;       // 1 ~ 3
+    int sampleRate;
+    int length;      // 字节
+    int samples;     // 每帧样本数
+    bool mono;
+};
+
+bool parseMp3Header(const uchar *p, Mp3Frame *frame)
+{
+    static const int bitrates[2][3][15] = {
+        // MPEG1：Layer I、II、III
+        { { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+          { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+          { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 } },
+        // MPEG2/2.5
+        { { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+          { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+          { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 } }
+    };
+    static const int sampleRates[4][3] = {
+        { 11025, 12000, 8000 },   // MPEG2.5
+        { 0, 0, 0 },
+        { 22050, 24000, 16000 },  // MPEG2
+        { 44100, 48000, 32000 }   // MPEG1
+    };
+
+    if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) {
+        return false;
+    }
+    const int version = (p[1] >> 3) & 3;
+    const int layerBits = (p[1] >> 1) & 3;
+    const int bitrateIndex = p[2] >> 4;
+    const int rateIndex = (p[2] >> 2) & 3;
+    if (version == 1 || layerBits == 0 || bitrateIndex == 0 || bitrateIndex == 15 || rateIndex == 3) {
+        return false;  // 保留值，或不定码率（free format，无法计算帧长）
+    }
+    const int layer = 4 - layerBits;
+    const int bitrate = bitrates[version == 3 ? 0 : 1][layer - 1][bitrateIndex] * 1000;
+    const int sampleRate = sampleRates[version][rateIndex];
+    const int padding = (p[2] >> 1) & 1;
+
+    frame->version = version;
+    frame->layer = layer;
+    frame->sampleRate = sampleRate;
+    frame->mono = (p[3] >> 6) == 3;
+    if (layer == 1) {
+        frame->length = (12 * bitrate / sampleRate + padding) * 4;
+        frame->samples = 384;
+    } else if (layer == 2 || version == 3) {
+        frame->length = 144 * bitrate / sampleRate + padding;
+        frame->samples = 1152;
+    } else {
+        frame->length = 72 * bitrate / sampleRate + padding;
+        frame->samples = 576;
+    }
+    return frame->length > 4;
+}
+
+bool sameStream(const Mp3Frame &a, const Mp3Frame &b)
+{
+    return a.version == b.version && a.layer == b.layer && a.sampleRate == b.sampleRate;
+}
+
+// 第一帧是否为 Xing/Info/VBRI 信息帧（不含音频，解码器会跳过）
+bool isInfoFrame(FileWindow &window, qint64 pos, const Mp3Frame &frame)
+{
+    const int sideInfo = frame.version == 3 ? (frame.mono ? 17 : 32) : (frame.mono ? 9 : 17);
+    if (const uchar *p = window.at(pos + 4 + sideInfo, 4)) {
+        if (std::memcmp(p, "Xing", 4) == 0 || std::memcmp(p, "Info", 4) == 0) {
+            return true;
+        }
+    }
+    const uchar *p = window.at(pos + 36, 4);
+    return p && std::memcmp(p, "VBRI", 4) == 0;
+}
+
+SeekTable buildMp3(FileWindow &window, qint64 start, const std::atomic<bool> *canceled)
+{
+    SeekTable table;
+    qint64 end = window.size();
+    if (const uchar *tag = window.at(end - 128, 3)) {
+        if (std::memcmp(tag, "TAG", 3) == 0) {
+            end -= 128;  // ID3v1
+        }
+    }
+
+    Mp3Frame first = {};
+    bool synced = false;
+    int resync = 0;
+    qint64 pos = start;
+    qint64 sample = 0;
+    qint64 nextPoint = 0;
+    int interval = 0;
+    qint64 frameIndex = 0;
+    SeekPoint recent[Mp3PrerollFrames + 1];
+
+    while (pos + 4 <= end) {
+        if (canceled && (frameIndex & 4095) == 0 && canceled->load(std::memory_order_relaxed)) {
+            return SeekTable();
+        }
+        Mp3Frame frame;
+        const uchar *p = window.at(pos, 4);
+        bool ok = p && parseMp3Header(p, &frame) && (!synced || sameStream(frame, first));
+        if (ok && (!synced || resync > 0)) {
+            // 刚同步时要求下一帧也对得上，避免把封面图片等数据误认成帧头
+            Mp3Frame next;
+            const uchar *q = window.at(pos + frame.length, 4);
+            ok = pos + frame.length >= end || (q && parseMp3Header(q, &next) && sameStream(frame, next));
+        }
+        if (!ok) {
+            if (++resync > MaxResync) {
+                break;  // 后面不是音频数据（APE 标签等）
+            }
+            ++pos;
+            continue;
+        }
+        resync = 0;
+
+        if (!synced) {
+            synced = true;
+            first = frame;
+            table.format = SeekTable::Mp3;
+            table.sampleRate = frame.sampleRate;
+            table.prerollSamples = Mp3PrerollFrames * frame.samples;
+            interval = frame.sampleRate * IntervalMs / 1000;
+            if (isInfoFrame(window, pos, frame)) {
+                pos += frame.length;
+                continue;
+            }
+        }
+
+        // 跳转点记录在前两帧的位置，从那里开始解码可以补齐比特池
+        recent[frameIndex % (Mp3PrerollFrames + 1)] = SeekPoint{sample, pos};
+        if (frameIndex >= Mp3PrerollFrames && sample >= nextPoint) {
+            table.points.append(recent[(frameIndex - Mp3PrerollFrames) % (Mp3PrerollFrames + 1)]);
+            nextPoint = sample + interval;
+        }
+        sample += frame.samples;
+        pos += frame.length;
+        ++frameIndex;
+    }
+    table.totalSamples = sample;
+    return table;
+}
+
+quint8 crc8(const uchar *data, int length)
+{
+    quint8 crc = 0;
+    for (int i = 0; i < length; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80) ? quint8((crc << 1) ^ 0x07) : quint8(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// 解析 FLAC 帧头（最长 16 字节），校验 CRC-8；固定块大小的流按帧号换算样本位置
+bool parseFlacFrame(const uchar *p, int n, int streamBlockSize, qint64 *sample, int *blockSize, int *headerLength)
+{
+    if (n < 6 || p[0] != 0xFF || (p[1] & 0xFE) != 0xF8) {
+        return false;
+    }
+    const bool variable = p[1] & 1;
+    const int blockCode = p[2] >> 4;
+    const int rateCode = p[2] & 0x0f;
+    const int channelCode = p[3] >> 4;
+    const int sizeCode = (p[3] >> 1) & 7;
+    if (blockCode == 0 || rateCode == 15 || channelCode >= 11 || sizeCode == 3 || (p[3] & 1)) {
+        return false;
+    }
+
+    // 类 UTF-8 编码的帧号或样本号
+    int i = 4;
+    const quint8 lead = p[i++];
+    qint64 value;
+    int extra;
+    if (!(lead & 0x80)) {
+        value = lead;
+        extra = 0;
+    } else if ((lead & 0xE0) == 0xC0) {
+        value = lead & 0x1F;
+        extra = 1;
+    } else if ((lead & 0xF0) == 0xE0) {
+        value = lead & 0x0F;
+        extra = 2;
+    } else if ((lead & 0xF8) == 0xF0) {
+        value = lead & 0x07;
+        extra = 3;
+    } else if ((lead & 0xFC) == 0xF8) {
+        value = lead & 0x03;
+        extra = 4;
+    } else if ((lead & 0xFE) == 0xFC) {
+        value = lead & 0x01;
+        extra = 5;
+    } else if (lead == 0xFE) {
+        value = 0;
+        extra = 6;
+    } else {
+        return false;
+    }
+    for (int e = 0; e < extra; ++e) {
+        if (i >= n || (p[i] & 0xC0) != 0x80) {
+            return false;
+        }
+        value = (value << 6) | (p[i++] & 0x3F);
+    }
+
+    int size;
+    if (blockCode == 1) {
+        size = 192;
+    } else if (blockCode <= 5) {
+        size = 576 << (blockCode - 2);
+    } else if (blockCode == 6) {
+        if (i + 1 > n) {
+            return false;
+        }
+        size = p[i++] + 1;
+    } else if (blockCode == 7) {
+        if (i + 2 > n) {
+            return false;
+        }
+        size = ((p[i] << 8) | p[i + 1]) + 1;
+        i += 2;
+    } else {
+        size = 256 << (blockCode - 8);
+    }
+    if (rateCode == 12) {
+        i += 1;
+    } else if (rateCode == 13 || rateCode == 14) {
+        i += 2;
+    }
+    if (i + 1 > n || crc8(p, i) != p[i]) {
+        return false;
+    }
+
+    *headerLength = i + 1;
+    *blockSize = size;
+    *sample = variable ? value : value * streamBlockSize;
+    return true;
+}
+
+SeekTable buildFlac(FileWindow &window, qint64 start, const std::atomic<bool> *canceled)
+{
+    SeekTable table;
+    qint64 pos = start + 4;
+    int maxBlock = 0;
+    int minFrame = 0;
+    QVector<SeekPoint> stored;  // 文件自带的 SEEKTABLE，偏移相对于第一帧
+
+    // 元数据块
+    for (;;) {
+        const uchar *h = window.at(pos, 4);
+        if (!h) {
+            return SeekTable();
+        }
+        const bool last = h[0] & 0x80;
+        const int type = h[0] & 0x7f;
+        const int length = (h[1] << 16) | (h[2] << 8) | h[3];
+        if (type == 0 && length >= 34) {
+            const uchar *si = window.at(pos + 4, 34);
+            if (!si) {
+                return SeekTable();
+            }
+            maxBlock = (si[2] << 8) | si[3];
+            minFrame = (si[4] << 16) | (si[5] << 8) | si[6];
+            table.sampleRate = (si[10] << 12) | (si[11] << 4) | (si[12] >> 4);
+            table.totalSamples = (qint64(si[13] & 0x0f) << 32) | (qint64(si[14]) << 24) | (si[15] << 16)
+                               | (si[16] << 8) | si[17];
+            // 从中间开始解码时的文件头：fLaC + 标记为最后一块的 STREAMINFO
+            table.header = QByteArray("fLaC", 4);
+            table.header.append(char(0x80));
+            table.header.append(char(0));
+            table.header.append(char(0));
+            table.header.append(char(34));
+            table.header.append(reinterpret_cast<const char *>(si), 34);
+        } else if (type == 3) {
+            for (int k = 0; k + 18 <= length; k += 18) {
+                const uchar *sp = window.at(pos + 4 + k, 18);
+                if (!sp) {
+                    break;
+                }
+                quint64 sampleNumber = 0;
+                quint64 offset = 0;
+                for (int b = 0; b < 8; ++b) {
+                    sampleNumber = (sampleNumber << 8) | sp[b];
+                    offset = (offset << 8) | sp[8 + b];
+                }
+                if (sampleNumber != ~quint64(0)) {  // 占位点
+                    stored.append(SeekPoint{qint64(sampleNumber), qint64(offset)});
+                }
+            }
+        }
+        pos += 4 + length;
+        if (last) {
+            break;
+        }
+    }
+    if (table.header.isEmpty() || table.sampleRate <= 0 || maxBlock <= 0) {
+        return SeekTable();
+    }
+    table.format = SeekTable::Flac;
+    const qint64 audioStart = pos;
+    const int interval = table.sampleRate * IntervalMs / 1000;
+
+    // 自带的 SEEKTABLE 足够密时直接使用（通常只有每 10 秒一个点）
+    if (stored.size() >= 2 && table.totalSamples > 0) {
+        qint64 maxGap = table.totalSamples - stored.last().sample;
+        for (int k = 1; k < stored.size(); ++k) {
+            maxGap = qMax(maxGap, stored[k].sample - stored[k - 1].sample);
+        }
+        if (stored.first().sample == 0 && maxGap <= interval) {
+            for (const SeekPoint &point : qAsConst(stored)) {
+                table.points.append(SeekPoint{point.sample, audioStart + point.offset});
+            }
+            return table;
+        }
+    }
+
+    // 逐帧扫描：找同步字并校验帧头，样本位置必须与上一帧衔接，排除音频数据中的伪同步
+    qint64 expected = 0;
+    qint64 nextPoint = 0;
+    qint64 iterations = 0;
+    while (pos < window.size()) {
+        if (canceled && (++iterations & 4095) == 0 && canceled->load(std::memory_order_relaxed)) {
+            return SeekTable();
+        }
+        int length = 0;
+        const uchar *p = window.span(pos, 16, &length);
+        if (!p) {
+            break;
+        }
+        const int searchable = length > 16 ? length - 15 : length;
+        const uchar *hit = static_cast<const uchar *>(std::memchr(p, 0xFF, size_t(searchable)));
+        if (!hit) {
+            pos += searchable;
+            continue;
+        }
+        pos += hit - p;
+
+        int available = 0;
+        const uchar *h = window.span(pos, 16, &available);
+        qint64 frameSample = 0;
+        int blockSize = 0;
+        int headerLength = 0;
+        if (h && parseFlacFrame(h, qMin(available, 16), maxBlock, &frameSample, &blockSize, &headerLength)
+            && frameSample == expected) {
+            if (frameSample >= nextPoint) {
+                table.points.append(SeekPoint{frameSample, pos});
+                nextPoint = frameSample + interval;
+            }
+            expected = frameSample + blockSize;
+            pos += qMax(minFrame, headerLength);
+        } else {
+            ++pos;
+        }
+    }
+    if (table.totalSamples <= 0) {
+        table.totalSamples = expected;
+    }
+    return table;
+}
+
+} // namespace
+
+SeekPoint SeekTable::locate(qint64 positionMs) const
+{
+    const SeekPoint none{0, -1};
+    if (isEmpty()) {
+        return none;
+    }
+    // 最后一个“开始解码后丢弃预滚样本仍不超过目标”的点
+    const qint64 target = positionMs * sampleRate / 1000 - prerollSamples;
+    auto it = std::upper_bound(points.constBegin(), points.constEnd(), target,
+                               [](qint64 value, const SeekPoint &point) { return value < point.sample; });
+    if (it == points.constBegin()) {
+        return none;
+    }
+    --it;
+    // 第一个点就是文件开头，直接打开整个文件
+    return it->sample > 0 ? *it : none;
+}
+
+SeekTableCache::SeekTableCache(QObject *parent)
+    : QObject(parent)
+    , m_pool(new QThreadPool(this))
+    , m_prefetchRunning(false)
+    , m_canceled(false)
+    , m_memoryLimit(16)
+    , m_diskLimit(DefaultDiskLimit)
+{
+    // 扫描受磁盘速度限制，单线程即可，避免与播放争抢磁盘
+    m_pool->setMaxThreadCount(1);
+    m_cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/seektables";
+    QDir().mkpath(m_cacheDir);
+}
+
+SeekTableCache::~SeekTableCache()
+{
+    m_canceled.store(true);
+    m_pool->clear();
+    m_pool->waitForDone();
+}
+
+void SeekTableCache::request(const QString &filePath)
+{
+    if (m_memory.contains(filePath)) {
+        m_recent.removeOne(filePath);
+        m_recent.append(filePath);
+        emit tableReady(filePath);
+        return;
+    }
+    if (!isSupported(filePath)) {
+        return;
+    }
+    m_requested.insert(filePath);
+    // 还在预先生成队列中时提到前面；正在预先生成的等它完成后再读取
+    if (m_prefetchQueue.removeOne(filePath)) {
+        m_pending.remove(filePath);
+    }
+    schedule(filePath);
+}
+
+void SeekTableCache::prefetch(const QStringList &filePaths)
+{
+    for (const QString &filePath : filePaths) {
+        if (m_memory.contains(filePath) || m_pending.contains(filePath) || !isSupported(filePath)) {
+            continue;
+        }
+        m_pending.insert(filePath);
+        m_prefetchQueue.append(filePath);
+    }
+    startPrefetch();
+}
+
+bool SeekTableCache::contains(const QString &filePath) const
+{
+    return m_memory.contains(filePath);
+}
+
+SeekTable SeekTableCache::table(const QString &filePath) const
+{
+    return m_memory.value(filePath);
+}
+
+void SeekTableCache::schedule(const QString &filePath)
+{
+    if (m_pending.contains(filePath)) {
+        return;
+    }
+    m_pending.insert(filePath);
+    // 读取修改时间和磁盘缓存都在工作线程中进行；m_cacheDir 构造后不再改变
+    const qint64 diskLimit = m_diskLimit;
+    m_pool->start([this, filePath, diskLimit]() {
+        const QString cachePath = cacheFilePath(filePath, QFileInfo(filePath).lastModified());
+        SeekTable table;
+        if (!load(cachePath, &table)) {
+            table = SeekTable::build(filePath, &m_canceled);
+            if (!table.isEmpty() && save(cachePath, table)) {
+                trim(m_cacheDir, diskLimit);
+            }
+        }
+        QMetaObject::invokeMethod(this, [this, filePath, table]() {
+            onTableBuilt(filePath, table);
+        }, Qt::QueuedConnection);
+    }, 1);
+}
+
+void SeekTableCache::onTableBuilt(const QString &filePath, const SeekTable &table)
+{
+    m_pending.remove(filePath);
+    m_requested.remove(filePath);
+    if (table.isEmpty()) {
+        return;
+    }
+    remember(filePath, table);
+    emit tableReady(filePath);
+}
+
+void SeekTableCache::startPrefetch()
+{
+    if (m_prefetchRunning || m_prefetchQueue.isEmpty()) {
+        return;
+    }
+    const QStringList batch = m_prefetchQueue.mid(0, PrefetchBatch);
+    m_prefetchQueue.erase(m_prefetchQueue.begin(), m_prefetchQueue.begin() + batch.size());
+    m_prefetchRunning = true;
+
+    // 已有缓存的只检查文件是否存在；遇到第一首需要扫描的建立后就结束，剩下的交回队列
+    const qint64 diskLimit = m_diskLimit;
+    m_pool->start([this, batch, diskLimit]() {
+        QStringList rest = batch;
+        bool full = false;
+        while (!rest.isEmpty() && !m_canceled.load()) {
+            const QString filePath = rest.takeFirst();
+            const QString cachePath = cacheFilePath(filePath, QFileInfo(filePath).lastModified());
+            if (QFile::exists(cachePath)) {
+                continue;
+            }
+            const SeekTable table = SeekTable::build(filePath, &m_canceled);
+            if (!table.isEmpty() && save(cachePath, table)) {
+                full = trim(m_cacheDir, diskLimit);
+            }
+            break;
+        }
+        QMetaObject::invokeMethod(this, [this, batch, rest, full]() {
+            onPrefetchDone(batch, rest, full);
+        }, Qt::QueuedConnection);
+    }, 0);
+}
+
+void SeekTableCache::onPrefetchDone(const QStringList &batch, const QStringList &rest, bool full)
+{
+    m_prefetchRunning = false;
+    QStringList remaining;
+    for (const QString &filePath : batch) {
+        if (!full && rest.contains(filePath) && !m_requested.contains(filePath)) {
+            remaining.append(filePath);
+            continue;
+        }
+        // 已在磁盘上；期间播放器请求了这首时从磁盘读取
+        m_pending.remove(filePath);
+        if (m_requested.contains(filePath)) {
+            schedule(filePath);
+        }
+    }
+
+    if (full) {
+        // 磁盘缓存已满：不再预先生成，免得挤掉最近播放过的歌曲的表
+        for (const QString &filePath : qAsConst(m_prefetchQueue)) {
+            m_pending.remove(filePath);
+        }
+        m_prefetchQueue.clear();
+        qDebug() << "跳转表磁盘缓存已满，停止预先生成";
+        return;
+    }
+    m_prefetchQueue = remaining + m_prefetchQueue;
+    startPrefetch();
+}
+
+void SeekTableCache::remember(const QString &filePath, const SeekTable &table)
+{
+    m_memory.insert(filePath, table);
+    m_recent.removeOne(filePath);
+    m_recent.append(filePath);
+    while (m_recent.size() > m_memoryLimit) {
+        m_memory.remove(m_recent.takeFirst());
+    }
+}
+
+QString SeekTableCache::cacheFilePath(const QString &filePath, const QDateTime &lastModified) const
+{
+    ContentHasher hasher;
+    hasher.addData(filePath.toUtf8());
+    qint64 mtime = lastModified.toMSecsSinceEpoch();
+    hasher.addData(reinterpret_cast<const char *>(&mtime), sizeof(mtime));
+    return m_cacheDir + QString("/%1.st").arg(hasher.result(), 16, 16, QChar('0'));
+}
+
+bool SeekTableCache::isSupported(const QString &filePath)
+{
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    return suffix == "mp3" || suffix == "flac";
+}
+
+SeekTable SeekTable::build(const QString &filePath, const std::atomic<bool> *canceled)
+{
+    ScheduledFile file(filePath, canceled);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return SeekTable();
+    }
+    FileWindow window(&file);
+    const qint64 start = skipId3(window);
+    const uchar *magic = window.at(start, 4);
+    SeekTable table;
+    if (magic && std::memcmp(magic, "fLaC", 4) == 0) {
+        table = buildFlac(window, start, canceled);
+    } else {
+        table = buildMp3(window, start, canceled);
+    }
+    if (table.isEmpty() && !(canceled && canceled->load())) {
+        qDebug() << "无法建立跳转表:" << filePath;
+    }
+    return table;
+}
+
+bool SeekTableCache::save(const QString &cachePath, const SeekTable &table)
+{
+    QSaveFile file(cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    // 跳转点按差值保存，两小时的 MP3 约 230KB
+    QDataStream out(&file);
+    out << SeekTableMagic << SeekTableVersion << qint32(table.format) << qint32(table.sampleRate)
+        << table.totalSamples << qint32(table.prerollSamples) << table.header << qint32(table.points.size());
+    SeekPoint previous{0, 0};
+    for (const SeekPoint &point : table.points) {
+        out << quint32(point.sample - previous.sample) << quint32(point.offset - previous.offset);
+        previous = point;
+    }
+    return out.status() == QDataStream::Ok && file.commit();
+}
+
+bool SeekTableCache::load(const QString &cachePath, SeekTable *table)
+{
+    QFile file(cachePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 format = 0;
+    qint32 sampleRate = 0;
+    qint32 preroll = 0;
+    qint32 count = 0;
+    in >> magic >> version;
+    if (magic != SeekTableMagic || version != SeekTableVersion) {
+        return false;
+    }
+    in >> format >> sampleRate >> table->totalSamples >> preroll >> table->header >> count;
+    if (in.status() != QDataStream::Ok || count < 0 || count > (1 << 24)) {
+        return false;
+    }
+    table->format = SeekTable::Format(format);
+    table->sampleRate = sampleRate;
+    table->prerollSamples = preroll;
+    table->points.resize(count);
+    SeekPoint previous{0, 0};
+    for (int i = 0; i < count; ++i) {
+        quint32 sampleDelta = 0;
+        quint32 offsetDelta = 0;
+        in >> sampleDelta >> offsetDelta;
+        previous = SeekPoint{previous.sample + sampleDelta, previous.offset + offsetDelta};
+        table->points[i] = previous;
+    }
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+    // 更新修改时间作为最近使用时间，超出磁盘上限时 trim 先删除最久未用的
+    file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+    return true;
+}
+
+bool SeekTableCache::trim(const QString &cacheDir, qint64 maxBytes)
+{
+    // 按修改时间从新到旧累计，超出上限的部分全部删除；返回是否删除了文件
+    const QFileInfoList entries = QDir(cacheDir).entryInfoList(QStringList() << "*.st", QDir::Files, QDir::Time);
+    qint64 total = 0;
+    bool removed = false;
+    for (const QFileInfo &entry : entries) {
+        total += entry.size();
+        if (total > maxBytes) {
+            removed |= QFile::remove(entry.filePath());
+        }
+    }
+    return removed;
+}
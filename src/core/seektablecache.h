@@ -0,0 +1,101 @@
+#ifndef SEEKTABLECACHE_H
+#define SEEKTABLECACHE_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QDateTime>
+#include <QStringList>
+#include <atomic>
+
+class QThreadPool;
+
+// 跳转点：从文件的 offset 字节处（一个完整帧的开头）开始解码，第一个样本是第 sample 个
+struct SeekPoint
+{
+    qint64 sample;
+    qint64 offset;
+};
+
+// 单首歌曲的跳转表，建立音乐库时扫描一次
+// MP3 按帧头逐帧遍历（不依赖 Xing/VBRI 目录），FLAC 文件自带的 SEEKTABLE 足够密时直接使用，
+// 否则扫描全部帧头。跳转点约每 250ms 一个，跳转时从前一个点开始解码并按样本数丢弃到目标位置。
+struct SeekTable
+{
+    enum Format {
+        NoFormat,
+        Mp3,
+        Flac
+    };
+
+    Format format = NoFormat;
+    int sampleRate = 0;
+    qint64 totalSamples = 0;
+    int prerollSamples = 0;   // 从跳转点开始解码后不可靠的样本数（MP3 比特池），这段必须丢弃
+    QByteArray header;        // 从中间开始解码时要放在数据前面的文件头（FLAC 的 fLaC + STREAMINFO）
+    QVector<SeekPoint> points;
+
+    bool isEmpty() const { return points.isEmpty() || sampleRate <= 0; }
+    qint64 durationMs() const { return sampleRate > 0 ? totalSamples * 1000 / sampleRate : 0; }
+    // 目标位置之前最近的可用跳转点；没有合适的点（目标在开头附近）时 offset 为 -1
+    SeekPoint locate(qint64 positionMs) const;
+
+    // 扫描文件建立跳转表；canceled 置位时中途放弃并返回空表
+    static SeekTable build(const QString &filePath, const std::atomic<bool> *canceled = nullptr);
+};
+
+// 跳转表缓存：后台线程扫描，结果按路径+修改时间保存到磁盘
+// 扫描音乐库时对所有歌曲预先生成，磁盘缓存超出上限时按最近使用时间删除并停止预先生成；
+// 检查和读取磁盘缓存都在工作线程中进行
+class SeekTableCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SeekTableCache(QObject *parent = nullptr);
+    ~SeekTableCache();
+
+    // 请求某首歌曲的跳转表；已缓存时立即发出 tableReady
+    void request(const QString &filePath);
+    // 建立音乐库时低优先级预先生成；每个任务最多建立一张表，播放时的请求可以插到前面
+    void prefetch(const QStringList &filePaths);
+
+    bool contains(const QString &filePath) const;
+    SeekTable table(const QString &filePath) const;
+
+    void setMemoryLimit(int count) { m_memoryLimit = count; }
+    void setDiskLimit(qint64 bytes) { m_diskLimit = bytes; }
+
+signals:
+    void tableReady(const QString &filePath);
+
+private:
+    void schedule(const QString &filePath);
+    void onTableBuilt(const QString &filePath, const SeekTable &table);
+    void startPrefetch();
+    void onPrefetchDone(const QStringList &batch, const QStringList &rest, bool full);
+    void remember(const QString &filePath, const SeekTable &table);
+    QString cacheFilePath(const QString &filePath, const QDateTime &lastModified) const;
+
+    static bool isSupported(const QString &filePath);
+    static bool save(const QString &cachePath, const SeekTable &table);
+    static bool load(const QString &cachePath, SeekTable *table);
+    static bool trim(const QString &cacheDir, qint64 maxBytes);
+
+private:
+    QThreadPool *m_pool;
+    QString m_cacheDir;
+    QHash<QString, SeekTable> m_memory;
+    QList<QString> m_recent;  // 内存中的 LRU 顺序
+    QSet<QString> m_pending;        // 已排队（包括预先生成队列）或正在处理
+    QSet<QString> m_requested;      // 播放器在等待的歌曲，完成后发出 tableReady
+    QStringList m_prefetchQueue;
+    bool m_prefetchRunning;
+    std::atomic<bool> m_canceled;  // 析构时让正在进行的扫描尽快结束
+    int m_memoryLimit;
+    qint64 m_diskLimit;
+};
+
+#endif // SEEKTABLECACHE_H
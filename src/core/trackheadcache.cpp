@@ -0,0 +1,183 @@
+#include "trackheadcache.h"
+#include "pcmdecoder.h"
+#include <QThreadPool>
+#include <QFile>
+#include <QDebug>
+#include <algorithm>
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
+namespace {
+const int HeadMs = 4000;                       // 每首缓存的开头长度，足够盖住打开文件和解码器启动的时间
+const qint64 DefaultMemoryLimit = 48 << 20;    // 48kHz 立体声约 1.5MB/首
+const qint64 ReadaheadBytes = 8 << 20;         // 提示系统预读的文件开头长度，接在缓存的开头之后播放
+const int HoverDelay = 250;                    // 鼠标停留多久后开始准备
+}
+
+TrackHeadCache::TrackHeadCache(QObject *parent)
+    : QObject(parent)
+    , m_pool(new QThreadPool(this))
+    , m_memory(0)
+    , m_memoryLimit(DefaultMemoryLimit)
+    , m_hits(0)
+    , m_misses(0)
+    , m_canceled(false)
+{
+    // 候选只有两三首，单线程按优先级依次准备，不与播放争抢磁盘
+    m_pool->setMaxThreadCount(1);
+
+    m_hoverTimer.setSingleShot(true);
+    m_hoverTimer.setInterval(HoverDelay);
+    connect(&m_hoverTimer, &QTimer::timeout, this, [this]() {
+        if (!m_hovered.isEmpty()) {
+            schedule(m_hovered);
+        }
+    });
+}
+
+TrackHeadCache::~TrackHeadCache()
+{
+    m_canceled.store(true);
+    m_pool->clear();
+    m_pool->waitForDone();
+}
+
+void TrackHeadCache::setCandidates(const QStringList &filePaths)
+{
+    // 排队中的旧候选不再需要；正在解码的一首完成后按是否仍是候选决定去留
+    m_candidates = filePaths;
+    m_pool->clear();
+    m_pending.clear();
+    for (const QString &filePath : filePaths) {
+        schedule(filePath);
+    }
+}
+
+void TrackHeadCache::setHovered(const QString &filePath)
+{
+    if (filePath == m_hovered) {
+        return;
+    }
+    m_hovered = filePath;
+    m_hoverTimer.start();
+}
+
+TrackHead TrackHeadCache::lookup(const QString &filePath)
+{
+    auto it = m_heads.constFind(filePath);
+    if (it == m_heads.constEnd()) {
+        ++m_misses;
+        return TrackHead();
+    }
+    ++m_hits;
+    m_recent.removeOne(filePath);
+    m_recent.append(filePath);
+    qDebug() << "开头缓存命中:" << filePath << "命中率" << hitRate() << "内存" << m_memory / 1024 << "KB";
+    return it.value();
+}
+
+void TrackHeadCache::setMemoryLimit(qint64 bytes)
+{
+    m_memoryLimit = bytes;
+    evict();
+}
+
+double TrackHeadCache::hitRate() const
+{
+    const int total = m_hits + m_misses;
+    return total > 0 ? double(m_hits) / total : 0.0;
+}
+
+void TrackHeadCache::schedule(const QString &filePath)
+{
+    if (filePath.isEmpty() || m_pending.contains(filePath)) {
+        return;
+    }
+    m_pending.insert(filePath);
+    // 已缓存的只需要预读文件，播放时接在开头后面的数据也能从页缓存读取
+    const bool cached = m_heads.contains(filePath);
+    const int priority = qMax(0, m_candidates.size() - m_candidates.indexOf(filePath));
+    m_pool->start([this, filePath, cached]() {
+        readahead(filePath);
+        const TrackHead head = cached ? TrackHead() : decodeHead(filePath, &m_canceled);
+        QMetaObject::invokeMethod(this, [this, filePath, head]() {
+            onHeadDecoded(filePath, head);
+        }, Qt::QueuedConnection);
+    }, priority);
+}
+
+void TrackHeadCache::onHeadDecoded(const QString &filePath, const TrackHead &head)
+{
+    m_pending.remove(filePath);
+    if (head.isEmpty() || !isWanted(filePath)) {
+        return;
+    }
+    auto it = m_heads.find(filePath);
+    if (it != m_heads.end()) {
+        m_memory -= it.value().bytes();
+        m_recent.removeOne(filePath);
+    }
+    m_heads.insert(filePath, head);
+    m_memory += head.bytes();
+    m_recent.append(filePath);
+    evict();
+}
+
+void TrackHeadCache::evict()
+{
+    while (m_memory > m_memoryLimit && !m_recent.isEmpty()) {
+        // 先淘汰最久未用且不再是候选的歌曲
+        int victim = 0;
+        for (int i = 0; i < m_recent.size(); ++i) {
+            if (!isWanted(m_recent.at(i))) {
+                victim = i;
+                break;
+            }
+        }
+        const QString filePath = m_recent.takeAt(victim);
+        m_memory -= m_heads.take(filePath).bytes();
+    }
+}
+
+bool TrackHeadCache::isWanted(const QString &filePath) const
+{
+    return filePath == m_hovered || m_candidates.contains(filePath);
+}
+
+TrackHead TrackHeadCache::decodeHead(const QString &filePath, const std::atomic<bool> *canceled)
+{
+    TrackHead head;
+    PcmDecoder decoder;
+    const bool ok = decoder.decode(filePath, [&](const float *samples, int frames, int channels, int sampleRate) {
+        if (head.samples.isEmpty()) {
+            head.sampleRate = sampleRate;
+            head.channels = channels;
+            head.samples.reserve(int(qint64(HeadMs) * sampleRate / 1000 + frames) * channels);
+        } else if (sampleRate != head.sampleRate || channels != head.channels) {
+            return false;  // 格式中途改变，只保留之前的部分
+        }
+        const int count = frames * channels;
+        const int offset = head.samples.size();
+        head.samples.resize(offset + count);
+        std::copy(samples, samples + count, head.samples.begin() + offset);
+        return head.frames() * 1000 < qint64(HeadMs) * sampleRate;
+    }, canceled);
+    if (!ok) {
+        return TrackHead();
+    }
+    return head;
+}
+
+void TrackHeadCache::readahead(const QString &filePath)
+{
+#ifdef Q_OS_LINUX
+    QFile file(filePath);
+    if (file.open(QIODevice::ReadOnly)) {
+        // 只是提示，内核在后台读入页缓存，不等待完成
+        ::posix_fadvise(file.handle(), 0, qMin(file.size(), ReadaheadBytes), POSIX_FADV_WILLNEED);
+    }
+#else
+    Q_UNUSED(filePath);
+#endif
+}
@@ -0,0 +1,77 @@
+#ifndef TRACKHEADCACHE_H
+#define TRACKHEADCACHE_H
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <atomic>
+
+class QThreadPool;
+
+// 解码好的歌曲开头（交错 float，歌曲原始格式）
+struct TrackHead
+{
+    int sampleRate = 0;
+    int channels = 0;
+    QVector<float> samples;
+
+    bool isEmpty() const { return samples.isEmpty() || sampleRate <= 0 || channels <= 0; }
+    qint64 frames() const { return channels > 0 ? samples.size() / channels : 0; }
+    qint64 bytes() const { return qint64(samples.size()) * qint64(sizeof(float)); }
+};
+
+// 即将播放的歌曲开头的内存缓存
+// 对下一首、上一首和鼠标停留的播放列表行，在后台解码开头几秒，并提示系统预读文件；
+// 切歌时播放引擎先播放内存中的开头，解码器同时从头打开文件并接在后面，
+// 网络存储或机械硬盘上切歌不必等待打开和读取文件。内存占用有上限，超出时先淘汰不再是候选的歌曲。
+class TrackHeadCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TrackHeadCache(QObject *parent = nullptr);
+    ~TrackHeadCache();
+
+    // 设置候选歌曲（按优先级排列），不在列表中的排队任务被取消
+    void setCandidates(const QStringList &filePaths);
+    // 鼠标停留在某一行上，停留一段时间后才开始准备
+    void setHovered(const QString &filePath);
+
+    // 开始播放时查找；计入命中率统计
+    TrackHead lookup(const QString &filePath);
+    bool contains(const QString &filePath) const { return m_heads.contains(filePath); }
+
+    void setMemoryLimit(qint64 bytes);
+    qint64 memoryUsage() const { return m_memory; }
+    int hits() const { return m_hits; }
+    int misses() const { return m_misses; }
+    double hitRate() const;
+
+private:
+    void schedule(const QString &filePath);
+    void onHeadDecoded(const QString &filePath, const TrackHead &head);
+    void evict();
+    bool isWanted(const QString &filePath) const;
+
+    static TrackHead decodeHead(const QString &filePath, const std::atomic<bool> *canceled);
+    static void readahead(const QString &filePath);
+
+private:
+    QThreadPool *m_pool;
+    QTimer m_hoverTimer;
+    QString m_hovered;
+    QStringList m_candidates;
+    QHash<QString, TrackHead> m_heads;
+    QList<QString> m_recent;   // LRU 顺序
+    QSet<QString> m_pending;
+    qint64 m_memory;
+    qint64 m_memoryLimit;
+    int m_hits;
+    int m_misses;
+    std::atomic<bool> m_canceled;
+};
+
+#endif // TRACKHEADCACHE_H
@@ -0,0 +1,179 @@
+#include "trackvalidator.h"
+#include "audiotagreader.h"
+#include "pcmdecoder.h"
+#include "ioscheduler.h"
+#include "models/playlist.h"
+#include <QThreadPool>
+#include <QTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QDebug>
+
+namespace {
+const int DefaultLookAhead = 5;
+const int DecodeTimeout = 3000;  // 毫秒，超过视为无法解码
+}
+
+struct TrackValidator::Job
+{
+    QStringList paths;
+    std::atomic<bool> canceled{false};
+};
+
+TrackValidator::TrackValidator(Playlist *playlist, QObject *parent)
+    : QObject(parent)
+    , m_playlist(playlist)
+    , m_pool(new QThreadPool(this))
+    , m_lookAhead(DefaultLookAhead)
+    , m_refreshScheduled(false)
+{
+    // 一次只检查一首，不与播放抢占磁盘和解码器
+    m_pool->setMaxThreadCount(1);
+
+    connect(m_playlist, &Playlist::playlistChanged, this, &TrackValidator::refresh);
+    connect(m_playlist, &Playlist::currentIndexChanged, this, &TrackValidator::refresh);
+    connect(m_playlist, &Playlist::playModeChanged, this, &TrackValidator::refresh);
+}
+
+TrackValidator::~TrackValidator()
+{
+    if (m_job) {
+        m_job->canceled = true;
+    }
+    m_pool->waitForDone();
+}
+
+void TrackValidator::setLookAhead(int count)
+{
+    m_lookAhead = qMax(0, count);
+    refresh();
+}
+
+bool TrackValidator::isPlayable(const QString &filePath) const
+{
+    return !m_failures.contains(filePath);
+}
+
+QString TrackValidator::errorString(const QString &filePath) const
+{
+    return m_failures.value(filePath);
+}
+
+void TrackValidator::markFailed(const QString &filePath, const QString &error)
+{
+    m_passed.remove(filePath);
+    auto it = m_failures.constFind(filePath);
+    if (it != m_failures.constEnd() && it.value() == error) {
+        return;
+    }
+    m_failures.insert(filePath, error);
+    emit trackFailed(filePath, error);
+}
+
+void TrackValidator::clear()
+{
+    m_passed.clear();
+    m_failures.clear();
+    refresh();
+}
+
+void TrackValidator::refresh()
+{
+    if (m_refreshScheduled) {
+        return;
+    }
+    m_refreshScheduled = true;
+    QTimer::singleShot(0, this, &TrackValidator::validateUpcoming);
+}
+
+void TrackValidator::validateUpcoming()
+{
+    m_refreshScheduled = false;
+
+    QStringList paths;
+    const QList<int> upcoming = m_playlist->upcomingIndices(m_lookAhead);
+    for (int index : upcoming) {
+        const QString path = m_playlist->at(index).filePath();
+        if (!path.isEmpty() && !m_passed.contains(path) && !m_failures.contains(path)
+            && !paths.contains(path)) {
+            paths.append(path);
+        }
+    }
+
+    // 正在检查的歌曲仍在队列中时不打断
+    if (m_job && m_job->paths == paths) {
+        return;
+    }
+    if (m_job) {
+        m_job->canceled = true;
+        m_job.reset();
+    }
+    if (paths.isEmpty()) {
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->paths = paths;
+    m_job = job;
+    m_pool->start([this, job]() {
+        for (const QString &filePath : qAsConst(job->paths)) {
+            if (job->canceled) {
+                break;
+            }
+            const QString error = validate(filePath, &job->canceled);
+            if (job->canceled) {
+                break;
+            }
+            QMetaObject::invokeMethod(this, [this, job, filePath, error]() {
+                onValidated(job, filePath, error);
+            }, Qt::QueuedConnection);
+        }
+    });
+}
+
+void TrackValidator::onValidated(const std::shared_ptr<Job> &job, const QString &filePath, const QString &error)
+{
+    if (error.isEmpty()) {
+        m_passed.insert(filePath);
+    } else {
+        qDebug() << "预读检查失败:" << filePath << error;
+        markFailed(filePath, error);
+    }
+    if (job == m_job && filePath == job->paths.last()) {
+        m_job.reset();
+    }
+}
+
+QString TrackValidator::validate(const QString &filePath, const std::atomic<bool> *canceled)
+{
+    QFileInfo info(filePath);
+    if (!info.exists()) {
+        return QStringLiteral("文件不存在");
+    }
+
+    ScheduledFile file(filePath, canceled);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QStringLiteral("无法读取文件: %1").arg(file.errorString());
+    }
+    qint64 begin = 0;
+    qint64 end = 0;
+    if (!AudioTagReader::audioPayloadRange(&file, &begin, &end) || begin >= end) {
+        return QStringLiteral("文件头损坏或没有音频数据");
+    }
+    file.close();
+
+    // 没有解码后端时播放走 QMediaPlayer，这里无法试解码，只检查文件头
+    if (!PcmDecoder::isAvailable()) {
+        return QString();
+    }
+    // 解出第一个缓冲区即可确认解码器能打开
+    PcmDecoder decoder;
+    decoder.setTimeout(DecodeTimeout);
+    const bool ok = decoder.decode(filePath, [](const float *, int, int, int) {
+        return false;
+    }, canceled);
+    if (!ok) {
+        return QStringLiteral("无法解码: %1").arg(decoder.errorString());
+    }
+    return QString();
+}
@@ -0,0 +1,61 @@
+#ifndef TRACKVALIDATOR_H
+#define TRACKVALIDATOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+
+class QThreadPool;
+class Playlist;
+
+// 播放队列预读检查
+// 在后台线程检查接下来将要播放的若干首歌：文件存在且可读、容器头部能解析、解码器能解出第一个缓冲区。
+// 检查失败的歌曲被标记为无法播放，MusicPlayer 切歌时直接跳过，不必等播放出错。
+class TrackValidator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TrackValidator(Playlist *playlist, QObject *parent = nullptr);
+    ~TrackValidator();
+
+    // 预读的歌曲数
+    int lookAhead() const { return m_lookAhead; }
+    void setLookAhead(int count);
+
+    // 未检查过或检查通过的歌曲都视为可以播放
+    bool isPlayable(const QString &filePath) const;
+    QString errorString(const QString &filePath) const;
+    QHash<QString, QString> failures() const { return m_failures; }
+
+    // 播放时出错的歌曲也记入失败列表
+    void markFailed(const QString &filePath, const QString &error);
+    // 清除所有检查结果，之后会重新检查
+    void clear();
+
+public slots:
+    // 播放队列或当前歌曲变化后调用，合并到下一次事件循环统一检查
+    void refresh();
+
+signals:
+    void trackFailed(const QString &filePath, const QString &error);
+
+private:
+    struct Job;
+    void validateUpcoming();
+    void onValidated(const std::shared_ptr<Job> &job, const QString &filePath, const QString &error);
+    static QString validate(const QString &filePath, const std::atomic<bool> *canceled);
+
+private:
+    Playlist *m_playlist;  // 不拥有此指针
+    QThreadPool *m_pool;
+    std::shared_ptr<Job> m_job;
+    int m_lookAhead;
+    bool m_refreshScheduled;
+    QSet<QString> m_passed;
+    QHash<QString, QString> m_failures;  // 路径 → 错误信息
+};
+
+#endif // TRACKVALIDATOR_H
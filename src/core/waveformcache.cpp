@@ -0,0 +1,359 @@
+#include "waveformcache.h"
+#include "pcmdecoder.h"
+#include "contenthash.h"
+#include <QThreadPool>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDebug>
+#include <cmath>
+#include <limits>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+const quint32 WaveformMagic = 0x59595746;  // "YYWF"
+const quint32 WaveformVersion = 2;        // 版本 1 的最小值/最大值被错误地限制在 0 两侧
+const qint64 DefaultDiskLimit = 64 * 1024 * 1024;  // 每首约 24KB，可保存约两千多首
+const int BlockFrames = 1024;      // 解码时的最小统计单元
+const int BaseBuckets = 4096;      // 最精细一级的柱数
+const int MinBuckets = 32;         // 最粗一级的柱数下限
+
+// 对一段样本求最小值、最大值和平方和
+void reduceBlock(const float *samples, int count, float *minOut, float *maxOut, double *sumSquares)
+{
+    float lo = *minOut;
+    float hi = *maxOut;
+    double sum = 0.0;
+    int i = 0;
+
+#if defined(__SSE__)
+    // 每次处理 4 个样本，最后再做水平归约
+    __m128 vmin = _mm_set1_ps(lo);
+    __m128 vmax = _mm_set1_ps(hi);
+    __m128 vsum = _mm_setzero_ps();
+    for (; i + 16 <= count; i += 16) {
+        __m128 a = _mm_loadu_ps(samples + i);
+        __m128 b = _mm_loadu_ps(samples + i + 4);
+        __m128 c = _mm_loadu_ps(samples + i + 8);
+        __m128 d = _mm_loadu_ps(samples + i + 12);
+        vmin = _mm_min_ps(vmin, _mm_min_ps(_mm_min_ps(a, b), _mm_min_ps(c, d)));
+        vmax = _mm_max_ps(vmax, _mm_max_ps(_mm_max_ps(a, b), _mm_max_ps(c, d)));
+        __m128 squares = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b)),
+                                    _mm_add_ps(_mm_mul_ps(c, c), _mm_mul_ps(d, d)));
+        vsum = _mm_add_ps(vsum, squares);
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, vmin);
+    lo = qMin(qMin(lanes[0], lanes[1]), qMin(lanes[2], lanes[3]));
+    _mm_storeu_ps(lanes, vmax);
+    hi = qMax(qMax(lanes[0], lanes[1]), qMax(lanes[2], lanes[3]));
+    _mm_storeu_ps(lanes, vsum);
+    sum = double(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+    for (; i < count; ++i) {
+        float x = samples[i];
+        lo = qMin(lo, x);
+        hi = qMax(hi, x);
+        sum += double(x) * x;
+    }
+
+    *minOut = lo;
+    *maxOut = hi;
+    *sumSquares += sum;
+}
+
+struct FloatPeak
+{
+    float min;
+    float max;
+    double meanSquare;
+};
+
+// 每个统计单元从空区间开始，否则全正或全负的一段会被拉到 0
+const FloatPeak EmptyPeak{std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), 0.0};
+
+QVector<WaveformPeak> quantize(const QVector<FloatPeak> &peaks)
+{
+    QVector<WaveformPeak> level(peaks.size());
+    for (int i = 0; i < peaks.size(); ++i) {
+        level[i].min = qint8(qBound(-127, int(std::lround(peaks[i].min * 127.0f)), 127));
+        level[i].max = qint8(qBound(-127, int(std::lround(peaks[i].max * 127.0f)), 127));
+        level[i].rms = quint8(qBound(0, int(std::lround(std::sqrt(peaks[i].meanSquare) * 255.0)), 255));
+    }
+    return level;
+}
+
+// 把 count 个细粒度统计合并为 buckets 个
+QVector<FloatPeak> downsample(const QVector<FloatPeak> &source, int buckets)
+{
+    QVector<FloatPeak> result(buckets);
+    const int count = source.size();
+    for (int b = 0; b < buckets; ++b) {
+        int first = int(qint64(b) * count / buckets);
+        int last = qMax(first + 1, int(qint64(b + 1) * count / buckets));
+        FloatPeak peak{source[first].min, source[first].max, 0.0};
+        for (int i = first; i < last; ++i) {
+            peak.min = qMin(peak.min, source[i].min);
+            peak.max = qMax(peak.max, source[i].max);
+            peak.meanSquare += source[i].meanSquare;
+        }
+        peak.meanSquare /= (last - first);
+        result[b] = peak;
+    }
+    return result;
+}
+
+} // namespace
+
+const QVector<WaveformPeak> &WaveformData::levelForWidth(int width) const
+{
+    // levels 按柱数从多到少排列，从最粗一级往回找
+    for (int i = levels.size() - 1; i > 0; --i) {
+        if (levels[i].size() >= width) {
+            return levels[i];
+        }
+    }
+    return levels.first();
+}
+
+WaveformCache::WaveformCache(QObject *parent)
+    : QObject(parent)
+    , m_pool(new QThreadPool(this))
+    , m_memoryLimit(64)
+    , m_diskLimit(DefaultDiskLimit)
+{
+    // 解码代价高，限制并发，避免与播放争抢 CPU 和磁盘
+    m_pool->setMaxThreadCount(2);
+    m_cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/waveforms";
+    QDir().mkpath(m_cacheDir);
+}
+
+WaveformCache::~WaveformCache()
+{
+    m_pool->clear();
+    m_pool->waitForDone();
+}
+
+void WaveformCache::request(const QString &filePath)
+{
+    if (m_memory.contains(filePath)) {
+        m_recent.removeOne(filePath);
+        m_recent.append(filePath);
+        emit waveformReady(filePath);
+        return;
+    }
+
+    // 读取修改时间和磁盘缓存都在工作线程中进行，网络存储上也不会卡住界面
+    m_requested.insert(filePath);
+    schedule(filePath, 1);
+}
+
+void WaveformCache::prefetch(const QStringList &filePaths)
+{
+    for (const QString &filePath : filePaths) {
+        if (!m_memory.contains(filePath)) {
+            schedule(filePath, 0);
+        }
+    }
+}
+
+bool WaveformCache::contains(const QString &filePath) const
+{
+    return m_memory.contains(filePath);
+}
+
+WaveformData WaveformCache::waveform(const QString &filePath) const
+{
+    return m_memory.value(filePath);
+}
+
+void WaveformCache::schedule(const QString &filePath, int priority)
+{
+    if (m_pending.contains(filePath)) {
+        return;
+    }
+    m_pending.insert(filePath);
+
+    // m_cacheDir 构造后不再改变，可以在工作线程中读取
+    const bool wanted = priority > 0;
+    const qint64 diskLimit = m_diskLimit;
+    m_pool->start([this, filePath, wanted, diskLimit]() {
+        const QString cachePath = cacheFilePath(filePath, QFileInfo(filePath).lastModified());
+        WaveformData data;
+        bool cached = false;
+        if (wanted) {
+            cached = load(cachePath, &data);
+        } else {
+            // 预先生成只需确认磁盘上已有，不读入内存
+            cached = QFile::exists(cachePath);
+        }
+        if (!cached) {
+            data = build(filePath);
+            if (!data.isEmpty() && save(cachePath, data)) {
+                trim(m_cacheDir, diskLimit);
+            }
+        }
+        const bool onDisk = cached && !wanted;
+        QMetaObject::invokeMethod(this, [this, filePath, data, onDisk]() {
+            onWaveformBuilt(filePath, data, onDisk);
+        }, Qt::QueuedConnection);
+    }, priority);
+}
+
+void WaveformCache::onWaveformBuilt(const QString &filePath, const WaveformData &data, bool onDisk)
+{
+    m_pending.remove(filePath);
+    if (data.isEmpty()) {
+        // 预先生成时发现已在磁盘上，期间界面又请求了这首：再排一次读取
+        if (onDisk && m_requested.contains(filePath)) {
+            schedule(filePath, 1);
+        } else {
+            m_requested.remove(filePath);
+        }
+        return;
+    }
+    m_requested.remove(filePath);
+    remember(filePath, data);
+    emit waveformReady(filePath);
+}
+
+void WaveformCache::remember(const QString &filePath, const WaveformData &data)
+{
+    m_memory.insert(filePath, data);
+    m_recent.removeOne(filePath);
+    m_recent.append(filePath);
+    while (m_recent.size() > m_memoryLimit) {
+        m_memory.remove(m_recent.takeFirst());
+    }
+}
+
+QString WaveformCache::cacheFilePath(const QString &filePath, const QDateTime &lastModified) const
+{
+    // 路径和修改时间共同决定缓存键，文件变化后自动失效
+    ContentHasher hasher;
+    hasher.addData(filePath.toUtf8());
+    qint64 mtime = lastModified.toMSecsSinceEpoch();
+    hasher.addData(reinterpret_cast<const char *>(&mtime), sizeof(mtime));
+    return m_cacheDir + QString("/%1.wf").arg(hasher.result(), 16, 16, QChar('0'));
+}
+
+WaveformData WaveformCache::build(const QString &filePath)
+{
+    QVector<FloatPeak> blocks;
+    FloatPeak current = EmptyPeak;
+    int currentSamples = 0;
+    int blockSamples = 0;
+
+    PcmDecoder decoder;
+    bool ok = decoder.decode(filePath, [&](const float *samples, int frames, int channels, int) {
+        blockSamples = BlockFrames * channels;
+        int count = frames * channels;
+        while (count > 0) {
+            int n = qMin(count, blockSamples - currentSamples);
+            reduceBlock(samples, n, &current.min, &current.max, &current.meanSquare);
+            samples += n;
+            count -= n;
+            currentSamples += n;
+            if (currentSamples == blockSamples) {
+                current.meanSquare /= currentSamples;
+                blocks.append(current);
+                current = EmptyPeak;
+                currentSamples = 0;
+            }
+        }
+        return true;
+    });
+
+    WaveformData data;
+    if (!ok) {
+        qDebug() << "生成波形失败:" << filePath << decoder.errorString();
+        return data;
+    }
+    if (currentSamples > 0) {
+        current.meanSquare /= currentSamples;
+        blocks.append(current);
+    }
+    if (blocks.isEmpty()) {
+        return data;
+    }
+
+    data.durationMs = decoder.sampleRate() > 0 ? decoder.decodedFrames() * 1000 / decoder.sampleRate() : 0;
+    QVector<FloatPeak> level = downsample(blocks, qMin(BaseBuckets, blocks.size()));
+    data.levels.append(quantize(level));
+    while (level.size() / 2 >= MinBuckets) {
+        level = downsample(level, level.size() / 2);
+        data.levels.append(quantize(level));
+    }
+    return data;
+}
+
+bool WaveformCache::save(const QString &cachePath, const WaveformData &data)
+{
+    QSaveFile file(cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out << WaveformMagic << WaveformVersion << data.durationMs << qint32(data.levels.size());
+    for (const QVector<WaveformPeak> &level : data.levels) {
+        out << qint32(level.size());
+        out.writeRawData(reinterpret_cast<const char *>(level.constData()), level.size() * int(sizeof(WaveformPeak)));
+    }
+    return file.commit();
+}
+
+bool WaveformCache::load(const QString &cachePath, WaveformData *data)
+{
+    QFile file(cachePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    quint32 magic = 0, version = 0;
+    qint32 levelCount = 0;
+    in >> magic >> version >> data->durationMs >> levelCount;
+    if (magic != WaveformMagic || version != WaveformVersion || levelCount <= 0 || levelCount > 32) {
+        return false;
+    }
+
+    data->levels.clear();
+    for (int i = 0; i < levelCount; ++i) {
+        qint32 count = 0;
+        in >> count;
+        if (count <= 0 || count > BaseBuckets) {
+            return false;
+        }
+        QVector<WaveformPeak> level(count);
+        int bytes = count * int(sizeof(WaveformPeak));
+        if (in.readRawData(reinterpret_cast<char *>(level.data()), bytes) != bytes) {
+            return false;
+        }
+        data->levels.append(level);
+    }
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+    // 更新修改时间作为最近使用时间，超出磁盘上限时 trim 先删除最久未用的
+    file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+    return true;
+}
+
+void WaveformCache::trim(const QString &cacheDir, qint64 maxBytes)
+{
+    // 按修改时间从新到旧累计，超出上限的部分全部删除
+    const QFileInfoList entries = QDir(cacheDir).entryInfoList(QStringList() << "*.wf", QDir::Files, QDir::Time);
+    qint64 total = 0;
+    for (const QFileInfo &entry : entries) {
+        total += entry.size();
+        if (total > maxBytes) {
+            QFile::remove(entry.filePath());
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef WAVEFORMCACHE_H
+#define WAVEFORMCACHE_H
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QDateTime>
+
+class QThreadPool;
+
+// 单个波形柱：最小值、最大值（-127~127）和均方根（0~255）
+struct WaveformPeak
+{
+    qint8 min;
+    qint8 max;
+    quint8 rms;
+};
+
+// 多分辨率波形概览，levels[0] 精度最高，之后每级柱数减半
+struct WaveformData
+{
+    qint64 durationMs = 0;
+    QVector<QVector<WaveformPeak>> levels;
+
+    bool isEmpty() const { return levels.isEmpty() || levels.first().isEmpty(); }
+    // 选择柱数不少于 width 的最粗一级，绘制时不需要再访问音频文件
+    const QVector<WaveformPeak> &levelForWidth(int width) const;
+};
+
+// 波形缓存：后台解码一次，结果按路径+修改时间保存到磁盘，磁盘缓存按最近使用时间限制总大小
+class WaveformCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit WaveformCache(QObject *parent = nullptr);
+    ~WaveformCache();
+
+    // 请求某首歌曲的波形；已缓存时立即发出 waveformReady
+    void request(const QString &filePath);
+    // 低优先级预先生成，不影响当前歌曲
+    void prefetch(const QStringList &filePaths);
+
+    bool contains(const QString &filePath) const;
+    WaveformData waveform(const QString &filePath) const;
+
+    void setMemoryLimit(int count) { m_memoryLimit = count; }
+    // 磁盘缓存总大小上限，超出时删除最久未用的波形
+    void setDiskLimit(qint64 bytes) { m_diskLimit = bytes; }
+
+signals:
+    void waveformReady(const QString &filePath);
+
+private:
+    void schedule(const QString &filePath, int priority);
+    void onWaveformBuilt(const QString &filePath, const WaveformData &data, bool onDisk);
+    void remember(const QString &filePath, const WaveformData &data);
+    QString cacheFilePath(const QString &filePath, const QDateTime &lastModified) const;
+
+    static WaveformData build(const QString &filePath);
+    static bool save(const QString &cachePath, const WaveformData &data);
+    static bool load(const QString &cachePath, WaveformData *data);
+    static void trim(const QString &cacheDir, qint64 maxBytes);
+
+private:
+    QThreadPool *m_pool;
+    QString m_cacheDir;
+    QHash<QString, WaveformData> m_memory;
+    QList<QString> m_recent;  // 内存中的 LRU 顺序
+    QSet<QString> m_pending;
+    QSet<QString> m_requested;  // 界面在等待的歌曲，完成后发出 waveformReady
+    int m_memoryLimit;
+    qint64 m_diskLimit;
+};
+
+#endif // WAVEFORMCACHE_H
@@ -1,4 +1,5 @@
 #include "ui/mainwindow.h"
+#include "core/controlclient.h"
 
 #include <QApplication>
 #include <QLocale>
@@ -8,6 +9,12 @@ int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
 
+    // 已有实例在运行时把参数交给它后立即退出，不再创建主窗口、载入设置和扫描音乐库
+    const QStringList paths = a.arguments().mid(1);
+    if (ControlClient::handoff(paths)) {
+        return 0;
+    }
+
     QTranslator translator;
     const QStringList uiLanguages = QLocale::system().uiLanguages();
     for (const QString &locale : uiLanguages) {
@@ -19,5 +26,8 @@ int main(int argc, char *argv[])
     }
     MainWindow w;
     w.show();
+    if (!paths.isEmpty()) {
+        w.openPaths(paths, true);
+    }
     return a.exec();
 }
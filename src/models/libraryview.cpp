@@ -0,0 +1,616 @@
+#include "libraryview.h"
+#include "musiclibrary.h"
+#include <QThreadPool>
+#include <QThread>
+#include <QSemaphore>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QLocale>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+// 超过该数量的整体排序放到后台线程并行完成
+const int ParallelThreshold = 20000;
+// 并行排序时每块的最小行数，块太小时线程调度的开销大于收益
+const int MinChunkRows = 4096;
+
+} // namespace
+
+struct LibraryView::Job
+{
+    Spec spec;
+    QVector<int> unkeyed;    // 需要计算排序键的行
+    QVector<QString> titles; // 这些行的标题，算完排序键即释放
+    QVector<quint32> names;  // 需要计算排序键的名称
+    QVector<int> order;      // 参与排序的全部行
+    std::atomic<bool> canceled{false};
+};
+
+LibraryView::LibraryView(MusicLibrary *library, QObject *parent)
+    : QObject(parent)
+    , m_library(library)
+    , m_pool(new QThreadPool(this))
+    , m_groupDepth(0)
+    , m_applyScheduled(false)
+    , m_lastSortMs(0)
+{
+    // 多留一个线程给协调任务，它会等待分块任务完成
+    m_pool->setMaxThreadCount(QThread::idealThreadCount() + 1);
+    m_spec.keys = {Path};
+    m_spec.order = Qt::AscendingOrder;
+    m_names.emplace_back();
+
+    connect(m_library, &MusicLibrary::fileAdded, this, &LibraryView::onFileAdded);
+    connect(m_library, &MusicLibrary::fileRemoved, this, &LibraryView::onFileRemoved);
+    connect(m_library, &MusicLibrary::fileUpdated, this, &LibraryView::onFileUpdated);
+
+    const TrackStore &tracks = m_library->tracks();
+    for (int track = 0; track < tracks.rowCount(); ++track) {
+        if (tracks.isLive(track)) {
+            m_pendingAdded.insert(track);
+        }
+    }
+    schedulePending();
+}
+
+LibraryView::~LibraryView()
+{
+    if (m_job) {
+        m_job->canceled = true;
+    }
+    m_pool->waitForDone();
+}
+
+QCollator LibraryView::collator()
+{
+    QCollator collator(QLocale(QLocale::Chinese, QLocale::China));
+    collator.setNumericMode(true);
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+    return collator;
+}
+
+void LibraryView::setSortKeys(const QVector<Key> &keys, Qt::SortOrder order)
+{
+    if (keys.isEmpty() || (keys == m_spec.keys && order == m_spec.order)) {
+        return;
+    }
+    m_spec.keys = keys;
+    m_spec.order = order;
+
+    // 正在排序时等它结束后再按新的规则排一次
+    if (!m_job) {
+        startSort(QVector<int>(), QVector<QString>());
+    }
+}
+
+QVector<LibraryView::Key> LibraryView::sortKeys() const
+{
+    return m_spec.keys;
+}
+
+Qt::SortOrder LibraryView::sortOrder() const
+{
+    return m_spec.order;
+}
+
+void LibraryView::setGroupDepth(int depth)
+{
+    m_groupDepth = qMax(0, depth);
+}
+
+int LibraryView::groupDepth() const
+{
+    return m_groupDepth;
+}
+
+int LibraryView::count() const
+{
+    return m_order.size();
+}
+
+QString LibraryView::filePath(int row) const
+{
+    return m_rows[size_t(m_order.at(row))].path;
+}
+
+QStringList LibraryView::filePaths() const
+{
+    QStringList paths;
+    paths.reserve(m_order.size());
+    for (int id : m_order) {
+        paths.append(m_rows[size_t(id)].path);
+    }
+    return paths;
+}
+
+QVector<LibraryView::Group> LibraryView::groups() const
+{
+    QVector<Group> result;
+    const int depth = qMin(m_groupDepth, m_spec.keys.size());
+    if (depth == 0) {
+        return result;
+    }
+
+    // 逐行比较前 depth 个键，从第一个不同的层级开始关闭旧分组、打开新分组
+    QVector<int> open(depth, -1);
+    for (int r = 0; r < m_order.size(); ++r) {
+        const Row &row = m_rows[size_t(m_order.at(r))];
+        int level = 0;
+        if (r > 0) {
+            const Row &previous = m_rows[size_t(m_order.at(r - 1))];
+            for (level = 0; level < depth; ++level) {
+                if (compareKey(previous, row, m_spec.keys.at(level)) != 0) {
+                    break;
+                }
+            }
+        }
+        for (int l = level; l < depth; ++l) {
+            if (open[l] >= 0) {
+                result[open[l]].count = r - result[open[l]].first;
+            }
+            result.append(Group{r, 0, l, keyText(m_order.at(r), m_spec.keys.at(l))});
+            open[l] = result.size() - 1;
+        }
+    }
+    for (int l = 0; l < depth; ++l) {
+        if (open[l] >= 0) {
+            result[open[l]].count = m_order.size() - result[open[l]].first;
+        }
+    }
+    return result;
+}
+
+bool LibraryView::isSorting() const
+{
+    return m_job != nullptr;
+}
+
+double LibraryView::lastSortMs() const
+{
+    return m_lastSortMs;
+}
+
+void LibraryView::onFileAdded(const QString &, int track)
+{
+    m_pendingAdded.insert(track);
+    schedulePending();
+}
+
+void LibraryView::onFileRemoved(const QString &, int track)
+{
+    // 音乐库中的这一行已经删除，视图中的行在合并时才清除，之前仍能给出原来的路径
+    m_pendingAdded.remove(track);
+    if (size_t(track) < m_rows.size() && m_rows[size_t(track)].live) {
+        m_pendingRemoved.insert(track);
+    }
+    schedulePending();
+}
+
+void LibraryView::onFileUpdated(const QString &filePath, int track)
+{
+    // 行已被删除、等待合并时，这是复用该行的另一首歌
+    if (size_t(track) >= m_rows.size() || !m_rows[size_t(track)].live || m_pendingRemoved.contains(track)) {
+        onFileAdded(filePath, track);
+        return;
+    }
+
+    // 只有参与排序的字段变化时才需要重新定位，哈希、响度等分析结果不影响顺序
+    const TrackStore &tracks = m_library->tracks();
+    const Row &row = m_rows[size_t(track)];
+    const QString title = tracks.title(track);
+    if (row.titleHash == qHash(title) && row.hasTitle == !title.isEmpty()
+        && m_names[row.artist].text == tracks.artist(track) && m_names[row.album].text == tracks.album(track)
+        && m_names[row.genre].text == tracks.genre(track) && row.duration == tracks.duration(track)
+        && row.modified == tracks.lastModifiedMSecs(track) && row.playCount == tracks.playCount(track)) {
+        return;
+    }
+    m_pendingRemoved.insert(track);
+    m_pendingAdded.insert(track);
+    schedulePending();
+}
+
+void LibraryView::schedulePending()
+{
+    if (m_applyScheduled) {
+        return;
+    }
+    m_applyScheduled = true;
+    QTimer::singleShot(0, this, &LibraryView::applyPending);
+}
+
+void LibraryView::applyPending()
+{
+    m_applyScheduled = false;
+    if (m_job || (m_pendingAdded.isEmpty() && m_pendingRemoved.isEmpty())) {
+        return;  // 排序结束后会再次调用
+    }
+
+    // 先删除：从顺序中过滤掉，再释放行和名称
+    QSet<QString> removed;
+    for (int id : qAsConst(m_pendingRemoved)) {
+        Row &row = m_rows[size_t(id)];
+        if (row.live) {
+            removed.insert(row.path);
+            row.live = false;
+        }
+    }
+    if (!removed.isEmpty()) {
+        m_order.erase(std::remove_if(m_order.begin(), m_order.end(), [this](int id) {
+            return !m_rows[size_t(id)].live;
+        }), m_order.end());
+    }
+    for (int id : qAsConst(m_pendingRemoved)) {
+        releaseRow(id);
+    }
+    m_pendingRemoved.clear();
+
+    const TrackStore &tracks = m_library->tracks();
+    if (m_rows.size() < size_t(tracks.rowCount())) {
+        m_rows.resize(size_t(tracks.rowCount()));
+    }
+    QVector<int> added;
+    QVector<QString> titles;
+    for (int id : qAsConst(m_pendingAdded)) {
+        if (id >= tracks.rowCount() || !tracks.isLive(id) || m_rows[size_t(id)].live) {
+            continue;
+        }
+        titles.append(fillRow(id));
+        added.append(id);
+    }
+    m_pendingAdded.clear();
+
+    if (added.isEmpty()) {
+        emit rowsChanged(removed);
+        return;
+    }
+
+    // 大批量变化（包括首次载入）整体排序，规模大时交给后台线程
+    const int total = m_order.size() + added.size();
+    const bool bulk = added.size() * 8 > total;
+    if (bulk && total >= ParallelThreshold) {
+        startSort(added, titles);
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const QCollator collator = LibraryView::collator();
+    for (int i = 0; i < added.size(); ++i) {
+        Row &row = m_rows[size_t(added.at(i))];
+        row.title.emplace(collator.sortKey(titles.at(i)));
+        computeNameKey(row.artist, collator);
+        computeNameKey(row.album, collator);
+        computeNameKey(row.genre, collator);
+    }
+
+    auto less = [this](int a, int b) {
+        return compareRows(m_rows[size_t(a)], m_rows[size_t(b)], m_spec) < 0;
+    };
+    if (bulk) {
+        m_order += added;
+        std::sort(m_order.begin(), m_order.end(), less);
+    } else {
+        // 少量新增：逐个二分查找插入位置，一次拷贝合并，比较次数为 k·log n
+        std::sort(added.begin(), added.end(), less);
+        QVector<int> merged;
+        merged.reserve(total);
+        auto from = m_order.constBegin();
+        for (int id : qAsConst(added)) {
+            auto pos = std::upper_bound(from, m_order.constEnd(), id, less);
+            for (; from != pos; ++from) {
+                merged.append(*from);
+            }
+            merged.append(id);
+        }
+        for (; from != m_order.constEnd(); ++from) {
+            merged.append(*from);
+        }
+        m_order.swap(merged);
+    }
+    m_lastSortMs = timer.nsecsElapsed() / 1e6;
+    if (bulk) {
+        emit orderChanged();
+    } else {
+        emit rowsChanged(removed);
+    }
+}
+
+void LibraryView::startSort(const QVector<int> &unkeyed, const QVector<QString> &titles)
+{
+    auto job = std::make_shared<Job>();
+    job->spec = m_spec;
+    job->unkeyed = unkeyed;
+    job->titles = titles;
+    job->order = m_order + unkeyed;
+    for (quint32 id = 1; id < quint32(m_names.size()); ++id) {
+        if (m_names[id].refs > 0 && !m_names[id].key) {
+            job->names.append(id);
+        }
+    }
+    m_job = job;
+
+    // 协调任务：先并行计算排序键，再分块排序、两两归并
+    m_pool->start([this, job]() {
+        QElapsedTimer timer;
+        timer.start();
+        const int workers = qMax(1, m_pool->maxThreadCount() - 1);
+
+        auto runParallel = [this](int tasks, const std::function<void(int)> &task) {
+            QSemaphore done;
+            for (int i = 0; i < tasks; ++i) {
+                m_pool->start([&task, &done, i]() {
+                    task(i);
+                    done.release();
+                });
+            }
+            done.acquire(tasks);
+        };
+
+        // 每个线程使用自己的 QCollator，它不能跨线程共享；每个任务只写自己负责的名称和行
+        const QVector<quint32> &names = job->names;
+        const int nameTasks = qBound(1, names.size() / MinChunkRows, workers);
+        runParallel(nameTasks, [this, job, &names, nameTasks](int t) {
+            const QCollator collator = LibraryView::collator();
+            const int first = int(qint64(names.size()) * t / nameTasks);
+            const int last = int(qint64(names.size()) * (t + 1) / nameTasks);
+            for (int i = first; i < last && !job->canceled; ++i) {
+                computeNameKey(names.at(i), collator);
+            }
+        });
+
+        const QVector<int> &unkeyed = job->unkeyed;
+        const QVector<QString> &titles = job->titles;
+        const int keyTasks = qBound(1, unkeyed.size() / MinChunkRows, workers);
+        runParallel(keyTasks, [this, job, &unkeyed, &titles, keyTasks](int t) {
+            const QCollator collator = LibraryView::collator();
+            const int first = int(qint64(unkeyed.size()) * t / keyTasks);
+            const int last = int(qint64(unkeyed.size()) * (t + 1) / keyTasks);
+            for (int i = first; i < last && !job->canceled; ++i) {
+                m_rows[size_t(unkeyed.at(i))].title.emplace(collator.sortKey(titles.at(i)));
+            }
+        });
+        job->titles = QVector<QString>();
+
+        QVector<int> order = job->order;
+        const Spec spec = job->spec;
+        auto less = [this, &spec](int a, int b) {
+            return compareRows(m_rows[size_t(a)], m_rows[size_t(b)], spec) < 0;
+        };
+
+        // 分块排序
+        int parts = qBound(1, order.size() / MinChunkRows, workers);
+        QVector<int> bounds;
+        for (int i = 0; i <= parts; ++i) {
+            bounds.append(int(qint64(order.size()) * i / parts));
+        }
+        if (!job->canceled) {
+            runParallel(parts, [&order, &bounds, &less](int t) {
+                std::sort(order.begin() + bounds.at(t), order.begin() + bounds.at(t + 1), less);
+            });
+        }
+
+        // 两两归并，直到只剩一块
+        QVector<int> buffer(order.size());
+        while (parts > 1 && !job->canceled) {
+            const int pairs = (parts + 1) / 2;
+            runParallel(pairs, [&order, &buffer, &bounds, &less, parts](int t) {
+                const int a = 2 * t;
+                auto out = buffer.begin() + bounds.at(a);
+                if (a + 1 < parts) {
+                    std::merge(order.constBegin() + bounds.at(a), order.constBegin() + bounds.at(a + 1),
+                               order.constBegin() + bounds.at(a + 1), order.constBegin() + bounds.at(a + 2),
+                               out, less);
+                } else {
+                    std::copy(order.constBegin() + bounds.at(a), order.constBegin() + bounds.at(a + 1), out);
+                }
+            });
+            order.swap(buffer);
+
+            QVector<int> merged;
+            for (int i = 0; i < parts; i += 2) {
+                merged.append(bounds.at(i));
+            }
+            merged.append(bounds.last());
+            bounds = merged;
+            parts = pairs;
+        }
+
+        const qint64 elapsed = timer.elapsed();
+        QMetaObject::invokeMethod(this, [this, job, order, elapsed]() {
+            onSortFinished(job, order, elapsed);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void LibraryView::onSortFinished(const std::shared_ptr<Job> &job, const QVector<int> &order, qint64 elapsed)
+{
+    if (job != m_job) {
+        return;
+    }
+    m_job.reset();
+
+    // 排序期间规则变了，排序键已经算好，直接按新规则再排一次
+    if (job->spec.keys != m_spec.keys || job->spec.order != m_spec.order) {
+        m_order = job->order;
+        startSort(QVector<int>(), QVector<QString>());
+        return;
+    }
+
+    m_order = order;
+    m_lastSortMs = elapsed;
+    emit orderChanged();
+
+    if (!m_pendingAdded.isEmpty() || !m_pendingRemoved.isEmpty()) {
+        applyPending();
+    }
+}
+
+QString LibraryView::fillRow(int id)
+{
+    const TrackStore &tracks = m_library->tracks();
+    const QString title = tracks.title(id);
+    Row &row = m_rows[size_t(id)];
+    row.path = tracks.filePath(id);
+    row.title.reset();
+    row.titleHash = qHash(title);
+    row.hasTitle = !title.isEmpty();
+    row.artist = acquireName(tracks.artist(id));
+    row.album = acquireName(tracks.album(id));
+    row.genre = acquireName(tracks.genre(id));
+    row.duration = tracks.duration(id);
+    row.modified = tracks.lastModifiedMSecs(id);
+    row.playCount = tracks.playCount(id);
+    row.live = true;
+    return title;
+}
+
+void LibraryView::releaseRow(int id)
+{
+    Row &row = m_rows[size_t(id)];
+    releaseName(row.artist);
+    releaseName(row.album);
+    releaseName(row.genre);
+    row = Row();
+}
+
+quint32 LibraryView::acquireName(const QString &text)
+{
+    if (text.isEmpty()) {
+        return 0;
+    }
+    auto it = m_nameIds.constFind(text);
+    if (it != m_nameIds.constEnd()) {
+        ++m_names[it.value()].refs;
+        return it.value();
+    }
+
+    quint32 id;
+    if (!m_freeNames.isEmpty()) {
+        id = m_freeNames.takeLast();
+    } else {
+        id = quint32(m_names.size());
+        m_names.emplace_back();
+    }
+    Name &name = m_names[id];
+    name.text = text;  // 与音乐库字符串池共享数据
+    name.refs = 1;
+    m_nameIds.insert(text, id);
+    return id;
+}
+
+void LibraryView::releaseName(quint32 id)
+{
+    if (id == 0 || --m_names[id].refs > 0) {
+        return;
+    }
+    m_nameIds.remove(m_names[id].text);
+    m_names[id] = Name();
+    m_freeNames.append(id);
+}
+
+void LibraryView::computeNameKey(quint32 id, const QCollator &collator)
+{
+    Name &name = m_names[id];
+    if (id != 0 && !name.key) {
+        name.key.emplace(collator.sortKey(name.text));
+    }
+}
+
+int LibraryView::compareName(quint32 a, quint32 b) const
+{
+    // 同一名称不必比较排序键；空文本（未知艺术家等）总是排在最后
+    if (a == b) {
+        return 0;
+    }
+    if (a == 0 || b == 0) {
+        return a == 0 ? 1 : -1;
+    }
+    return m_names[a].key->compare(*m_names[b].key);
+}
+
+int LibraryView::compareKey(const Row &a, const Row &b, Key key) const
+{
+    switch (key) {
+    case Title:
+        if (a.hasTitle != b.hasTitle) {
+            return a.hasTitle ? -1 : 1;
+        }
+        return a.title->compare(*b.title);
+    case Artist:
+        return compareName(a.artist, b.artist);
+    case Album:
+        return compareName(a.album, b.album);
+    case Genre:
+        return compareName(a.genre, b.genre);
+    case Duration:
+        return (a.duration > b.duration) - (a.duration < b.duration);
+    case LastModified:
+        return (a.modified > b.modified) - (a.modified < b.modified);
+    case PlayCount:
+        return (a.playCount > b.playCount) - (a.playCount < b.playCount);
+    case Path:
+        return a.path.compare(b.path);
+    }
+    return 0;
+}
+
+int LibraryView::compareRows(const Row &a, const Row &b, const Spec &spec) const
+{
+    for (Key key : spec.keys) {
+        int result = compareKey(a, b, key);
+        if (result != 0) {
+            // 空文本（未知艺术家等）在升序和降序时都排在最后，不随排序方向反转
+            if (isEmptyKey(a, key) != isEmptyKey(b, key)) {
+                return result;
+            }
+            return spec.order == Qt::AscendingOrder ? result : -result;
+        }
+    }
+    // 以路径区分相同的键，保证顺序稳定
+    return a.path.compare(b.path);
+}
+
+bool LibraryView::isEmptyKey(const Row &row, Key key)
+{
+    switch (key) {
+    case Title:
+        return !row.hasTitle;
+    case Artist:
+        return row.artist == 0;
+    case Album:
+        return row.album == 0;
+    case Genre:
+        return row.genre == 0;
+    default:
+        return false;
+    }
+}
+
+QString LibraryView::keyText(int id, Key key) const
+{
+    const Row &row = m_rows[size_t(id)];
+    switch (key) {
+    case Title: {
+        // 排序期间音乐库可能已经删除了这一行（变化尚未合并），此时不显示标题
+        const TrackStore &tracks = m_library->tracks();
+        return id < tracks.rowCount() && tracks.isLive(id) ? tracks.title(id) : QString();
+    }
+    case Artist:
+        return m_names[row.artist].text;
+    case Album:
+        return m_names[row.album].text;
+    case Genre:
+        return m_names[row.genre].text;
+    case Duration:
+        return QString::number(row.duration / 1000);
+    case LastModified:
+        return QString::number(row.modified);
+    case PlayCount:
+        return QString::number(row.playCount);
+    case Path:
+        return row.path;
+    }
+    return QString();
+}
@@ -0,0 +1,154 @@
+#ifndef LIBRARYVIEW_H
+#define LIBRARYVIEW_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QStringList>
+#include <QCollator>
+#include <QCollatorSortKey>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+
+class QThreadPool;
+class MusicLibrary;
+
+// 可排序、可分组的音乐库视图
+// 每首歌的排序键（QCollatorSortKey）在加入视图时计算一次，之后排序只比较排序键。
+// 大规模排序在线程池中分块并行完成；音乐库的少量变化通过二分插入合并到已有顺序中，不重新排序。
+// 行号就是 TrackStore 的行号。标签文字不在视图中另存：艺术家、专辑、流派按名称登记，排序键每个名称只算一次；
+// 标题只保留排序键，分组名从音乐库读取。路径保留一份，后台排序线程比较路径时不能读取界面线程正在修改的 TrackStore
+class LibraryView : public QObject
+{
+    Q_OBJECT
+public:
+    enum Key {
+        Title,
+        Artist,
+        Album,
+        Genre,
+        Duration,
+        LastModified,
+        PlayCount,
+        Path
+    };
+
+    // 分组：同一分组内的歌曲在 [first, first + count) 范围内，depth 为分组层级
+    struct Group
+    {
+        int first;
+        int count;
+        int depth;
+        QString label;
+    };
+
+    explicit LibraryView(MusicLibrary *library, QObject *parent = nullptr);
+    ~LibraryView();
+
+    // 多级排序，例如 艺术家 → 专辑 → 标题
+    void setSortKeys(const QVector<Key> &keys, Qt::SortOrder order = Qt::AscendingOrder);
+    QVector<Key> sortKeys() const;
+    Qt::SortOrder sortOrder() const;
+
+    // 按前 depth 个排序键分组，0 表示不分组
+    void setGroupDepth(int depth);
+    int groupDepth() const;
+
+    int count() const;
+    QString filePath(int row) const;
+    QStringList filePaths() const;
+    QVector<Group> groups() const;
+
+    bool isSorting() const;
+    double lastSortMs() const;
+
+    // 中文按拼音排序，数字按数值比较，忽略大小写
+    static QCollator collator();
+
+signals:
+    // 整体重新排序（规则变化、大批量变化），列表需要全部刷新
+    void orderChanged();
+    // 少量增删合并到了已有顺序中：removed 中的歌曲离开原位置（更新的歌曲会在新位置重新出现），
+    // 其余歌曲的相对顺序不变，列表可以只插入、删除变化的行
+    void rowsChanged(const QSet<QString> &removed);
+
+private slots:
+    void onFileAdded(const QString &filePath, int track);
+    void onFileRemoved(const QString &filePath, int track);
+    void onFileUpdated(const QString &filePath, int track);
+
+private:
+    // 艺术家、专辑、流派名称，编号 0 表示空文本
+    struct Name
+    {
+        QString text;
+        std::optional<QCollatorSortKey> key;
+        int refs = 0;
+    };
+
+    struct Row
+    {
+        QString path;
+        std::optional<QCollatorSortKey> title;
+        uint titleHash = 0;  // 判断标题是否变化
+        quint32 artist = 0;  // m_names 中的编号
+        quint32 album = 0;
+        quint32 genre = 0;
+        int duration = 0;
+        qint64 modified = 0;
+        int playCount = 0;
+        bool hasTitle = false;
+        bool live = false;
+    };
+
+    struct Spec
+    {
+        QVector<Key> keys;
+        Qt::SortOrder order;
+    };
+
+    struct Job;
+
+    void schedulePending();
+    void applyPending();
+    void startSort(const QVector<int> &unkeyed, const QVector<QString> &titles);
+    void onSortFinished(const std::shared_ptr<Job> &job, const QVector<int> &order, qint64 elapsed);
+    QString fillRow(int id);
+    void releaseRow(int id);
+    quint32 acquireName(const QString &text);
+    void releaseName(quint32 id);
+    void computeNameKey(quint32 id, const QCollator &collator);
+
+    int compareName(quint32 a, quint32 b) const;
+    int compareKey(const Row &a, const Row &b, Key key) const;
+    int compareRows(const Row &a, const Row &b, const Spec &spec) const;
+    static bool isEmptyKey(const Row &row, Key key);
+    QString keyText(int id, Key key) const;
+
+private:
+    MusicLibrary *m_library;  // 不拥有此指针
+    QThreadPool *m_pool;
+
+    std::vector<Row> m_rows;  // 按 TrackStore 的行号存放
+    QVector<int> m_order;     // 排好序的行号
+    Spec m_spec;
+    int m_groupDepth;
+
+    // 名称表，排序期间不增删，后台线程可以直接读取
+    std::vector<Name> m_names;
+    QHash<QString, quint32> m_nameIds;
+    QVector<quint32> m_freeNames;
+
+    // 尚未合并的变化（行号），在事件循环空闲时批量处理
+    QSet<int> m_pendingAdded;
+    QSet<int> m_pendingRemoved;
+    bool m_applyScheduled;
+
+    std::shared_ptr<Job> m_job;
+    double m_lastSortMs;
+};
+
+#endif // LIBRARYVIEW_H
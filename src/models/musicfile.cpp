@@ -4,24 +4,48 @@
 #include <QMediaPlayer>
 #include <QMediaContent>
 #include <QEventLoop>
+#include <QTimer>
 
 MusicFile::MusicFile()
     : m_duration(0)
+    , m_contentHash(0)
+    , m_artHash(0)
+    , m_trackLoudness(qQNaN())
+    , m_trackPeak(0)
+    , m_albumLoudness(qQNaN())
+    , m_albumPeak(0)
+    , m_playCount(0)
+    , m_skipCount(0)
 {
 }
 
 MusicFile::MusicFile(const QString &filePath)
     : m_duration(0)
     , m_filePath(filePath)
+    , m_contentHash(0)
+    , m_artHash(0)
+    , m_trackLoudness(qQNaN())
+    , m_trackPeak(0)
+    , m_albumLoudness(qQNaN())
+    , m_albumPeak(0)
+    , m_playCount(0)
+    , m_skipCount(0)
 {
     QFileInfo fileInfo(filePath);
-    m_fileUrl = QUrl::fromLocalFile(filePath);
     m_lastModified = fileInfo.lastModified();
     m_title = fileInfo.baseName(); // 默认使用文件名作为标题
     loadMetadata();
 }
 
-bool MusicFile::loadMetadata()
+MusicFile MusicFile::placeholder(const QString &filePath)
+{
+    MusicFile file;
+    file.m_filePath = filePath;
+    file.m_title = QFileInfo(filePath).baseName();
+    return file;
+}
+
+bool MusicFile::loadMetadata(int timeoutMs)
 {
     if (m_filePath.isEmpty()) {
         return false;
@@ -29,14 +53,34 @@ bool MusicFile::loadMetadata()
 
     // 创建临时的QMediaPlayer来读取元数据
     QMediaPlayer player;
-    player.setMedia(QMediaContent(m_fileUrl));
+    player.setMedia(QMediaContent(fileUrl()));
 
-    // 等待元数据加载完成
-    QEventLoop loop;
-    QObject::connect(&player, SIGNAL(metaDataChanged()), &loop, SLOT(quit()));
-    loop.exec();
+    // 等待元数据加载完成；损坏的文件可能永远不会发出 metaDataChanged，必须有超时
+    bool ready = isMetadataReady(player);
+    if (!ready && player.mediaStatus() != QMediaPlayer::InvalidMedia) {
+        QEventLoop loop;
+        QTimer deadline;
+        deadline.setSingleShot(true);
+        QObject::connect(&deadline, &QTimer::timeout, &loop, &QEventLoop::quit);
+        auto check = [&]() {
+            ready = isMetadataReady(player);
+            if (ready || player.mediaStatus() == QMediaPlayer::InvalidMedia) {
+                loop.quit();
+            }
+        };
+        QObject::connect(&player, QOverload<>::of(&QMediaPlayer::metaDataChanged), &loop, check);
+        QObject::connect(&player, &QMediaPlayer::durationChanged, &loop, check);
+        QObject::connect(&player, &QMediaPlayer::mediaStatusChanged, &loop, check);
+        deadline.start(timeoutMs);
+        loop.exec();
+    }
 
-    // 读取元数据
+    readMetadata(player);
+    return ready;
+}
+
+void MusicFile::readMetadata(const QMediaPlayer &player)
+{
     if (player.metaData(QMediaMetaData::Title).isValid()) {
         m_title = player.metaData(QMediaMetaData::Title).toString();
     }
@@ -52,6 +96,52 @@ bool MusicFile::loadMetadata()
     if (player.duration() > 0) {
         m_duration = player.duration();
     }
+}
 
-    return true;
-} 
\ No newline at end of file
+bool MusicFile::isMetadataReady(const QMediaPlayer &player)
+{
+    const QMediaPlayer::MediaStatus status = player.mediaStatus();
+    const bool loaded = status == QMediaPlayer::LoadedMedia || status == QMediaPlayer::BufferedMedia;
+    return player.duration() > 0 && (player.isMetaDataAvailable() || loaded);
+}
+
+QDataStream &operator<<(QDataStream &out, const MusicFile &file)
+{
+    out << file.filePath() << file.title() << file.artist() << file.album() << file.genre()
+        << qint32(file.duration()) << file.lastModified() << file.contentHash() << file.artHash()
+        << file.trackLoudness() << file.trackPeak() << file.albumLoudness() << file.albumPeak()
+        << file.dateAdded() << qint32(file.playCount()) << qint32(file.skipCount()) << file.lastPlayed();
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, MusicFile &file)
+{
+    QString filePath, title, artist, album, genre;
+    qint32 duration;
+    QDateTime lastModified;
+    quint64 contentHash, artHash;
+    float trackLoudness, trackPeak, albumLoudness, albumPeak;
+    QDateTime dateAdded, lastPlayed;
+    qint32 playCount, skipCount;
+    in >> filePath >> title >> artist >> album >> genre
+       >> duration >> lastModified >> contentHash >> artHash
+       >> trackLoudness >> trackPeak >> albumLoudness >> albumPeak
+       >> dateAdded >> playCount >> skipCount >> lastPlayed;
+
+    file.setFilePath(filePath);
+    file.setTitle(title);
+    file.setArtist(artist);
+    file.setAlbum(album);
+    file.setGenre(genre);
+    file.setDuration(duration);
+    file.setLastModified(lastModified);
+    file.setContentHash(contentHash);
+    file.setArtHash(artHash);
+    file.setTrackLoudness(trackLoudness, trackPeak);
+    file.setAlbumLoudness(albumLoudness, albumPeak);
+    file.setDateAdded(dateAdded);
+    file.setPlayCount(playCount);
+    file.setSkipCount(skipCount);
+    file.setLastPlayed(lastPlayed);
+    return in;
+}
@@ -4,6 +4,10 @@
 #include <QString>
 #include <QUrl>
 #include <QDateTime>
+#include <QDataStream>
+#include <QtNumeric>
+
+class QMediaPlayer;
 
 class MusicFile
 {
@@ -11,15 +15,34 @@ public:
     MusicFile();
     MusicFile(const QString &filePath);
 
+    // 只记录路径、不探测元数据的占位条目，标题暂用文件名
+    static MusicFile placeholder(const QString &filePath);
+    bool isPlaceholder() const { return !m_lastModified.isValid(); }  // 尚未探测过的条目没有修改时间
+
     // Getters
     QString title() const { return m_title; }
     QString artist() const { return m_artist; }
     QString album() const { return m_album; }
     QString genre() const { return m_genre; }
     int duration() const { return m_duration; }
-    QUrl fileUrl() const { return m_fileUrl; }
+    QUrl fileUrl() const { return QUrl::fromLocalFile(m_filePath); }  // 由路径生成，不单独保存
     QString filePath() const { return m_filePath; }
     QDateTime lastModified() const { return m_lastModified; }
+    quint64 contentHash() const { return m_contentHash; }  // 音频数据哈希，0 表示尚未计算
+    quint64 artHash() const { return m_artHash; }          // 封面图片哈希，0 表示尚未检查
+
+    // 响度分析结果（LUFS / 线性峰值），未分析时为 NaN
+    bool hasLoudness() const { return !qIsNaN(m_trackLoudness); }
+    float trackLoudness() const { return m_trackLoudness; }
+    float trackPeak() const { return m_trackPeak; }
+    float albumLoudness() const { return m_albumLoudness; }
+    float albumPeak() const { return m_albumPeak; }
+
+    // 统计信息：加入音乐库的时间、播放次数、跳过次数和最近播放时间
+    QDateTime dateAdded() const { return m_dateAdded; }
+    int playCount() const { return m_playCount; }
+    int skipCount() const { return m_skipCount; }
+    QDateTime lastPlayed() const { return m_lastPlayed; }
 
     // Setters
     void setTitle(const QString &title) { m_title = title; }
@@ -27,12 +50,25 @@ public:
     void setAlbum(const QString &album) { m_album = album; }
     void setGenre(const QString &genre) { m_genre = genre; }
     void setDuration(int duration) { m_duration = duration; }
-    void setFileUrl(const QUrl &url) { m_fileUrl = url; }
     void setFilePath(const QString &path) { m_filePath = path; }
     void setLastModified(const QDateTime &dt) { m_lastModified = dt; }
+    void setContentHash(quint64 hash) { m_contentHash = hash; }
+    void setArtHash(quint64 hash) { m_artHash = hash; }
+    void setTrackLoudness(float loudness, float peak) { m_trackLoudness = loudness; m_trackPeak = peak; }
+    void setAlbumLoudness(float loudness, float peak) { m_albumLoudness = loudness; m_albumPeak = peak; }
+    void setDateAdded(const QDateTime &dt) { m_dateAdded = dt; }
+    void setPlayCount(int count) { m_playCount = count; }
+    void setSkipCount(int count) { m_skipCount = count; }
+    void setLastPlayed(const QDateTime &dt) { m_lastPlayed = dt; }
+
+    static const int DefaultMetadataTimeout = 3000;  // 毫秒
 
-    // 从文件加载元数��
-    bool loadMetadata();
+    // 从文件加载元数据（同步，最多等待 timeoutMs 毫秒，超时返回 false 并保留已读到的信息）
+    bool loadMetadata(int timeoutMs = DefaultMetadataTimeout);
+    // 从已经设置好媒体的 QMediaPlayer 读取当前可用的元数据
+    void readMetadata(const QMediaPlayer &player);
+    // 时长已知且元数据已可用（没有标签的文件以载入完成为准），可以结束探测
+    static bool isMetadataReady(const QMediaPlayer &player);
 
 private:
     QString m_title;
@@ -40,9 +76,22 @@ private:
     QString m_album;
     QString m_genre;
     int m_duration;
-    QUrl m_fileUrl;
     QString m_filePath;
     QDateTime m_lastModified;
+    quint64 m_contentHash;
+    quint64 m_artHash;
+    float m_trackLoudness;
+    float m_trackPeak;
+    float m_albumLoudness;
+    float m_albumPeak;
+    QDateTime m_dateAdded;
+    int m_playCount;
+    int m_skipCount;
+    QDateTime m_lastPlayed;
 };
 
+// 音乐库缓存的序列化
+QDataStream &operator<<(QDataStream &out, const MusicFile &file);
+QDataStream &operator>>(QDataStream &in, MusicFile &file);
+
 #endif // MUSICFILE_H 
\ No newline at end of file
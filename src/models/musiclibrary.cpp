@@ -0,0 +1,285 @@
+#include "musiclibrary.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+const quint32 CacheMagic = 0x59594c42;  // "YYLB"
+const quint32 CacheVersion = 4;
+}
+
+MusicLibrary::MusicLibrary(QObject *parent)
+    : QObject(parent)
+{
+}
+
+bool MusicLibrary::contains(const QString &filePath) const
+{
+    return m_store.find(filePath) >= 0;
+}
+
+MusicFile MusicLibrary::file(const QString &filePath) const
+{
+    return m_store.file(m_store.find(filePath));
+}
+
+void MusicLibrary::insert(const MusicFile &file)
+{
+    const QString filePath = file.filePath();
+    const int existing = m_store.find(filePath);
+    bool existed = existing >= 0;
+    MusicFile entry = file;
+    if (existed) {
+        // 重新探测的文件保留原有的统计信息
+        if (!entry.dateAdded().isValid()) {
+            const MusicFile old = m_store.file(existing);
+            entry.setDateAdded(old.dateAdded());
+            entry.setPlayCount(old.playCount());
+            entry.setSkipCount(old.skipCount());
+            entry.setLastPlayed(old.lastPlayed());
+        }
+    } else if (!entry.dateAdded().isValid()) {
+        entry.setDateAdded(QDateTime::currentDateTime());
+    }
+
+    const int row = m_store.insert(entry);
+    if (existed) {
+        emit fileUpdated(filePath, row);
+    } else {
+        emit fileAdded(filePath, row);
+    }
+}
+
+void MusicLibrary::remove(const QString &filePath)
+{
+    const int row = m_store.find(filePath);
+    if (row < 0) {
+        return;
+    }
+    m_store.remove(row);
+    emit fileRemoved(filePath, row);
+}
+
+void MusicLibrary::clear()
+{
+    QVector<QPair<QString, int>> removed;
+    removed.reserve(m_store.size());
+    for (int row = 0; row < m_store.rowCount(); ++row) {
+        if (m_store.isLive(row)) {
+            removed.append(qMakePair(m_store.filePath(row), row));
+        }
+    }
+    m_store.clear();
+    for (const auto &entry : qAsConst(removed)) {
+        emit fileRemoved(entry.first, entry.second);
+    }
+}
+
+int MusicLibrary::count() const
+{
+    return m_store.size();
+}
+
+QStringList MusicLibrary::filePaths() const
+{
+    QStringList paths;
+    paths.reserve(m_store.size());
+    for (int row = 0; row < m_store.rowCount(); ++row) {
+        if (m_store.isLive(row)) {
+            paths.append(m_store.filePath(row));
+        }
+    }
+    return paths;
+}
+
+quint64 MusicLibrary::contentHash(const QString &filePath) const
+{
+    const int row = m_store.find(filePath);
+    return row >= 0 ? m_store.contentHash(row) : 0;
+}
+
+void MusicLibrary::setContentHash(const QString &filePath, quint64 hash)
+{
+    const int row = m_store.find(filePath);
+    if (row < 0 || m_store.contentHash(row) == hash) {
+        return;
+    }
+
+    m_store.setContentHash(row, hash);
+    emit fileUpdated(filePath, row);
+}
+
+QStringList MusicLibrary::filesWithoutHash() const
+{
+    QStringList paths;
+    for (int row = 0; row < m_store.rowCount(); ++row) {
+        if (m_store.isLive(row) && m_store.contentHash(row) == 0) {
+            paths.append(m_store.filePath(row));
+        }
+    }
+    return paths;
+}
+
+QList<QStringList> MusicLibrary::duplicateGroups() const
+{
+    QList<QStringList> groups;
+    for (int row = 0; row < m_store.rowCount(); ++row) {
+        if (!m_store.isLive(row) || m_store.contentHash(row) == 0) {
+            continue;
+        }
+        // 每组只在行号最小的成员处收集一次
+        const QVector<int> rows = m_store.rowsWithContentHash(m_store.contentHash(row));
+        if (rows.size() < 2 || rows.first() != row) {
+            continue;
+        }
+        QStringList paths;
+        for (int member : rows) {
+            paths.append(m_store.filePath(member));
+        }
+        // 组内按路径排序，保证每次得到的“原始文件”一致
+        std::sort(paths.begin(), paths.end());
+        groups.append(paths);
+    }
+    return groups;
+}
+
+QStringList MusicLibrary::duplicatesOf(const QString &filePath) const
+{
+    const int row = m_store.find(filePath);
+    if (row < 0) {
+        return QStringList();
+    }
+
+    QStringList paths;
+    const QVector<int> rows = m_store.rowsWithContentHash(m_store.contentHash(row));
+    for (int member : rows) {
+        if (member != row) {
+            paths.append(m_store.filePath(member));
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+void MusicLibrary::setTrackLoudness(const QString &filePath, float loudness, float peak)
+{
+    const int row = m_store.find(filePath);
+    if (row < 0) {
+        return;
+    }
+    m_store.setTrackLoudness(row, loudness, peak);
+    emit fileUpdated(filePath, row);
+}
+
+void MusicLibrary::setAlbumLoudness(const QString &filePath, float loudness, float peak)
+{
+    const int row = m_store.find(filePath);
+    if (row < 0) {
+        return;
+    }
+    m_store.setAlbumLoudness(row, loudness, peak);
+    emit fileUpdated(filePath, row);
+}
+
+QStringList MusicLibrary::filesWithoutLoudness() const
+{
+    QStringList paths;
+    for (int row = 0; row < m_store.rowCount(); ++row) {
+        if (m_store.isLive(row) && !m_store.hasLoudness(row)) {
+            paths.append(m_store.filePath(row));
+        }
+    }
+    return paths;
+}
+
+void MusicLibrary::setArtHash(const QString &filePath, quint64 hash)
+{
+    const int row = m_store.find(filePath);
+    if (row < 0 || m_store.artHash(row) == hash) {
+        return;
+    }
+    m_store.setArtHash(row, hash);
+    emit fileUpdated(filePath, row);
+}
+
+QStringList MusicLibrary::filesWithoutArt() const
+{
+    QStringList paths;
+    for (int row = 0; row < m_store.rowCount(); ++row) {
+        if (m_store.isLive(row) && m_store.artHash(row) == 0) {
+            paths.append(m_store.filePath(row));
+        }
+    }
+    return paths;
+}
+
+void MusicLibrary::setPlayStats(const QString &filePath, int playCount, int skipCount, const QDateTime &lastPlayed)
+{
+    const int row = m_store.find(filePath);
+    if (row < 0) {
+        return;
+    }
+    if (m_store.setPlayStats(row, playCount, skipCount, lastPlayed)) {
+        emit fileUpdated(filePath, row);
+    }
+}
+
+qint64 MusicLibrary::memoryUsage() const
+{
+    return m_store.bytesUsed();
+}
+
+bool MusicLibrary::save(const QString &cachePath) const
+{
+    QSaveFile file(cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "无法写入音乐库缓存:" << cachePath << file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << CacheMagic << CacheVersion << qint32(m_store.size());
+    for (int row = 0; row < m_store.rowCount(); ++row) {
+        if (m_store.isLive(row)) {
+            out << m_store.file(row);
+        }
+    }
+    return file.commit();
+}
+
+bool MusicLibrary::load(const QString &cachePath)
+{
+    QFile file(cachePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != CacheMagic || version != CacheVersion || count < 0) {
+        qDebug() << "音乐库缓存版本不匹配，忽略:" << cachePath;
+        return false;
+    }
+
+    // 条数来自文件，预留空间时设上限，防止损坏的缓存申请过多内存
+    m_store.reserve(m_store.size() + qMin(count, 1 << 22));
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        MusicFile musicFile;
+        in >> musicFile;
+        if (in.status() == QDataStream::Ok) {
+            insert(musicFile);
+        }
+    }
+    if (m_store.size() > 0) {
+        qDebug() << "音乐库载入" << m_store.size() << "首，内存约"
+                 << memoryUsage() / m_store.size() << "字节/首";
+    }
+    return in.status() == QDataStream::Ok;
+}
@@ -0,0 +1,64 @@
+#ifndef MUSICLIBRARY_H
+#define MUSICLIBRARY_H
+
+#include <QObject>
+#include <QStringList>
+#include "musicfile.h"
+#include "trackstore.h"
+
+// 音乐库：以文件路径为键保存所有已扫描的歌曲
+// 歌曲按列存放在 TrackStore 中，file() 按需组装 MusicFile；
+// 界面和索引模块通过 tracks() 按行读取字段，以信号中的行号标识歌曲，不另存标签文字
+class MusicLibrary : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MusicLibrary(QObject *parent = nullptr);
+
+    // 基本操作
+    bool contains(const QString &filePath) const;
+    MusicFile file(const QString &filePath) const;
+    void insert(const MusicFile &file);
+    void remove(const QString &filePath);
+    void clear();
+    int count() const;
+    QStringList filePaths() const;
+    const TrackStore &tracks() const { return m_store; }
+
+    // 内容哈希与重复检测
+    quint64 contentHash(const QString &filePath) const;
+    void setContentHash(const QString &filePath, quint64 hash);
+    QStringList filesWithoutHash() const;
+    QList<QStringList> duplicateGroups() const;
+    QStringList duplicatesOf(const QString &filePath) const;  // 与该文件内容相同的其他文件
+
+    // 响度分析结果
+    void setTrackLoudness(const QString &filePath, float loudness, float peak);
+    void setAlbumLoudness(const QString &filePath, float loudness, float peak);
+    QStringList filesWithoutLoudness() const;
+
+    // 专辑封面（缩略图保存在 AlbumArtCache 中，这里只记录封面哈希）
+    void setArtHash(const QString &filePath, quint64 hash);
+    QStringList filesWithoutArt() const;
+
+    // 播放统计（由 PlayStatsLog 汇总后写入）
+    void setPlayStats(const QString &filePath, int playCount, int skipCount, const QDateTime &lastPlayed);
+
+    // 内存占用（字节），不含界面和索引模块
+    qint64 memoryUsage() const;
+
+    // 持久化：保存已扫描的元数据和分析结果，下次启动无需重新探测
+    bool save(const QString &cachePath) const;
+    bool load(const QString &cachePath);
+
+signals:
+    // track 为歌曲在 tracks() 中的行号；fileRemoved 发出时该行已删除，之后可能被新加入的歌曲复用
+    void fileAdded(const QString &filePath, int track);
+    void fileRemoved(const QString &filePath, int track);
+    void fileUpdated(const QString &filePath, int track);
+
+private:
+    TrackStore m_store;
+};
+
+#endif // MUSICLIBRARY_H
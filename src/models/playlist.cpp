@@ -1,5 +1,6 @@
 #include "playlist.h"
 #include <QRandomGenerator>
+#include <algorithm>
 
 Playlist::Playlist(QObject *parent)
     : QObject(parent)
@@ -18,33 +19,165 @@ Playlist::Playlist(const QString &name, QObject *parent)
 
 void Playlist::addFile(const MusicFile &file)
 {
-    m_files.append(file);
+    insertFiles(m_files.size(), QList<MusicFile>() << file);
+}
+
+void Playlist::addFiles(const QList<MusicFile> &files)
+{
+    insertFiles(m_files.size(), files);
+}
+
+void Playlist::setFiles(const QList<MusicFile> &files)
+{
+    m_files.assign(files);
+    m_snapshot = files;
+    m_randomQueue.clear();
+    m_pathCounts.clear();
+    m_pathCounts.reserve(files.size());
+    for (const MusicFile &file : files) {
+        retainPath(file.filePath());
+    }
+    m_currentIndex = -1;
+    emit currentIndexChanged(m_currentIndex);
     emit playlistChanged();
 }
 
 void Playlist::removeFile(int index)
 {
-    if (index >= 0 && index < m_files.size()) {
-        m_files.removeAt(index);
-        if (index == m_currentIndex) {
+    removeIndices(QList<int>() << index);
+}
+
+void Playlist::clear()
+{
+    m_files.clear();
+    m_snapshot.reset();
+    m_randomQueue.clear();
+    m_pathCounts.clear();
+    m_currentIndex = -1;
+    emit currentIndexChanged(m_currentIndex);
+    emit playlistChanged();
+}
+
+void Playlist::insertFiles(int index, const QList<MusicFile> &files)
+{
+    if (files.isEmpty()) {
+        return;
+    }
+    index = qBound(0, index, m_files.size());
+    m_files.insert(index, files);
+    m_snapshot.reset();
+    m_randomQueue.clear();
+    for (const MusicFile &file : files) {
+        retainPath(file.filePath());
+    }
+
+    if (m_currentIndex >= index) {
+        m_currentIndex += files.size();
+        emit currentIndexChanged(m_currentIndex);
+    }
+    emit filesInserted(index, files.size());
+    emit playlistChanged();
+}
+
+void Playlist::removeIndices(const QList<int> &indices)
+{
+    QVector<int> rows;
+    rows.reserve(indices.size());
+    for (int index : indices) {
+        if (index >= 0 && index < m_files.size()) {
+            rows.append(index);
+        }
+    }
+    if (rows.isEmpty()) {
+        return;
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    // 合并成连续区间，从后往前整段删除，每段 O(log n)
+    RangeList ranges;
+    for (int row : rows) {
+        if (!ranges.isEmpty() && ranges.last().first + ranges.last().second == row) {
+            ++ranges.last().second;
+        } else {
+            ranges.append(qMakePair(row, 1));
+        }
+    }
+    for (int i = ranges.size() - 1; i >= 0; --i) {
+        const QList<MusicFile> removed = m_files.take(ranges.at(i).first, ranges.at(i).second);
+        for (const MusicFile &file : removed) {
+            releasePath(file.filePath());
+        }
+    }
+    m_snapshot.reset();
+    m_randomQueue.clear();
+
+    if (m_currentIndex >= 0) {
+        auto it = std::lower_bound(rows.constBegin(), rows.constEnd(), m_currentIndex);
+        if (it != rows.constEnd() && *it == m_currentIndex) {
             m_currentIndex = -1;
             emit currentIndexChanged(m_currentIndex);
-        } else if (index < m_currentIndex) {
-            m_currentIndex--;
+        } else if (it != rows.constBegin()) {
+            m_currentIndex -= int(it - rows.constBegin());
             emit currentIndexChanged(m_currentIndex);
         }
-        emit playlistChanged();
     }
+    emit filesRemoved(ranges);
+    emit playlistChanged();
 }
 
-void Playlist::clear()
+void Playlist::move(int first, int count, int destination)
 {
-    m_files.clear();
-    m_currentIndex = -1;
-    emit currentIndexChanged(m_currentIndex);
+    if (first < 0 || count <= 0 || first + count > m_files.size()
+        || destination < 0 || destination > m_files.size() - count || destination == first) {
+        return;
+    }
+
+    m_files.move(first, count, destination);
+    m_snapshot.reset();
+    m_randomQueue.clear();
+
+    // 当前歌曲跟随移动
+    int current = m_currentIndex;
+    if (current >= first && current < first + count) {
+        current = destination + (current - first);
+    } else if (destination < first && current >= destination && current < first) {
+        current += count;
+    } else if (destination > first && current >= first + count && current < destination + count) {
+        current -= count;
+    }
+    if (current != m_currentIndex) {
+        m_currentIndex = current;
+        emit currentIndexChanged(m_currentIndex);
+    }
+    emit filesMoved(first, count, destination);
     emit playlistChanged();
 }
 
+bool Playlist::contains(const QString &filePath) const
+{
+    return m_pathCounts.contains(filePath);
+}
+
+QList<int> Playlist::updateFiles(const QHash<QString, MusicFile> &files)
+{
+    QList<int> rows;
+    if (files.isEmpty()) {
+        return rows;
+    }
+    m_files.forEach([&](int index, MusicFile &file) {
+        auto it = files.constFind(file.filePath());
+        if (it != files.constEnd()) {
+            file = it.value();
+            rows.append(index);
+        }
+    });
+    if (!rows.isEmpty()) {
+        m_snapshot.reset();
+    }
+    return rows;
+}
+
 int Playlist::nextIndex() const
 {
     if (m_files.isEmpty()) {
@@ -55,7 +188,7 @@ int Playlist::nextIndex() const
     case Sequential:
         return (m_currentIndex + 1) % m_files.size();
     case Random:
-        return QRandomGenerator::global()->bounded(m_files.size());
+        return upcomingIndices(1).value(0, -1);
     case RepeatOne:
         return m_currentIndex;
     case RepeatAll:
@@ -65,6 +198,40 @@ int Playlist::nextIndex() const
     return -1;
 }
 
+QList<int> Playlist::upcomingIndices(int count) const
+{
+    QList<int> indices;
+    const int size = m_files.size();
+    if (size == 0 || count <= 0) {
+        return indices;
+    }
+
+    switch (m_playMode) {
+    case Sequential:
+        for (int i = m_currentIndex + 1; i < size && indices.size() < count; ++i) {
+            indices.append(i);
+        }
+        break;
+    case Random:
+        while (m_randomQueue.size() < count) {
+            m_randomQueue.append(QRandomGenerator::global()->bounded(size));
+        }
+        indices = m_randomQueue.mid(0, count).toList();
+        break;
+    case RepeatOne:
+        if (m_currentIndex >= 0) {
+            indices.append(m_currentIndex);
+        }
+        break;
+    case RepeatAll:
+        for (int i = 1; i <= size && indices.size() < count; ++i) {
+            indices.append((m_currentIndex + i) % size);
+        }
+        break;
+    }
+    return indices;
+}
+
 int Playlist::previousIndex() const
 {
     if (m_files.isEmpty()) {
@@ -91,7 +258,15 @@ int Playlist::currentIndex() const
 
 void Playlist::setCurrentIndex(int index)
 {
-    if (index != m_currentIndex && index >= -1 && index < m_files.size()) {
+    if (index < -1 || index >= m_files.size()) {
+        return;
+    }
+    // 播放了预先抽取的歌曲时，丢弃它及之前被跳过的部分（随机抽到当前歌曲时也要丢弃）
+    const int queued = m_randomQueue.indexOf(index);
+    if (queued >= 0) {
+        m_randomQueue.remove(0, queued + 1);
+    }
+    if (index != m_currentIndex) {
         m_currentIndex = index;
         emit currentIndexChanged(index);
     }
@@ -106,6 +281,7 @@ void Playlist::setPlayMode(PlayMode mode)
 {
     if (m_playMode != mode) {
         m_playMode = mode;
+        m_randomQueue.clear();
         emit playModeChanged(mode);
     }
 }
@@ -132,5 +308,22 @@ MusicFile Playlist::at(int index) const
 
 QList<MusicFile> Playlist::files() const
 {
-    return m_files;
-} 
\ No newline at end of file
+    // 未修改时返回同一份快照，与 PlaylistManager 中的副本共享数据
+    if (!m_snapshot) {
+        m_snapshot = m_files.toList();
+    }
+    return *m_snapshot;
+}
+
+void Playlist::retainPath(const QString &filePath)
+{
+    ++m_pathCounts[filePath];
+}
+
+void Playlist::releasePath(const QString &filePath)
+{
+    auto it = m_pathCounts.find(filePath);
+    if (it != m_pathCounts.end() && --it.value() == 0) {
+        m_pathCounts.erase(it);
+    }
+}
@@ -3,8 +3,13 @@
 
 #include <QObject>
 #include <QList>
+#include <QHash>
+#include <QVector>
+#include <QPair>
 #include <QString>
+#include <optional>
 #include "musicfile.h"
+#include "tracksequence.h"
 
 class Playlist : public QObject
 {
@@ -20,14 +25,32 @@ public:
     explicit Playlist(QObject *parent = nullptr);
     explicit Playlist(const QString &name, QObject *parent = nullptr);
 
+    // (起始行, 行数)
+    using RangeList = QVector<QPair<int, int>>;
+
     // 基本操作
     void addFile(const MusicFile &file);
+    void addFiles(const QList<MusicFile> &files);
+    void setFiles(const QList<MusicFile> &files);  // 整体替换，与传入的列表共享数据
     void removeFile(int index);
     void clear();
+
+    // 批量操作：一次遍历完成，只发出一次范围通知和一次 playlistChanged
+    void insertFiles(int index, const QList<MusicFile> &files);
+    void removeIndices(const QList<int> &indices);
+    // 把 [first, first + count) 移动到新位置，destination 是移动后第一行的行号
+    void move(int first, int count, int destination);
+    bool contains(const QString &filePath) const;
+    // 用新探测到的元数据替换同路径的条目，返回被更新的行号
+    QList<int> updateFiles(const QHash<QString, MusicFile> &files);
     
     // 播放控制
     int nextIndex() const;
     int previousIndex() const;
+    // 接下来自动播放的最多 count 首歌的行号。顺序模式下到列表末尾为止，当前是最后一首时为空
+    // （自动播放到此停止）；nextIndex() 供手动切换下一首，会回到第一首。其他模式下第一个与 nextIndex() 一致
+    // 随机模式下预先抽取，之后的 nextIndex() 按同样的顺序返回
+    QList<int> upcomingIndices(int count) const;
     int currentIndex() const;
     void setCurrentIndex(int index);
     
@@ -46,12 +69,22 @@ signals:
     void currentIndexChanged(int index);
     void playModeChanged(PlayMode mode);
     void playlistChanged();
+    void filesInserted(int first, int count);
+    void filesRemoved(const Playlist::RangeList &ranges);  // 按起始行升序，使用删除前的行号
+    void filesMoved(int first, int count, int destination);
+
+private:
+    void retainPath(const QString &filePath);
+    void releasePath(const QString &filePath);
 
 private:
     QString m_name;
-    QList<MusicFile> m_files;
+    TrackSequence m_files;  // 任意位置增删、移动为 O(log n)
+    mutable std::optional<QList<MusicFile>> m_snapshot;  // files() 的缓存，修改后失效
+    QHash<QString, int> m_pathCounts;  // 路径 → 出现次数，用于快速去重
     int m_currentIndex;
     PlayMode m_playMode;
+    mutable QVector<int> m_randomQueue;  // 随机模式下预先抽取的后续行号，列表修改后失效
 };
 
 #endif // PLAYLIST_H 
\ No newline at end of file
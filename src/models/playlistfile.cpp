@@ -0,0 +1,321 @@
+#include "playlistfile.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QUrl>
+#include <QTextStream>
+#include <QTextCodec>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <QObject>
+#include <QDebug>
+
+namespace {
+
+// "艺术家 - 标题" 形式的显示文本拆开
+void splitDisplayText(const QString &text, PlaylistEntry *entry)
+{
+    const int separator = text.indexOf(QLatin1String(" - "));
+    if (separator > 0) {
+        entry->artist = text.left(separator).trimmed();
+        entry->title = text.mid(separator + 3).trimmed();
+    } else {
+        entry->title = text.trimmed();
+    }
+}
+
+QString displayText(const MusicFile &file)
+{
+    if (file.artist().isEmpty()) {
+        return file.title();
+    }
+    return file.artist() + " - " + file.title();
+}
+
+// 时长以秒为单位写入，未知时写 -1
+int durationSeconds(const MusicFile &file)
+{
+    return file.duration() > 0 ? (file.duration() + 500) / 1000 : -1;
+}
+
+} // namespace
+
+PlaylistFile::Format PlaylistFile::formatForPath(const QString &path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix == "m3u" || suffix == "m3u8") {
+        return M3U;
+    }
+    if (suffix == "pls") {
+        return PLS;
+    }
+    if (suffix == "xspf") {
+        return XSPF;
+    }
+    return Unknown;
+}
+
+QString PlaylistFile::nameFilter()
+{
+    return QObject::tr("播放列表 (*.m3u8 *.m3u *.pls *.xspf)");
+}
+
+bool PlaylistFile::read(const QString &path, const EntryHandler &handler, QString *error)
+{
+    const Format format = formatForPath(path);
+    if (format == Unknown) {
+        if (error) {
+            *error = QObject::tr("不支持的播放列表格式");
+        }
+        return false;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    const QString baseDir = QFileInfo(path).absolutePath();
+    switch (format) {
+    case M3U:
+        return readM3U(&file, baseDir, path.endsWith("8"), handler);
+    case PLS:
+        return readPLS(&file, baseDir, handler);
+    case XSPF:
+        return readXSPF(&file, baseDir, handler, error);
+    case Unknown:
+        break;
+    }
+    return false;
+}
+
+bool PlaylistFile::readM3U(QIODevice *device, const QString &baseDir, bool utf8, const EntryHandler &handler)
+{
+    QTextStream in(device);
+    in.setCodec(utf8 ? QTextCodec::codecForName("UTF-8") : QTextCodec::codecForLocale());
+
+    // #EXTINF 的信息属于紧随其后的路径行
+    PlaylistEntry entry;
+    QString line;
+    while (in.readLineInto(&line)) {
+        const QString trimmed = line.trimmed();
+        if (trimmed.isEmpty()) {
+            continue;
+        }
+        if (trimmed.startsWith('#')) {
+            if (trimmed.startsWith(QLatin1String("#EXTINF:"))) {
+                const int comma = trimmed.indexOf(',');
+                const int seconds = trimmed.mid(8, comma < 0 ? -1 : comma - 8).toInt();
+                entry.duration = seconds > 0 ? seconds * 1000 : 0;
+                if (comma >= 0) {
+                    splitDisplayText(trimmed.mid(comma + 1), &entry);
+                }
+            }
+            continue;
+        }
+
+        entry.filePath = resolvePath(trimmed, baseDir);
+        if (!entry.filePath.isEmpty()) {
+            handler(entry);
+        }
+        entry = PlaylistEntry();
+    }
+    return true;
+}
+
+bool PlaylistFile::readPLS(QIODevice *device, const QString &baseDir, const EntryHandler &handler)
+{
+    QTextStream in(device);
+    in.setCodec("UTF-8");
+
+    // FileN / TitleN / LengthN 一般连续出现，编号变化时输出上一条
+    PlaylistEntry entry;
+    int current = -1;
+    auto flush = [&]() {
+        if (!entry.filePath.isEmpty()) {
+            handler(entry);
+        }
+        entry = PlaylistEntry();
+    };
+
+    QString line;
+    while (in.readLineInto(&line)) {
+        const int equals = line.indexOf('=');
+        if (equals <= 0) {
+            continue;
+        }
+        const QString key = line.left(equals).trimmed().toLower();
+        const QString value = line.mid(equals + 1).trimmed();
+
+        int digits = key.size();
+        while (digits > 0 && key.at(digits - 1).isDigit()) {
+            --digits;
+        }
+        if (digits == key.size()) {
+            continue;  // [playlist]、NumberOfEntries、Version 等
+        }
+        const int number = key.midRef(digits).toInt();
+        const QStringRef name = key.leftRef(digits);
+        if (number != current) {
+            flush();
+            current = number;
+        }
+
+        if (name == QLatin1String("file")) {
+            entry.filePath = resolvePath(value, baseDir);
+        } else if (name == QLatin1String("title")) {
+            splitDisplayText(value, &entry);
+        } else if (name == QLatin1String("length")) {
+            const int seconds = value.toInt();
+            entry.duration = seconds > 0 ? seconds * 1000 : 0;
+        }
+    }
+    flush();
+    return true;
+}
+
+bool PlaylistFile::readXSPF(QIODevice *device, const QString &baseDir, const EntryHandler &handler, QString *error)
+{
+    QXmlStreamReader xml(device);
+    PlaylistEntry entry;
+    bool inTrack = false;
+
+    while (!xml.atEnd()) {
+        xml.readNext();
+        if (xml.isStartElement()) {
+            const QStringRef name = xml.name();
+            if (name == QLatin1String("track")) {
+                inTrack = true;
+                entry = PlaylistEntry();
+            } else if (inTrack && name == QLatin1String("location")) {
+                if (entry.filePath.isEmpty()) {
+                    entry.filePath = resolvePath(xml.readElementText(), baseDir, true);
+                }
+            } else if (inTrack && name == QLatin1String("title")) {
+                entry.title = xml.readElementText().trimmed();
+            } else if (inTrack && name == QLatin1String("creator")) {
+                entry.artist = xml.readElementText().trimmed();
+            } else if (inTrack && name == QLatin1String("duration")) {
+                entry.duration = qMax(0, xml.readElementText().toInt());
+            }
+        } else if (xml.isEndElement() && xml.name() == QLatin1String("track")) {
+            inTrack = false;
+            if (!entry.filePath.isEmpty()) {
+                handler(entry);
+            }
+        }
+    }
+
+    if (xml.hasError()) {
+        qDebug() << "XSPF 解析错误:" << xml.errorString() << "行" << xml.lineNumber();
+        if (error) {
+            *error = xml.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+QString PlaylistFile::resolvePath(const QString &location, const QString &baseDir, bool uri)
+{
+    const QString trimmed = location.trimmed();
+    if (trimmed.isEmpty()) {
+        return QString();
+    }
+
+    if (trimmed.startsWith(QLatin1String("file:"), Qt::CaseInsensitive)) {
+        return QDir::cleanPath(QUrl(trimmed).toLocalFile());
+    }
+    if (trimmed.contains(QLatin1String("://"))) {
+        return QString();  // 网络地址不支持
+    }
+
+    // XSPF 的相对地址是百分号编码的 URI；M3U/PLS 中是普通路径，文件名本身可能含有 %
+    const QString path = QDir::fromNativeSeparators(uri ? QUrl::fromPercentEncoding(trimmed.toUtf8()) : trimmed);
+    return QDir::cleanPath(QDir(baseDir).absoluteFilePath(path));
+}
+
+bool PlaylistFile::write(const QString &path, const QList<MusicFile> &files, QString *error)
+{
+    const Format format = formatForPath(path);
+    if (format == Unknown) {
+        if (error) {
+            *error = QObject::tr("不支持的播放列表格式");
+        }
+        return false;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    if (format == XSPF) {
+        QXmlStreamWriter xml(&file);
+        xml.setAutoFormatting(true);
+        xml.writeStartDocument();
+        xml.writeStartElement("playlist");
+        xml.writeDefaultNamespace("http://xspf.org/ns/0/");
+        xml.writeAttribute("version", "1");
+        xml.writeStartElement("trackList");
+        for (const MusicFile &musicFile : files) {
+            xml.writeStartElement("track");
+            xml.writeTextElement("location", QUrl::fromLocalFile(musicFile.filePath()).toString(QUrl::FullyEncoded));
+            xml.writeTextElement("title", musicFile.title());
+            if (!musicFile.artist().isEmpty()) {
+                xml.writeTextElement("creator", musicFile.artist());
+            }
+            if (!musicFile.album().isEmpty()) {
+                xml.writeTextElement("album", musicFile.album());
+            }
+            if (musicFile.duration() > 0) {
+                xml.writeTextElement("duration", QString::number(musicFile.duration()));
+            }
+            xml.writeEndElement();
+        }
+        xml.writeEndElement();
+        xml.writeEndElement();
+        xml.writeEndDocument();
+    } else {
+        QTextStream out(&file);
+        if (format == PLS || path.endsWith("8")) {
+            out.setCodec("UTF-8");
+        } else {
+            out.setCodec(QTextCodec::codecForLocale());
+        }
+
+        if (format == M3U) {
+            out << "#EXTM3U\n";
+            for (const MusicFile &musicFile : files) {
+                out << "#EXTINF:" << durationSeconds(musicFile) << ',' << displayText(musicFile) << '\n'
+                    << QDir::toNativeSeparators(musicFile.filePath()) << '\n';
+            }
+        } else {
+            out << "[playlist]\n";
+            for (int i = 0; i < files.size(); ++i) {
+                const MusicFile &musicFile = files.at(i);
+                out << "File" << i + 1 << '=' << QDir::toNativeSeparators(musicFile.filePath()) << '\n'
+                    << "Title" << i + 1 << '=' << displayText(musicFile) << '\n'
+                    << "Length" << i + 1 << '=' << durationSeconds(musicFile) << '\n';
+            }
+            out << "NumberOfEntries=" << files.size() << '\n'
+                << "Version=2\n";
+        }
+        out.flush();
+    }
+
+    if (!file.commit()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef PLAYLISTFILE_H
+#define PLAYLISTFILE_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <functional>
+#include "musicfile.h"
+
+class QIODevice;
+
+// 播放列表文件中的一条记录，标题、艺术家和时长是文件里自带的提示信息，可能为空
+struct PlaylistEntry
+{
+    QString filePath;
+    QString title;
+    QString artist;
+    int duration = 0;  // 毫秒
+};
+
+// M3U / M3U8 / PLS / XSPF 播放列表的读写
+// 读取时逐条解析并回调，不探测音频文件，内存占用与文件大小无关
+class PlaylistFile
+{
+public:
+    enum Format {
+        Unknown,
+        M3U,
+        PLS,
+        XSPF
+    };
+
+    using EntryHandler = std::function<void(const PlaylistEntry &entry)>;
+
+    static Format formatForPath(const QString &path);
+    static QString nameFilter();  // 用于文件对话框
+
+    static bool read(const QString &path, const EntryHandler &handler, QString *error = nullptr);
+    static bool write(const QString &path, const QList<MusicFile> &files, QString *error = nullptr);
+
+private:
+    static bool readM3U(QIODevice *device, const QString &baseDir, bool utf8, const EntryHandler &handler);
+    static bool readPLS(QIODevice *device, const QString &baseDir, const EntryHandler &handler);
+    static bool readXSPF(QIODevice *device, const QString &baseDir, const EntryHandler &handler, QString *error);
+    // file:// 地址总是解码；uri 为 true 时（XSPF 的 location）相对地址也按百分号编码解码
+    static QString resolvePath(const QString &location, const QString &baseDir, bool uri = false);
+};
+
+#endif // PLAYLISTFILE_H
@@ -0,0 +1,268 @@
+#include "playlistmanager.h"
+#include "playlistfile.h"
+#include "musiclibrary.h"
+#include <QSettings>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QDebug>
+
+PlaylistManager::PlaylistManager(MusicLibrary *library, QObject *parent)
+    : QObject(parent)
+    , m_library(library)
+{
+    m_directory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/playlists";
+    QDir().mkpath(m_directory);
+}
+
+QStringList PlaylistManager::names() const
+{
+    QStringList result;
+    for (const Entry &entry : m_entries) {
+        result.append(entry.name);
+    }
+    return result;
+}
+
+bool PlaylistManager::contains(const QString &name) const
+{
+    return indexOf(name) >= 0;
+}
+
+int PlaylistManager::count(const QString &name) const
+{
+    int index = indexOf(name);
+    return index >= 0 ? m_entries.at(index).count : 0;
+}
+
+bool PlaylistManager::isLoaded(const QString &name) const
+{
+    int index = indexOf(name);
+    return index >= 0 && m_entries.at(index).files.has_value();
+}
+
+int PlaylistManager::loadedCount() const
+{
+    int loaded = 0;
+    for (const Entry &entry : m_entries) {
+        if (entry.files) {
+            ++loaded;
+        }
+    }
+    return loaded;
+}
+
+QList<MusicFile> PlaylistManager::files(const QString &name, QStringList *placeholders)
+{
+    int index = indexOf(name);
+    if (index < 0) {
+        return QList<MusicFile>();
+    }
+
+    Entry &entry = m_entries[index];
+    if (!entry.files) {
+        // 从磁盘载入：音乐库中已有的文件直接使用已探测的元数据，其余建立占位条目
+        QList<MusicFile> files;
+        QString error;
+        bool ok = PlaylistFile::read(filePath(entry), [this, &files](const PlaylistEntry &item) {
+            if (m_library->contains(item.filePath)) {
+                files.append(m_library->file(item.filePath));
+                return;
+            }
+            MusicFile file = MusicFile::placeholder(item.filePath);
+            if (!item.title.isEmpty()) {
+                file.setTitle(item.title);
+            }
+            file.setArtist(item.artist);
+            file.setDuration(item.duration);
+            files.append(file);
+        }, &error);
+        if (!ok) {
+            qDebug() << "无法载入播放列表:" << entry.name << error;
+        }
+        entry.files = files;
+        entry.count = files.size();
+    }
+
+    if (placeholders) {
+        for (const MusicFile &file : *entry.files) {
+            if (file.isPlaceholder()) {
+                placeholders->append(file.filePath());
+            }
+        }
+    }
+    return *entry.files;
+}
+
+void PlaylistManager::setFiles(const QString &name, const QList<MusicFile> &files)
+{
+    int index = indexOf(name);
+    bool created = index < 0;
+    if (created) {
+        Entry entry;
+        entry.name = name;
+        entry.fileName = newFileName();
+        m_entries.append(entry);
+        index = m_entries.size() - 1;
+    }
+
+    Entry &entry = m_entries[index];
+    if (entry.files && entry.files->isSharedWith(files)) {
+        return;  // 内容没有变化
+    }
+    entry.files = files;  // 隐式共享，不复制歌曲数据
+    entry.count = files.size();
+    entry.dirty = true;
+
+    if (created) {
+        emit playlistsChanged();
+    }
+}
+
+bool PlaylistManager::duplicate(const QString &source, const QString &name)
+{
+    if (!contains(source) || contains(name) || name.isEmpty()) {
+        return false;
+    }
+    setFiles(name, files(source));
+    return true;
+}
+
+bool PlaylistManager::rename(const QString &oldName, const QString &newName)
+{
+    int index = indexOf(oldName);
+    if (index < 0 || newName.isEmpty() || contains(newName)) {
+        return false;
+    }
+
+    // 文件名与播放列表名无关，只需更新索引
+    m_entries[index].name = newName;
+    if (m_active == oldName) {
+        m_active = newName;
+    }
+    emit playlistsChanged();
+    return true;
+}
+
+void PlaylistManager::remove(const QString &name)
+{
+    int index = indexOf(name);
+    if (index < 0) {
+        return;
+    }
+
+    m_removedFiles.append(m_entries.at(index).fileName);
+    m_entries.removeAt(index);
+    if (m_active == name) {
+        m_active.clear();
+    }
+    emit playlistsChanged();
+}
+
+void PlaylistManager::setActive(const QString &name)
+{
+    m_active = name;
+    releaseInactive();
+}
+
+QString PlaylistManager::active() const
+{
+    return m_active;
+}
+
+bool PlaylistManager::save()
+{
+    bool ok = true;
+    for (Entry &entry : m_entries) {
+        if (!entry.dirty || !entry.files) {
+            continue;
+        }
+        QString error;
+        if (PlaylistFile::write(filePath(entry), *entry.files, &error)) {
+            entry.dirty = false;
+        } else {
+            qDebug() << "无法保存播放列表:" << entry.name << error;
+            ok = false;
+        }
+    }
+
+    for (const QString &fileName : qAsConst(m_removedFiles)) {
+        QFile::remove(m_directory + "/" + fileName);
+    }
+    m_removedFiles.clear();
+
+    QSettings settings("YinYue", "MusicPlayer");
+    settings.beginWriteArray("playlists");
+    for (int i = 0; i < m_entries.size(); ++i) {
+        const Entry &entry = m_entries.at(i);
+        settings.setArrayIndex(i);
+        settings.setValue("name", entry.name);
+        settings.setValue("file", entry.fileName);
+        settings.setValue("count", entry.count);
+    }
+    settings.endArray();
+
+    releaseInactive();
+    return ok;
+}
+
+void PlaylistManager::load()
+{
+    m_entries.clear();
+
+    // 只读取索引，播放列表内容在打开时才载入
+    QSettings settings("YinYue", "MusicPlayer");
+    int size = settings.beginReadArray("playlists");
+    for (int i = 0; i < size; ++i) {
+        settings.setArrayIndex(i);
+        Entry entry;
+        entry.name = settings.value("name").toString();
+        entry.fileName = settings.value("file").toString();
+        entry.count = settings.value("count").toInt();
+        if (!entry.name.isEmpty() && !entry.fileName.isEmpty() && !contains(entry.name)) {
+            m_entries.append(entry);
+        }
+    }
+    settings.endArray();
+
+    emit playlistsChanged();
+}
+
+int PlaylistManager::indexOf(const QString &name) const
+{
+    for (int i = 0; i < m_entries.size(); ++i) {
+        if (m_entries.at(i).name == name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+QString PlaylistManager::filePath(const Entry &entry) const
+{
+    return m_directory + "/" + entry.fileName;
+}
+
+QString PlaylistManager::newFileName() const
+{
+    for (int n = 1; ; ++n) {
+        const QString fileName = QString("playlist-%1.m3u8").arg(n);
+        bool used = m_removedFiles.contains(fileName) || QFile::exists(m_directory + "/" + fileName);
+        for (const Entry &entry : m_entries) {
+            used = used || entry.fileName == fileName;
+        }
+        if (!used) {
+            return fileName;
+        }
+    }
+}
+
+void PlaylistManager::releaseInactive()
+{
+    // 已写入磁盘的非当前播放列表释放内存，下次打开时重新载入
+    for (Entry &entry : m_entries) {
+        if (entry.files && !entry.dirty && entry.name != m_active) {
+            entry.files.reset();
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef PLAYLISTMANAGER_H
+#define PLAYLISTMANAGER_H
+
+#include <QObject>
+#include <QList>
+#include <QStringList>
+#include <optional>
+#include "musicfile.h"
+
+class MusicLibrary;
+
+// 多个命名播放列表
+// 歌曲列表使用 Qt 隐式共享：复制或派生播放列表只增加引用计数，修改时才真正复制。
+// 每个播放列表保存为一个 M3U8 文件，未打开的播放列表只在磁盘上，不占内存。
+// 当前正在播放的列表由 Playlist 持有，切换或保存时通过 setFiles 同步回来。
+class PlaylistManager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PlaylistManager(MusicLibrary *library, QObject *parent = nullptr);
+
+    QStringList names() const;
+    bool contains(const QString &name) const;
+    int count(const QString &name) const;  // 不需要载入
+    bool isLoaded(const QString &name) const;
+    int loadedCount() const;
+
+    // 取出歌曲列表，未载入时从磁盘读取；placeholders 返回音乐库中没有、尚未探测元数据的文件
+    QList<MusicFile> files(const QString &name, QStringList *placeholders = nullptr);
+
+    // 新建或替换播放列表内容
+    void setFiles(const QString &name, const QList<MusicFile> &files);
+    // 复制播放列表，与原列表共享数据
+    bool duplicate(const QString &source, const QString &name);
+    bool rename(const QString &oldName, const QString &newName);
+    void remove(const QString &name);
+
+    // 当前打开的播放列表始终保留在内存中，其余的在保存后释放
+    void setActive(const QString &name);
+    QString active() const;
+
+    // 写入已修改的播放列表和索引
+    bool save();
+    void load();
+
+signals:
+    void playlistsChanged();
+
+private:
+    struct Entry
+    {
+        QString name;
+        QString fileName;  // 播放列表目录下的文件名
+        int count = 0;
+        bool dirty = false;
+        std::optional<QList<MusicFile>> files;  // 未载入时为空
+    };
+
+    int indexOf(const QString &name) const;
+    QString filePath(const Entry &entry) const;
+    QString newFileName() const;
+    void releaseInactive();
+
+private:
+    MusicLibrary *m_library;  // 不拥有此指针
+    QString m_directory;
+    QList<Entry> m_entries;
+    QString m_active;
+    QStringList m_removedFiles;  // 保存时删除
+};
+
+#endif // PLAYLISTMANAGER_H
@@ -0,0 +1,426 @@
+#include "searchindex.h"
+#include "musiclibrary.h"
+#include <QFileInfo>
+#include <QDir>
+#include <QSet>
+#include <QElapsedTimer>
+#include <algorithm>
+
+namespace {
+
+const int MaxGram = 3;
+const QChar PrefixMarker(0x01);      // 前缀 n-gram 的键以此开头
+const quint32 MaxStamp = 1u << 29;   // 词标记中低 2 位存放匹配类型
+
+enum MatchKind {
+    Substring = 1,
+    Prefix = 2,
+    Exact = 3
+};
+
+// 字段权重：标题最重要，路径只作补充
+float fieldWeight(int field)
+{
+    static const float weights[] = {8.0f, 6.0f, 4.0f, 2.0f, 1.0f};
+    return weights[field];
+}
+
+} // namespace
+
+SearchIndex::SearchIndex(MusicLibrary *library, QObject *parent)
+    : QObject(parent)
+    , m_library(library)
+    , m_docCount(0)
+    , m_stamp(0)
+    , m_lastQueryMs(0)
+{
+    connect(m_library, &MusicLibrary::fileAdded, this, &SearchIndex::addFile);
+    connect(m_library, &MusicLibrary::fileRemoved, this, &SearchIndex::removeFile);
+    connect(m_library, &MusicLibrary::fileUpdated, this, &SearchIndex::updateFile);
+
+    const TrackStore &tracks = m_library->tracks();
+    for (int track = 0; track < tracks.rowCount(); ++track) {
+        if (tracks.isLive(track)) {
+            addDocument(track);
+        }
+    }
+}
+
+QStringList SearchIndex::tokenize(const QString &text)
+{
+    // 连续的字母或数字构成一个词，中文没有空格，整段作为一个词，靠 n-gram 做子串匹配
+    QStringList tokens;
+    const QString folded = text.toCaseFolded();
+    int start = -1;
+    for (int i = 0; i <= folded.size(); ++i) {
+        bool word = i < folded.size() && folded.at(i).isLetterOrNumber();
+        if (word && start < 0) {
+            start = i;
+        } else if (!word && start >= 0) {
+            tokens.append(folded.mid(start, i - start));
+            start = -1;
+        }
+    }
+    return tokens;
+}
+
+QStringList SearchIndex::search(const QString &query, int limit)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QStringList terms = tokenize(query);
+    terms.removeDuplicates();
+    if (terms.isEmpty()) {
+        resetQueryCache();
+        m_lastQueryMs = timer.nsecsElapsed() / 1e6;
+        return QStringList();
+    }
+
+    if (m_stamp + quint32(terms.size()) + 2 >= MaxStamp) {
+        m_tokenMarks.fill(0);
+        m_docStamps.fill(0);
+        m_stamp = 0;
+    }
+
+    // 先处理命中最少的关键词，后面的关键词只需在已有结果上过滤
+    QVector<QPair<qint64, QString>> ordered;
+    for (const QString &term : terms) {
+        ordered.append(qMakePair(termVolume(term), term));
+    }
+    std::sort(ordered.begin(), ordered.end());
+
+    // 每个旧关键词都被某个新关键词包含时，新结果一定是旧结果的子集
+    bool refine = !m_lastTerms.isEmpty();
+    for (const QString &old : qAsConst(m_lastTerms)) {
+        bool covered = false;
+        for (const QString &term : qAsConst(terms)) {
+            if (term.contains(old)) {
+                covered = true;
+                break;
+            }
+        }
+        if (!covered) {
+            refine = false;
+            break;
+        }
+    }
+
+    const quint32 docStamp = ++m_stamp;
+    QVector<int> docs;
+    int first = 0;
+    if (refine && m_lastDocs.size() <= ordered.first().first) {
+        docs = m_lastDocs;
+        for (int doc : qAsConst(docs)) {
+            m_docStamps[doc] = docStamp;
+            m_docScores[doc] = 0.0f;
+        }
+    } else {
+        // 从最稀疏的关键词的倒排表收集候选文档
+        const quint32 tokenStamp = ++m_stamp;
+        markTerm(ordered.first().second, tokenStamp);
+        const QVector<int> &candidates = m_markedTokens;
+        for (int token : candidates) {
+            const float kind = m_tokenMarks.at(token) & 3;
+            for (quint32 posting : m_postings.at(token)) {
+                const int doc = int(posting >> 3);
+                if (m_docStamps.at(doc) != docStamp) {
+                    m_docStamps[doc] = docStamp;
+                    m_docScores[doc] = 0.0f;
+                    docs.append(doc);
+                }
+                m_docScores[doc] += fieldWeight(posting & 7) * kind;
+            }
+        }
+        first = 1;
+    }
+
+    // 其余关键词：检查候选文档自己的词表
+    for (int i = first; i < ordered.size() && !docs.isEmpty(); ++i) {
+        const quint32 tokenStamp = ++m_stamp;
+        markTerm(ordered.at(i).second, tokenStamp);
+        QVector<int> kept;
+        kept.reserve(docs.size());
+        for (int doc : qAsConst(docs)) {
+            float score = 0.0f;
+            for (const Entry &entry : m_docs.at(doc).entries) {
+                const quint32 mark = m_tokenMarks.at(entry.token);
+                if ((mark >> 2) == tokenStamp) {
+                    score += fieldWeight(entry.field) * (mark & 3);
+                }
+            }
+            if (score > 0.0f) {
+                m_docScores[doc] += score;
+                kept.append(doc);
+            }
+        }
+        docs.swap(kept);
+    }
+
+    m_lastTerms = terms;
+    m_lastDocs = docs;
+
+    // 排序：相关度从高到低，相同时按路径
+    const TrackStore &tracks = m_library->tracks();
+    auto better = [this, &tracks](int a, int b) {
+        if (m_docScores.at(a) != m_docScores.at(b)) {
+            return m_docScores.at(a) > m_docScores.at(b);
+        }
+        return tracks.comparePaths(a, b) < 0;
+    };
+    if (limit >= 0 && limit < docs.size()) {
+        std::partial_sort(docs.begin(), docs.begin() + limit, docs.end(), better);
+        docs.resize(limit);
+    } else {
+        std::sort(docs.begin(), docs.end(), better);
+    }
+
+    QStringList results;
+    results.reserve(docs.size());
+    for (int doc : qAsConst(docs)) {
+        results.append(tracks.filePath(doc));
+    }
+    m_lastQueryMs = timer.nsecsElapsed() / 1e6;
+    return results;
+}
+
+int SearchIndex::documentCount() const
+{
+    return m_docCount;
+}
+
+int SearchIndex::tokenCount() const
+{
+    return m_tokens.size();
+}
+
+double SearchIndex::lastQueryMs() const
+{
+    return m_lastQueryMs;
+}
+
+void SearchIndex::addFile(const QString &, int track)
+{
+    if (isIndexed(track)) {
+        updateFile(QString(), track);
+        return;
+    }
+    addDocument(track);
+}
+
+void SearchIndex::removeFile(const QString &, int track)
+{
+    // 音乐库中的这一行已经删除，只需要文档自己记录的倒排位置
+    if (isIndexed(track)) {
+        removeDocument(track);
+    }
+}
+
+void SearchIndex::updateFile(const QString &, int track)
+{
+    if (!isIndexed(track)) {
+        addDocument(track);
+        return;
+    }
+
+    // 哈希、响度等分析结果也会触发更新，只有标签变化时才需要重新索引
+    if (m_docs.at(track).signature == tagSignature(track)) {
+        return;
+    }
+    removeDocument(track);
+    addDocument(track);
+}
+
+bool SearchIndex::isIndexed(int doc) const
+{
+    return doc < m_docs.size() && m_docs.at(doc).live;
+}
+
+void SearchIndex::addDocument(int doc)
+{
+    if (doc >= m_docs.size()) {
+        m_docs.resize(doc + 1);
+        m_docStamps.resize(doc + 1);
+        m_docScores.resize(doc + 1);
+    }
+
+    const TrackStore &tracks = m_library->tracks();
+    Document &document = m_docs[doc];
+    document.live = true;
+    document.signature = tagSignature(doc);
+    ++m_docCount;
+
+    addTokens(doc, tracks.title(doc), Title);
+    addTokens(doc, tracks.artist(doc), Artist);
+    addTokens(doc, tracks.album(doc), Album);
+    addTokens(doc, tracks.genre(doc), Genre);
+
+    // 路径只取所在目录名和文件名，避免所有文件共享的上层目录淹没结果
+    QFileInfo info(tracks.filePath(doc));
+    addTokens(doc, info.dir().dirName() + ' ' + info.completeBaseName(), Path);
+    resetQueryCache();
+}
+
+void SearchIndex::removeDocument(int doc)
+{
+    // 从倒排表中交换删除，并修正被移动项所属文档记录的位置
+    Document &document = m_docs[doc];
+    for (int i = 0; i < document.entries.size(); ++i) {
+        const Entry entry = document.entries.at(i);
+        QVector<quint32> &postings = m_postings[entry.token];
+        const quint32 last = postings.last();
+        postings[entry.slot] = last;
+        postings.removeLast();
+        if (entry.slot >= postings.size()) {
+            continue;
+        }
+
+        const int movedField = int(last & 7);
+        for (Entry &moved : m_docs[int(last >> 3)].entries) {
+            if (moved.token == entry.token && moved.field == movedField) {
+                moved.slot = entry.slot;
+                break;
+            }
+        }
+    }
+
+    m_docs[doc] = Document();
+    --m_docCount;
+    resetQueryCache();
+}
+
+// 标签指纹，用于判断文件更新时是否需要重新索引
+uint SearchIndex::tagSignature(int doc) const
+{
+    const TrackStore &tracks = m_library->tracks();
+    return qHash(tracks.title(doc)) ^ qHash(tracks.artist(doc)) * 3
+         ^ qHash(tracks.album(doc)) * 5 ^ qHash(tracks.genre(doc)) * 7;
+}
+
+void SearchIndex::addTokens(int doc, const QString &text, Field field)
+{
+    QStringList tokens = tokenize(text);
+    tokens.removeDuplicates();
+    Document &document = m_docs[doc];
+    for (const QString &token : qAsConst(tokens)) {
+        const int id = tokenId(token);
+        QVector<quint32> &postings = m_postings[id];
+        document.entries.append(Entry{id, int(field), postings.size()});
+        postings.append((quint32(doc) << 3) | quint32(field));
+    }
+}
+
+int SearchIndex::tokenId(const QString &token)
+{
+    auto it = m_tokenIds.constFind(token);
+    if (it != m_tokenIds.constEnd()) {
+        return it.value();
+    }
+
+    // 新词：登记 1~3 字的子串和前缀。不再被引用的词保留在词典中，倒排表为空即可
+    const int id = m_tokens.size();
+    m_tokens.append(token);
+    m_tokenIds.insert(token, id);
+    m_postings.append(QVector<quint32>());
+    m_tokenMarks.append(0);
+
+    QSet<QString> grams;
+    for (int n = 1; n <= MaxGram && n <= token.size(); ++n) {
+        for (int i = 0; i + n <= token.size(); ++i) {
+            grams.insert(token.mid(i, n));
+        }
+        grams.insert(PrefixMarker + token.left(n));
+    }
+    for (const QString &gram : qAsConst(grams)) {
+        m_grams[gram].append(id);
+    }
+    return id;
+}
+
+void SearchIndex::markTerm(const QString &term, quint32 stamp)
+{
+    // 把包含 term 的词标记为 (stamp << 2) | 匹配类型，同时记录到 m_markedTokens
+    m_markedTokens.clear();
+    const quint32 base = stamp << 2;
+    auto mark = [&](int token, quint32 kind) {
+        quint32 &current = m_tokenMarks[token];
+        if ((current >> 2) != stamp) {
+            current = base | kind;
+            m_markedTokens.append(token);
+        } else if ((current & 3) < kind) {
+            current = base | kind;
+        }
+    };
+
+    if (term.size() <= MaxGram) {
+        // 短关键词直接由 n-gram 表给出，无需校验
+        auto it = m_grams.constFind(term);
+        if (it != m_grams.constEnd()) {
+            for (int token : it.value()) {
+                mark(token, Substring);
+            }
+        }
+        it = m_grams.constFind(PrefixMarker + term);
+        if (it != m_grams.constEnd()) {
+            for (int token : it.value()) {
+                mark(token, Prefix);
+            }
+        }
+    } else {
+        // 长关键词：取最短的 3-gram 列表作为候选，再逐个校验
+        const QVector<int> *shortest = nullptr;
+        for (int i = 0; i + MaxGram <= term.size(); ++i) {
+            auto it = m_grams.constFind(term.mid(i, MaxGram));
+            if (it == m_grams.constEnd()) {
+                return;
+            }
+            if (!shortest || it.value().size() < shortest->size()) {
+                shortest = &it.value();
+            }
+        }
+        for (int token : *shortest) {
+            const QString &text = m_tokens.at(token);
+            if (text.startsWith(term)) {
+                mark(token, Prefix);
+            } else if (text.contains(term)) {
+                mark(token, Substring);
+            }
+        }
+    }
+
+    const int exact = m_tokenIds.value(term, -1);
+    if (exact >= 0) {
+        mark(exact, Exact);
+    }
+}
+
+qint64 SearchIndex::termVolume(const QString &term) const
+{
+    // 估算关键词命中的倒排项数量，长关键词以最短的 3-gram 列表为上界
+    QString key = term.size() <= MaxGram ? term : QString();
+    if (key.isEmpty()) {
+        int best = -1;
+        for (int i = 0; i + MaxGram <= term.size(); ++i) {
+            const int size = m_grams.value(term.mid(i, MaxGram)).size();
+            if (best < 0 || size < best) {
+                best = size;
+                key = term.mid(i, MaxGram);
+            }
+        }
+    }
+
+    qint64 volume = 0;
+    auto it = m_grams.constFind(key);
+    if (it != m_grams.constEnd()) {
+        for (int token : it.value()) {
+            volume += m_postings.at(token).size();
+        }
+    }
+    return volume;
+}
+
+void SearchIndex::resetQueryCache()
+{
+    m_lastTerms.clear();
+    m_lastDocs.clear();
+}
@@ -0,0 +1,95 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+
+class MusicLibrary;
+
+// 音乐库搜索索引
+// 标题、艺术家、专辑、流派和路径按词切分，词典上建立 1~3 字的 n-gram 索引，
+// 支持前缀和子串匹配；随音乐库的增删改增量维护，不会整体重建。
+// 文档编号就是歌曲在 TrackStore 中的行号，索引中不保存路径和标签文字，需要时从音乐库读取
+class SearchIndex : public QObject
+{
+    Q_OBJECT
+public:
+    enum Field {
+        Title,
+        Artist,
+        Album,
+        Genre,
+        Path
+    };
+
+    explicit SearchIndex(MusicLibrary *library, QObject *parent = nullptr);
+
+    // 返回所有关键词都匹配的文件，按相关度从高到低排列；limit < 0 表示不限制
+    QStringList search(const QString &query, int limit = -1);
+
+    int documentCount() const;
+    int tokenCount() const;
+    double lastQueryMs() const;
+
+    // 切分并规范化（大小写折叠）文本，搜索框输入也使用同样的规则
+    static QStringList tokenize(const QString &text);
+
+private slots:
+    void addFile(const QString &filePath, int track);
+    void removeFile(const QString &filePath, int track);
+    void updateFile(const QString &filePath, int track);
+
+private:
+    struct Entry
+    {
+        int token;
+        int field;
+        int slot;   // 在该词倒排表中的位置，删除时用于 O(1) 移除
+    };
+
+    struct Document
+    {
+        QVector<Entry> entries;
+        uint signature = 0;  // 已索引标签的指纹
+        bool live = false;
+    };
+
+    bool isIndexed(int doc) const;
+    void addDocument(int doc);
+    void removeDocument(int doc);
+    uint tagSignature(int doc) const;
+    void addTokens(int doc, const QString &text, Field field);
+    int tokenId(const QString &token);
+    void markTerm(const QString &term, quint32 stamp);
+    qint64 termVolume(const QString &term) const;
+    void resetQueryCache();
+
+private:
+    MusicLibrary *m_library;  // 不拥有此指针
+
+    // 文档，按 TrackStore 的行号存放
+    QVector<Document> m_docs;
+    int m_docCount;
+
+    // 词典与倒排表，倒排项为 (文档 << 3) | 字段
+    QVector<QString> m_tokens;
+    QHash<QString, int> m_tokenIds;
+    QVector<QVector<quint32>> m_postings;
+    QHash<QString, QVector<int>> m_grams;  // n-gram（含前缀标记）到词
+
+    // 查询时复用的工作区，用时间戳代替清零
+    QVector<quint32> m_tokenMarks;
+    QVector<int> m_markedTokens;
+    QVector<quint32> m_docStamps;
+    QVector<float> m_docScores;
+    quint32 m_stamp;
+
+    // 连续输入时，新查询的结果是上一次结果的子集，可以直接在上次结果中过滤
+    QStringList m_lastTerms;
+    QVector<int> m_lastDocs;
+    double m_lastQueryMs;
+};
+
+#endif // SEARCHINDEX_H
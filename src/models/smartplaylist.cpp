@@ -0,0 +1,584 @@
+#include "smartplaylist.h"
+#include "musiclibrary.h"
+#include <QRegularExpression>
+#include <QSettings>
+#include <QDateTime>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// 含相对时间的规则每小时整体重新计算一次
+const int TimeRefreshInterval = 60 * 60 * 1000;
+
+const qint64 Second = 1000;
+const qint64 Minute = 60 * Second;
+const qint64 Hour = 60 * Minute;
+const qint64 Day = 24 * Hour;
+
+// 距今时长，无效时间（例如从未播放）视为无穷久
+double age(const QDateTime &time, qint64 nowMs)
+{
+    if (!time.isValid()) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return double(nowMs - time.toMSecsSinceEpoch());
+}
+
+} // namespace
+
+class SmartRule::Parser
+{
+public:
+    explicit Parser(const QString &text);
+
+    bool parse(Node *root, bool *dependsOnTime, QString *error);
+
+private:
+    struct Token
+    {
+        enum Kind { Word, String, Operator, LeftParen, RightParen, End };
+        Kind kind;
+        QString text;
+    };
+
+    const Token &peek() const { return m_tokens.at(m_pos); }
+    bool acceptKeyword(const QString &word, const QString &symbol);
+    bool parseOr(Node *node);
+    bool parseAnd(Node *node);
+    bool parseNot(Node *node);
+    bool parsePrimary(Node *node);
+    bool parseComparison(Node *node);
+    bool fail(const QString &message);
+
+private:
+    QVector<Token> m_tokens;
+    int m_pos;
+    bool m_time;
+    QString m_error;
+};
+
+SmartRule::Parser::Parser(const QString &text)
+    : m_pos(0)
+    , m_time(false)
+{
+    static const QStringList operators = {
+        "!=", "<=", ">=", "!~", "&&", "||", "=", "<", ">", "~", "!"
+    };
+    static const QString operatorChars = "=!<>~&|";
+
+    int i = 0;
+    while (i < text.size()) {
+        const QChar c = text.at(i);
+        if (c.isSpace()) {
+            ++i;
+        } else if (c == '(') {
+            m_tokens.append(Token{Token::LeftParen, "("});
+            ++i;
+        } else if (c == ')') {
+            m_tokens.append(Token{Token::RightParen, ")"});
+            ++i;
+        } else if (c == '"' || c == '\'') {
+            int end = text.indexOf(c, i + 1);
+            if (end < 0) {
+                end = text.size();
+            }
+            m_tokens.append(Token{Token::String, text.mid(i + 1, end - i - 1)});
+            i = end + 1;
+        } else if (operatorChars.contains(c)) {
+            QString op;
+            for (const QString &candidate : operators) {
+                if (text.midRef(i, candidate.size()) == candidate) {
+                    op = candidate;
+                    break;
+                }
+            }
+            if (op.isEmpty()) {
+                op = c;  // 单独的 & 或 |，交给语法分析报错
+            }
+            m_tokens.append(Token{Token::Operator, op});
+            i += op.size();
+        } else {
+            int start = i;
+            while (i < text.size() && !text.at(i).isSpace() && text.at(i) != '('
+                   && text.at(i) != ')' && !operatorChars.contains(text.at(i))) {
+                ++i;
+            }
+            m_tokens.append(Token{Token::Word, text.mid(start, i - start)});
+        }
+    }
+    m_tokens.append(Token{Token::End, QString()});
+}
+
+bool SmartRule::Parser::parse(Node *root, bool *dependsOnTime, QString *error)
+{
+    if (peek().kind == Token::End) {
+        if (error) {
+            *error = QObject::tr("规则为空");
+        }
+        return false;
+    }
+
+    bool ok = parseOr(root);
+    if (ok && peek().kind != Token::End) {
+        ok = fail(QObject::tr("无法识别“%1”").arg(peek().text));
+    }
+    if (!ok && error) {
+        *error = m_error;
+    }
+    *dependsOnTime = m_time;
+    return ok;
+}
+
+bool SmartRule::Parser::acceptKeyword(const QString &word, const QString &symbol)
+{
+    const Token &token = peek();
+    if ((token.kind == Token::Word && token.text.compare(word, Qt::CaseInsensitive) == 0)
+        || (token.kind == Token::Operator && token.text == symbol)) {
+        ++m_pos;
+        return true;
+    }
+    return false;
+}
+
+bool SmartRule::Parser::parseOr(Node *node)
+{
+    Node left;
+    if (!parseAnd(&left)) {
+        return false;
+    }
+
+    Node result;
+    result.type = Node::Or;
+    result.children.push_back(std::move(left));
+    while (acceptKeyword("or", "||")) {
+        Node right;
+        if (!parseAnd(&right)) {
+            return false;
+        }
+        result.children.push_back(std::move(right));
+    }
+    *node = result.children.size() == 1 ? std::move(result.children.front()) : std::move(result);
+    return true;
+}
+
+bool SmartRule::Parser::parseAnd(Node *node)
+{
+    Node left;
+    if (!parseNot(&left)) {
+        return false;
+    }
+
+    Node result;
+    result.type = Node::And;
+    result.children.push_back(std::move(left));
+    while (acceptKeyword("and", "&&")) {
+        Node right;
+        if (!parseNot(&right)) {
+            return false;
+        }
+        result.children.push_back(std::move(right));
+    }
+    *node = result.children.size() == 1 ? std::move(result.children.front()) : std::move(result);
+    return true;
+}
+
+bool SmartRule::Parser::parseNot(Node *node)
+{
+    if (acceptKeyword("not", "!")) {
+        Node operand;
+        if (!parseNot(&operand)) {
+            return false;
+        }
+        node->type = Node::Not;
+        node->children.push_back(std::move(operand));
+        return true;
+    }
+    return parsePrimary(node);
+}
+
+bool SmartRule::Parser::parsePrimary(Node *node)
+{
+    if (peek().kind == Token::LeftParen) {
+        ++m_pos;
+        if (!parseOr(node)) {
+            return false;
+        }
+        if (peek().kind != Token::RightParen) {
+            return fail(QObject::tr("缺少右括号"));
+        }
+        ++m_pos;
+        return true;
+    }
+    return parseComparison(node);
+}
+
+bool SmartRule::Parser::parseComparison(Node *node)
+{
+    static const QHash<QString, Field> fields = {
+        {"title", Title}, {"标题", Title},
+        {"artist", Artist}, {"艺术家", Artist},
+        {"album", Album}, {"专辑", Album},
+        {"genre", Genre}, {"流派", Genre},
+        {"path", FilePath}, {"路径", FilePath},
+        {"duration", Duration}, {"时长", Duration},
+        {"plays", Plays}, {"播放次数", Plays},
+        {"skips", Skips}, {"跳过次数", Skips},
+        {"loudness", Loudness}, {"响度", Loudness},
+        {"added", Added}, {"加入", Added},
+        {"lastplayed", LastPlayed}, {"最近播放", LastPlayed},
+        {"modified", Modified}, {"修改", Modified}
+    };
+    static const QHash<QString, Op> ops = {
+        {"=", Equal}, {"!=", NotEqual}, {"<", Less}, {"<=", LessEqual},
+        {">", Greater}, {">=", GreaterEqual}, {"~", Contains}, {"!~", NotContains}
+    };
+
+    const Token fieldToken = peek();
+    auto field = fields.constFind(fieldToken.text.toLower());
+    if (fieldToken.kind != Token::Word || field == fields.constEnd()) {
+        return fail(QObject::tr("未知字段“%1”").arg(fieldToken.text));
+    }
+    ++m_pos;
+
+    const Token opToken = peek();
+    auto op = ops.constFind(opToken.text);
+    if (opToken.kind != Token::Operator || op == ops.constEnd()) {
+        return fail(QObject::tr("字段“%1”后缺少比较运算符").arg(fieldToken.text));
+    }
+    ++m_pos;
+
+    const Token value = peek();
+    if (value.kind != Token::Word && value.kind != Token::String) {
+        return fail(QObject::tr("“%1”后缺少比较值").arg(opToken.text));
+    }
+    ++m_pos;
+
+    node->type = Node::Compare;
+    node->field = field.value();
+    node->op = op.value();
+
+    // 文本字段
+    if (node->field <= FilePath) {
+        if (node->op != Equal && node->op != NotEqual && node->op != Contains && node->op != NotContains) {
+            return fail(QObject::tr("文本字段只支持 = != ~ !~"));
+        }
+        node->text = value.text.toCaseFolded();
+        return true;
+    }
+
+    // 数值字段：数字加可选单位
+    if (node->op == Contains || node->op == NotContains) {
+        return fail(QObject::tr("数值字段不支持 ~ 运算"));
+    }
+    static const QRegularExpression numberPattern("^(-?\\d+(?:\\.\\d+)?)([a-z]*)$");
+    const QRegularExpressionMatch match = numberPattern.match(value.text.toLower());
+    if (!match.hasMatch()) {
+        return fail(QObject::tr("无效的数值“%1”").arg(value.text));
+    }
+
+    static const QHash<QString, qint64> units = {
+        {"ms", 1}, {"s", Second}, {"sec", Second}, {"m", Minute}, {"min", Minute},
+        {"h", Hour}, {"d", Day}, {"w", 7 * Day}, {"y", 365 * Day}
+    };
+    const QString unit = match.captured(2);
+    const bool isTime = node->field == Added || node->field == LastPlayed || node->field == Modified;
+    qint64 scale = 1;
+    if (node->field == Duration || isTime) {
+        if (unit.isEmpty()) {
+            scale = isTime ? Day : Second;
+        } else if (units.contains(unit)) {
+            scale = units.value(unit);
+        } else {
+            return fail(QObject::tr("未知单位“%1”").arg(unit));
+        }
+    } else if (!unit.isEmpty()) {
+        return fail(QObject::tr("字段“%1”没有单位").arg(fieldToken.text));
+    }
+
+    node->number = match.captured(1).toDouble() * scale;
+    m_time = m_time || isTime;
+    return true;
+}
+
+bool SmartRule::Parser::fail(const QString &message)
+{
+    if (m_error.isEmpty()) {
+        m_error = message;
+    }
+    return false;
+}
+
+SmartRule::SmartRule()
+    : m_valid(false)
+    , m_dependsOnTime(false)
+{
+}
+
+SmartRule SmartRule::parse(const QString &text, QString *error)
+{
+    SmartRule rule;
+    rule.m_text = text.trimmed();
+    Parser parser(rule.m_text);
+    rule.m_valid = parser.parse(&rule.m_root, &rule.m_dependsOnTime, error);
+    return rule;
+}
+
+bool SmartRule::isValid() const
+{
+    return m_valid;
+}
+
+QString SmartRule::text() const
+{
+    return m_text;
+}
+
+bool SmartRule::dependsOnTime() const
+{
+    return m_dependsOnTime;
+}
+
+bool SmartRule::matches(const MusicFile &file, qint64 nowMs) const
+{
+    return m_valid && evaluate(m_root, file, nowMs);
+}
+
+bool SmartRule::evaluate(const Node &node, const MusicFile &file, qint64 nowMs)
+{
+    switch (node.type) {
+    case Node::And:
+        return std::all_of(node.children.begin(), node.children.end(), [&](const Node &child) {
+            return evaluate(child, file, nowMs);
+        });
+    case Node::Or:
+        return std::any_of(node.children.begin(), node.children.end(), [&](const Node &child) {
+            return evaluate(child, file, nowMs);
+        });
+    case Node::Not:
+        return !evaluate(node.children.front(), file, nowMs);
+    case Node::Compare:
+        break;
+    }
+
+    if (node.field <= FilePath) {
+        QString text;
+        switch (node.field) {
+        case Title: text = file.title(); break;
+        case Artist: text = file.artist(); break;
+        case Album: text = file.album(); break;
+        case Genre: text = file.genre(); break;
+        default: text = file.filePath(); break;
+        }
+        text = text.toCaseFolded();
+        switch (node.op) {
+        case Equal: return text == node.text;
+        case NotEqual: return text != node.text;
+        case Contains: return text.contains(node.text);
+        case NotContains: return !text.contains(node.text);
+        default: return false;
+        }
+    }
+
+    double value = 0;
+    switch (node.field) {
+    case Duration: value = file.duration(); break;
+    case Plays: value = file.playCount(); break;
+    case Skips: value = file.skipCount(); break;
+    case Loudness:
+        if (!file.hasLoudness()) {
+            return false;  // 未分析的文件不参与响度比较
+        }
+        value = file.trackLoudness();
+        break;
+    case Added: value = age(file.dateAdded(), nowMs); break;
+    case LastPlayed: value = age(file.lastPlayed(), nowMs); break;
+    case Modified: value = age(file.lastModified(), nowMs); break;
+    default: break;
+    }
+
+    switch (node.op) {
+    case Equal: return value == node.number;
+    case NotEqual: return value != node.number;
+    case Less: return value < node.number;
+    case LessEqual: return value <= node.number;
+    case Greater: return value > node.number;
+    case GreaterEqual: return value >= node.number;
+    default: return false;
+    }
+}
+
+SmartPlaylists::SmartPlaylists(MusicLibrary *library, QObject *parent)
+    : QObject(parent)
+    , m_library(library)
+{
+    connect(m_library, &MusicLibrary::fileAdded, this, &SmartPlaylists::onFileChanged);
+    connect(m_library, &MusicLibrary::fileUpdated, this, &SmartPlaylists::onFileChanged);
+    connect(m_library, &MusicLibrary::fileRemoved, this, &SmartPlaylists::onFileRemoved);
+
+    m_timeRefresh.setInterval(TimeRefreshInterval);
+    connect(&m_timeRefresh, &QTimer::timeout, this, &SmartPlaylists::refreshTimeRules);
+}
+
+bool SmartPlaylists::addPlaylist(const QString &name, const QString &rule, QString *error)
+{
+    Entry entry;
+    entry.name = name;
+    entry.rule = SmartRule::parse(rule, error);
+    if (name.isEmpty() || !entry.rule.isValid()) {
+        return false;
+    }
+
+    removePlaylist(name);
+    evaluateAll(entry);
+    m_entries.append(entry);
+    if (entry.rule.dependsOnTime() && !m_timeRefresh.isActive()) {
+        m_timeRefresh.start();
+    }
+    emit playlistChanged(name);
+    return true;
+}
+
+void SmartPlaylists::removePlaylist(const QString &name)
+{
+    for (int i = 0; i < m_entries.size(); ++i) {
+        if (m_entries.at(i).name == name) {
+            m_entries.removeAt(i);
+            emit playlistChanged(name);
+            return;
+        }
+    }
+}
+
+QStringList SmartPlaylists::names() const
+{
+    QStringList result;
+    for (const Entry &entry : m_entries) {
+        result.append(entry.name);
+    }
+    return result;
+}
+
+QString SmartPlaylists::rule(const QString &name) const
+{
+    for (const Entry &entry : m_entries) {
+        if (entry.name == name) {
+            return entry.rule.text();
+        }
+    }
+    return QString();
+}
+
+QStringList SmartPlaylists::files(const QString &name) const
+{
+    for (const Entry &entry : m_entries) {
+        if (entry.name == name) {
+            QStringList paths = entry.members.values();
+            std::sort(paths.begin(), paths.end());
+            return paths;
+        }
+    }
+    return QStringList();
+}
+
+int SmartPlaylists::count(const QString &name) const
+{
+    for (const Entry &entry : m_entries) {
+        if (entry.name == name) {
+            return entry.members.size();
+        }
+    }
+    return 0;
+}
+
+void SmartPlaylists::save() const
+{
+    QSettings settings("YinYue", "MusicPlayer");
+    settings.beginWriteArray("smartPlaylists");
+    for (int i = 0; i < m_entries.size(); ++i) {
+        settings.setArrayIndex(i);
+        settings.setValue("name", m_entries.at(i).name);
+        settings.setValue("rule", m_entries.at(i).rule.text());
+    }
+    settings.endArray();
+}
+
+void SmartPlaylists::load()
+{
+    QSettings settings("YinYue", "MusicPlayer");
+    int size = settings.beginReadArray("smartPlaylists");
+    for (int i = 0; i < size; ++i) {
+        settings.setArrayIndex(i);
+        QString error;
+        const QString name = settings.value("name").toString();
+        if (!addPlaylist(name, settings.value("rule").toString(), &error)) {
+            qDebug() << "智能播放列表规则无效:" << name << error;
+        }
+    }
+    settings.endArray();
+}
+
+void SmartPlaylists::onFileChanged(const QString &filePath)
+{
+    if (m_entries.isEmpty()) {
+        return;
+    }
+
+    // 只用变化的文件测试每条规则
+    const MusicFile file = m_library->file(filePath);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (Entry &entry : m_entries) {
+        const bool matched = entry.rule.matches(file, now);
+        if (matched == entry.members.contains(filePath)) {
+            continue;
+        }
+        if (matched) {
+            entry.members.insert(filePath);
+        } else {
+            entry.members.remove(filePath);
+        }
+        emit playlistChanged(entry.name);
+    }
+}
+
+void SmartPlaylists::onFileRemoved(const QString &filePath)
+{
+    for (Entry &entry : m_entries) {
+        if (entry.members.remove(filePath)) {
+            emit playlistChanged(entry.name);
+        }
+    }
+}
+
+void SmartPlaylists::refreshTimeRules()
+{
+    bool any = false;
+    for (Entry &entry : m_entries) {
+        if (!entry.rule.dependsOnTime()) {
+            continue;
+        }
+        any = true;
+        const QSet<QString> before = entry.members;
+        evaluateAll(entry);
+        if (entry.members != before) {
+            emit playlistChanged(entry.name);
+        }
+    }
+    if (!any) {
+        m_timeRefresh.stop();
+    }
+}
+
+void SmartPlaylists::evaluateAll(Entry &entry)
+{
+    entry.members.clear();
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const QStringList paths = m_library->filePaths();
+    for (const QString &path : paths) {
+        if (entry.rule.matches(m_library->file(path), now)) {
+            entry.members.insert(path);
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef SMARTPLAYLIST_H
+#define SMARTPLAYLIST_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include <vector>
+
+class MusicLibrary;
+class MusicFile;
+
+// 智能播放列表规则
+// 语法示例：
+//   genre = "摇滚" and duration < 5min
+//   added < 30d                      （30 天内加入音乐库）
+//   plays = 0 or lastplayed > 90d    （从未播放或 90 天未播放）
+//   not (artist ~ live) and loudness > -12
+// 字段：title artist album genre path（文本，= != ~ !~，不区分大小写）
+//       duration（时长，默认单位秒） plays（播放次数） skips（跳过次数） loudness（LUFS）
+//       added lastplayed modified（距今时长，默认单位天；从未播放视为无穷久）
+// 运算符：and or not 以及括号
+class SmartRule
+{
+public:
+    SmartRule();
+
+    static SmartRule parse(const QString &text, QString *error = nullptr);
+
+    bool isValid() const;
+    QString text() const;
+
+    // 规则中包含相对时间时，结果会随时间推移变化
+    bool dependsOnTime() const;
+
+    bool matches(const MusicFile &file, qint64 nowMs) const;
+
+private:
+    enum Field {
+        Title, Artist, Album, Genre, FilePath,
+        Duration, Plays, Skips, Loudness,
+        Added, LastPlayed, Modified
+    };
+
+    enum Op {
+        Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual, Contains, NotContains
+    };
+
+    struct Node
+    {
+        enum Type { And, Or, Not, Compare };
+        Type type = Compare;
+        Field field = Title;
+        Op op = Equal;
+        QString text;
+        double number = 0;
+        std::vector<Node> children;
+    };
+
+    class Parser;
+    static bool evaluate(const Node &node, const MusicFile &file, qint64 nowMs);
+
+private:
+    QString m_text;
+    Node m_root;
+    bool m_valid;
+    bool m_dependsOnTime;
+};
+
+// 智能播放列表
+// 音乐库每次增删改只用变化的文件测试各条规则，更新代价与变化量成正比；
+// 含相对时间的规则另外定时整体重新计算
+class SmartPlaylists : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SmartPlaylists(MusicLibrary *library, QObject *parent = nullptr);
+
+    bool addPlaylist(const QString &name, const QString &rule, QString *error = nullptr);
+    void removePlaylist(const QString &name);
+
+    QStringList names() const;
+    QString rule(const QString &name) const;
+    QStringList files(const QString &name) const;  // 按路径排序
+    int count(const QString &name) const;
+
+    // 持久化规则（结果不保存，载入时计算）
+    void save() const;
+    void load();
+
+signals:
+    void playlistChanged(const QString &name);
+
+private slots:
+    void onFileChanged(const QString &filePath);
+    void onFileRemoved(const QString &filePath);
+    void refreshTimeRules();
+
+private:
+    struct Entry
+    {
+        QString name;
+        SmartRule rule;
+        QSet<QString> members;
+    };
+
+    void evaluateAll(Entry &entry);
+
+private:
+    MusicLibrary *m_library;  // 不拥有此指针
+    QList<Entry> m_entries;
+    QTimer m_timeRefresh;
+};
+
+#endif // SMARTPLAYLIST_H
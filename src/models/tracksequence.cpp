@@ -0,0 +1,263 @@
+#include "tracksequence.h"
+
+TrackSequence::TrackSequence()
+    : m_root(-1)
+    , m_seed(0x9e3779b9u)
+{
+}
+
+int TrackSequence::size() const
+{
+    return sizeOf(m_root);
+}
+
+bool TrackSequence::isEmpty() const
+{
+    return m_root < 0;
+}
+
+const MusicFile &TrackSequence::at(int index) const
+{
+    Q_ASSERT(index >= 0 && index < size());
+    return m_nodes[nodeAt(index)].file;
+}
+
+MusicFile TrackSequence::value(int index) const
+{
+    if (index < 0 || index >= size()) {
+        return MusicFile();
+    }
+    return at(index);
+}
+
+void TrackSequence::replace(int index, const MusicFile &file)
+{
+    if (index >= 0 && index < size()) {
+        m_nodes[nodeAt(index)].file = file;
+    }
+}
+
+void TrackSequence::assign(const QList<MusicFile> &files)
+{
+    clear();
+    m_nodes.reserve(files.size());
+    m_root = build(files);
+}
+
+void TrackSequence::insert(int index, const QList<MusicFile> &files)
+{
+    if (files.isEmpty()) {
+        return;
+    }
+    const int middle = build(files);
+    int left, right;
+    split(m_root, qBound(0, index, size()), &left, &right);
+    m_root = merge(merge(left, middle), right);
+}
+
+QList<MusicFile> TrackSequence::take(int first, int count)
+{
+    QList<MusicFile> files;
+    if (first < 0 || count <= 0 || first + count > size()) {
+        return files;
+    }
+    int left, middle, right;
+    split(m_root, first, &left, &right);
+    split(right, count, &middle, &right);
+    m_root = merge(left, right);
+    files.reserve(count);
+    release(middle, &files);
+    return files;
+}
+
+void TrackSequence::remove(int first, int count)
+{
+    if (first < 0 || count <= 0 || first + count > size()) {
+        return;
+    }
+    int left, middle, right;
+    split(m_root, first, &left, &right);
+    split(right, count, &middle, &right);
+    m_root = merge(left, right);
+    release(middle, nullptr);
+}
+
+void TrackSequence::move(int first, int count, int destination)
+{
+    if (first < 0 || count <= 0 || first + count > size()
+        || destination < 0 || destination > size() - count || destination == first) {
+        return;
+    }
+    int left, middle, right;
+    split(m_root, first, &left, &right);
+    split(right, count, &middle, &right);
+    const int rest = merge(left, right);
+    split(rest, destination, &left, &right);
+    m_root = merge(merge(left, middle), right);
+}
+
+void TrackSequence::clear()
+{
+    m_nodes.clear();
+    m_free.clear();
+    m_root = -1;
+}
+
+QList<MusicFile> TrackSequence::toList() const
+{
+    QList<MusicFile> files;
+    files.reserve(size());
+    std::vector<int> stack;
+    int node = m_root;
+    while (node >= 0 || !stack.empty()) {
+        while (node >= 0) {
+            stack.push_back(node);
+            node = m_nodes[node].left;
+        }
+        node = stack.back();
+        stack.pop_back();
+        files.append(m_nodes[node].file);
+        node = m_nodes[node].right;
+    }
+    return files;
+}
+
+int TrackSequence::nodeAt(int index) const
+{
+    int node = m_root;
+    while (true) {
+        const int leftSize = sizeOf(m_nodes[node].left);
+        if (index < leftSize) {
+            node = m_nodes[node].left;
+        } else if (index == leftSize) {
+            return node;
+        } else {
+            index -= leftSize + 1;
+            node = m_nodes[node].right;
+        }
+    }
+}
+
+void TrackSequence::update(int node)
+{
+    Node &n = m_nodes[node];
+    n.size = 1 + sizeOf(n.left) + sizeOf(n.right);
+}
+
+int TrackSequence::allocate(const MusicFile &file)
+{
+    Node node;
+    node.file = file;
+    node.priority = nextPriority();
+    if (!m_free.empty()) {
+        const int index = m_free.back();
+        m_free.pop_back();
+        m_nodes[index] = std::move(node);
+        return index;
+    }
+    m_nodes.push_back(std::move(node));
+    return int(m_nodes.size()) - 1;
+}
+
+void TrackSequence::release(int node, QList<MusicFile> *files)
+{
+    // 中序遍历被删除的子树，按顺序取出歌曲并回收节点
+    std::vector<int> stack;
+    while (node >= 0 || !stack.empty()) {
+        while (node >= 0) {
+            stack.push_back(node);
+            node = m_nodes[node].left;
+        }
+        node = stack.back();
+        stack.pop_back();
+        Node &n = m_nodes[node];
+        if (files) {
+            files->append(std::move(n.file));
+        }
+        n.file = MusicFile();
+        m_free.push_back(node);
+        node = n.right;
+    }
+}
+
+int TrackSequence::build(const QList<MusicFile> &files)
+{
+    // 用栈在线性时间内按随机优先级建立笛卡尔树，栈中保存最右链
+    std::vector<int> stack;
+    for (const MusicFile &file : files) {
+        const int node = allocate(file);
+        int last = -1;
+        while (!stack.empty() && m_nodes[stack.back()].priority < m_nodes[node].priority) {
+            last = stack.back();
+            stack.pop_back();
+            update(last);
+        }
+        m_nodes[node].left = last;
+        if (!stack.empty()) {
+            m_nodes[stack.back()].right = node;
+        }
+        stack.push_back(node);
+    }
+
+    int root = -1;
+    while (!stack.empty()) {
+        root = stack.back();
+        stack.pop_back();
+        update(root);
+    }
+    return root;
+}
+
+void TrackSequence::split(int node, int count, int *left, int *right)
+{
+    if (node < 0) {
+        *left = -1;
+        *right = -1;
+        return;
+    }
+
+    const int leftSize = sizeOf(m_nodes[node].left);
+    if (count <= leftSize) {
+        int a, b;
+        split(m_nodes[node].left, count, &a, &b);
+        m_nodes[node].left = b;
+        update(node);
+        *left = a;
+        *right = node;
+    } else {
+        int a, b;
+        split(m_nodes[node].right, count - leftSize - 1, &a, &b);
+        m_nodes[node].right = a;
+        update(node);
+        *left = node;
+        *right = b;
+    }
+}
+
+int TrackSequence::merge(int left, int right)
+{
+    if (left < 0) {
+        return right;
+    }
+    if (right < 0) {
+        return left;
+    }
+
+    if (m_nodes[left].priority > m_nodes[right].priority) {
+        m_nodes[left].right = merge(m_nodes[left].right, right);
+        update(left);
+        return left;
+    }
+    m_nodes[right].left = merge(left, m_nodes[right].left);
+    update(right);
+    return right;
+}
+
+quint32 TrackSequence::nextPriority()
+{
+    // xorshift32，足够打乱 treap 的形状
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return m_seed;
+}
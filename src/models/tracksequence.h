@@ -0,0 +1,83 @@
+#ifndef TRACKSEQUENCE_H
+#define TRACKSEQUENCE_H
+
+#include <QList>
+#include <vector>
+#include "musicfile.h"
+
+// 播放队列的顺序容器：按位置索引的隐式 treap（每个节点记录子树大小）
+// 任意位置的插入、删除、整段移动都是 O(log n)，批量插入 k 首为 O(k + log n)，
+// 按行号访问为 O(log n)。节点放在连续数组中，删除后回收复用。
+class TrackSequence
+{
+public:
+    TrackSequence();
+
+    int size() const;
+    bool isEmpty() const;
+
+    const MusicFile &at(int index) const;
+    MusicFile value(int index) const;  // 越界时返回空 MusicFile
+    void replace(int index, const MusicFile &file);
+
+    void assign(const QList<MusicFile> &files);
+    void insert(int index, const QList<MusicFile> &files);
+    QList<MusicFile> take(int first, int count);  // 删除并返回被删除的歌曲
+    void remove(int first, int count);
+    // 把 [first, first + count) 移动到新位置，destination 是移动后第一行的行号
+    void move(int first, int count, int destination);
+    void clear();
+
+    QList<MusicFile> toList() const;
+
+    // 按顺序访问每一首歌，f(int index, MusicFile &file)
+    template <typename F>
+    void forEach(F f);
+
+private:
+    struct Node
+    {
+        MusicFile file;
+        int left = -1;
+        int right = -1;
+        int size = 1;
+        quint32 priority = 0;
+    };
+
+    int sizeOf(int node) const { return node < 0 ? 0 : m_nodes[node].size; }
+    int nodeAt(int index) const;
+    void update(int node);
+    int allocate(const MusicFile &file);
+    void release(int node, QList<MusicFile> *files);
+    int build(const QList<MusicFile> &files);
+    void split(int node, int count, int *left, int *right);
+    int merge(int left, int right);
+    quint32 nextPriority();
+
+private:
+    std::vector<Node> m_nodes;
+    std::vector<int> m_free;
+    int m_root;
+    quint32 m_seed;
+};
+
+template <typename F>
+void TrackSequence::forEach(F f)
+{
+    // 中序遍历，显式栈避免递归过深
+    std::vector<int> stack;
+    int node = m_root;
+    int index = 0;
+    while (node >= 0 || !stack.empty()) {
+        while (node >= 0) {
+            stack.push_back(node);
+            node = m_nodes[node].left;
+        }
+        node = stack.back();
+        stack.pop_back();
+        f(index++, m_nodes[node].file);
+        node = m_nodes[node].right;
+    }
+}
+
+#endif // TRACKSEQUENCE_H
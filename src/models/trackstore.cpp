@@ -0,0 +1,615 @@
+#include "trackstore.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+const qint64 InvalidTime = std::numeric_limits<qint64>::min();  // 无效的 QDateTime
+const size_t MinSlots = 16;
+const int BlockShift = 16;
+const int BlockChars = 1 << BlockShift;  // 每块 64K 个字符
+const quint16 MaxTextLength = 0xffff;
+
+size_t slotCountFor(size_t entries)
+{
+    size_t slots = MinSlots;
+    while (slots < entries * 2) {
+        slots *= 2;
+    }
+    return slots;
+}
+
+// 线性探测表的后移删除：把后面探测链上的元素前移填补空位，不留墓碑
+template <typename Slot, typename IsEmpty, typename Home>
+void eraseSlot(std::vector<Slot> &slots, size_t i, const Slot &empty, IsEmpty isEmpty, Home home)
+{
+    const size_t mask = slots.size() - 1;
+    size_t j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (isEmpty(slots[j])) {
+            break;
+        }
+        const size_t h = home(slots[j]) & mask;
+        const bool between = i <= j ? (i < h && h <= j) : (i < h || h <= j);
+        if (between) {
+            continue;
+        }
+        slots[i] = slots[j];
+        i = j;
+    }
+    slots[i] = empty;
+}
+}
+
+// ---------------------------------------------------------------- StringPool
+
+TrackStore::StringPool::StringPool()
+{
+    m_strings.append(QString());
+    m_refs.append(0);
+}
+
+quint32 TrackStore::StringPool::acquire(const QString &text)
+{
+    if (text.isEmpty()) {
+        return 0;
+    }
+    auto it = m_ids.constFind(text);
+    if (it != m_ids.constEnd()) {
+        ++m_refs[int(it.value())];
+        return it.value();
+    }
+
+    quint32 id;
+    if (!m_free.isEmpty()) {
+        id = m_free.takeLast();
+        m_strings[int(id)] = text;
+        m_refs[int(id)] = 1;
+    } else {
+        id = quint32(m_strings.size());
+        m_strings.append(text);
+        m_refs.append(1);
+    }
+    m_ids.insert(text, id);
+    return id;
+}
+
+void TrackStore::StringPool::release(quint32 id)
+{
+    if (id == 0 || --m_refs[int(id)] > 0) {
+        return;
+    }
+    m_ids.remove(m_strings.at(int(id)));
+    m_strings[int(id)] = QString();
+    m_free.append(id);
+}
+
+int TrackStore::StringPool::find(const QString &text) const
+{
+    if (text.isEmpty()) {
+        return 0;
+    }
+    return int(m_ids.value(text, quint32(-1)));
+}
+
+qint64 TrackStore::StringPool::bytesUsed() const
+{
+    // 每个字符串：QString 指针 + 数据头 + 字符；哈希表节点约为指针、哈希值、键和值
+    qint64 bytes = m_strings.capacity() * qint64(sizeof(QString));
+    bytes += (m_refs.capacity() + m_free.capacity()) * qint64(sizeof(quint32));
+    for (const QString &text : m_strings) {
+        if (!text.isNull()) {
+            bytes += 24 + (text.size() + 1) * qint64(sizeof(QChar));
+        }
+    }
+    bytes += m_ids.size() * qint64(sizeof(void *) * 2 + sizeof(QString) + sizeof(quint32) + sizeof(uint));
+    bytes += m_ids.capacity() * qint64(sizeof(void *));
+    return bytes;
+}
+
+// ---------------------------------------------------------------- TextColumn
+
+void TrackStore::TextColumn::resize(int rows)
+{
+    m_offsets.resize(size_t(rows), 0);
+    m_lengths.resize(size_t(rows), 0);
+}
+
+void TrackStore::TextColumn::reserve(int rows)
+{
+    m_offsets.reserve(size_t(rows));
+    m_lengths.reserve(size_t(rows));
+}
+
+void TrackStore::TextColumn::set(int row, const QString &text)
+{
+    // 长度不变时原地覆盖，否则另外分配，旧内容成为空洞
+    const quint16 length = quint16(qMin(text.size(), int(MaxTextLength)));
+    const quint16 oldLength = m_lengths[size_t(row)];
+    if (length == oldLength) {
+        if (length > 0) {
+            const quint32 offset = m_offsets[size_t(row)];
+            std::copy(text.constData(), text.constData() + length,
+                      m_blocks[offset >> BlockShift].get() + (offset & (BlockChars - 1)));
+        }
+        return;
+    }
+
+    m_waste += oldLength;
+    m_lengths[size_t(row)] = length;
+    m_offsets[size_t(row)] = 0;
+    if (length > 0) {
+        QChar *data = allocate(length, &m_offsets[size_t(row)]);
+        std::copy(text.constData(), text.constData() + length, data);
+    }
+    if (m_waste > BlockChars && m_waste * 2 > m_used) {
+        compact();
+    }
+}
+
+void TrackStore::TextColumn::reset(int row)
+{
+    m_waste += m_lengths[size_t(row)];
+    m_lengths[size_t(row)] = 0;
+    m_offsets[size_t(row)] = 0;
+}
+
+QStringView TrackStore::TextColumn::view(int row) const
+{
+    const quint16 length = m_lengths[size_t(row)];
+    if (length == 0) {
+        return QStringView();
+    }
+    const quint32 offset = m_offsets[size_t(row)];
+    return QStringView(m_blocks[offset >> BlockShift].get() + (offset & (BlockChars - 1)), length);
+}
+
+qint64 TrackStore::TextColumn::bytesUsed() const
+{
+    return qint64(m_blocks.size()) * BlockChars * qint64(sizeof(QChar))
+         + qint64(m_blocks.capacity()) * qint64(sizeof(void *))
+         + qint64(m_offsets.capacity()) * qint64(sizeof(quint32))
+         + qint64(m_lengths.capacity()) * qint64(sizeof(quint16));
+}
+
+QChar *TrackStore::TextColumn::allocate(quint16 length, quint32 *offset)
+{
+    // 一段文字不跨块，当前块放不下时开新块（块尾的空余不计入空洞）
+    if (m_blocks.empty() || m_blockUsed + length > BlockChars) {
+        m_blocks.emplace_back(new QChar[BlockChars]);
+        m_blockUsed = 0;
+    }
+    const quint32 block = quint32(m_blocks.size() - 1);
+    *offset = (block << BlockShift) | quint32(m_blockUsed);
+    QChar *data = m_blocks.back().get() + m_blockUsed;
+    m_blockUsed += length;
+    m_used += length;
+    return data;
+}
+
+void TrackStore::TextColumn::compact()
+{
+    std::vector<std::unique_ptr<QChar[]>> old;
+    old.swap(m_blocks);
+    m_used = 0;
+    m_waste = 0;
+    m_blockUsed = 0;
+    for (size_t row = 0; row < m_offsets.size(); ++row) {
+        const quint16 length = m_lengths[row];
+        if (length == 0) {
+            continue;
+        }
+        const quint32 offset = m_offsets[row];
+        const QChar *source = old[offset >> BlockShift].get() + (offset & (BlockChars - 1));
+        QChar *data = allocate(length, &m_offsets[row]);
+        std::copy(source, source + length, data);
+    }
+}
+
+// ---------------------------------------------------------------- TrackStore
+
+TrackStore::TrackStore()
+    : m_size(0)
+    , m_hashedRows(0)
+{
+    m_pathSlots.assign(MinSlots, PathSlot{-1, 0});
+    m_contentSlots.assign(MinSlots, -1);
+}
+
+void TrackStore::reserve(int rows)
+{
+    const size_t count = size_t(qMax(rows, 0));
+    m_live.reserve(count);
+    m_dirIds.reserve(count);
+    m_fileNames.reserve(rows);
+    m_titles.reserve(rows);
+    m_artistIds.reserve(count);
+    m_albumIds.reserve(count);
+    m_genreIds.reserve(count);
+    m_durations.reserve(count);
+    m_modified.reserve(count);
+    m_added.reserve(count);
+    m_contentHashes.reserve(count);
+    m_artHashes.reserve(count);
+    m_loudness.reserve(count);
+    m_stats.reserve(count);
+    if (slotCountFor(count) > m_pathSlots.size()) {
+        pathRehash(slotCountFor(count));
+    }
+}
+
+int TrackStore::find(const QString &filePath) const
+{
+    const int slash = filePath.lastIndexOf('/');
+    const int dirId = m_dirs.find(filePath.left(qMax(0, slash)));
+    if (dirId < 0) {
+        return -1;
+    }
+    const QStringView fileName = QStringView(filePath).mid(slash + 1);
+    const uint hash = hashPath(filePath);
+    const size_t mask = m_pathSlots.size() - 1;
+    for (size_t i = hash & mask; m_pathSlots[i].row >= 0; i = (i + 1) & mask) {
+        if (m_pathSlots[i].hash == hash && rowMatches(m_pathSlots[i].row, dirId, fileName)) {
+            return m_pathSlots[i].row;
+        }
+    }
+    return -1;
+}
+
+int TrackStore::insert(const MusicFile &file)
+{
+    const QString filePath = file.filePath();
+    int row = find(filePath);
+    if (row < 0) {
+        row = allocateRow();
+        const int slash = filePath.lastIndexOf('/');
+        m_dirIds[size_t(row)] = m_dirs.acquire(filePath.left(qMax(0, slash)));
+        m_fileNames.set(row, filePath.mid(slash + 1));
+        m_live[size_t(row)] = true;
+        ++m_size;
+        pathInsert(row, hashPath(filePath));
+    } else {
+        m_names.release(m_artistIds[size_t(row)]);
+        m_names.release(m_albumIds[size_t(row)]);
+        m_names.release(m_genreIds[size_t(row)]);
+    }
+
+    m_titles.set(row, file.title());
+    m_artistIds[size_t(row)] = m_names.acquire(file.artist());
+    m_albumIds[size_t(row)] = m_names.acquire(file.album());
+    m_genreIds[size_t(row)] = m_names.acquire(file.genre());
+    m_durations[size_t(row)] = file.duration();
+    m_modified[size_t(row)] = toMSecs(file.lastModified());
+    m_added[size_t(row)] = toSecs(file.dateAdded());
+    setContentHash(row, file.contentHash());
+    m_artHashes[size_t(row)] = file.artHash();
+    m_loudness[size_t(row)] = Loudness{file.trackLoudness(), file.trackPeak(),
+                                       file.albumLoudness(), file.albumPeak()};
+    m_stats[size_t(row)] = Stats{file.playCount(), file.skipCount(), toSecs(file.lastPlayed())};
+    return row;
+}
+
+void TrackStore::remove(int row)
+{
+    if (row < 0 || row >= rowCount() || !m_live[size_t(row)]) {
+        return;
+    }
+    pathRemove(row, hashPath(filePath(row)));
+    setContentHash(row, 0);
+    m_dirs.release(m_dirIds[size_t(row)]);
+    m_names.release(m_artistIds[size_t(row)]);
+    m_names.release(m_albumIds[size_t(row)]);
+    m_names.release(m_genreIds[size_t(row)]);
+    m_dirIds[size_t(row)] = 0;
+    m_artistIds[size_t(row)] = 0;
+    m_albumIds[size_t(row)] = 0;
+    m_genreIds[size_t(row)] = 0;
+    m_fileNames.reset(row);
+    m_titles.reset(row);
+    m_live[size_t(row)] = false;
+    m_freeRows.push_back(row);
+    --m_size;
+}
+
+void TrackStore::clear()
+{
+    *this = TrackStore();
+}
+
+MusicFile TrackStore::file(int row) const
+{
+    MusicFile file;
+    if (row < 0 || row >= rowCount() || !m_live[size_t(row)]) {
+        return file;
+    }
+    file.setFilePath(filePath(row));
+    file.setTitle(m_titles.value(row));
+    file.setArtist(m_names.value(m_artistIds[size_t(row)]));
+    file.setAlbum(m_names.value(m_albumIds[size_t(row)]));
+    file.setGenre(m_names.value(m_genreIds[size_t(row)]));
+    file.setDuration(m_durations[size_t(row)]);
+    file.setLastModified(fromMSecs(m_modified[size_t(row)]));
+    file.setDateAdded(fromSecs(m_added[size_t(row)]));
+    file.setContentHash(m_contentHashes[size_t(row)]);
+    file.setArtHash(m_artHashes[size_t(row)]);
+    const Loudness &loudness = m_loudness[size_t(row)];
+    file.setTrackLoudness(loudness.track, loudness.trackPeak);
+    file.setAlbumLoudness(loudness.album, loudness.albumPeak);
+    const Stats &stats = m_stats[size_t(row)];
+    file.setPlayCount(stats.playCount);
+    file.setSkipCount(stats.skipCount);
+    file.setLastPlayed(fromSecs(stats.lastPlayed));
+    return file;
+}
+
+QString TrackStore::filePath(int row) const
+{
+    const QString &dir = m_dirs.value(m_dirIds[size_t(row)]);
+    const QStringView fileName = m_fileNames.view(row);
+    QString path;
+    path.reserve(dir.size() + 1 + fileName.size());
+    path.append(dir);
+    path.append(QLatin1Char('/'));
+    path.append(fileName);
+    return path;
+}
+
+int TrackStore::comparePaths(int a, int b) const
+{
+    const QStringView nameA = m_fileNames.view(a);
+    const QStringView nameB = m_fileNames.view(b);
+    const quint32 dirA = m_dirIds[size_t(a)];
+    const quint32 dirB = m_dirIds[size_t(b)];
+    if (dirA == dirB) {
+        return nameA.compare(nameB);
+    }
+
+    // 逐个比较“目录 + '/' + 文件名”的 UTF-16 码元，目录互为前缀时分隔符也参与比较
+    const QString &pathA = m_dirs.value(dirA);
+    const QString &pathB = m_dirs.value(dirB);
+    auto at = [](const QString &dir, QStringView name, int i) {
+        return i < dir.size() ? dir.at(i) : i == dir.size() ? QChar('/') : name.at(i - dir.size() - 1);
+    };
+    const int lengthA = pathA.size() + 1 + nameA.size();
+    const int lengthB = pathB.size() + 1 + nameB.size();
+    for (int i = 0; i < qMin(lengthA, lengthB); ++i) {
+        const QChar x = at(pathA, nameA, i);
+        const QChar y = at(pathB, nameB, i);
+        if (x != y) {
+            return x < y ? -1 : 1;
+        }
+    }
+    return (lengthA > lengthB) - (lengthA < lengthB);
+}
+
+void TrackStore::setContentHash(int row, quint64 hash)
+{
+    if (m_contentHashes[size_t(row)] == hash) {
+        return;
+    }
+    // 先按旧哈希移出索引，再按新哈希加入
+    if (m_contentHashes[size_t(row)] != 0) {
+        contentRemove(row);
+    }
+    m_contentHashes[size_t(row)] = hash;
+    if (hash != 0) {
+        contentInsert(row);
+    }
+}
+
+QVector<int> TrackStore::rowsWithContentHash(quint64 hash) const
+{
+    QVector<int> rows;
+    if (hash == 0) {
+        return rows;
+    }
+    const size_t mask = m_contentSlots.size() - 1;
+    for (size_t i = homeOf(hash, mask); m_contentSlots[i] >= 0; i = (i + 1) & mask) {
+        if (m_contentHashes[size_t(m_contentSlots[i])] == hash) {
+            rows.append(m_contentSlots[i]);
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+void TrackStore::setTrackLoudness(int row, float loudness, float peak)
+{
+    m_loudness[size_t(row)].track = loudness;
+    m_loudness[size_t(row)].trackPeak = peak;
+}
+
+void TrackStore::setAlbumLoudness(int row, float loudness, float peak)
+{
+    m_loudness[size_t(row)].album = loudness;
+    m_loudness[size_t(row)].albumPeak = peak;
+}
+
+bool TrackStore::setPlayStats(int row, int playCount, int skipCount, const QDateTime &lastPlayed)
+{
+    const Stats stats{playCount, skipCount, toSecs(lastPlayed)};
+    Stats &current = m_stats[size_t(row)];
+    if (current.playCount == stats.playCount && current.skipCount == stats.skipCount
+        && current.lastPlayed == stats.lastPlayed) {
+        return false;
+    }
+    current = stats;
+    return true;
+}
+
+qint64 TrackStore::bytesUsed() const
+{
+    auto capacityOf = [](const auto &column) {
+        return qint64(column.capacity()) * qint64(sizeof(column[0]));
+    };
+    qint64 bytes = sizeof(TrackStore);
+    bytes += capacityOf(m_freeRows) + qint64(m_live.capacity() / 8);
+    bytes += m_dirs.bytesUsed() + capacityOf(m_dirIds) + m_fileNames.bytesUsed();
+    bytes += m_titles.bytesUsed() + m_names.bytesUsed();
+    bytes += capacityOf(m_artistIds) + capacityOf(m_albumIds) + capacityOf(m_genreIds);
+    bytes += capacityOf(m_durations) + capacityOf(m_modified) + capacityOf(m_added);
+    bytes += capacityOf(m_contentHashes) + capacityOf(m_artHashes);
+    bytes += capacityOf(m_loudness) + capacityOf(m_stats);
+    bytes += capacityOf(m_pathSlots) + capacityOf(m_contentSlots);
+    return bytes;
+}
+
+uint TrackStore::hashPath(QStringView filePath)
+{
+    return qHash(filePath);
+}
+
+size_t TrackStore::homeOf(quint64 contentHash, size_t mask)
+{
+    // 内容哈希本身已经均匀，乘法再混合一次，避免低位恰好相关
+    return size_t((contentHash * 0x9e3779b97f4a7c15ULL) >> 32) & mask;
+}
+
+qint64 TrackStore::toMSecs(const QDateTime &dateTime)
+{
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : InvalidTime;
+}
+
+QDateTime TrackStore::fromMSecs(qint64 msecs)
+{
+    return msecs == InvalidTime ? QDateTime() : QDateTime::fromMSecsSinceEpoch(msecs);
+}
+
+quint32 TrackStore::toSecs(const QDateTime &dateTime)
+{
+    if (!dateTime.isValid()) {
+        return 0;
+    }
+    return quint32(qBound<qint64>(1, dateTime.toSecsSinceEpoch(), std::numeric_limits<quint32>::max()));
+}
+
+QDateTime TrackStore::fromSecs(quint32 secs)
+{
+    return secs == 0 ? QDateTime() : QDateTime::fromSecsSinceEpoch(qint64(secs));
+}
+
+bool TrackStore::rowMatches(int row, int dirId, QStringView fileName) const
+{
+    return m_dirIds[size_t(row)] == quint32(dirId) && m_fileNames.view(row) == fileName;
+}
+
+void TrackStore::pathInsert(int row, uint hash)
+{
+    // 装载率保持在一半以下
+    if (size_t(m_size) * 2 > m_pathSlots.size()) {
+        pathRehash(m_pathSlots.size() * 2);
+    }
+    const size_t mask = m_pathSlots.size() - 1;
+    size_t i = hash & mask;
+    while (m_pathSlots[i].row >= 0) {
+        i = (i + 1) & mask;
+    }
+    m_pathSlots[i] = PathSlot{row, hash};
+}
+
+void TrackStore::pathRemove(int row, uint hash)
+{
+    const size_t mask = m_pathSlots.size() - 1;
+    size_t i = hash & mask;
+    while (m_pathSlots[i].row != row) {
+        if (m_pathSlots[i].row < 0) {
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+    eraseSlot(m_pathSlots, i, PathSlot{-1, 0},
+              [](const PathSlot &slot) { return slot.row < 0; },
+              [](const PathSlot &slot) { return size_t(slot.hash); });
+}
+
+void TrackStore::pathRehash(size_t slotCount)
+{
+    std::vector<PathSlot> old;
+    old.swap(m_pathSlots);
+    m_pathSlots.assign(qMax(slotCount, MinSlots), PathSlot{-1, 0});
+    const size_t mask = m_pathSlots.size() - 1;
+    for (const PathSlot &slot : old) {
+        if (slot.row >= 0) {
+            size_t i = slot.hash & mask;
+            while (m_pathSlots[i].row >= 0) {
+                i = (i + 1) & mask;
+            }
+            m_pathSlots[i] = slot;
+        }
+    }
+}
+
+void TrackStore::contentInsert(int row)
+{
+    if (size_t(m_hashedRows + 1) * 2 > m_contentSlots.size()) {
+        contentRehash(m_contentSlots.size() * 2);
+    }
+    const size_t mask = m_contentSlots.size() - 1;
+    size_t i = homeOf(m_contentHashes[size_t(row)], mask);
+    while (m_contentSlots[i] >= 0) {
+        i = (i + 1) & mask;
+    }
+    m_contentSlots[i] = row;
+    ++m_hashedRows;
+}
+
+void TrackStore::contentRemove(int row)
+{
+    const size_t mask = m_contentSlots.size() - 1;
+    size_t i = homeOf(m_contentHashes[size_t(row)], mask);
+    while (m_contentSlots[i] != row) {
+        if (m_contentSlots[i] < 0) {
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+    // 探测链上其他行的哈希仍在列中，按列中的值计算它们的起始位置
+    eraseSlot(m_contentSlots, i, qint32(-1),
+              [](qint32 slot) { return slot < 0; },
+              [this, mask](qint32 slot) { return homeOf(m_contentHashes[size_t(slot)], mask); });
+    --m_hashedRows;
+}
+
+void TrackStore::contentRehash(size_t slotCount)
+{
+    std::vector<qint32> old;
+    old.swap(m_contentSlots);
+    m_contentSlots.assign(qMax(slotCount, MinSlots), -1);
+    const size_t mask = m_contentSlots.size() - 1;
+    for (qint32 row : old) {
+        if (row >= 0) {
+            size_t i = homeOf(m_contentHashes[size_t(row)], mask);
+            while (m_contentSlots[i] >= 0) {
+                i = (i + 1) & mask;
+            }
+            m_contentSlots[i] = row;
+        }
+    }
+}
+
+int TrackStore::allocateRow()
+{
+    if (!m_freeRows.empty()) {
+        const int row = m_freeRows.back();
+        m_freeRows.pop_back();
+        return row;
+    }
+
+    const int row = rowCount();
+    const size_t rows = size_t(row) + 1;
+    m_live.resize(rows, false);
+    m_dirIds.resize(rows, 0);
+    m_fileNames.resize(int(rows));
+    m_titles.resize(int(rows));
+    m_artistIds.resize(rows, 0);
+    m_albumIds.resize(rows, 0);
+    m_genreIds.resize(rows, 0);
+    m_durations.resize(rows, 0);
+    m_modified.resize(rows, InvalidTime);
+    m_added.resize(rows, 0);
+    m_contentHashes.resize(rows, 0);
+    m_artHashes.resize(rows, 0);
+    m_loudness.resize(rows, Loudness{qQNaN(), 0, qQNaN(), 0});
+    m_stats.resize(rows, Stats{0, 0, 0});
+    return row;
+}
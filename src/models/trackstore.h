@@ -0,0 +1,174 @@
+#ifndef TRACKSTORE_H
+#define TRACKSTORE_H
+
+#include <QString>
+#include <QStringView>
+#include <QHash>
+#include <QVector>
+#include <memory>
+#include <vector>
+#include "musicfile.h"
+
+// 音乐库的列式存储
+// 每首歌占一行，各字段分别存放在连续数组中；艺术家、专辑、流派和所在目录在字符串池中只保存一份，
+// 行里只记录编号；标题和文件名放在分块的字符缓冲区中，行里只记录偏移和长度。
+// 路径和内容哈希的索引都是开放寻址哈希表，只保存行号，不再额外保存路径字符串。
+// 删除的行放入空闲列表复用，行号在删除前保持不变。
+class TrackStore
+{
+public:
+    TrackStore();
+
+    int size() const { return m_size; }
+    int rowCount() const { return int(m_dirIds.size()); }  // 包括已删除的行
+    bool isLive(int row) const { return m_live[size_t(row)]; }
+    void reserve(int rows);
+
+    int find(const QString &filePath) const;  // 不存在返回 -1
+    int insert(const MusicFile &file);        // 同路径已存在时覆盖，返回行号
+    void remove(int row);
+    void clear();
+
+    MusicFile file(int row) const;
+    QString filePath(int row) const;
+    int comparePaths(int a, int b) const;  // 与比较两行的完整路径结果相同，但不拼接字符串
+
+    // 按行读取单个字段，界面和索引模块不必另存一份
+    QString title(int row) const { return m_titles.value(row); }
+    const QString &artist(int row) const { return m_names.value(m_artistIds[size_t(row)]); }
+    const QString &album(int row) const { return m_names.value(m_albumIds[size_t(row)]); }
+    const QString &genre(int row) const { return m_names.value(m_genreIds[size_t(row)]); }
+    int duration(int row) const { return m_durations[size_t(row)]; }
+    qint64 lastModifiedMSecs(int row) const { return m_modified[size_t(row)]; }
+
+    quint64 contentHash(int row) const { return m_contentHashes[size_t(row)]; }
+    void setContentHash(int row, quint64 hash);
+    QVector<int> rowsWithContentHash(quint64 hash) const;  // 内容相同的所有行，按行号排序
+    quint64 artHash(int row) const { return m_artHashes[size_t(row)]; }
+    void setArtHash(int row, quint64 hash) { m_artHashes[size_t(row)] = hash; }
+    bool hasLoudness(int row) const { return !qIsNaN(m_loudness[size_t(row)].track); }
+    void setTrackLoudness(int row, float loudness, float peak);
+    void setAlbumLoudness(int row, float loudness, float peak);
+    int playCount(int row) const { return m_stats[size_t(row)].playCount; }
+    int skipCount(int row) const { return m_stats[size_t(row)].skipCount; }
+    QDateTime lastPlayed(int row) const { return fromSecs(m_stats[size_t(row)].lastPlayed); }
+    bool setPlayStats(int row, int playCount, int skipCount, const QDateTime &lastPlayed);  // 有变化时返回 true
+
+    // 估算占用的内存（按容量计算，包括字符串池、字符缓冲区和索引）
+    qint64 bytesUsed() const;
+    // 其中标题文字占用的部分
+    qint64 titleBytes() const { return m_titles.textBytes(); }
+
+private:
+    // 引用计数的字符串池，编号 0 表示空字符串
+    class StringPool
+    {
+    public:
+        StringPool();
+        quint32 acquire(const QString &text);
+        void release(quint32 id);
+        int find(const QString &text) const;  // 不存在返回 -1
+        const QString &value(quint32 id) const { return m_strings[int(id)]; }
+        qint64 bytesUsed() const;
+
+    private:
+        QVector<QString> m_strings;
+        QVector<quint32> m_refs;
+        QVector<quint32> m_free;
+        QHash<QString, quint32> m_ids;
+    };
+
+    // 多行文字存放在固定大小的块中（不会因扩容而多占一倍内存），修改或删除留下的空洞超过一半时整理
+    class TextColumn
+    {
+    public:
+        void resize(int rows);
+        void reserve(int rows);
+        void set(int row, const QString &text);
+        void reset(int row);
+        QString value(int row) const { return view(row).toString(); }
+        QStringView view(int row) const;
+        qint64 bytesUsed() const;
+        qint64 textBytes() const { return (m_used - m_waste) * qint64(sizeof(QChar)); }
+
+    private:
+        QChar *allocate(quint16 length, quint32 *offset);
+        void compact();
+
+        std::vector<std::unique_ptr<QChar[]>> m_blocks;
+        std::vector<quint32> m_offsets;  // 块号 × 块大小 + 块内偏移
+        std::vector<quint16> m_lengths;
+        qint64 m_used = 0;   // 已分配的字符数（含空洞）
+        qint64 m_waste = 0;  // 空洞字符数
+        int m_blockUsed = 0;
+    };
+
+    struct Loudness
+    {
+        float track;
+        float trackPeak;
+        float album;
+        float albumPeak;
+    };
+
+    struct Stats
+    {
+        qint32 playCount;
+        qint32 skipCount;
+        quint32 lastPlayed;  // 秒级时间戳，0 表示从未播放
+    };
+
+    struct PathSlot
+    {
+        qint32 row;  // -1 表示空位
+        uint hash;
+    };
+
+    static uint hashPath(QStringView filePath);
+    static size_t homeOf(quint64 contentHash, size_t mask);
+    static qint64 toMSecs(const QDateTime &dateTime);
+    static QDateTime fromMSecs(qint64 msecs);
+    static quint32 toSecs(const QDateTime &dateTime);
+    static QDateTime fromSecs(quint32 secs);
+    bool rowMatches(int row, int dirId, QStringView fileName) const;
+    void pathInsert(int row, uint hash);
+    void pathRemove(int row, uint hash);
+    void pathRehash(size_t slotCount);
+    void contentInsert(int row);
+    void contentRemove(int row);
+    void contentRehash(size_t slotCount);
+    int allocateRow();
+
+private:
+    int m_size;
+    std::vector<int> m_freeRows;
+    std::vector<bool> m_live;
+
+    // 路径：目录编号 + 文件名
+    StringPool m_dirs;
+    std::vector<quint32> m_dirIds;
+    TextColumn m_fileNames;
+
+    // 元数据
+    TextColumn m_titles;
+    StringPool m_names;  // 艺术家、专辑、流派共用一个池
+    std::vector<quint32> m_artistIds;
+    std::vector<quint32> m_albumIds;
+    std::vector<quint32> m_genreIds;
+    std::vector<qint32> m_durations;
+    std::vector<qint64> m_modified;  // 毫秒，与文件系统时间逐一比较，不能降低精度
+    std::vector<quint32> m_added;    // 秒
+
+    // 分析结果与统计
+    std::vector<quint64> m_contentHashes;
+    std::vector<quint64> m_artHashes;
+    std::vector<Loudness> m_loudness;
+    std::vector<Stats> m_stats;
+
+    // 索引：容量为 2 的幂，线性探测，装载率不超过一半
+    std::vector<PathSlot> m_pathSlots;
+    std::vector<qint32> m_contentSlots;  // 内容哈希非 0 的行，哈希值从列中读取
+    int m_hashedRows;
+};
+
+#endif // TRACKSTORE_H
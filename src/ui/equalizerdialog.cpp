@@ -0,0 +1,136 @@
+#include "equalizerdialog.h"
+#include <QCheckBox>
+#include <QDialogButtonBox>
+#include <QGridLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QSlider>
+#include <QVBoxLayout>
+
+namespace {
+const char *const BandNames[EqualizerDialog::BandCount] = {
+    "31", "62", "125", "250", "500", "1K", "2K", "4K", "8K", "16K"
+};
+
+QSlider *createGainSlider(QWidget *parent)
+{
+    QSlider *slider = new QSlider(Qt::Vertical, parent);
+    slider->setRange(-EqualizerDialog::MaxGain, EqualizerDialog::MaxGain);
+    slider->setTickPosition(QSlider::TicksBothSides);
+    slider->setTickInterval(6);
+    slider->setMinimumHeight(160);
+    return slider;
+}
+
+QString gainText(int gain)
+{
+    return gain > 0 ? QString("+%1").arg(gain) : QString::number(gain);
+}
+}
+
+EqualizerDialog::EqualizerDialog(QWidget *parent)
+    : QDialog(parent)
+    , m_enabled(new QCheckBox(tr("启用均衡器"), this))
+    , m_limiter(new QCheckBox(tr("限幅器（防止削波）"), this))
+    , m_preamp(createGainSlider(this))
+    , m_preampLabel(new QLabel(this))
+    , m_updating(false)
+{
+    setWindowTitle(tr("均衡器"));
+    setWindowModality(Qt::NonModal);
+
+    // 每一列：数值、滑块、频率
+    QGridLayout *grid = new QGridLayout;
+    grid->addWidget(m_preampLabel, 0, 0, Qt::AlignHCenter);
+    grid->addWidget(m_preamp, 1, 0, Qt::AlignHCenter);
+    grid->addWidget(new QLabel(tr("前级"), this), 2, 0, Qt::AlignHCenter);
+    grid->setColumnMinimumWidth(1, 16);
+    for (int i = 0; i < BandCount; ++i) {
+        QSlider *slider = createGainSlider(this);
+        QLabel *label = new QLabel(this);
+        grid->addWidget(label, 0, i + 2, Qt::AlignHCenter);
+        grid->addWidget(slider, 1, i + 2, Qt::AlignHCenter);
+        grid->addWidget(new QLabel(BandNames[i], this), 2, i + 2, Qt::AlignHCenter);
+        m_bands.append(slider);
+        m_bandLabels.append(label);
+        connect(slider, &QSlider::valueChanged, this, &EqualizerDialog::onChanged);
+    }
+    connect(m_preamp, &QSlider::valueChanged, this, &EqualizerDialog::onChanged);
+    connect(m_enabled, &QCheckBox::toggled, this, &EqualizerDialog::onChanged);
+    connect(m_limiter, &QCheckBox::toggled, this, &EqualizerDialog::onChanged);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    QPushButton *resetButton = buttons->addButton(tr("归零"), QDialogButtonBox::ResetRole);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::hide);
+    connect(resetButton, &QPushButton::clicked, this, [this]() {
+        m_updating = true;
+        m_preamp->setValue(0);
+        for (QSlider *slider : qAsConst(m_bands)) {
+            slider->setValue(0);
+        }
+        m_updating = false;
+        onChanged();
+    });
+
+    QHBoxLayout *options = new QHBoxLayout;
+    options->addWidget(m_enabled);
+    options->addStretch();
+    options->addWidget(m_limiter);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(options);
+    layout->addLayout(grid);
+    layout->addWidget(buttons);
+
+    m_limiter->setChecked(true);
+    updateLabels();
+}
+
+DspChain::Parameters EqualizerDialog::parameters() const
+{
+    float gains[BandCount];
+    for (int i = 0; i < BandCount; ++i) {
+        gains[i] = float(m_bands.at(i)->value());
+    }
+    DspChain::Parameters parameters = DspChain::graphicEqualizer(gains);
+    parameters.equalizer = m_enabled->isChecked();
+    parameters.preamp = float(m_preamp->value());
+    parameters.limiter = m_limiter->isChecked();
+    return parameters;
+}
+
+void EqualizerDialog::setParameters(const DspChain::Parameters &parameters)
+{
+    m_updating = true;
+    m_enabled->setChecked(parameters.equalizer);
+    m_limiter->setChecked(parameters.limiter);
+    m_preamp->setValue(qRound(parameters.preamp));
+    for (int i = 0; i < BandCount; ++i) {
+        m_bands.at(i)->setValue(i < parameters.bandCount ? qRound(parameters.bands[i].gain) : 0);
+    }
+    m_updating = false;
+    updateLabels();
+}
+
+void EqualizerDialog::updateLabels()
+{
+    m_preampLabel->setText(gainText(m_preamp->value()));
+    for (int i = 0; i < BandCount; ++i) {
+        m_bandLabels.at(i)->setText(gainText(m_bands.at(i)->value()));
+    }
+    const bool enabled = m_enabled->isChecked();
+    m_preamp->setEnabled(enabled);
+    for (QSlider *slider : qAsConst(m_bands)) {
+        slider->setEnabled(enabled);
+    }
+}
+
+void EqualizerDialog::onChanged()
+{
+    if (m_updating) {
+        return;
+    }
+    updateLabels();
+    emit parametersChanged(parameters());
+}
@@ -0,0 +1,42 @@
+#ifndef EQUALIZERDIALOG_H
+#define EQUALIZERDIALOG_H
+
+#include <QDialog>
+#include <QList>
+#include "core/dspchain.h"
+
+class QCheckBox;
+class QLabel;
+class QSlider;
+
+// 10 段图示均衡器窗口（非模态）
+// 拖动滑块时立即发出 parametersChanged，由 DSP 链在音频线程中平滑过渡
+class EqualizerDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    enum { BandCount = 10, MaxGain = 12 };
+
+    explicit EqualizerDialog(QWidget *parent = nullptr);
+
+    DspChain::Parameters parameters() const;
+    void setParameters(const DspChain::Parameters &parameters);
+
+signals:
+    void parametersChanged(const DspChain::Parameters &parameters);
+
+private:
+    void updateLabels();
+    void onChanged();
+
+private:
+    QCheckBox *m_enabled;
+    QCheckBox *m_limiter;
+    QSlider *m_preamp;
+    QLabel *m_preampLabel;
+    QList<QSlider *> m_bands;
+    QList<QLabel *> m_bandLabels;
+    bool m_updating;  // setParameters() 期间不发出信号
+};
+
+#endif // EQUALIZERDIALOG_H
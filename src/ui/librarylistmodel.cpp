@@ -0,0 +1,215 @@
+#include "librarylistmodel.h"
+#include "models/musiclibrary.h"
+#include <QFont>
+#include <QBrush>
+#include <QDebug>
+#include <climits>
+
+LibraryListModel::LibraryListModel(MusicLibrary *library, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_library(library)
+{
+    // 元数据探测完成后重绘对应的行；顺序变化由 LibraryView 另行通知
+    connect(m_library, &MusicLibrary::fileUpdated, this, &LibraryListModel::refresh);
+}
+
+void LibraryListModel::setRows(const QStringList &paths, const QVector<LibraryView::Group> &groups)
+{
+    beginResetModel();
+    m_items = buildItems(paths, groups);
+    endResetModel();
+}
+
+void LibraryListModel::applyRows(const QStringList &paths, const QVector<LibraryView::Group> &groups,
+                                 const QSet<QString> &removed)
+{
+    const QVector<Item> items = buildItems(paths, groups);
+
+    // 从后往前标记保留的行：分组标题之后直到下一个同级或更高级标题之间还有歌曲时才保留
+    QVector<bool> keep(m_items.size());
+    int nextDepth = -1;  // 后面第一个保留的行的层级，歌曲视为最深，-1 表示已到末尾
+    for (int row = m_items.size() - 1; row >= 0; --row) {
+        const Item &item = m_items.at(row);
+        if (!item.path.isEmpty()) {
+            keep[row] = !removed.contains(item.path);
+            if (keep[row]) {
+                nextDepth = INT_MAX;
+            }
+        } else {
+            keep[row] = nextDepth > item.depth;
+            if (keep[row]) {
+                nextDepth = item.depth;
+            }
+        }
+    }
+
+    // 连续删除的行合并为一次通知
+    for (int last = m_items.size() - 1; last >= 0; --last) {
+        if (keep.at(last)) {
+            continue;
+        }
+        int first = last;
+        while (first > 0 && !keep.at(first - 1)) {
+            --first;
+        }
+        beginRemoveRows(QModelIndex(), first, last);
+        m_items.remove(first, last - first + 1);
+        endRemoveRows();
+        last = first;
+    }
+
+    // 保留下来的行是新列表的子序列，逐个对齐，不匹配的连续新行一次插入
+    int current = 0;
+    for (int row = 0; row < items.size();) {
+        if (current < m_items.size() && sameItem(m_items.at(current), items.at(row))) {
+            m_items[current] = items.at(row);  // 分组的歌曲数可能变了
+            ++current;
+            ++row;
+            continue;
+        }
+        int end = row + 1;
+        while (end < items.size() && !(current < m_items.size() && sameItem(m_items.at(current), items.at(end)))) {
+            ++end;
+        }
+        beginInsertRows(QModelIndex(), current, current + end - row - 1);
+        m_items.insert(current, end - row, Item());
+        for (; row < end; ++row, ++current) {
+            m_items[current] = items.at(row);
+        }
+        endInsertRows();
+    }
+
+    if (current != m_items.size()) {
+        // 不应发生：说明顺序并非只有增删，退回整体刷新
+        qWarning() << "音乐库列表增量更新失败，整体刷新";
+        setRows(paths, groups);
+        return;
+    }
+    if (!m_items.isEmpty()) {
+        emit dataChanged(index(0), index(m_items.size() - 1), {Qt::DisplayRole});
+    }
+}
+
+QString LibraryListModel::filePath(int row) const
+{
+    if (row < 0 || row >= m_items.size()) {
+        return QString();
+    }
+    return m_items.at(row).path;
+}
+
+int LibraryListModel::rowOf(const QString &filePath) const
+{
+    for (int row = 0; row < m_items.size(); ++row) {
+        if (m_items.at(row).path == filePath) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+int LibraryListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_items.size();
+}
+
+QVariant LibraryListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_items.size()) {
+        return QVariant();
+    }
+    const Item &item = m_items.at(index.row());
+
+    // 分组标题：加粗，不可选中
+    if (item.path.isEmpty()) {
+        switch (role) {
+        case Qt::DisplayRole: {
+            const QString label = item.label.isEmpty() ? tr("未知") : item.label;
+            return QString(item.depth * 4, ' ') + QString("%1 (%2)").arg(label).arg(item.count);
+        }
+        case Qt::FontRole: {
+            QFont font;
+            font.setBold(true);
+            return font;
+        }
+        default:
+            return QVariant();
+        }
+    }
+
+    switch (role) {
+    case Qt::DisplayRole: {
+        const MusicFile musicFile = m_library->file(item.path);
+        QString displayText = musicFile.title();
+        if (!musicFile.artist().isEmpty()) {
+            displayText = musicFile.artist() + " - " + musicFile.title();
+        }
+        // 内容重复的歌曲标出，只保留路径最小的一份不标
+        const QStringList duplicates = m_library->duplicatesOf(item.path);
+        if (!duplicates.isEmpty() && duplicates.first() < item.path) {
+            displayText += tr(" (重复)");
+        }
+        return displayText;
+    }
+    case Qt::ToolTipRole:
+        return item.path;
+    case Qt::ForegroundRole: {
+        const QStringList duplicates = m_library->duplicatesOf(item.path);
+        if (!duplicates.isEmpty() && duplicates.first() < item.path) {
+            return QBrush(Qt::gray);
+        }
+        return QVariant();
+    }
+    default:
+        return QVariant();
+    }
+}
+
+Qt::ItemFlags LibraryListModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.row() >= m_items.size()) {
+        return Qt::NoItemFlags;
+    }
+    if (m_items.at(index.row()).path.isEmpty()) {
+        return Qt::ItemIsEnabled;
+    }
+    return QAbstractListModel::flags(index);
+}
+
+QVector<LibraryListModel::Item> LibraryListModel::buildItems(const QStringList &paths,
+                                                            const QVector<LibraryView::Group> &groups)
+{
+    QVector<Item> items;
+    items.reserve(paths.size() + groups.size());
+    int nextGroup = 0;
+    for (int row = 0; row < paths.size(); ++row) {
+        for (; nextGroup < groups.size() && groups.at(nextGroup).first == row; ++nextGroup) {
+            const LibraryView::Group &group = groups.at(nextGroup);
+            Item header;
+            header.label = group.label;
+            header.depth = group.depth;
+            header.count = group.count;
+            items.append(header);
+        }
+        Item item;
+        item.path = paths.at(row);
+        items.append(item);
+    }
+    return items;
+}
+
+bool LibraryListModel::sameItem(const Item &a, const Item &b)
+{
+    if (a.path.isEmpty() || b.path.isEmpty()) {
+        return a.path.isEmpty() && b.path.isEmpty() && a.depth == b.depth && a.label == b.label;
+    }
+    return a.path == b.path;
+}
+
+void LibraryListModel::refresh()
+{
+    // 不维护路径到行号的索引：只有可见的行会重新读取数据，整体通知的代价与可见行数成正比
+    if (!m_items.isEmpty()) {
+        emit dataChanged(index(0), index(m_items.size() - 1), {Qt::DisplayRole, Qt::ForegroundRole});
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef LIBRARYLISTMODEL_H
+#define LIBRARYLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include <QSet>
+#include <QStringList>
+#include "models/libraryview.h"
+
+class MusicLibrary;
+
+// 音乐库列表的数据模型：每行只保存文件路径（或分组标题），显示文字在绘制时才从音乐库读取，
+// 百万首歌曲也不需要为每一行创建界面对象；切换搜索结果和排序结果只替换路径列表。
+class LibraryListModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit LibraryListModel(MusicLibrary *library, QObject *parent = nullptr);
+
+    // 整体替换列表内容；groups 中的 first 是 paths 的下标，标题行插在该歌曲之前
+    void setRows(const QStringList &paths, const QVector<LibraryView::Group> &groups = QVector<LibraryView::Group>());
+    // 少量变化：先删除 removed 中的歌曲和因此变空的分组，再插入新出现的行，其余行保持不动，
+    // 选中状态和滚动位置不受影响。对应 LibraryView::rowsChanged
+    void applyRows(const QStringList &paths, const QVector<LibraryView::Group> &groups, const QSet<QString> &removed);
+
+    QString filePath(int row) const;  // 分组标题和越界的行返回空字符串
+    int rowOf(const QString &filePath) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+private:
+    // path 为空的行是分组标题
+    struct Item
+    {
+        QString path;
+        QString label;
+        int depth = 0;
+        int count = 0;
+    };
+
+    static QVector<Item> buildItems(const QStringList &paths, const QVector<LibraryView::Group> &groups);
+    static bool sameItem(const Item &a, const Item &b);
+    void refresh();
+
+private:
+    MusicLibrary *m_library;  // 不拥有此指针
+    QVector<Item> m_items;
+};
+
+#endif // LIBRARYLISTMODEL_H
@@ -1,14 +1,72 @@
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
+#include "core/duplicateanalyzer.h"
+#include "core/loudnessanalyzer.h"
+#include "core/waveformcache.h"
+#include "core/seektablecache.h"
+#include "core/trackheadcache.h"
+#include "core/albumartcache.h"
+#include "core/metadataprober.h"
+#include "core/libraryscanner.h"
+#include "core/controlserver.h"
+#include "core/playstatslog.h"
+#include "core/trackvalidator.h"
+#include "models/searchindex.h"
+#include "models/libraryview.h"
+#include "models/smartplaylist.h"
+#include "models/playlistfile.h"
+#include "models/playlistmanager.h"
+#include "ui/equalizerdialog.h"
+#include "ui/librarylistmodel.h"
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QDir>
 #include <QDirIterator>
 #include <QStandardPaths>
 #include <QProgressDialog>
+#include <QInputDialog>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QActionGroup>
+#include <QListWidget>
+#include <QScrollBar>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QDateTime>
 #include <QDebug>
 #include <QSettings>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QSet>
+#include <cerrno>
+
+namespace {
+// 搜索结果只显示相关度最高的一部分，列表控件无法流畅显示上百万行
+const int MaxSearchResults = 5000;
+
+// 占位条目探测完成后攒一批再刷新播放列表显示
+const int ProbeFlushInterval = 300;
+
+// 滚动停下一小段时间后再更新探测优先级；即将播放的歌曲优先探测的数量
+const int ProbePriorityInterval = 50;
+const int UpcomingProbeCount = 5;
+
+// 播放列表控件逐行增删的上限，超过后整体重建更快
+const int MaxPlaylistItemEdits = 256;
+
+// 播放错误报告保留的条数
+const int MaxErrorEntries = 500;
+
+const QStringList MusicNameFilters = {"*.mp3", "*.wav", "*.flac"};
+
+QString playlistItemText(const MusicFile &file)
+{
+    if (file.artist().isEmpty()) {
+        return file.title();
+    }
+    return file.artist() + " - " + file.title();
+}
+}
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -21,11 +79,85 @@ MainWindow::MainWindow(QWidget *parent)
     , m_progressTimer(new QTimer(this))
     , m_lastPosition(0)
     , m_isUserSeeking(false)
+    , m_library(new MusicLibrary(this))
+    , m_duplicateAnalyzer(new DuplicateAnalyzer(m_library, this))
+    , m_duplicateProgress(nullptr)
+    , m_loudnessAnalyzer(new LoudnessAnalyzer(m_library, this))
+    , m_waveformCache(new WaveformCache(this))
+    , m_seekTables(new SeekTableCache(this))
+    , m_headCache(new TrackHeadCache(this))
+    , m_albumArtCache(new AlbumArtCache(m_library, this))
+    , m_searchIndex(nullptr)
+    , m_libraryView(nullptr)
+    , m_libraryModel(nullptr)
+    , m_smartPlaylists(nullptr)
+    , m_metadataProber(new MetadataProber(this))
+    , m_libraryScanner(new LibraryScanner(this))
+    , m_controlServer(new ControlServer(this))
+    , m_playlistManager(new PlaylistManager(m_library, this))
+    , m_probeFlushTimer(new QTimer(this))
+    , m_probePriorityTimer(new QTimer(this))
+    , m_playStatsLog(new PlayStatsLog(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation), this))
+    , m_trackValidator(new TrackValidator(m_playlist, this))
+    , m_equalizer(nullptr)
+    , m_errorReport(nullptr)
+    , m_errorList(nullptr)
 {
     ui->setupUi(this);
+    ui->coverLabel->installEventFilter(this);
     
     // 设置播放器的播放列表
     m_player->setPlaylist(m_playlist);
+    m_player->setLibrary(m_library);
+    m_player->setStatsLog(m_playStatsLog);
+    m_player->setValidator(m_trackValidator);
+    m_player->setSeekTables(m_seekTables);
+    m_player->setHeadCache(m_headCache);
+    
+    // 先载入音乐库缓存，已扫描过且未修改的文件不必重新探测元数据
+    m_library->load(libraryCachePath());
+    m_searchIndex = new SearchIndex(m_library, this);
+    m_libraryView = new LibraryView(m_library, this);
+    m_libraryModel = new LibraryListModel(m_library, this);
+    ui->libraryWidget->setModel(m_libraryModel);
+    m_smartPlaylists = new SmartPlaylists(m_library, this);
+    m_smartPlaylists->load();
+    updateSmartPlaylistMenu();
+    
+    // 播放统计由后台线程汇总，汇总结果写回音乐库供智能列表和排序使用
+    connect(m_playStatsLog, &PlayStatsLog::statsChanged, this, [this](const QStringList &paths) {
+        for (const QString &path : paths) {
+            const PlayStatsLog::Stats stats = m_playStatsLog->stats(path);
+            m_library->setPlayStats(path, stats.playCount, stats.skipCount,
+                                    stats.lastPlayed > 0 ? QDateTime::fromMSecsSinceEpoch(stats.lastPlayed) : QDateTime());
+        }
+    });
+    m_playStatsLog->start();
+    
+    // 音乐库排序方式
+    ui->sortCombo->addItem(tr("按文件名"));
+    ui->sortCombo->addItem(tr("按标题"));
+    ui->sortCombo->addItem(tr("艺术家 / 专辑"));
+    ui->sortCombo->addItem(tr("按流派"));
+    ui->sortCombo->addItem(tr("按时长"));
+    ui->sortCombo->addItem(tr("按修改时间"));
+    ui->sortCombo->addItem(tr("按播放次数"));
+    
+    // 音量均衡：关闭 / 按单曲 / 按专辑三选一，选择立即保存
+    QActionGroup *gainGroup = new QActionGroup(this);
+    gainGroup->setExclusive(true);
+    ui->actionReplayGainOff->setData(static_cast<int>(MusicPlayer::GainOff));
+    ui->actionReplayGainTrack->setData(static_cast<int>(MusicPlayer::GainTrack));
+    ui->actionReplayGainAlbum->setData(static_cast<int>(MusicPlayer::GainAlbum));
+    gainGroup->addAction(ui->actionReplayGainOff);
+    gainGroup->addAction(ui->actionReplayGainTrack);
+    gainGroup->addAction(ui->actionReplayGainAlbum);
+    connect(gainGroup, &QActionGroup::triggered, this, [this](QAction *action) {
+        const int mode = action->data().toInt();
+        m_player->setReplayGainMode(static_cast<MusicPlayer::ReplayGainMode>(mode));
+        QSettings settings("YinYue", "MusicPlayer");
+        settings.setValue("replayGainMode", mode);
+    });
     
     setupConnections();
     
@@ -66,6 +198,10 @@ void MainWindow::setupConnections()
     connect(m_player, &MusicPlayer::positionChanged, this, &MainWindow::updatePosition);
     connect(m_player, &MusicPlayer::durationChanged, this, &MainWindow::updateDuration);
     connect(m_player, &MusicPlayer::errorOccurred, this, &MainWindow::handleError);
+    connect(m_player, &MusicPlayer::currentSongChanged, m_trackValidator, &TrackValidator::refresh);
+    connect(m_trackValidator, &TrackValidator::trackFailed, this, [this](const QString &filePath, const QString &error) {
+        addErrorReportEntry(QString("%1  %2").arg(QFileInfo(filePath).fileName(), error));
+    });
     
     // 连接歌曲改变信号
     connect(m_player, &MusicPlayer::currentSongChanged, this, [this](int index) {
@@ -77,6 +213,9 @@ void MainWindow::setupConnections()
     
     // 连接播放列表信号
     connect(m_playlist, &Playlist::playlistChanged, m_player, &MusicPlayer::onPlaylistChanged);
+    connect(m_playlist, &Playlist::filesInserted, this, &MainWindow::onPlaylistFilesInserted);
+    connect(m_playlist, &Playlist::filesRemoved, this, &MainWindow::onPlaylistFilesRemoved);
+    connect(m_playlist, &Playlist::filesMoved, this, &MainWindow::onPlaylistFilesMoved);
     
     // 连接文件监控信号
     connect(m_fileWatcher, &QFileSystemWatcher::directoryChanged,
@@ -87,6 +226,16 @@ void MainWindow::setupConnections()
     // 连接位置更新信号到歌词更新槽
     connect(m_player, &MusicPlayer::positionChanged, this, &MainWindow::updateLyric);
     
+    // 频谱显示：看得见时才让播放器写 PCM 副本；输出设备第一次打开后才知道格式
+    ui->spectrumWidget->setTap(m_player->pcmTap());
+    connect(ui->spectrumWidget, &SpectrumWidget::activeChanged, m_player, &MusicPlayer::setPcmTapEnabled);
+    connect(m_player, &MusicPlayer::mediaStatusChanged, this, [this](QMediaPlayer::MediaStatus status) {
+        if (status == QMediaPlayer::BufferedMedia) {
+            const QAudioFormat format = m_player->outputFormat();
+            ui->spectrumWidget->setFormat(format.sampleRate(), format.channelCount());
+        }
+    });
+    
     // 设置歌词显示区域的样式
     ui->lyricEdit->setStyleSheet(
         "QTextEdit {"
@@ -107,14 +256,16 @@ void MainWindow::setupConnections()
     adjustLyricFontSize();
     
     // 进度条相关连接
+    // 拖动中的跳转由播放器合并，松开时跳到最终位置
     connect(ui->progressSlider, &QSlider::sliderPressed, this, [this]() {
         m_isUserSeeking = true;
         stopProgressTimer();
+        m_player->beginScrub();
     });
     
     connect(ui->progressSlider, &QSlider::sliderReleased, this, [this]() {
         m_isUserSeeking = false;
-        m_player->setPosition(ui->progressSlider->value());
+        m_player->endScrub(ui->progressSlider->value());
         if (m_isPlaying) {
             startProgressTimer();
         }
@@ -122,122 +273,404 @@ void MainWindow::setupConnections()
     
     // 连接播放模式信号
     connect(m_player, &MusicPlayer::playModeChanged, this, &MainWindow::updatePlayModeButton);
+    
+    // 鼠标停留的播放列表行可能马上被双击播放，提前准备开头
+    ui->playlistWidget->setMouseTracking(true);
+    connect(ui->playlistWidget, &QListWidget::itemEntered, this, [this](QListWidgetItem *item) {
+        m_headCache->setHovered(item->toolTip());
+    });
+    
+    // 波形生成后绘制到进度条背后
+    connect(m_waveformCache, &WaveformCache::waveformReady, this, [this](const QString &filePath) {
+        if (filePath == m_currentFilePath) {
+            ui->progressSlider->setWaveform(m_waveformCache->waveform(filePath));
+        }
+    });
+    
+    // 音乐库视图排好序后刷新列表（搜索时列表按相关度排列，不受影响）
+    connect(m_libraryView, &LibraryView::orderChanged, this, [this]() {
+        if (ui->searchEdit->text().trimmed().isEmpty()) {
+            updateLibraryView();
+        }
+    });
+    // 少量增删只插入、删除变化的行，不重建整个列表
+    connect(m_libraryView, &LibraryView::rowsChanged, this, [this](const QSet<QString> &removed) {
+        if (ui->searchEdit->text().trimmed().isEmpty()) {
+            m_libraryModel->applyRows(m_libraryView->filePaths(), m_libraryView->groups(), removed);
+            m_probePriorityTimer->start();
+        }
+    });
+    
+    // 目录扫描在后台完成
+    connect(m_libraryScanner, &LibraryScanner::rootFinished, this, &MainWindow::applyLibraryScan);
+    connect(m_libraryScanner, &LibraryScanner::rootProgress, this, [this](const QString &root, int scanned, int total) {
+        ui->statusbar->showMessage(tr("正在扫描 %1：%2 / %3").arg(root).arg(scanned).arg(total), 3000);
+    });
+    
+    // 控制接口：第二次启动的程序和外部脚本发来的命令
+    connect(m_controlServer, &ControlServer::openRequested, this, [this](const QStringList &paths) {
+        openPaths(paths, true);
+        setWindowState(windowState() & ~Qt::WindowMinimized);
+        show();
+        raise();
+        activateWindow();
+    });
+    connect(m_controlServer, &ControlServer::enqueueRequested, this, [this](const QStringList &paths) {
+        openPaths(paths, false);
+    });
+    connect(m_controlServer, &ControlServer::playRequested, this, [this]() {
+        if (!m_isPlaying) {
+            on_playButton_clicked();
+        }
+    });
+    connect(m_controlServer, &ControlServer::pauseRequested, this, [this]() {
+        if (m_isPlaying) {
+            m_player->pause();
+        }
+    });
+    connect(m_controlServer, &ControlServer::stopRequested, m_player, &MusicPlayer::stop);
+    connect(m_controlServer, &ControlServer::nextRequested, this, &MainWindow::on_nextButton_clicked);
+    connect(m_controlServer, &ControlServer::previousRequested, this, &MainWindow::on_previousButton_clicked);
+    connect(m_controlServer, &ControlServer::seekRequested, m_player, &MusicPlayer::setPosition);
+    m_controlServer->setStateProvider([this]() {
+        ControlProtocol::PlayerState state;
+        state.state = m_player->state();
+        state.position = m_player->position();
+        state.duration = m_player->duration();
+        state.volume = m_player->volume();
+        state.currentIndex = m_playlist->currentIndex();
+        state.count = m_playlist->count();
+        if (state.currentIndex >= 0 && state.currentIndex < state.count) {
+            state.filePath = m_playlist->at(state.currentIndex).filePath();
+        }
+        return state;
+    });
+    m_controlServer->listen();
+    
+    // 占位条目的元数据探测完成后批量刷新播放列表
+    m_probeFlushTimer->setSingleShot(true);
+    m_probeFlushTimer->setInterval(ProbeFlushInterval);
+    connect(m_metadataProber, &MetadataProber::probed, this, [this](const MusicFile &file) {
+        m_probedFiles.insert(file.filePath(), file);
+        if (!m_probeFlushTimer->isActive()) {
+            m_probeFlushTimer->start();
+        }
+    });
+    connect(m_probeFlushTimer, &QTimer::timeout, this, &MainWindow::applyProbedFiles);
+    
+    // 界面上可见和即将播放的条目优先探测，滚走的条目回到后台队列
+    m_probePriorityTimer->setSingleShot(true);
+    m_probePriorityTimer->setInterval(ProbePriorityInterval);
+    connect(m_probePriorityTimer, &QTimer::timeout, this, &MainWindow::updateProbePriorities);
+    auto scheduleProbePriorities = [this]() {
+        m_probePriorityTimer->start();
+    };
+    connect(ui->libraryWidget->verticalScrollBar(), &QScrollBar::valueChanged, this, scheduleProbePriorities);
+    connect(ui->playlistWidget->verticalScrollBar(), &QScrollBar::valueChanged, this, scheduleProbePriorities);
+    connect(m_playlist, &Playlist::currentIndexChanged, this, scheduleProbePriorities);
+    connect(m_playlist, &Playlist::playlistChanged, this, scheduleProbePriorities);
+    connect(m_library, &MusicLibrary::fileRemoved, this, [this](const QString &filePath) {
+        if (!m_playlist->contains(filePath)) {
+            m_metadataProber->cancel(QStringList() << filePath);
+        }
+    });
+    
+    // 播放列表增删后或菜单打开时更新切换菜单（当前列表的歌曲数随时在变）
+    connect(m_playlistManager, &PlaylistManager::playlistsChanged, this, &MainWindow::updatePlaylistMenu);
+    connect(ui->menuPlaylists, &QMenu::aboutToShow, this, &MainWindow::updatePlaylistMenu);
+    
+    // 智能播放列表内容变化时更新菜单中的歌曲数
+    connect(m_smartPlaylists, &SmartPlaylists::playlistChanged, this, &MainWindow::updateSmartPlaylistMenu);
+    
+    // 封面提取完成后刷新当前歌曲的封面
+    connect(m_albumArtCache, &AlbumArtCache::artworkReady, this, [this](const QString &filePath) {
+        if (filePath == m_currentFilePath) {
+            updateCover(filePath);
+        }
+    });
+    
+    // 响度分析进度显示在状态栏
+    connect(m_loudnessAnalyzer, &LoudnessAnalyzer::progressChanged, this, [this](int processed, int total) {
+        ui->statusbar->showMessage(tr("正在分析响度 %1/%2").arg(processed).arg(total));
+    });
+    connect(m_loudnessAnalyzer, &LoudnessAnalyzer::finished, this, [this](bool canceled) {
+        ui->actionAnalyzeLoudness->setText(tr("分析响度"));
+        if (canceled) {
+            ui->statusbar->showMessage(tr("已取消响度分析"), 3000);
+            return;
+        }
+        ui->statusbar->showMessage(tr("响度分析完成：%1 首，%2 首/秒，%3 倍实时速度")
+            .arg(m_loudnessAnalyzer->processedCount())
+            .arg(m_loudnessAnalyzer->tracksPerSecond(), 0, 'f', 1)
+            .arg(m_loudnessAnalyzer->realtimeFactor(), 0, 'f', 1), 8000);
+        m_library->save(libraryCachePath());
+    });
 }
 
 void MainWindow::onDirectoryChanged(const QString &path)
 {
     qDebug() << "目录发生变化:" << path;
-    if (path == m_currentMusicFolder) {
-        refreshMusicLibrary();
+    if (m_musicFolders.contains(path)) {
+        m_libraryScanner->scan(QStringList() << path, MusicNameFilters);
     }
 }
 
 void MainWindow::onFileChanged(const QString &path)
 {
     qDebug() << "文件发生变化:" << path;
-    if (m_musicLibrary.contains(path)) {
-        // 重新加载文件元数据
-        MusicFile musicFile(path);
-        m_musicLibrary[path] = musicFile;
-        refreshMusicLibrary();
+    if (m_library->contains(path)) {
+        // 重新探测文件元数据（内容可能已变化，旧的哈希随之失效）
+        m_metadataProber->enqueue(QStringList() << path);
+        // 只重新扫描文件所在的根目录（文件被删除或改名时从音乐库中移除）
+        const QString root = QFileInfo(path).absolutePath();
+        if (m_musicFolders.contains(root)) {
+            m_libraryScanner->scan(QStringList() << root, MusicNameFilters);
+        }
     }
 }
 
 void MainWindow::refreshMusicLibrary()
 {
-    if (m_currentMusicFolder.isEmpty()) {
+    if (m_musicFolders.isEmpty()) {
         return;
     }
     
-    // 保存当前选中的项
-    QString currentItem;
-    if (ui->libraryWidget->currentItem()) {
-        currentItem = ui->libraryWidget->currentItem()->text();
+    // 在后台重新扫描各根目录，文件信息和开头批量读取，每个根目录完成后在 applyLibraryScan 中合并
+    m_libraryScanner->scan(m_musicFolders, MusicNameFilters);
+}
+
+void MainWindow::applyLibraryScan(const QString &root, const QVector<ScannedFile> &files, qint64 elapsedMs, bool complete)
+{
+    if (!m_musicFolders.contains(root)) {
+        return;  // 扫描期间移除了这个目录
     }
+    if (!complete) {
+        // 磁盘未挂载或网络断开：保留音乐库中的条目，等目录恢复后再扫描
+        ui->statusbar->showMessage(tr("无法读取 %1").arg(root), 5000);
+        return;
+    }
+    ui->statusbar->showMessage(tr("%1：%2 个文件，扫描用时 %3 毫秒").arg(root).arg(files.size()).arg(elapsedMs), 3000);
     
-    // 清空列表
-    ui->libraryWidget->clear();
-    
-    // 重新扫描目录
-    QDir dir(m_currentMusicFolder);
-    QStringList filters;
-    filters << "*.mp3" << "*.wav" << "*.flac";
-    dir.setNameFilters(filters);
-    dir.setFilter(QDir::Files | QDir::NoDotAndDotDot | QDir::Readable);
-    QFileInfoList fileList = dir.entryInfoList();
-    
-    // 新音乐库
-    for (const QFileInfo &fileInfo : fileList) {
-        QString filePath = fileInfo.absoluteFilePath();
-        if (!m_musicLibrary.contains(filePath)) {
-            MusicFile musicFile(filePath);
-            m_musicLibrary[filePath] = musicFile;
+    // 新文件先以占位条目加入音乐库，已修改的文件保留旧信息，元数据都交给后台探测，不阻塞界面
+    QStringList unprobed;
+    QStringList readable;
+    QSet<QString> present;
+    for (const ScannedFile &scanned : files) {
+        if (scanned.error == ENOENT) {
+            continue;  // 列出目录之后被删除
         }
-        
-        // 添加到列表显示
-        const MusicFile &musicFile = m_musicLibrary[filePath];
-        QString displayText = musicFile.title();
-        if (!musicFile.artist().isEmpty()) {
-            displayText = musicFile.artist() + " - " + musicFile.title();
+        present.insert(scanned.filePath);
+        if (!scanned.isValid()) {
+            continue;  // 无法读取
+        }
+        const QString &filePath = scanned.filePath;
+        readable.append(filePath);
+        if (!m_library->contains(filePath)) {
+            m_library->insert(MusicFile::placeholder(filePath));
+            unprobed.append(filePath);
+        } else if (m_library->file(filePath).lastModified().toMSecsSinceEpoch() != scanned.modifiedMs) {
+            unprobed.append(filePath);
         }
-        QListWidgetItem *item = new QListWidgetItem(displayText, ui->libraryWidget);
-        item->setToolTip(filePath);
     }
+    m_metadataProber->enqueue(unprobed);
+    // 建立音乐库时就准备跳转表（已有缓存的只在后台检查一下），第一次播放时跳转也不必从头解码
+    m_seekTables->prefetch(readable);
     
-    // 恢复选中状态
-    if (!currentItem.isEmpty()) {
-        QList<QListWidgetItem*> items = ui->libraryWidget->findItems(currentItem, Qt::MatchExactly);
-        if (!items.isEmpty()) {
-            ui->libraryWidget->setCurrentItem(items.first());
+    // 每个根目录的扫描结果是完整的：这个目录下已被删除或移走的文件从音乐库中移除
+    const QStringList paths = m_library->filePaths();
+    for (const QString &path : paths) {
+        if (!present.contains(path) && QFileInfo(path).absolutePath() == root) {
+            m_library->remove(path);
         }
     }
+    
+    // 排序视图随后通过 rowsChanged/orderChanged 更新列表，这里只需刷新搜索结果
+    if (!ui->searchEdit->text().trimmed().isEmpty()) {
+        updateLibraryView();
+    }
+    
+    // 后台提取新文件的封面
+    m_albumArtCache->extractMissing();
 }
 
-void MainWindow::loadFolder(const QString &folderPath)
+void MainWindow::updateLibraryView()
 {
-    qDebug() << "正在加载文件夹:" << folderPath;
+    // 保存当前选中的歌曲
+    const QString currentPath = m_libraryModel->filePath(ui->libraryWidget->currentIndex().row());
+    
+    // 有搜索关键词时按相关度显示匹配的歌曲，否则按当前排序方式分组显示全部；
+    // 模型只替换路径列表，显示文字在绘制可见行时才读取
+    const QString query = ui->searchEdit->text();
+    if (query.trimmed().isEmpty()) {
+        m_libraryModel->setRows(m_libraryView->filePaths(), m_libraryView->groups());
+    } else {
+        m_libraryModel->setRows(m_searchIndex->search(query, MaxSearchResults));
+        ui->statusbar->showMessage(tr("找到 %1 首（%2 毫秒）")
+            .arg(m_libraryModel->rowCount()).arg(m_searchIndex->lastQueryMs(), 0, 'f', 2), 3000);
+    }
     
-    QDir dir(folderPath);
-    if (!dir.exists()) {
-        QMessageBox::warning(this, tr("错误"), tr("文件夹不存在"));
+    // 恢复选中状态
+    const int row = currentPath.isEmpty() ? -1 : m_libraryModel->rowOf(currentPath);
+    if (row >= 0) {
+        ui->libraryWidget->setCurrentIndex(m_libraryModel->index(row));
+    }
+    m_probePriorityTimer->start();
+}
+
+void MainWindow::on_searchEdit_textChanged(const QString &text)
+{
+    Q_UNUSED(text);
+    updateLibraryView();
+}
+
+void MainWindow::on_sortCombo_currentIndexChanged(int index)
+{
+    if (!m_libraryView) {
         return;
     }
     
-    // 更新当前音乐文件夹
-    m_currentMusicFolder = folderPath;
+    // 排序在后台完成，结果通过 orderChanged 刷新列表
+    switch (index) {
+    case 1:
+        m_libraryView->setGroupDepth(0);
+        m_libraryView->setSortKeys({LibraryView::Title});
+        break;
+    case 2:
+        m_libraryView->setGroupDepth(2);
+        m_libraryView->setSortKeys({LibraryView::Artist, LibraryView::Album, LibraryView::Title});
+        break;
+    case 3:
+        m_libraryView->setGroupDepth(1);
+        m_libraryView->setSortKeys({LibraryView::Genre, LibraryView::Artist, LibraryView::Title});
+        break;
+    case 4:
+        m_libraryView->setGroupDepth(0);
+        m_libraryView->setSortKeys({LibraryView::Duration});
+        break;
+    case 5:
+        m_libraryView->setGroupDepth(0);
+        m_libraryView->setSortKeys({LibraryView::LastModified}, Qt::DescendingOrder);
+        break;
+    case 6:
+        m_libraryView->setGroupDepth(0);
+        m_libraryView->setSortKeys({LibraryView::PlayCount}, Qt::DescendingOrder);
+        break;
+    default:
+        m_libraryView->setGroupDepth(0);
+        m_libraryView->setSortKeys({LibraryView::Path});
+        break;
+    }
+    updateLibraryView();
+}
+
+void MainWindow::setMusicFolders(const QStringList &folders)
+{
+    qDebug() << "正在加载文件夹:" << folders;
+    
+    QStringList roots;
+    for (const QString &folder : folders) {
+        QDir dir(folder);
+        if (!dir.exists()) {
+            QMessageBox::warning(this, tr("错误"), tr("文件夹不存在：%1").arg(folder));
+            continue;
+        }
+        const QString root = dir.absolutePath();
+        if (!roots.contains(root)) {
+            roots.append(root);
+        }
+    }
+    
+    // 更新音乐库根目录
+    m_musicFolders = roots;
     
     // 设置文件监控
     if (!m_fileWatcher->directories().isEmpty()) {
         m_fileWatcher->removePaths(m_fileWatcher->directories());
     }
-    m_fileWatcher->addPath(folderPath);
+    if (!roots.isEmpty()) {
+        m_fileWatcher->addPaths(roots);
+    }
     
-    // 清空并重新加载音乐库
-    m_musicLibrary.clear();
+    // 移除不在这些文件夹中的歌曲，保留缓存中仍然有效的条目
+    m_duplicateAnalyzer->cancel();
+    m_loudnessAnalyzer->cancel();
+    m_albumArtCache->cancel();
+    m_libraryScanner->cancel();
+    const QStringList paths = m_library->filePaths();
+    for (const QString &path : paths) {
+        if (!roots.contains(QFileInfo(path).absolutePath())) {
+            m_library->remove(path);
+        }
+    }
+    if (!ui->searchEdit->text().trimmed().isEmpty()) {
+        updateLibraryView();
+    }
     refreshMusicLibrary();
 }
 
+void MainWindow::openPaths(const QStringList &paths, bool play)
+{
+    QStringList folders = m_musicFolders;
+    QList<PlaylistEntry> entries;
+    for (const QString &path : paths) {
+        const QFileInfo info(path);
+        if (info.isDir()) {
+            if (!folders.contains(info.absoluteFilePath())) {
+                folders.append(info.absoluteFilePath());
+            }
+        } else if (info.isFile()) {
+            PlaylistEntry entry;
+            entry.filePath = info.absoluteFilePath();
+            entries.append(entry);
+        }
+    }
+    if (folders != m_musicFolders) {
+        setMusicFolders(folders);
+    }
+    
+    const int first = m_playlist->count();
+    appendToPlaylist(entries);
+    if (!play || entries.isEmpty()) {
+        return;
+    }
+    
+    // 播放传入的第一首；已在播放列表中时播放原有的那一项
+    const QString &target = entries.first().filePath;
+    int index = first;
+    if (index >= m_playlist->count() || m_playlist->at(index).filePath() != target) {
+        index = -1;
+        for (int i = 0; i < m_playlist->count(); ++i) {
+            if (m_playlist->at(i).filePath() == target) {
+                index = i;
+                break;
+            }
+        }
+    }
+    if (index >= 0) {
+        m_playlist->setCurrentIndex(index);
+        const MusicFile currentFile = m_playlist->at(index);
+        updateCurrentSong(currentFile, true);
+        m_player->setSource(currentFile.fileUrl());
+        m_player->play();
+    }
+}
+
 void MainWindow::addToPlaylist(const MusicFile &file)
 {
-    // 检查是否已存在
-    for (int i = 0; i < ui->playlistWidget->count(); ++i) {
-        QListWidgetItem *item = ui->playlistWidget->item(i);
-        if (item->toolTip() == file.filePath()) {
-            // 文件已存在，不重复添加
+    // 检查是否已存在（包括内容相同的重复文件）
+    if (m_playlist->contains(file.filePath())) {
+        return;
+    }
+    const QStringList duplicates = m_library->duplicatesOf(file.filePath());
+    for (const QString &duplicate : duplicates) {
+        if (m_playlist->contains(duplicate)) {
             return;
         }
     }
     
-    // 添加到播放列表
+    // 添加到播放列表，播放队列显示由 filesInserted 更新
     m_playlist->addFile(file);
-    
-    // 添加到播放队列显示
-    QString displayText = file.title();
-    if (!file.artist().isEmpty()) {
-        displayText = file.artist() + " - " + file.title();
-    }
-    QListWidgetItem *item = new QListWidgetItem(displayText, ui->playlistWidget);
-    item->setToolTip(file.filePath());
+    QListWidgetItem *item = ui->playlistWidget->item(ui->playlistWidget->count() - 1);
     
     // 仅当播放列表为空且没有正在播放的音乐时，才自动选中并播放
     if (ui->playlistWidget->count() == 1 && !m_isPlaying) {
@@ -249,6 +682,168 @@ void MainWindow::addToPlaylist(const MusicFile &file)
     }
 }
 
+void MainWindow::appendToPlaylist(const QList<PlaylistEntry> &entries)
+{
+    // 音乐库中已有的文件直接使用已探测的元数据，其余先建立占位条目，之后在后台探测
+    QList<MusicFile> files;
+    QStringList unprobed;
+    QSet<QString> seen;
+    files.reserve(entries.size());
+    for (const PlaylistEntry &entry : entries) {
+        if (m_playlist->contains(entry.filePath) || seen.contains(entry.filePath)) {
+            continue;
+        }
+        seen.insert(entry.filePath);
+
+        if (m_library->contains(entry.filePath)) {
+            files.append(m_library->file(entry.filePath));
+            continue;
+        }
+        MusicFile file = MusicFile::placeholder(entry.filePath);
+        if (!entry.title.isEmpty()) {
+            file.setTitle(entry.title);
+        }
+        file.setArtist(entry.artist);
+        file.setDuration(entry.duration);
+        files.append(file);
+        unprobed.append(entry.filePath);
+    }
+    
+    m_playlist->addFiles(files);
+    m_metadataProber->enqueue(unprobed);
+}
+
+void MainWindow::rebuildPlaylistWidget()
+{
+    ui->playlistWidget->setUpdatesEnabled(false);
+    ui->playlistWidget->clear();
+    // addItems 一次插入所有行，列表控件只做一次布局
+    const int count = m_playlist->count();
+    QStringList texts;
+    texts.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        texts.append(playlistItemText(m_playlist->at(i)));
+    }
+    ui->playlistWidget->addItems(texts);
+    for (int i = 0; i < count; ++i) {
+        ui->playlistWidget->item(i)->setToolTip(m_playlist->at(i).filePath());
+    }
+    if (m_playlist->currentIndex() >= 0) {
+        ui->playlistWidget->setCurrentRow(m_playlist->currentIndex());
+    }
+    ui->playlistWidget->setUpdatesEnabled(true);
+}
+
+void MainWindow::onPlaylistFilesInserted(int first, int count)
+{
+    // 导入大的播放列表时逐行插入每次都要重新布局，直接重建
+    if (count > MaxPlaylistItemEdits) {
+        rebuildPlaylistWidget();
+        return;
+    }
+    ui->playlistWidget->setUpdatesEnabled(false);
+    for (int i = first; i < first + count; ++i) {
+        const MusicFile file = m_playlist->at(i);
+        QListWidgetItem *item = new QListWidgetItem(playlistItemText(file));
+        item->setToolTip(file.filePath());
+        ui->playlistWidget->insertItem(i, item);
+    }
+    ui->playlistWidget->setUpdatesEnabled(true);
+}
+
+void MainWindow::onPlaylistFilesRemoved(const Playlist::RangeList &ranges)
+{
+    int removed = 0;
+    for (const auto &range : ranges) {
+        removed += range.second;
+    }
+    
+    // 列表控件逐行删除是 O(n) 的，删除较多时直接重建
+    if (removed > MaxPlaylistItemEdits) {
+        rebuildPlaylistWidget();
+        return;
+    }
+    ui->playlistWidget->setUpdatesEnabled(false);
+    for (int i = ranges.size() - 1; i >= 0; --i) {
+        for (int k = 0; k < ranges.at(i).second; ++k) {
+            delete ui->playlistWidget->takeItem(ranges.at(i).first);
+        }
+    }
+    ui->playlistWidget->setUpdatesEnabled(true);
+}
+
+void MainWindow::onPlaylistFilesMoved(int first, int count, int destination)
+{
+    if (count > MaxPlaylistItemEdits) {
+        rebuildPlaylistWidget();
+        return;
+    }
+    ui->playlistWidget->setUpdatesEnabled(false);
+    QList<QListWidgetItem*> items;
+    for (int k = 0; k < count; ++k) {
+        items.append(ui->playlistWidget->takeItem(first));
+    }
+    for (int k = 0; k < count; ++k) {
+        ui->playlistWidget->insertItem(destination + k, items.at(k));
+    }
+    ui->playlistWidget->setUpdatesEnabled(true);
+}
+
+void MainWindow::applyProbedFiles()
+{
+    // 音乐库中的条目（扫描时的占位条目或已修改的文件）一并更新
+    for (const MusicFile &file : qAsConst(m_probedFiles)) {
+        if (m_library->contains(file.filePath())) {
+            m_library->insert(file);
+        }
+    }
+    const QList<int> rows = m_playlist->updateFiles(m_probedFiles);
+    // 新加入的歌曲在后台建立跳转表，播放时跳转不必从头解码
+    m_seekTables->prefetch(m_probedFiles.keys());
+    m_probedFiles.clear();
+    for (int row : rows) {
+        if (QListWidgetItem *item = ui->playlistWidget->item(row)) {
+            item->setText(playlistItemText(m_playlist->at(row)));
+        }
+    }
+}
+
+void MainWindow::updateProbePriorities()
+{
+    if (m_metadataProber->pendingCount() == 0) {
+        return;
+    }
+    
+    // 列表控件中可见的行范围
+    auto visibleRows = [](QListView *widget) {
+        const int first = widget->indexAt(QPoint(0, 0)).row();
+        int last = widget->indexAt(QPoint(0, widget->viewport()->height() - 1)).row();
+        if (last < 0) {
+            last = widget->model()->rowCount() - 1;
+        }
+        return qMakePair(qMax(0, first), last);
+    };
+    
+    // 顺序：即将播放 → 播放列表可见行 → 音乐库可见行
+    QStringList paths;
+    const QList<int> upcoming = m_playlist->upcomingIndices(UpcomingProbeCount);
+    for (int index : upcoming) {
+        paths.append(m_playlist->at(index).filePath());
+    }
+    const QPair<int, int> playlistRows = visibleRows(ui->playlistWidget);
+    for (int row = playlistRows.first; row <= playlistRows.second; ++row) {
+        paths.append(m_playlist->at(row).filePath());
+    }
+    const QPair<int, int> libraryRows = visibleRows(ui->libraryWidget);
+    for (int row = libraryRows.first; row <= libraryRows.second; ++row) {
+        const QString filePath = m_libraryModel->filePath(row);
+        if (!filePath.isEmpty()) {
+            paths.append(filePath);
+        }
+    }
+    m_metadataProber->setPrioritized(paths);
+}
+
 void MainWindow::updateCurrentSong(const MusicFile &file, bool updatePlayer)
 {
     // 更新标题和艺术家信息
@@ -261,6 +856,34 @@ void MainWindow::updateCurrentSong(const MusicFile &file, bool updatePlayer)
     // 更新窗口标题
     setWindowTitle(QString("%1 - %2").arg(title).arg(artist));
     
+    // 更新进度条波形
+    if (m_currentFilePath != file.filePath()) {
+        m_currentFilePath = file.filePath();
+        updateCover(m_currentFilePath);
+        ui->progressSlider->clearWaveform();
+        m_waveformCache->request(m_currentFilePath);
+        
+        // 顺带在后台准备下一首的波形
+        int nextIndex = m_playlist->currentIndex() + 1;
+        if (nextIndex > 0 && nextIndex < m_playlist->count()) {
+            m_waveformCache->prefetch(QStringList() << m_playlist->at(nextIndex).filePath());
+            m_seekTables->prefetch(QStringList() << m_playlist->at(nextIndex).filePath());
+        }
+        
+        // 下一首和上一首的开头预先解码到内存，切歌时立即出声
+        QStringList candidates;
+        const QList<int> upcoming = m_playlist->upcomingIndices(1);
+        if (!upcoming.isEmpty()) {
+            candidates.append(m_playlist->at(upcoming.first()).filePath());
+        }
+        // 随机模式下的上一首每次都不同，无法预测
+        const int previousIndex = m_playlist->playMode() != Playlist::Random ? m_playlist->previousIndex() : -1;
+        if (previousIndex >= 0) {
+            candidates.append(m_playlist->at(previousIndex).filePath());
+        }
+        m_headCache->setCandidates(candidates);
+    }
+    
     // 高亮显示当前播放的歌曲
     for (int i = 0; i < ui->playlistWidget->count(); ++i) {
         QListWidgetItem *item = ui->playlistWidget->item(i);
@@ -282,6 +905,38 @@ void MainWindow::updateCurrentSong(const MusicFile &file, bool updatePlayer)
     }
 }
 
+void MainWindow::updateCover(const QString &filePath)
+{
+    // 缩略图直接引用图集的映射内存，切歌时不需要解码图片
+    const QImage thumbnail = m_albumArtCache->thumbnail(m_library->file(filePath).artHash());
+    if (thumbnail.isNull()) {
+        ui->coverLabel->clear();
+    } else {
+        ui->coverLabel->setPixmap(QPixmap::fromImage(thumbnail));
+    }
+}
+
+void MainWindow::showFullCover()
+{
+    if (m_currentFilePath.isEmpty()) {
+        return;
+    }
+    
+    // 原图只在用户查看时解码
+    const QImage image = AlbumArtCache::fullImage(m_currentFilePath);
+    if (image.isNull()) {
+        return;
+    }
+    
+    QLabel *viewer = new QLabel(this, Qt::Window);
+    viewer->setAttribute(Qt::WA_DeleteOnClose);
+    viewer->setWindowTitle(ui->titleLabel->text());
+    viewer->setAlignment(Qt::AlignCenter);
+    viewer->setPixmap(QPixmap::fromImage(image).scaled(QSize(800, 800).boundedTo(image.size()),
+        Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    viewer->show();
+}
+
 void MainWindow::loadLyric(const QString &musicFilePath)
 {
     // 清空当前歌词
@@ -410,10 +1065,9 @@ void MainWindow::on_libraryWidget_doubleClicked(const QModelIndex &index)
         return;
     }
     
-    QListWidgetItem *item = ui->libraryWidget->item(index.row());
-    QString filePath = item->toolTip();
-    if (m_musicLibrary.contains(filePath)) {
-        addToPlaylist(m_musicLibrary[filePath]);
+    const QString filePath = m_libraryModel->filePath(index.row());
+    if (m_library->contains(filePath)) {
+        addToPlaylist(m_library->file(filePath));
     }
 }
 
@@ -438,8 +1092,18 @@ void MainWindow::on_playlistWidget_doubleClicked(const QModelIndex &index)
 
 void MainWindow::on_clearPlaylistButton_clicked()
 {
+    // 只取消播放列表独有的占位条目；音乐库扫描的占位条目在同一个探测器中，仍然需要探测
+    QStringList canceled;
+    for (int i = 0; i < m_playlist->count(); ++i) {
+        const QString path = m_playlist->at(i).filePath();
+        if (!m_library->contains(path)) {
+            canceled.append(path);
+            m_probedFiles.remove(path);
+        }
+    }
     ui->playlistWidget->clear();
     m_playlist->clear();
+    m_metadataProber->cancel(canceled);
     
     // 清除当前播放信息
     ui->titleLabel->setText(tr("未知歌曲"));
@@ -453,25 +1117,41 @@ void MainWindow::on_clearPlaylistButton_clicked()
     // 重置进度条和时间标签
     ui->progressSlider->setValue(0);
     ui->progressSlider->setMaximum(0);
+    ui->progressSlider->clearWaveform();
+    ui->coverLabel->clear();
+    m_currentFilePath.clear();
     updateTimeLabel(ui->currentTimeLabel, 0);
     updateTimeLabel(ui->totalTimeLabel, 0);
 }
 
 void MainWindow::on_removeSelectedButton_clicked()
 {
-    QList<QListWidgetItem*> items = ui->playlistWidget->selectedItems();
-    bool removedCurrentSong = false;
-    int currentIndex = m_playlist->currentIndex();
+    const QModelIndexList selected = ui->playlistWidget->selectionModel()->selectedRows();
+    if (selected.isEmpty()) {
+        return;
+    }
     
-    for (QListWidgetItem *item : items) {
-        int row = ui->playlistWidget->row(item);
-        // 检查是否移除了当前播放的歌曲
-        if (row == currentIndex) {
-            removedCurrentSong = true;
+    QList<int> rows;
+    QStringList removedPaths;
+    rows.reserve(selected.size());
+    for (const QModelIndex &index : selected) {
+        rows.append(index.row());
+        removedPaths.append(m_playlist->at(index.row()).filePath());
+    }
+    
+    // 一次性删除，行号不会在删除过程中变化
+    const int currentIndex = m_playlist->currentIndex();
+    const bool removedCurrentSong = currentIndex >= 0 && rows.contains(currentIndex);
+    m_playlist->removeIndices(rows);
+    
+    // 删除的占位条目不再需要探测（音乐库中的条目仍然需要）
+    QStringList canceled;
+    for (const QString &path : qAsConst(removedPaths)) {
+        if (!m_playlist->contains(path) && !m_library->contains(path)) {
+            canceled.append(path);
         }
-        m_playlist->removeFile(row);
-        delete item;
     }
+    m_metadataProber->cancel(canceled);
     
     // 如果移除了当前播放的歌曲，或播放列表已空
     if (removedCurrentSong || m_playlist->count() == 0) {
@@ -480,7 +1160,7 @@ void MainWindow::on_removeSelectedButton_clicked()
         m_player->setSource(QUrl());  // 清除当前媒体
         
         // 清除当前播放信息
-        ui->titleLabel->setText(tr("���知歌曲"));
+        ui->titleLabel->setText(tr("未知歌曲"));
         ui->artistLabel->setText(tr("未知艺术家"));
         setWindowTitle(tr("音乐播放器"));
         
@@ -491,20 +1171,11 @@ void MainWindow::on_removeSelectedButton_clicked()
         // 重置进度条和时间标签
         ui->progressSlider->setValue(0);
         ui->progressSlider->setMaximum(0);
+        ui->progressSlider->clearWaveform();
+        m_currentFilePath.clear();
         updateTimeLabel(ui->currentTimeLabel, 0);
         updateTimeLabel(ui->totalTimeLabel, 0);
     }
-    // 如果还有歌曲，且移除了当前播放的歌曲，播放下一首
-    else if (removedCurrentSong && m_playlist->count() > 0) {
-        int nextIndex = m_playlist->nextIndex();
-        if (nextIndex != -1) {
-            m_playlist->setCurrentIndex(nextIndex);
-            MusicFile currentFile = m_playlist->at(nextIndex);
-            updateCurrentSong(currentFile, true);  // 切换到下一首时完整更新
-            m_player->setSource(currentFile.fileUrl());
-            m_player->play();
-        }
-    }
 }
 
 void MainWindow::on_playButton_clicked()
@@ -558,7 +1229,7 @@ void MainWindow::on_volumeSlider_valueChanged(int value)
 
 void MainWindow::on_progressSlider_sliderMoved(int position)
 {
-    m_player->setPosition(position);
+    m_player->scrubTo(position);
 }
 
 void MainWindow::on_actionOpenFolder_triggered()
@@ -568,7 +1239,18 @@ void MainWindow::on_actionOpenFolder_triggered()
         QStandardPaths::writableLocation(QStandardPaths::MusicLocation));
         
     if (!folderPath.isEmpty()) {
-        loadFolder(folderPath);
+        setMusicFolders(QStringList() << folderPath);
+    }
+}
+
+void MainWindow::on_actionAddFolder_triggered()
+{
+    QString folderPath = QFileDialog::getExistingDirectory(this,
+        tr("添加音乐文件夹"),
+        QStandardPaths::writableLocation(QStandardPaths::MusicLocation));
+        
+    if (!folderPath.isEmpty()) {
+        setMusicFolders(QStringList(m_musicFolders) << folderPath);
     }
 }
 
@@ -577,6 +1259,298 @@ void MainWindow::on_actionExit_triggered()
     close();
 }
 
+void MainWindow::on_actionFindDuplicates_triggered()
+{
+    if (m_duplicateAnalyzer->isRunning()) {
+        return;
+    }
+    
+    // 非模态进度窗口，分析期间可以继续播放和操作
+    if (!m_duplicateProgress) {
+        m_duplicateProgress = new QProgressDialog(tr("正在分析重复歌曲..."), tr("取消"), 0, 0, this);
+        m_duplicateProgress->setWindowModality(Qt::NonModal);
+        m_duplicateProgress->setAutoClose(false);
+        m_duplicateProgress->setAutoReset(false);
+        connect(m_duplicateProgress, &QProgressDialog::canceled,
+                m_duplicateAnalyzer, &DuplicateAnalyzer::cancel);
+        connect(m_duplicateAnalyzer, &DuplicateAnalyzer::progressChanged, this, [this](int processed, int total) {
+            m_duplicateProgress->setMaximum(total);
+            m_duplicateProgress->setValue(processed);
+        });
+        connect(m_duplicateAnalyzer, &DuplicateAnalyzer::finished, this, [this](bool canceled) {
+            m_duplicateProgress->hide();
+            if (canceled) {
+                ui->statusbar->showMessage(tr("已取消重复歌曲分析"), 3000);
+                return;
+            }
+            int groups = m_library->duplicateGroups().size();
+            ui->statusbar->showMessage(tr("分析完成，发现 %1 组重复歌曲").arg(groups), 5000);
+            refreshMusicLibrary();
+        });
+    }
+    
+    m_duplicateProgress->reset();
+    m_duplicateProgress->show();
+    m_duplicateAnalyzer->start();
+}
+
+void MainWindow::on_actionAnalyzeLoudness_triggered()
+{
+    // 再次点击取消正在进行的分析
+    if (m_loudnessAnalyzer->isRunning()) {
+        m_loudnessAnalyzer->cancel();
+        return;
+    }
+    
+    ui->actionAnalyzeLoudness->setText(tr("取消响度分析"));
+    m_loudnessAnalyzer->start();
+}
+
+void MainWindow::on_actionScrubPreview_toggled(bool checked)
+{
+    m_player->setScrubPreview(checked);
+}
+
+void MainWindow::on_actionEqualizer_triggered()
+{
+    if (!m_equalizer) {
+        m_equalizer = new EqualizerDialog(this);
+        m_equalizer->setParameters(m_player->equalizer());
+        connect(m_equalizer, &EqualizerDialog::parametersChanged, m_player, &MusicPlayer::setEqualizer);
+    }
+    m_equalizer->show();
+    m_equalizer->raise();
+}
+
+void MainWindow::openPlaylist(const QString &name)
+{
+    QStringList placeholders;
+    const QList<MusicFile> files = m_playlistManager->files(name, &placeholders);
+    m_playlistManager->setActive(name);
+    m_playlist->setName(name);
+    m_playlist->setFiles(files);
+    rebuildPlaylistWidget();
+    
+    m_metadataProber->enqueue(placeholders);
+    updatePlaylistMenu();
+}
+
+void MainWindow::switchPlaylist(const QString &name)
+{
+    if (name == m_playlist->name() || !m_playlistManager->contains(name)) {
+        return;
+    }
+    
+    syncCurrentPlaylist();
+    m_player->stop();
+    m_player->setSource(QUrl());
+    on_clearPlaylistButton_clicked();
+    openPlaylist(name);
+}
+
+void MainWindow::syncCurrentPlaylist()
+{
+    // 当前播放列表与管理器共享数据，没有修改时不会被重新写入
+    if (!m_playlist->name().isEmpty()) {
+        m_playlistManager->setFiles(m_playlist->name(), m_playlist->files());
+    }
+}
+
+void MainWindow::updatePlaylistMenu()
+{
+    ui->menuPlaylists->clear();
+    const QStringList names = m_playlistManager->names();
+    for (const QString &name : names) {
+        const int count = name == m_playlist->name() ? m_playlist->count() : m_playlistManager->count(name);
+        QAction *action = ui->menuPlaylists->addAction(QString("%1 (%2)").arg(name).arg(count));
+        action->setCheckable(true);
+        action->setChecked(name == m_playlist->name());
+        connect(action, &QAction::triggered, this, [this, name]() {
+            switchPlaylist(name);
+        });
+    }
+    ui->actionDeletePlaylist->setEnabled(!names.isEmpty());
+}
+
+void MainWindow::on_actionNewPlaylist_triggered()
+{
+    const QString name = QInputDialog::getText(this, tr("新建播放列表"), tr("名称:")).trimmed();
+    if (name.isEmpty()) {
+        return;
+    }
+    if (m_playlistManager->contains(name)) {
+        QMessageBox::warning(this, tr("新建播放列表"), tr("已存在名为“%1”的播放列表").arg(name));
+        return;
+    }
+    
+    m_playlistManager->setFiles(name, QList<MusicFile>());
+    switchPlaylist(name);
+}
+
+void MainWindow::on_actionDuplicatePlaylist_triggered()
+{
+    const QString name = QInputDialog::getText(this, tr("复制播放列表"), tr("名称:"), QLineEdit::Normal,
+                                               tr("%1 副本").arg(m_playlist->name())).trimmed();
+    if (name.isEmpty()) {
+        return;
+    }
+    
+    // 副本与原列表共享歌曲数据，编辑其中一个时才复制
+    syncCurrentPlaylist();
+    if (!m_playlistManager->duplicate(m_playlist->name(), name)) {
+        QMessageBox::warning(this, tr("复制播放列表"), tr("已存在名为“%1”的播放列表").arg(name));
+        return;
+    }
+    switchPlaylist(name);
+}
+
+void MainWindow::on_actionRenamePlaylist_triggered()
+{
+    const QString oldName = m_playlist->name();
+    const QString name = QInputDialog::getText(this, tr("重命名播放列表"), tr("名称:"),
+                                               QLineEdit::Normal, oldName).trimmed();
+    if (name.isEmpty() || name == oldName) {
+        return;
+    }
+    if (!m_playlistManager->rename(oldName, name)) {
+        QMessageBox::warning(this, tr("重命名播放列表"), tr("已存在名为“%1”的播放列表").arg(name));
+        return;
+    }
+    m_playlist->setName(name);
+    updatePlaylistMenu();
+}
+
+void MainWindow::on_actionDeletePlaylist_triggered()
+{
+    const QString name = m_playlist->name();
+    if (QMessageBox::question(this, tr("删除播放列表"), tr("确定删除播放列表“%1”吗？").arg(name))
+        != QMessageBox::Yes) {
+        return;
+    }
+    
+    m_player->stop();
+    m_player->setSource(QUrl());
+    on_clearPlaylistButton_clicked();
+    m_playlist->setName(QString());
+    m_playlistManager->remove(name);
+    
+    if (m_playlistManager->names().isEmpty()) {
+        m_playlistManager->setFiles(tr("默认列表"), QList<MusicFile>());
+    }
+    openPlaylist(m_playlistManager->names().first());
+}
+
+void MainWindow::on_actionImportPlaylist_triggered()
+{
+    QString path = QFileDialog::getOpenFileName(this, tr("导入播放列表"),
+                                                m_musicFolders.value(0), PlaylistFile::nameFilter());
+    if (path.isEmpty()) {
+        return;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    QList<PlaylistEntry> entries;
+    QString error;
+    if (!PlaylistFile::read(path, [&entries](const PlaylistEntry &entry) { entries.append(entry); }, &error)) {
+        QMessageBox::warning(this, tr("导入播放列表"), tr("无法读取播放列表：%1").arg(error));
+        return;
+    }
+    
+    const int before = m_playlist->count();
+    appendToPlaylist(entries);
+    ui->statusbar->showMessage(tr("已导入 %1 首歌曲（%2 条记录，%3 毫秒），%4 首正在读取信息")
+        .arg(m_playlist->count() - before).arg(entries.size()).arg(timer.elapsed())
+        .arg(m_metadataProber->pendingCount()), 5000);
+}
+
+void MainWindow::on_actionExportPlaylist_triggered()
+{
+    QString path = QFileDialog::getSaveFileName(this, tr("导出播放列表"),
+                                                m_playlist->name().isEmpty() ? QString("playlist.m3u8")
+                                                                             : m_playlist->name() + ".m3u8",
+                                                PlaylistFile::nameFilter());
+    if (path.isEmpty()) {
+        return;
+    }
+    if (PlaylistFile::formatForPath(path) == PlaylistFile::Unknown) {
+        path += ".m3u8";
+    }
+    
+    QString error;
+    if (!PlaylistFile::write(path, m_playlist->files(), &error)) {
+        QMessageBox::warning(this, tr("导出播放列表"), tr("无法保存播放列表：%1").arg(error));
+        return;
+    }
+    ui->statusbar->showMessage(tr("已导出 %1 首歌曲").arg(m_playlist->count()), 3000);
+}
+
+void MainWindow::on_actionNewSmartPlaylist_triggered()
+{
+    bool ok = false;
+    const QString name = QInputDialog::getText(this, tr("新建智能播放列表"), tr("名称:"),
+                                               QLineEdit::Normal, QString(), &ok).trimmed();
+    if (!ok || name.isEmpty()) {
+        return;
+    }
+
+    QString rule = m_smartPlaylists->rule(name);
+    while (true) {
+        rule = QInputDialog::getText(this, tr("新建智能播放列表"),
+                                     tr("规则（例如 genre = 摇滚 and added < 30d）:"),
+                                     QLineEdit::Normal, rule, &ok);
+        if (!ok) {
+            return;
+        }
+
+        QString error;
+        if (m_smartPlaylists->addPlaylist(name, rule, &error)) {
+            break;
+        }
+        QMessageBox::warning(this, tr("规则无效"), error);
+    }
+
+    m_smartPlaylists->save();
+    ui->statusbar->showMessage(tr("智能播放列表“%1”包含 %2 首歌曲")
+        .arg(name).arg(m_smartPlaylists->count(name)), 5000);
+}
+
+void MainWindow::updateSmartPlaylistMenu()
+{
+    ui->menuSmartPlaylists->clear();
+    const QStringList names = m_smartPlaylists->names();
+    for (const QString &name : names) {
+        QAction *action = ui->menuSmartPlaylists->addAction(
+            QString("%1 (%2)").arg(name).arg(m_smartPlaylists->count(name)));
+        connect(action, &QAction::triggered, this, [this, name]() {
+            playSmartPlaylist(name);
+        });
+    }
+    ui->menuSmartPlaylists->setEnabled(!names.isEmpty());
+}
+
+void MainWindow::playSmartPlaylist(const QString &name)
+{
+    // 用智能播放列表的内容替换当前播放列表，并从第一首开始播放
+    m_player->stop();
+    on_clearPlaylistButton_clicked();
+
+    const QStringList paths = m_smartPlaylists->files(name);
+    QList<PlaylistEntry> entries;
+    entries.reserve(paths.size());
+    for (const QString &path : paths) {
+        PlaylistEntry entry;
+        entry.filePath = path;
+        entries.append(entry);
+    }
+    appendToPlaylist(entries);
+    
+    if (m_playlist->count() > 0) {
+        on_playlistWidget_doubleClicked(ui->playlistWidget->model()->index(0, 0));
+    }
+}
+
 void MainWindow::updatePlaybackState(QMediaPlayer::State state)
 {
     m_isPlaying = (state == QMediaPlayer::PlayingState);
@@ -603,7 +1577,56 @@ void MainWindow::updateDuration(qint64 duration)
 
 void MainWindow::handleError(const QString &error)
 {
-    QMessageBox::warning(this, tr("错误"), error);
+    // 不弹出模态对话框：播放器已经跳到下一首，错误记入报告，状态栏提示一下
+    ui->statusbar->showMessage(tr("播放出错，已跳过：%1").arg(error), 5000);
+}
+
+void MainWindow::addErrorReportEntry(const QString &text)
+{
+    const QString entry = QString("[%1] %2").arg(QDateTime::currentDateTime().toString("HH:mm:ss"), text);
+    m_errorEntries.append(entry);
+    if (m_errorEntries.size() > MaxErrorEntries) {
+        m_errorEntries.removeFirst();
+    }
+    if (m_errorList) {
+        m_errorList->addItem(entry);
+        if (m_errorList->count() > MaxErrorEntries) {
+            delete m_errorList->takeItem(0);
+        }
+        m_errorList->scrollToBottom();
+    }
+    ui->actionErrorReport->setText(tr("播放错误报告 (%1)...").arg(m_errorEntries.size()));
+}
+
+void MainWindow::on_actionErrorReport_triggered()
+{
+    if (!m_errorReport) {
+        m_errorReport = new QDialog(this);
+        m_errorReport->setWindowTitle(tr("播放错误报告"));
+        m_errorReport->setWindowModality(Qt::NonModal);
+        m_errorReport->resize(560, 320);
+        
+        m_errorList = new QListWidget(m_errorReport);
+        m_errorList->addItems(m_errorEntries);
+        
+        QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, m_errorReport);
+        QPushButton *clearButton = buttons->addButton(tr("清除并重新检查"), QDialogButtonBox::ResetRole);
+        connect(buttons, &QDialogButtonBox::rejected, m_errorReport, &QDialog::hide);
+        connect(clearButton, &QPushButton::clicked, this, [this]() {
+            m_errorEntries.clear();
+            m_errorList->clear();
+            m_trackValidator->clear();
+            ui->actionErrorReport->setText(tr("播放错误报告..."));
+        });
+        
+        QVBoxLayout *layout = new QVBoxLayout(m_errorReport);
+        layout->addWidget(m_errorList);
+        layout->addWidget(buttons);
+    }
+    
+    m_errorList->scrollToBottom();
+    m_errorReport->show();
+    m_errorReport->raise();
 }
 
 void MainWindow::updateTimeLabel(QLabel *label, qint64 time)
@@ -616,6 +1639,15 @@ void MainWindow::updateTimeLabel(QLabel *label, qint64 time)
         .arg(seconds, 2, 10, QChar('0')));
 }
 
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == ui->coverLabel && event->type() == QEvent::MouseButtonDblClick) {
+        showFullCover();
+        return true;
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
 void MainWindow::resizeEvent(QResizeEvent *event)
 {
     QMainWindow::resizeEvent(event);
@@ -645,23 +1677,56 @@ void MainWindow::loadSettings()
 {
     QSettings settings("YinYue", "MusicPlayer");
     
-    // 加载音乐文件夹路径
-    QString musicFolder = settings.value("musicFolder").toString();
-    if (!musicFolder.isEmpty() && QDir(musicFolder).exists()) {
-        loadFolder(musicFolder);
+    // 每种设备上扫描音乐库时同时处理的文件数
+    m_libraryScanner->setDeviceConcurrency(LibraryScanner::SolidState,
+        settings.value("libraryScan/solidStateDepth", m_libraryScanner->deviceConcurrency(LibraryScanner::SolidState)).toInt());
+    m_libraryScanner->setDeviceConcurrency(LibraryScanner::Rotational,
+        settings.value("libraryScan/rotationalDepth", m_libraryScanner->deviceConcurrency(LibraryScanner::Rotational)).toInt());
+    m_libraryScanner->setDeviceConcurrency(LibraryScanner::Network,
+        settings.value("libraryScan/networkDepth", m_libraryScanner->deviceConcurrency(LibraryScanner::Network)).toInt());
+    
+    // 加载音乐文件夹路径（旧版本只有一个文件夹）
+    QStringList musicFolders = settings.value("musicFolders").toStringList();
+    if (musicFolders.isEmpty() && settings.contains("musicFolder")) {
+        musicFolders << settings.value("musicFolder").toString();
+    }
+    QStringList existing;
+    for (const QString &folder : musicFolders) {
+        if (!folder.isEmpty() && QDir(folder).exists()) {
+            existing << folder;
+        }
+    }
+    if (!existing.isEmpty()) {
+        setMusicFolders(existing);
     }
     
-    // 加载播放列表
-    int size = settings.beginReadArray("playlist");
-    for (int i = 0; i < size; ++i) {
-        settings.setArrayIndex(i);
-        QString filePath = settings.value("filePath").toString();
-        if (QFile::exists(filePath)) {
-            MusicFile musicFile(filePath);
-            addToPlaylist(musicFile);
+    // 加载播放列表：只打开上次使用的一个，其余留在磁盘上
+    m_playlistManager->load();
+    if (m_playlistManager->names().isEmpty()) {
+        // 旧版本把唯一的播放列表保存在设置中，迁移为默认播放列表
+        QList<PlaylistEntry> entries;
+        int size = settings.beginReadArray("playlist");
+        for (int i = 0; i < size; ++i) {
+            settings.setArrayIndex(i);
+            PlaylistEntry entry;
+            entry.filePath = settings.value("filePath").toString();
+            if (QFile::exists(entry.filePath)) {
+                entries.append(entry);
+            }
+        }
+        settings.endArray();
+        settings.remove("playlist");
+        
+        m_playlistManager->setFiles(tr("默认列表"), QList<MusicFile>());
+        openPlaylist(tr("默认列表"));
+        appendToPlaylist(entries);
+    } else {
+        QString name = settings.value("currentPlaylist").toString();
+        if (!m_playlistManager->contains(name)) {
+            name = m_playlistManager->names().first();
         }
+        openPlaylist(name);
     }
-    settings.endArray();
     
     // 加载音量
     int volume = settings.value("volume", 50).toInt();
@@ -691,6 +1756,36 @@ void MainWindow::loadSettings()
     // 加载播放模式
     int playMode = settings.value("playMode", static_cast<int>(Playlist::Sequential)).toInt();
     m_player->setPlayMode(static_cast<Playlist::PlayMode>(playMode));
+    
+    // 加载音量均衡设置
+    int gainMode = settings.value("replayGainMode", static_cast<int>(MusicPlayer::GainTrack)).toInt();
+    if (gainMode < MusicPlayer::GainOff || gainMode > MusicPlayer::GainAlbum) {
+        gainMode = MusicPlayer::GainTrack;
+    }
+    ui->actionReplayGainOff->setChecked(gainMode == MusicPlayer::GainOff);
+    ui->actionReplayGainTrack->setChecked(gainMode == MusicPlayer::GainTrack);
+    ui->actionReplayGainAlbum->setChecked(gainMode == MusicPlayer::GainAlbum);
+    m_player->setReplayGainMode(static_cast<MusicPlayer::ReplayGainMode>(gainMode));
+    
+    // 加载拖动试听设置
+    const bool scrubPreview = settings.value("scrubPreview", true).toBool();
+    ui->actionScrubPreview->setChecked(scrubPreview);
+    m_player->setScrubPreview(scrubPreview);
+    
+    // 加载均衡器设置（10 段增益）
+    float gains[EqualizerDialog::BandCount] = {};
+    const QVariantList savedGains = settings.value("equalizer/gains").toList();
+    for (int i = 0; i < EqualizerDialog::BandCount && i < savedGains.size(); ++i) {
+        gains[i] = qBound(-float(EqualizerDialog::MaxGain), savedGains.at(i).toFloat(), float(EqualizerDialog::MaxGain));
+    }
+    DspChain::Parameters equalizer = DspChain::graphicEqualizer(gains);
+    equalizer.equalizer = settings.value("equalizer/enabled", false).toBool();
+    equalizer.preamp = settings.value("equalizer/preamp", 0.0f).toFloat();
+    equalizer.limiter = settings.value("equalizer/limiter", true).toBool();
+    m_player->setEqualizer(equalizer);
+    
+    // 加载音乐库排序方式
+    ui->sortCombo->setCurrentIndex(settings.value("librarySort", 0).toInt());
 }
 
 void MainWindow::saveSettings()
@@ -698,17 +1793,18 @@ void MainWindow::saveSettings()
     QSettings settings("YinYue", "MusicPlayer");
     
     // 保存音乐文件夹路径
-    if (!m_currentMusicFolder.isEmpty()) {
-        settings.setValue("musicFolder", m_currentMusicFolder);
+    if (!m_musicFolders.isEmpty()) {
+        settings.setValue("musicFolders", m_musicFolders);
+        settings.remove("musicFolder");
     }
+    settings.setValue("libraryScan/solidStateDepth", m_libraryScanner->deviceConcurrency(LibraryScanner::SolidState));
+    settings.setValue("libraryScan/rotationalDepth", m_libraryScanner->deviceConcurrency(LibraryScanner::Rotational));
+    settings.setValue("libraryScan/networkDepth", m_libraryScanner->deviceConcurrency(LibraryScanner::Network));
     
-    // 保存播放列表
-    settings.beginWriteArray("playlist");
-    for (int i = 0; i < m_playlist->count(); ++i) {
-        settings.setArrayIndex(i);
-        settings.setValue("filePath", m_playlist->at(i).filePath());
-    }
-    settings.endArray();
+    // 保存播放列表（只写入有修改的）
+    syncCurrentPlaylist();
+    m_playlistManager->save();
+    settings.setValue("currentPlaylist", m_playlist->name());
     
     // 保存音量
     settings.setValue("volume", m_player->volume());
@@ -721,7 +1817,35 @@ void MainWindow::saveSettings()
     // 保存播放模式
     settings.setValue("playMode", static_cast<int>(m_player->playMode()));
     
+    // 保存音量均衡设置
+    settings.setValue("replayGainMode", static_cast<int>(m_player->replayGainMode()));
+    settings.setValue("scrubPreview", m_player->scrubPreview());
+    
+    // 保存均衡器设置
+    const DspChain::Parameters equalizer = m_player->equalizer();
+    QVariantList gains;
+    for (int i = 0; i < equalizer.bandCount; ++i) {
+        gains.append(equalizer.bands[i].gain);
+    }
+    settings.setValue("equalizer/enabled", equalizer.equalizer);
+    settings.setValue("equalizer/preamp", equalizer.preamp);
+    settings.setValue("equalizer/gains", gains);
+    settings.setValue("equalizer/limiter", equalizer.limiter);
+    
+    // 保存音乐库排序方式
+    settings.setValue("librarySort", ui->sortCombo->currentIndex());
+    
     settings.sync();
+    
+    // 保存音乐库缓存（元数据、哈希、响度）
+    m_library->save(libraryCachePath());
+}
+
+QString MainWindow::libraryCachePath() const
+{
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dataDir);
+    return dataDir + "/library.dat";
 }
 
 void MainWindow::startProgressTimer()
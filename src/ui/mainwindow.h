@@ -10,6 +10,30 @@
 #include "core/musicplayer.h"
 #include "models/playlist.h"
 #include "models/lyric.h"
+#include "models/musiclibrary.h"
+
+class DuplicateAnalyzer;
+class LoudnessAnalyzer;
+class WaveformCache;
+class SeekTableCache;
+class TrackHeadCache;
+class AlbumArtCache;
+class SearchIndex;
+class LibraryView;
+class LibraryListModel;
+class SmartPlaylists;
+class MetadataProber;
+class LibraryScanner;
+class ControlServer;
+struct ScannedFile;
+class PlaylistManager;
+class PlayStatsLog;
+class TrackValidator;
+class EqualizerDialog;
+struct PlaylistEntry;
+class QProgressDialog;
+class QDialog;
+class QListWidget;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -23,9 +47,13 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // 打开外部传入的路径（命令行参数、控制接口）：文件夹加入音乐库，文件加入播放列表，play 时播放第一首
+    void openPaths(const QStringList &paths, bool play);
+
 protected:
     void resizeEvent(QResizeEvent *event) override;
     void closeEvent(QCloseEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
 
 private slots:
     // 播放控制
@@ -37,9 +65,26 @@ private slots:
     
     // 文件菜单
     void on_actionOpenFolder_triggered();
+    void on_actionAddFolder_triggered();
     void on_actionExit_triggered();
+    void on_actionFindDuplicates_triggered();
+    void on_actionAnalyzeLoudness_triggered();
+    void on_actionScrubPreview_toggled(bool checked);
+    void on_actionEqualizer_triggered();
+    void on_actionErrorReport_triggered();
+    
+    // 音乐库
+    void on_searchEdit_textChanged(const QString &text);
+    void on_sortCombo_currentIndexChanged(int index);
     
     // 播放列表
+    void on_actionNewPlaylist_triggered();
+    void on_actionDuplicatePlaylist_triggered();
+    void on_actionRenamePlaylist_triggered();
+    void on_actionDeletePlaylist_triggered();
+    void on_actionImportPlaylist_triggered();
+    void on_actionExportPlaylist_triggered();
+    void on_actionNewSmartPlaylist_triggered();
     void on_libraryWidget_doubleClicked(const QModelIndex &index);
     void on_playlistWidget_doubleClicked(const QModelIndex &index);
     void on_clearPlaylistButton_clicked();
@@ -65,14 +110,33 @@ private slots:
 private:
     void setupConnections();
     void updateTimeLabel(QLabel *label, qint64 time);
-    void loadFolder(const QString &folderPath);
+    void setMusicFolders(const QStringList &folders);
     void refreshMusicLibrary();
+    void applyLibraryScan(const QString &root, const QVector<ScannedFile> &files, qint64 elapsedMs, bool complete);
+    void updateLibraryView();
+    void updateSmartPlaylistMenu();
+    void addErrorReportEntry(const QString &text);
+    void updateProbePriorities();
+    void playSmartPlaylist(const QString &name);
     void addToPlaylist(const MusicFile &file);
+    void appendToPlaylist(const QList<PlaylistEntry> &entries);
+    void applyProbedFiles();
+    void rebuildPlaylistWidget();
+    void onPlaylistFilesInserted(int first, int count);
+    void onPlaylistFilesRemoved(const Playlist::RangeList &ranges);
+    void onPlaylistFilesMoved(int first, int count, int destination);
+    void openPlaylist(const QString &name);
+    void switchPlaylist(const QString &name);
+    void syncCurrentPlaylist();
+    void updatePlaylistMenu();
     void updateCurrentSong(const MusicFile &file, bool updatePlayer = true);
+    void updateCover(const QString &filePath);
+    void showFullCover();
     void loadLyric(const QString &musicFilePath);
     void adjustLyricFontSize();
     void loadSettings();
     void saveSettings();
+    QString libraryCachePath() const;
     
     // 新增：进度条相关
     QTimer *m_progressTimer;        // 用于平滑更新进度条
@@ -94,8 +158,33 @@ private:
     Lyric *m_lyric;
     bool m_isPlaying;
     QFileSystemWatcher *m_fileWatcher;
-    QString m_currentMusicFolder;
-    QMap<QString, MusicFile> m_musicLibrary;
+    QStringList m_musicFolders;     // 音乐库根目录，可以在不同的磁盘上
+    MusicLibrary *m_library;
+    DuplicateAnalyzer *m_duplicateAnalyzer;
+    QProgressDialog *m_duplicateProgress;
+    LoudnessAnalyzer *m_loudnessAnalyzer;
+    WaveformCache *m_waveformCache;
+    SeekTableCache *m_seekTables;
+    TrackHeadCache *m_headCache;
+    AlbumArtCache *m_albumArtCache;
+    SearchIndex *m_searchIndex;
+    LibraryView *m_libraryView;
+    LibraryListModel *m_libraryModel;
+    SmartPlaylists *m_smartPlaylists;
+    MetadataProber *m_metadataProber;
+    LibraryScanner *m_libraryScanner;
+    ControlServer *m_controlServer;
+    PlaylistManager *m_playlistManager;
+    QTimer *m_probeFlushTimer;
+    QTimer *m_probePriorityTimer;  // 滚动或切歌后合并更新探测优先级
+    PlayStatsLog *m_playStatsLog;
+    TrackValidator *m_trackValidator;
+    EqualizerDialog *m_equalizer;  // 第一次打开时创建
+    QDialog *m_errorReport;      // 非模态错误报告窗口，第一次打开时创建
+    QListWidget *m_errorList;
+    QStringList m_errorEntries;  // 最近的播放错误
+    QHash<QString, MusicFile> m_probedFiles;  // 等待刷新到播放列表的探测结果
+    QString m_currentFilePath;  // 当前显示的歌曲
 };
 
 #endif // MAINWINDOW_H
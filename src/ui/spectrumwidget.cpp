@@ -0,0 +1,277 @@
+#include "spectrumwidget.h"
+#include "core/pcmring.h"
+#include <QPainter>
+#include <QScreen>
+#include <QShowEvent>
+#include <QHideEvent>
+#include <QtMath>
+
+namespace {
+const int FftSize = 2048;             // 48kHz 时约 43ms，频率分辨率约 23Hz
+const int BarCount = 28;
+const double MinFrequency = 40.0;
+const double MaxFrequency = 16000.0;
+const float FloorDb = -72.0f;         // 柱高为 0 的电平
+const float FallPerSecond = 1.2f;     // 柱子每秒下落的高度（占满高的比例）
+const int PeakHoldMs = 600;
+const int StaleMs = 200;              // 超过这个时间没有新数据视为静音
+const int IdleInterval = 250;         // 看不见时的检查间隔
+const int ReadChunk = 8192;           // 每次从副本读取的样本数
+const int LevelWidth = 6;
+
+int refreshInterval(const QWidget *widget)
+{
+    const QScreen *screen = widget->screen();
+    const qreal rate = screen && screen->refreshRate() > 0 ? screen->refreshRate() : 60.0;
+    return qBound(8, qRound(1000.0 / rate), 50);
+}
+
+float toHeight(float power)
+{
+    const float db = 10.0f * std::log10(power + 1e-20f);
+    return qBound(0.0f, 1.0f - db / FloorDb, 1.0f);
+}
+}
+
+SpectrumWidget::SpectrumWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_tap(nullptr)
+    , m_sampleRate(0)
+    , m_channels(0)
+    , m_active(false)
+    , m_lastTick(0)
+    , m_lastData(-StaleMs)
+    , m_fft(FftSize)
+    , m_windowNorm(0.0f)
+    , m_history(FftSize, 0.0f)
+    , m_historyPos(0)
+    , m_readBuffer(ReadChunk)
+    , m_frame(FftSize)
+    , m_power(FftSize / 2 + 1)
+    , m_bars(BarCount, 0.0f)
+    , m_barPeaks(BarCount, 0.0f)
+    , m_barHolds(BarCount, 0)
+    , m_levels(2, 0.0f)
+    , m_levelPeaks(2, 0.0f)
+    , m_levelHolds(2, 0)
+{
+    m_levelTargets[0] = m_levelTargets[1] = 0.0f;
+    setMinimumHeight(60);
+
+    // 汉宁窗；满幅正弦在窗口中的幅度为 sum(w)/2
+    m_window.resize(FftSize);
+    double sum = 0.0;
+    for (int i = 0; i < FftSize; ++i) {
+        m_window[i] = float(0.5 - 0.5 * std::cos(2.0 * M_PI * i / FftSize));
+        sum += m_window[i];
+    }
+    m_windowNorm = float(4.0 / (sum * sum));
+
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &SpectrumWidget::onTick);
+    m_clock.start();
+}
+
+void SpectrumWidget::setTap(PcmRing *tap)
+{
+    m_tap = tap;
+}
+
+void SpectrumWidget::setFormat(int sampleRate, int channels)
+{
+    if (sampleRate == m_sampleRate && channels == m_channels) {
+        return;
+    }
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+    updateBands();
+}
+
+void SpectrumWidget::updateBands()
+{
+    m_bandStart.resize(BarCount);
+    m_bandEnd.resize(BarCount);
+    if (m_sampleRate <= 0) {
+        return;
+    }
+    const int half = FftSize / 2;
+    const double top = qMin(MaxFrequency, m_sampleRate / 2.0);
+    for (int b = 0; b < BarCount; ++b) {
+        const double f0 = MinFrequency * std::pow(top / MinFrequency, double(b) / BarCount);
+        const double f1 = MinFrequency * std::pow(top / MinFrequency, double(b + 1) / BarCount);
+        const int start = qBound(1, int(f0 * FftSize / m_sampleRate), half);
+        m_bandStart[b] = start;
+        m_bandEnd[b] = qBound(start + 1, int(f1 * FftSize / m_sampleRate), half + 1);
+    }
+}
+
+void SpectrumWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    m_lastTick = m_clock.elapsed();
+    setActive(true);
+    m_timer.start();
+}
+
+void SpectrumWidget::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    setActive(false);
+    m_timer.stop();
+}
+
+void SpectrumWidget::setActive(bool active)
+{
+    if (active == m_active) {
+        return;
+    }
+    m_active = active;
+    m_timer.setInterval(active ? refreshInterval(this) : IdleInterval);
+    emit activeChanged(active);
+}
+
+void SpectrumWidget::onTick()
+{
+    const qint64 now = m_clock.elapsed();
+    const float elapsed = qMin(0.25f, (now - m_lastTick) / 1000.0f);
+    m_lastTick = now;
+
+    // 最小化或被其他窗口完全遮挡时不分析也不重绘
+    const bool visible = isVisible() && !window()->isMinimized() && !visibleRegion().isEmpty();
+    setActive(visible);
+    if (!visible) {
+        return;
+    }
+
+    if (readTap() > 0) {
+        m_lastData = now;
+    }
+    analyze(elapsed);
+}
+
+int SpectrumWidget::readTap()
+{
+    m_levelTargets[0] = m_levelTargets[1] = 0.0f;
+    if (!m_tap || m_channels <= 0) {
+        return 0;
+    }
+    // 写端只写整帧，这里也只读整帧，声道位置始终对齐
+    const int channels = m_channels;
+    const int mask = FftSize - 1;
+    int frames = 0;
+    for (;;) {
+        int count = qMin(m_tap->readAvailable(), m_readBuffer.size());
+        count -= count % channels;
+        if (count == 0) {
+            break;
+        }
+        m_tap->read(m_readBuffer.data(), count);
+        const float *samples = m_readBuffer.constData();
+        const int n = count / channels;
+        for (int f = 0; f < n; ++f, samples += channels) {
+            float sum = 0.0f;
+            for (int c = 0; c < channels; ++c) {
+                sum += samples[c];
+            }
+            m_levelTargets[0] = qMax(m_levelTargets[0], qAbs(samples[0]));
+            m_levelTargets[1] = qMax(m_levelTargets[1], qAbs(samples[channels > 1 ? 1 : 0]));
+            m_history[m_historyPos] = sum / channels;
+            m_historyPos = (m_historyPos + 1) & mask;
+        }
+        frames += n;
+    }
+    return frames;
+}
+
+void SpectrumWidget::analyze(float elapsed)
+{
+    // 设备按块拉取数据，两帧之间可能没有新样本，这时沿用最近的历史，避免柱子闪烁
+    float targets[BarCount] = {};
+    if (m_sampleRate > 0 && m_lastTick - m_lastData < StaleMs) {
+        const int mask = FftSize - 1;
+        for (int i = 0; i < FftSize; ++i) {
+            m_frame[i] = m_history[(m_historyPos + i) & mask] * m_window[i];
+        }
+        m_fft.powerSpectrum(m_frame.constData(), m_power.data());
+        for (int b = 0; b < BarCount; ++b) {
+            float peak = 0.0f;
+            for (int k = m_bandStart[b]; k < m_bandEnd[b]; ++k) {
+                peak = qMax(peak, m_power[k]);
+            }
+            targets[b] = toHeight(peak * m_windowNorm);
+        }
+    }
+    const float levelTargets[2] = { toHeight(m_levelTargets[0] * m_levelTargets[0]),
+                                    toHeight(m_levelTargets[1] * m_levelTargets[1]) };
+
+    decay(m_bars, m_barPeaks, m_barHolds, targets, elapsed);
+    decay(m_levels, m_levelPeaks, m_levelHolds, levelTargets, elapsed);
+
+    // 全部落到底之后不再重绘
+    bool visible = false;
+    for (int i = 0; i < BarCount && !visible; ++i) {
+        visible = m_barPeaks[i] > 0.0f;
+    }
+    if (visible || m_levelPeaks[0] > 0.0f || m_levelPeaks[1] > 0.0f || m_lastTick - m_lastData < StaleMs) {
+        update();
+    }
+}
+
+void SpectrumWidget::decay(QVector<float> &values, QVector<float> &peaks, QVector<qint64> &holds,
+                           const float *targets, float elapsed)
+{
+    const float fall = FallPerSecond * elapsed;
+    for (int i = 0; i < values.size(); ++i) {
+        values[i] = qMax(targets[i], values[i] - fall);
+        if (values[i] >= peaks[i]) {
+            peaks[i] = values[i];
+            holds[i] = m_lastTick + PeakHoldMs;
+        } else if (m_lastTick > holds[i]) {
+            peaks[i] = qMax(values[i], peaks[i] - fall);
+        }
+    }
+}
+
+void SpectrumWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    const QRect area = rect().adjusted(2, 2, -(2 * LevelWidth + 10), -2);
+    const int height = area.height();
+    const QColor barColor = palette().color(QPalette::Highlight);
+    QColor peakColor = palette().color(QPalette::Text);
+    peakColor.setAlpha(160);
+
+    // 频谱
+    const double slot = double(area.width()) / BarCount;
+    const int gap = slot > 6 ? 2 : 1;
+    for (int b = 0; b < BarCount; ++b) {
+        const int x = area.left() + int(b * slot);
+        const int w = qMax(1, int((b + 1) * slot) - int(b * slot) - gap);
+        const int h = int(m_bars[b] * height);
+        if (h > 0) {
+            painter.fillRect(x, area.bottom() - h + 1, w, h, barColor);
+        }
+        const int peak = int(m_barPeaks[b] * height);
+        if (peak > 0) {
+            painter.fillRect(x, area.bottom() - peak + 1, w, 2, peakColor);
+        }
+    }
+
+    // 左右声道电平，接近满幅时变红
+    QColor trackColor = palette().color(QPalette::Mid);
+    trackColor.setAlpha(60);
+    for (int c = 0; c < 2; ++c) {
+        const int x = rect().right() - 2 - (2 - c) * (LevelWidth + 2) + 2;
+        painter.fillRect(x, area.top(), LevelWidth, height, trackColor);
+        const int h = int(m_levels[c] * height);
+        if (h > 0) {
+            painter.fillRect(x, area.bottom() - h + 1, LevelWidth, h,
+                             m_levels[c] > 0.98f ? QColor(Qt::red) : barColor);
+        }
+        const int peak = int(m_levelPeaks[c] * height);
+        if (peak > 0) {
+            painter.fillRect(x, area.bottom() - peak + 1, LevelWidth, 2, peakColor);
+        }
+    }
+}
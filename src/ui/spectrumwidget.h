@@ -0,0 +1,72 @@
+#ifndef SPECTRUMWIDGET_H
+#define SPECTRUMWIDGET_H
+
+#include <QWidget>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include "core/fft.h"
+
+class PcmRing;
+
+// 实时频谱与电平显示
+// 按屏幕刷新率从播放引擎的 PCM 副本取数据，对最近 2048 个单声道样本加汉宁窗做 FFT，
+// 按对数频率分成若干柱显示；右侧是左右声道的峰值电平。
+// 窗口隐藏、最小化或被完全遮挡时降低到每秒几次检查，并通过 activeChanged 让播放器停止写副本。
+class SpectrumWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit SpectrumWidget(QWidget *parent = nullptr);
+
+    void setTap(PcmRing *tap);
+    void setFormat(int sampleRate, int channels);
+
+signals:
+    void activeChanged(bool active);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    void onTick();
+    void setActive(bool active);
+    int readTap();
+    void analyze(float elapsed);
+    void decay(QVector<float> &values, QVector<float> &peaks, QVector<qint64> &holds,
+               const float *targets, float elapsed);
+    void updateBands();
+
+private:
+    PcmRing *m_tap;
+    int m_sampleRate;
+    int m_channels;
+    bool m_active;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_lastTick;
+    qint64 m_lastData;           // 最近一次读到新样本的时间
+
+    Fft m_fft;
+    QVector<float> m_window;     // 汉宁窗
+    float m_windowNorm;          // 把功率换算为满幅正弦 = 0dB 的系数
+    QVector<float> m_history;    // 最近 FftSize 个单声道样本（环形）
+    int m_historyPos;
+    QVector<float> m_readBuffer;
+    QVector<float> m_frame;      // 加窗后的一帧
+    QVector<float> m_power;
+    QVector<int> m_bandStart;    // 每个柱对应的 FFT 频点范围
+    QVector<int> m_bandEnd;
+
+    float m_levelTargets[2];     // 本次读到的数据的峰值（线性）
+    QVector<float> m_bars;       // 0 ~ 1
+    QVector<float> m_barPeaks;
+    QVector<qint64> m_barHolds;  // 峰值标记保持到的时间
+    QVector<float> m_levels;
+    QVector<float> m_levelPeaks;
+    QVector<qint64> m_levelHolds;
+};
+
+#endif // SPECTRUMWIDGET_H
@@ -0,0 +1,76 @@
+#include "waveformslider.h"
+#include <QPainter>
+#include <QStyle>
+#include <QStyleOptionSlider>
+
+WaveformSlider::WaveformSlider(QWidget *parent)
+    : QSlider(parent)
+{
+}
+
+WaveformSlider::WaveformSlider(Qt::Orientation orientation, QWidget *parent)
+    : QSlider(orientation, parent)
+{
+}
+
+void WaveformSlider::setWaveform(const WaveformData &waveform)
+{
+    m_waveform = waveform;
+    update();
+}
+
+void WaveformSlider::clearWaveform()
+{
+    m_waveform = WaveformData();
+    update();
+}
+
+void WaveformSlider::paintEvent(QPaintEvent *event)
+{
+    if (m_waveform.isEmpty() || orientation() != Qt::Horizontal) {
+        QSlider::paintEvent(event);
+        return;
+    }
+
+    QPainter painter(this);
+    QStyleOptionSlider option;
+    initStyleOption(&option);
+
+    // 只使用已缓存的金字塔数据，按当前宽度挑选合适的一级
+    const QRect area = rect().adjusted(0, 1, 0, -1);
+    const int width = area.width();
+    const QVector<WaveformPeak> &level = m_waveform.levelForWidth(width);
+    const int count = level.size();
+    const int middle = area.center().y();
+    const double scale = area.height() / 2.0 / 127.0;
+    const int played = QStyle::sliderPositionFromValue(minimum(), maximum(), value(), width);
+
+    const QColor playedColor = palette().color(QPalette::Highlight);
+    const QColor restColor = palette().color(QPalette::Mid);
+
+    for (int x = 0; x < width && count > 0; ++x) {
+        int first = int(qint64(x) * count / width);
+        int last = qMax(first + 1, int(qint64(x + 1) * count / width));
+        int lo = 127, hi = -127, rms = 0;
+        for (int i = first; i < last && i < count; ++i) {
+            lo = qMin(lo, int(level[i].min));
+            hi = qMax(hi, int(level[i].max));
+            rms = qMax(rms, int(level[i].rms));
+        }
+
+        QColor color = x < played ? playedColor : restColor;
+        color.setAlpha(140);
+        painter.setPen(color);
+        painter.drawLine(area.left() + x, middle - int(hi * scale), area.left() + x, middle - int(lo * scale));
+
+        // 均方根部分用不透明颜色叠加，显示响度轮廓
+        int rmsHeight = int(rms / 255.0 * 127.0 * scale);
+        color.setAlpha(255);
+        painter.setPen(color);
+        painter.drawLine(area.left() + x, middle - rmsHeight, area.left() + x, middle + rmsHeight);
+    }
+
+    // 只绘制滑块手柄，凹槽由波形代替
+    option.subControls = QStyle::SC_SliderHandle;
+    style()->drawComplexControl(QStyle::CC_Slider, &option, &painter, this);
+}
@@ -0,0 +1,25 @@
+#ifndef WAVEFORMSLIDER_H
+#define WAVEFORMSLIDER_H
+
+#include <QSlider>
+#include "core/waveformcache.h"
+
+// 在滑块背后绘制波形概览的进度条
+class WaveformSlider : public QSlider
+{
+    Q_OBJECT
+public:
+    explicit WaveformSlider(QWidget *parent = nullptr);
+    explicit WaveformSlider(Qt::Orientation orientation, QWidget *parent = nullptr);
+
+    void setWaveform(const WaveformData &waveform);
+    void clearWaveform();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    WaveformData m_waveform;
+};
+
+#endif // WAVEFORMSLIDER_H